@@ -0,0 +1,175 @@
+#include "AnalogOutputEngine.h"
+#include "P-Block-struct.h"
+
+#define AO_Q16_ONE                  (0x10000U)
+
+// Note: pin and DMA mappings need to be updated based on actual hardware design
+const AnalogOutputEngine::PwmTimer_t AnalogOutputEngine::timers_[2] = {
+    {TMR3, DMA1_CHANNEL3, 0, 4},    // TMR3 overflow DMA request, CH1-4 on PC6-PC9 (full remap)
+    {TMR4, DMA1_CHANNEL7, 4, 2},    // TMR4 overflow DMA request, CH1-2 on PD12-PD13 (remap)
+};
+
+volatile uint32_t AnalogOutputEngine::dirty_mask_ = 0;
+uint32_t AnalogOutputEngine::current_q16_[AO_CHANNELS] = {};
+uint32_t AnalogOutputEngine::target_q16_[AO_CHANNELS] = {};
+uint32_t AnalogOutputEngine::step_q16_[AO_CHANNELS] = {};
+uint16_t AnalogOutputEngine::duty_[AO_CHANNELS] = {};
+uint32_t AnalogOutputEngine::update_count_ = 0;
+
+bool AnalogOutputEngine::Init(void) {
+    gpio_init_type gpio_init_struct;
+
+    crm_periph_clock_enable(CRM_IOMUX_PERIPH_CLOCK, TRUE);
+    crm_periph_clock_enable(CRM_GPIOC_PERIPH_CLOCK, TRUE);
+    crm_periph_clock_enable(CRM_GPIOD_PERIPH_CLOCK, TRUE);
+    crm_periph_clock_enable(CRM_TMR3_PERIPH_CLOCK, TRUE);
+    crm_periph_clock_enable(CRM_TMR4_PERIPH_CLOCK, TRUE);
+    crm_periph_clock_enable(CRM_DMA1_PERIPH_CLOCK, TRUE);
+
+    // Default pins collide with the universal inputs on GPIOB
+    gpio_pin_remap_config(TMR3_GMUX_0011, TRUE);
+    gpio_pin_remap_config(TMR4_GMUX_0001, TRUE);
+
+    gpio_default_para_init(&gpio_init_struct);
+    gpio_init_struct.gpio_drive_strength = GPIO_DRIVE_STRENGTH_STRONGER;
+    gpio_init_struct.gpio_out_type = GPIO_OUTPUT_PUSH_PULL;
+    gpio_init_struct.gpio_mode = GPIO_MODE_MUX;
+    gpio_init_struct.gpio_pull = GPIO_PULL_NONE;
+    gpio_init_struct.gpio_pins = GPIO_PINS_6 | GPIO_PINS_7 | GPIO_PINS_8 | GPIO_PINS_9;
+    gpio_init(GPIOC, &gpio_init_struct);
+    gpio_init_struct.gpio_pins = GPIO_PINS_12 | GPIO_PINS_13;
+    gpio_init(GPIOD, &gpio_init_struct);
+
+    for (uint8_t i = 0; i < AO_CHANNELS; i++) {
+        SetSlewRate(i, AO_DEFAULT_SLEW_MV_PER_S);
+    }
+
+    for (const PwmTimer_t& pwm : timers_) {
+        InitTimer(pwm);
+    }
+
+    // Pick up setpoints stored before the engine was running
+    dirty_mask_ = (1U << AO_CHANNELS) - 1;
+    return true;
+}
+
+void AnalogOutputEngine::InitTimer(const PwmTimer_t& pwm) {
+    static const tmr_channel_select_type channels[4] = {
+        TMR_SELECT_CHANNEL_1, TMR_SELECT_CHANNEL_2, TMR_SELECT_CHANNEL_3, TMR_SELECT_CHANNEL_4
+    };
+    tmr_output_config_type output_config;
+    dma_init_type dma_init_struct;
+
+    // 240 MHz timer clock / 10000 counts = 24 kHz PWM, well above the output filter corner
+    tmr_base_init(pwm.tmr, AO_PWM_PERIOD - 1, 0);
+    tmr_cnt_dir_set(pwm.tmr, TMR_COUNT_UP);
+    tmr_period_buffer_enable(pwm.tmr, TRUE);
+
+    tmr_output_default_para_init(&output_config);
+    output_config.oc_mode = TMR_OUTPUT_CONTROL_PWM_MODE_A;
+    output_config.oc_polarity = TMR_OUTPUT_ACTIVE_HIGH;
+    output_config.oc_output_state = TRUE;
+    for (uint8_t i = 0; i < pwm.count; i++) {
+        tmr_output_channel_config(pwm.tmr, channels[i], &output_config);
+        tmr_channel_value_set(pwm.tmr, channels[i], 0);
+        tmr_output_channel_buffer_enable(pwm.tmr, channels[i], TRUE);
+    }
+
+    // Each overflow DMA request writes pwm.count halfwords to C1DT..CxDT through DMADT
+    tmr_dma_control_config(pwm.tmr, (pwm.count == 4) ? TMR_DMA_TRANSFER_4BYTES : TMR_DMA_TRANSFER_2BYTES,
+                           TMR_C1DT_ADDRESS);
+    tmr_dma_request_enable(pwm.tmr, TMR_OVERFLOW_DMA_REQUEST, TRUE);
+
+    dma_reset(pwm.dma);
+    dma_default_para_init(&dma_init_struct);
+    dma_init_struct.buffer_size = pwm.count;
+    dma_init_struct.direction = DMA_DIR_MEMORY_TO_PERIPHERAL;
+    dma_init_struct.memory_base_addr = reinterpret_cast<uint32_t>(&duty_[pwm.first]);
+    dma_init_struct.memory_data_width = DMA_MEMORY_DATA_WIDTH_HALFWORD;
+    dma_init_struct.memory_inc_enable = TRUE;
+    dma_init_struct.peripheral_base_addr = reinterpret_cast<uint32_t>(&pwm.tmr->dmadt);
+    dma_init_struct.peripheral_data_width = DMA_PERIPHERAL_DATA_WIDTH_HALFWORD;
+    dma_init_struct.peripheral_inc_enable = FALSE;
+    dma_init_struct.priority = DMA_PRIORITY_MEDIUM;
+    dma_init_struct.loop_mode_enable = FALSE;
+    dma_init(pwm.dma, &dma_init_struct);
+
+    tmr_counter_enable(pwm.tmr, TRUE);
+}
+
+void AnalogOutputEngine::StartBurst(const PwmTimer_t& pwm) {
+    // One-shot burst: armed here, executed by the next overflow request
+    dma_channel_enable(pwm.dma, FALSE);
+    dma_data_number_set(pwm.dma, pwm.count);
+    dma_channel_enable(pwm.dma, TRUE);
+    update_count_++;
+}
+
+void AnalogOutputEngine::MarkDirty(uint8_t index) {
+    if (index < AO_CHANNELS) {
+        __atomic_fetch_or(&dirty_mask_, 1U << index, __ATOMIC_RELEASE);
+    }
+}
+
+void AnalogOutputEngine::SetSlewRate(uint8_t index, uint16_t mv_per_s) {
+    if (index >= AO_CHANNELS) {
+        return;
+    }
+    // mV/s -> Q16 mV per Process() call
+    step_q16_[index] = static_cast<uint32_t>(
+        (static_cast<uint64_t>(mv_per_s) * AO_Q16_ONE * AO_ENGINE_PERIOD_MS) / 1000U);
+    if (mv_per_s != 0 && step_q16_[index] == 0) {
+        step_q16_[index] = 1;
+    }
+}
+
+uint16_t AnalogOutputEngine::GetActualMillivolts(uint8_t index) {
+    if (index >= AO_CHANNELS) {
+        return 0;
+    }
+    return static_cast<uint16_t>((current_q16_[index] + AO_Q16_ONE / 2) >> 16);
+}
+
+void AnalogOutputEngine::Process(void) {
+    uint32_t dirty = __atomic_exchange_n(&dirty_mask_, 0U, __ATOMIC_ACQUIRE);
+
+    while (dirty) {
+        uint8_t i = static_cast<uint8_t>(__builtin_ctz(dirty));
+        dirty &= dirty - 1;
+        uint32_t mv = PBlockRegisters_t::GetAnalogOutput(i + 1);
+        if (mv > AO_MAX_MV) {
+            mv = AO_MAX_MV;
+        }
+        target_q16_[i] = mv << 16;
+    }
+
+    uint32_t changed = 0;
+    for (uint8_t i = 0; i < AO_CHANNELS; i++) {
+        uint32_t cur = current_q16_[i];
+        uint32_t tgt = target_q16_[i];
+        uint32_t step = step_q16_[i];
+
+        if (cur != tgt) {
+            if (cur < tgt) {
+                cur = (step == 0 || tgt - cur <= step) ? tgt : cur + step;
+            } else {
+                cur = (step == 0 || cur - tgt <= step) ? tgt : cur - step;
+            }
+            current_q16_[i] = cur;
+        }
+
+        uint32_t mv = (cur + AO_Q16_ONE / 2) >> 16;
+        uint16_t duty = static_cast<uint16_t>((mv * AO_PWM_PERIOD) / AO_MAX_MV);
+        if (duty != duty_[i]) {
+            duty_[i] = duty;
+            changed |= 1U << i;
+        }
+    }
+
+    for (const PwmTimer_t& pwm : timers_) {
+        uint32_t mask = ((1U << pwm.count) - 1) << pwm.first;
+        if (changed & mask) {
+            StartBurst(pwm);
+        }
+    }
+}
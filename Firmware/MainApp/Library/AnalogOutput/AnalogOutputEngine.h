@@ -0,0 +1,89 @@
+#ifndef __ANALOG_OUTPUT_ENGINE_H__
+#define __ANALOG_OUTPUT_ENGINE_H__
+
+#include <stdint.h>
+#include "at32f403a_407_tmr.h"
+#include "at32f403a_407_dma.h"
+#include "at32f403a_407_gpio.h"
+#include "at32f403a_407_crm.h"
+
+#define AO_CHANNELS                 (6U)
+#define AO_MAX_MV                   (10000U)
+#define AO_PWM_PERIOD               (10000U)    /// timer counts per PWM period, 1 count = 1 mV at full scale
+#define AO_ENGINE_PERIOD_MS         (10U)       /// Process() call interval
+#define AO_DEFAULT_SLEW_MV_PER_S    (0U)        /// 0 = no slew limiting
+
+/**
+ * @brief Analog output engine for the six 0-10 V outputs
+ * Channels are PWM outputs filtered to 0-10 V on the board:
+ *   [0]=B3, [1]=B16, [2]=B2-A, [3]=B2-B -> TMR3 CH1-CH4
+ *   [4]=B15-A, [5]=B15-B                -> TMR4 CH1-CH2
+ * Setpoint writers (Modbus, RPDO, SDO) only store the value and mark the
+ * channel dirty; Process() picks up all pending setpoints at once, applies
+ * the slew limit in Q16 fixed point and hands the new compare values to
+ * DMA, which loads them in one burst at the next PWM period boundary.
+ * A burst of setpoint writes therefore costs one hardware update per cycle.
+ */
+class AnalogOutputEngine {
+public:
+    /**
+     * @brief Configure PWM timers, pins and DMA channels
+     * @return true on success
+     */
+    static bool Init(void);
+
+    /**
+     * @brief Mark output setpoint as changed (any context)
+     * @param index Output index (0-5)
+     */
+    static void MarkDirty(uint8_t index);
+
+    /**
+     * @brief Set slew-rate limit
+     * @param index Output index (0-5)
+     * @param mv_per_s Maximum change in mV per second, 0 disables limiting
+     */
+    static void SetSlewRate(uint8_t index, uint16_t mv_per_s);
+
+    /**
+     * @brief Output value currently driven (after slew limiting)
+     * @param index Output index (0-5)
+     * @return Value in mV
+     */
+    static uint16_t GetActualMillivolts(uint8_t index);
+
+    /**
+     * @brief Advance slew limiting and push changed values to hardware
+     * Called every AO_ENGINE_PERIOD_MS from the output task.
+     */
+    static void Process(void);
+
+    /**
+     * @brief Number of DMA bursts issued (hardware updates)
+     */
+    static uint32_t GetUpdateCount(void) { return update_count_; }
+
+private:
+    /**
+     * @brief PWM timer with DMA burst update of its compare registers
+     */
+    struct PwmTimer_t {
+        tmr_type* tmr;
+        dma_channel_type* dma;
+        uint8_t first;      /// first output index on this timer
+        uint8_t count;      /// outputs on this timer (consecutive CxDT registers)
+    };
+
+    static void InitTimer(const PwmTimer_t& pwm);
+    static void StartBurst(const PwmTimer_t& pwm);
+
+    static const PwmTimer_t timers_[2];
+    static volatile uint32_t dirty_mask_;
+    static uint32_t current_q16_[AO_CHANNELS];     /// slewed output, mV in Q16
+    static uint32_t target_q16_[AO_CHANNELS];
+    static uint32_t step_q16_[AO_CHANNELS];        /// max change per Process(), 0 = unlimited
+    static uint16_t duty_[AO_CHANNELS];            /// DMA source, laid out as CxDT per timer
+    static uint32_t update_count_;
+};
+
+#endif // __ANALOG_OUTPUT_ENGINE_H__
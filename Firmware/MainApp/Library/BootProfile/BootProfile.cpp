@@ -0,0 +1,22 @@
+#include "BootProfile.h"
+
+BootProfileRecord BootProfile::record_;
+
+static const bpr_data_type stamp_regs_[BOOT_PROFILE_PHASES] = {
+    BPR_DATA14, BPR_DATA15, BPR_DATA16, BPR_DATA17,
+    BPR_DATA18, BPR_DATA19, BPR_DATA20, BPR_DATA21,
+};
+
+void BootProfile::Capture(void) {
+    record_.marker = bpr_data_read(BPR_DATA13);
+    for (uint8_t i = 0; i < BOOT_PROFILE_PHASES; i++) {
+        record_.stamps[i] = bpr_data_read(stamp_regs_[i]);
+    }
+    record_.flags = bpr_data_read(BPR_DATA22);
+}
+
+void BootProfile::MarkRunning(void) {
+    if (record_.marker == BOOT_PROFILE_MARKER) {
+        bpr_data_write(BPR_DATA22, static_cast<uint16_t>(bpr_data_read(BPR_DATA22) | BOOT_PROFILE_APP_RUNNING));
+    }
+}
@@ -0,0 +1,47 @@
+#ifndef __BOOT_PROFILE_H__
+#define __BOOT_PROFILE_H__
+
+#include <stdint.h>
+#include "at32f403a_407.h"
+
+#define BOOT_PROFILE_MARKER         (0xB001U)   /// BPR_DATA13, written by bootloader0
+#define BOOT_PROFILE_PHASES         (8U)        /// BPR_DATA14..BPR_DATA21
+#define BOOT_PROFILE_TICK_US        (10U)       /// stamp unit
+#define BOOT_PROFILE_RUNNING_MS     (5000U)     /// uptime after which the boot counts as clean
+
+#define BOOT_PROFILE_FAST           (0x0001U)   /// bootloader took the fast path
+#define BOOT_PROFILE_COLD           (0x0002U)   /// power-on or watchdog reset
+#define BOOT_PROFILE_APP_STARTED    (0x0004U)   /// bootloader jumped to the application
+#define BOOT_PROFILE_APP_RUNNING    (0x0008U)   /// set by MarkRunning()
+
+/**
+ * @brief Start-up profile left by bootloader0 in the backup registers
+ * Stamps are the end of each bootloader phase since reset handling began,
+ * in BOOT_PROFILE_TICK_US units, 0 if the phase was skipped: RTC, flash
+ * service, USB, config, journal, boot flags, application check, jump.
+ */
+struct BootProfileRecord {
+    uint16_t marker;                        /// BOOT_PROFILE_MARKER, else no profile
+    uint16_t stamps[BOOT_PROFILE_PHASES];
+    uint16_t flags;
+};
+
+/**
+ * @brief Reads the bootloader start-up profile and reports a clean boot
+ * Capture() copies the record into RAM before anything else can touch the
+ * backup registers. MarkRunning() sets BOOT_PROFILE_APP_RUNNING; the next
+ * warm restart then takes the bootloader fast path. It is called from the
+ * idle hook once the application has run BOOT_PROFILE_RUNNING_MS, so a
+ * firmware that resets during start-up keeps getting the full bootloader.
+ */
+class BootProfile {
+public:
+    static void Capture(void);
+    static void MarkRunning(void);
+    static const BootProfileRecord& Get(void) { return record_; }
+
+private:
+    static BootProfileRecord record_;
+};
+
+#endif // __BOOT_PROFILE_H__
@@ -0,0 +1,87 @@
+#include "ButtonGestures.h"
+
+static bool reached(uint32_t now_ms, uint32_t deadline_ms) {
+    return static_cast<int32_t>(now_ms - deadline_ms) >= 0;
+}
+
+void ButtonGestures::Emit(ButtonEventType type, uint8_t buttons, uint32_t held_ms) {
+    if (count_ < BUTTON_MAX_EVENTS) {
+        out_[count_++] = {type, buttons, static_cast<uint16_t>(held_ms > 0xFFFFU ? 0xFFFFU : held_ms)};
+    }
+}
+
+uint8_t ButtonGestures::Process(uint8_t pressed, uint32_t now_ms, ButtonEvent *events) {
+    out_ = events;
+    count_ = 0;
+
+    if (pressed != raw_) {
+        raw_ = pressed;
+        raw_since_ = now_ms;
+    }
+
+    // Debounced changes, all bits that settled together are applied at once
+    if (raw_ != stable_ && reached(now_ms, raw_since_ + BUTTON_DEBOUNCE_MS)) {
+        const uint8_t went_up = stable_ & ~raw_;
+        const uint8_t went_down = raw_ & ~stable_;
+        const uint8_t was_down = stable_;
+        stable_ = raw_;
+
+        for (uint8_t i = 0; i < BUTTON_COUNT; i++) {
+            if (went_up & (1U << i)) {
+                const uint32_t held_ms = now_ms - down_since_[i];
+                if (!combo_ && !long_sent_[i]) {
+                    Emit(ButtonEventType::CLICK, static_cast<uint8_t>(1U << i), held_ms);
+                }
+                Emit(ButtonEventType::RELEASE, static_cast<uint8_t>(1U << i), held_ms);
+            }
+        }
+        for (uint8_t i = 0; i < BUTTON_COUNT; i++) {
+            if (went_down & (1U << i)) {
+                down_since_[i] = now_ms;
+                next_hold_[i] = now_ms + BUTTON_LONG_MS;
+                long_sent_[i] = false;
+                Emit(ButtonEventType::PRESS, static_cast<uint8_t>(1U << i), 0);
+            }
+        }
+        if (went_down && (was_down || (went_down & (went_down - 1U)))) {
+            combo_ = true;
+            Emit(ButtonEventType::COMBO, stable_, 0);
+        }
+        if (stable_ == 0) {
+            combo_ = false;
+        }
+    }
+
+    // Hold timers of single presses
+    if (!combo_) {
+        for (uint8_t i = 0; i < BUTTON_COUNT; i++) {
+            if ((stable_ & (1U << i)) && reached(now_ms, next_hold_[i])) {
+                const ButtonEventType type = long_sent_[i] ? ButtonEventType::REPEAT : ButtonEventType::LONG;
+                Emit(type, static_cast<uint8_t>(1U << i), now_ms - down_since_[i]);
+                long_sent_[i] = true;
+                next_hold_[i] = now_ms + BUTTON_REPEAT_MS;
+            }
+        }
+    }
+    return count_;
+}
+
+uint32_t ButtonGestures::NextDeadlineMs(uint32_t now_ms) const {
+    uint32_t next = UINT32_MAX;
+    if (raw_ != stable_) {
+        const int32_t left = static_cast<int32_t>(raw_since_ + BUTTON_DEBOUNCE_MS - now_ms);
+        next = left > 0 ? static_cast<uint32_t>(left) : 0U;
+    }
+    if (!combo_) {
+        for (uint8_t i = 0; i < BUTTON_COUNT; i++) {
+            if (stable_ & (1U << i)) {
+                const int32_t left = static_cast<int32_t>(next_hold_[i] - now_ms);
+                const uint32_t wait = left > 0 ? static_cast<uint32_t>(left) : 0U;
+                if (wait < next) {
+                    next = wait;
+                }
+            }
+        }
+    }
+    return next;
+}
@@ -0,0 +1,77 @@
+#ifndef __BUTTON_GESTURES_H__
+#define __BUTTON_GESTURES_H__
+
+#include <stdint.h>
+
+#define BUTTON_COUNT                (3U)
+#define BUTTON_DEBOUNCE_MS          (20U)       /// stable time before a level is accepted
+#define BUTTON_LONG_MS              (800U)      /// hold time of BUTTON_LONG
+#define BUTTON_REPEAT_MS            (200U)      /// BUTTON_REPEAT period after BUTTON_LONG
+#define BUTTON_MAX_EVENTS           (4U * BUTTON_COUNT + 1U) /// events one Process() call can produce
+
+/** @brief Bit n of a button mask is button n */
+enum ButtonId : uint8_t {
+    BUTTON_UP = 0,
+    BUTTON_DOWN,
+    BUTTON_OK,
+};
+
+enum class ButtonEventType : uint8_t {
+    PRESS = 0,      /// a button went down
+    CLICK,          /// released before BUTTON_LONG_MS, not part of a combination
+    LONG,           /// held for BUTTON_LONG_MS
+    REPEAT,         /// still held, every BUTTON_REPEAT_MS after LONG
+    COMBO,          /// a second button went down, buttons = all buttons down
+    RELEASE,        /// a button went up
+};
+
+struct ButtonEvent {
+    ButtonEventType type;
+    uint8_t buttons;        /// mask of the button, of all buttons down for COMBO
+    uint16_t held_ms;       /// hold time for CLICK, LONG, REPEAT and RELEASE, saturates
+};
+
+/**
+ * @brief Debounce and gesture detection on button levels
+ * Pure logic without hardware or RTOS, fed with the raw pressed mask
+ * whenever it may have changed and whenever NextDeadlineMs() has passed.
+ *
+ * A level counts once it has been stable for BUTTON_DEBOUNCE_MS. A single
+ * button gives PRESS, then CLICK on a short release or LONG followed by
+ * REPEAT while held, and RELEASE. Pressing a second button gives COMBO
+ * with the buttons down; LONG, REPEAT and CLICK are then suppressed until
+ * all buttons are up, so a combination never also acts as its parts.
+ */
+class ButtonGestures {
+public:
+    /**
+     * @brief Advance debouncing and hold timers
+     * @param pressed Raw pressed mask
+     * @param now_ms Current time in ms
+     * @param events Destination, BUTTON_MAX_EVENTS entries
+     * @return Number of events written
+     */
+    uint8_t Process(uint8_t pressed, uint32_t now_ms, ButtonEvent *events);
+
+    /**
+     * @brief Time until Process() must run again without a level change
+     * @return Milliseconds, UINT32_MAX while no button is down or bouncing
+     */
+    uint32_t NextDeadlineMs(uint32_t now_ms) const;
+
+private:
+    void Emit(ButtonEventType type, uint8_t buttons, uint32_t held_ms);
+
+    uint8_t raw_ = 0;           /// last raw mask
+    uint8_t stable_ = 0;        /// debounced mask
+    uint32_t raw_since_ = 0;    /// time raw_ was first seen
+    bool combo_ = false;        /// a combination happened since all buttons were up
+    uint32_t down_since_[BUTTON_COUNT] = {};
+    uint32_t next_hold_[BUTTON_COUNT] = {};     /// time of the next LONG/REPEAT
+    bool long_sent_[BUTTON_COUNT] = {};
+
+    ButtonEvent *out_ = nullptr;
+    uint8_t count_ = 0;
+};
+
+#endif // __BUTTON_GESTURES_H__
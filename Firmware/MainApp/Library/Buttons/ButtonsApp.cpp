@@ -1,14 +1,104 @@
 #include "ButtonsApp.h"
 #include "FreeRTOS.h"
 #include "task.h"
+#include "queue.h"
+#include "at32f403a_407.h"
+#include "at32f403a_407_misc.h"
+#include "DigitalInputCapture.h"
+#include "PowerManager.h"
+
+#define BUTTONS_LINE_MASK           (((1U << BUTTON_COUNT) - 1U) << BUTTONS_FIRST_PIN)
+
+static_assert(BUTTONS_FIRST_PIN >= 10U && BUTTONS_FIRST_PIN + BUTTON_COUNT <= 16U,
+              "button lines must be served by EXINT15_10_IRQHandler");
+
+static StaticQueue_t queue_struct_;
+static uint8_t queue_storage_[BUTTONS_QUEUE_SIZE * sizeof(ButtonEvent)];
+static QueueHandle_t queue_ = NULL;
+static TaskHandle_t task_ = NULL;
+
+static void buttons_init(void)
+{
+    gpio_init_type gpio_init_struct;
+    exint_init_type exint_init_struct;
+
+    crm_periph_clock_enable(CRM_IOMUX_PERIPH_CLOCK, TRUE);
+    crm_periph_clock_enable(BUTTONS_PORT_CLOCK, TRUE);
+
+    gpio_default_para_init(&gpio_init_struct);
+    gpio_init_struct.gpio_mode = GPIO_MODE_INPUT;
+    gpio_init_struct.gpio_pull = GPIO_PULL_UP;
+    gpio_init_struct.gpio_pins = BUTTONS_LINE_MASK;
+    gpio_init(BUTTONS_PORT, &gpio_init_struct);
+
+    for (uint8_t i = 0; i < BUTTON_COUNT; i++)
+    {
+        gpio_exint_line_config(BUTTONS_PORT_SOURCE, static_cast<gpio_pins_source_type>(BUTTONS_FIRST_PIN + i));
+    }
+
+    exint_default_para_init(&exint_init_struct);
+    exint_init_struct.line_enable = TRUE;
+    exint_init_struct.line_mode = EXINT_LINE_INTERRUPUT;
+    exint_init_struct.line_select = BUTTONS_LINE_MASK;
+    exint_init_struct.line_polarity = EXINT_TRIGGER_BOTH_EDGE;
+    exint_init(&exint_init_struct);
+    exint_flag_clear(BUTTONS_LINE_MASK);
+
+    nvic_irq_enable(EXINT15_10_IRQn, DI_CAPTURE_IRQ_PRIORITY, 0);
+}
+
+/**
+ * @brief Pressed mask, bit n = button n
+ */
+static uint8_t buttons_read(void)
+{
+    return static_cast<uint8_t>((~BUTTONS_PORT->idt & BUTTONS_LINE_MASK) >> BUTTONS_FIRST_PIN);
+}
+
+void buttonsIrqHandler(void)
+{
+    const uint32_t pending = EXINT->intsts & BUTTONS_LINE_MASK;
+    if (pending == 0)
+    {
+        return;
+    }
+    EXINT->intsts = pending;
+    PowerManager::Wake(task_);
+}
+
+bool buttonsGetEvent(ButtonEvent *event, uint32_t wait_ms)
+{
+    if (queue_ == NULL)
+    {
+        return false;
+    }
+    return xQueueReceive(queue_, event, pdMS_TO_TICKS(wait_ms)) == pdTRUE;
+}
 
 void buttonsFun(void *parameters)
 {
     (void)parameters;
-    // Button input handling task
+
+    static ButtonGestures gestures;
+    ButtonEvent events[BUTTON_MAX_EVENTS];
+
+    queue_ = xQueueCreateStatic(BUTTONS_QUEUE_SIZE, sizeof(ButtonEvent), queue_storage_, &queue_struct_);
+    task_ = xTaskGetCurrentTaskHandle();
+    buttons_init();
+
     for (;;)
     {
-        // Button scanning and event handling - to be implemented
-        vTaskDelay(50); // Poll buttons frequently
+        const uint32_t now_ms = xTaskGetTickCount() * portTICK_PERIOD_MS;
+        const uint8_t count = gestures.Process(buttons_read(), now_ms, events);
+        for (uint8_t i = 0; i < count; i++)
+        {
+            // A full queue drops the event, the menu must not stall the input
+            xQueueSend(queue_, &events[i], 0);
+        }
+
+        // Edges wake the task; timeouts only while a button is bouncing or held
+        const uint32_t wait_ms = gestures.NextDeadlineMs(now_ms);
+        ulTaskNotifyTake(pdTRUE, wait_ms == UINT32_MAX ? portMAX_DELAY
+                                                       : (wait_ms == 0 ? 1 : pdMS_TO_TICKS(wait_ms)));
     }
 }
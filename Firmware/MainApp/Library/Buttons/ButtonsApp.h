@@ -1,12 +1,44 @@
 #ifndef _BUTTONS_APP_H_
 #define _BUTTONS_APP_H_
 
+#include <stdint.h>
+#include <stdbool.h>
+#include "at32f403a_407_gpio.h"
+#include "at32f403a_407_crm.h"
+#include "ButtonGestures.h"
+
+// Pins are an assumption, adjust them to the board; lines 11..13 stay clear of the digital inputs (lines 0..10)
+#define BUTTONS_PORT                GPIOC
+#define BUTTONS_PORT_CLOCK          CRM_GPIOC_PERIPH_CLOCK
+#define BUTTONS_PORT_SOURCE         GPIO_PORT_SOURCE_GPIOC
+#define BUTTONS_FIRST_PIN           (11U)       /// button n is on pin BUTTONS_FIRST_PIN + n, low when pressed
+#define BUTTONS_QUEUE_SIZE          (16U)       /// events waiting for the display/menu layer
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+/**
+ * @brief Button task
+ * Sleeps in ulTaskNotifyTake until a button edge (EXINT) or the next
+ * debounce/hold deadline of ButtonGestures; with no button down it blocks
+ * without timeout and costs no CPU. Events go to the button queue.
+ */
 void buttonsFun(void* parameters) __attribute__((noreturn));
 
+/**
+ * @brief EXINT handler of the button lines, called from EXINT15_10_IRQHandler
+ */
+void buttonsIrqHandler(void);
+
+/**
+ * @brief Take the next button event
+ * @param event Destination
+ * @param wait_ms Time to wait for an event, 0 to poll
+ * @return false if no event arrived or the button task is not running
+ */
+bool buttonsGetEvent(ButtonEvent* event, uint32_t wait_ms);
+
 #ifdef __cplusplus
 }
 #endif
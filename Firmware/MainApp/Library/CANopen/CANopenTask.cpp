@@ -1,8 +1,13 @@
 #include "CANopenTask.h"
-#include "Tracing.h"
+#include "ODExtensions.h"
+#include "CANopen_tmrTask.h"
+#include "PowerManager.h"
+#include "DeadlineMonitor.h"
+#include "Trace.h"
 
+/* Binary trace: only the format address and the arguments leave the task */
 #define log_printf(macropar_message, ...) \
-  hal_print_trace(macropar_message, ##__VA_ARGS__)
+  TRACE(macropar_message, ##__VA_ARGS__)
 
 /* default values for CO_CANopenInit() */
 #define NMT_CONTROL \
@@ -12,10 +17,25 @@
 #define SDO_CLI_TIMEOUT_TIME 500
 #define SDO_CLI_BLOCK false
 #define OD_STATUS_BITS NULL
+#define CO_MAX_SLEEP_US 100000U /* longest wait of the mainline, timerNext_us only shortens it */
+
+/* CO_new must not touch the FreeRTOS heap: heap_1 never frees, and the
+ * objects are sized by the OD_CNT_* counts of OD.h at compile time anyway */
+#ifndef CO_USE_GLOBALS
+#error CANopen objects must be static, define CO_USE_GLOBALS in CO_driver_target.h
+#endif
 
 /* Global variables and objects */
 CO_t *CO = NULL; /* CANopen object */
 uint8_t LED_red, LED_green;
+static TaskHandle_t mainlineTaskHandle = NULL;
+
+/* Pre-callback of the mainline objects: a frame for them arrived or an
+ * emergency was reported, CO_process() has work */
+static void CO_mainlineWake(void *object) {
+  (void)object;
+  PowerManager::Wake(mainlineTaskHandle);
+}
 
 void CANopenTask(void *parameters) {
   CO_ReturnError_t err;
@@ -43,8 +63,11 @@ void CANopenTask(void *parameters) {
 */
 
   /* Configure microcontroller. */
+  mainlineTaskHandle = xTaskGetCurrentTaskHandle();
+  DeadlineMonitor::SetWakeTask(mainlineTaskHandle); /* late tasks raise an EMCY from here */
 
-  /* Allocate memory */
+  /* Allocate memory: with CO_USE_GLOBALS CO_new hands out the static objects,
+   * once, the communication reset below reinitializes them in place */
   CO_config_t *config_ptr = NULL;
 
   CO = CO_new(config_ptr, &heapMemoryUsed);
@@ -137,6 +160,9 @@ void CANopenTask(void *parameters) {
       }
     }
 
+    /* Application OD entries must be extended before PDOs are mapped */
+    ODExtensions::Init();
+
     err = CO_CANopenInitPDO(CO, CO->em, OD, activeNodeId, &errInfo);
     if (err != CO_ERROR_NO && err != CO_ERROR_NODE_ID_UNCONFIGURED_LSS) {
       if (err == CO_ERROR_OD_PARAMETERS) {
@@ -154,7 +180,31 @@ void CANopenTask(void *parameters) {
     /* Configure CAN transmit and receive interrupt */
 
     /* Configure CANopen callbacks, etc */
+    /* Received frames wake the task that processes them, both tasks sleep otherwise */
+#if ((CO_CONFIG_LSS) & CO_CONFIG_LSS_SLAVE) && ((CO_CONFIG_LSS) & CO_CONFIG_FLAG_CALLBACK_PRE)
+    CO_LSSslave_initCallbackPre(CO->LSSslave, NULL, CO_mainlineWake);
+#endif
     if (!CO->nodeIdUnconfigured) {
+#if (CO_CONFIG_NMT) & CO_CONFIG_FLAG_CALLBACK_PRE
+      CO_NMT_initCallbackPre(CO->NMT, NULL, CO_mainlineWake);
+#endif
+#if (CO_CONFIG_EM) & CO_CONFIG_FLAG_CALLBACK_PRE
+      CO_EM_initCallbackPre(CO->em, NULL, CO_mainlineWake);
+#endif
+#if ((CO_CONFIG_HB_CONS) & CO_CONFIG_HB_CONS_ENABLE) && ((CO_CONFIG_HB_CONS) & CO_CONFIG_FLAG_CALLBACK_PRE)
+      CO_HBconsumer_initCallbackPre(CO->HBcons, NULL, CO_mainlineWake);
+#endif
+#if (CO_CONFIG_SDO_SRV) & CO_CONFIG_FLAG_CALLBACK_PRE
+      CO_SDOserver_initCallbackPre(&CO->SDOserver[0], NULL, CO_mainlineWake);
+#endif
+#if ((CO_CONFIG_SYNC) & CO_CONFIG_SYNC_ENABLE) && ((CO_CONFIG_SYNC) & CO_CONFIG_FLAG_CALLBACK_PRE)
+      CO_SYNC_initCallbackPre(CO->SYNC, NULL, CANopen_tmrWake);
+#endif
+#if ((CO_CONFIG_PDO) & CO_CONFIG_RPDO_ENABLE) && ((CO_CONFIG_RPDO) & CO_CONFIG_FLAG_CALLBACK_PRE)
+      for (uint16_t i = 0; i < CO_GET_CNT(RPDO); i++) {
+        CO_RPDO_initCallbackPre(&CO->RPDO[i], NULL, CANopen_tmrWake);
+      }
+#endif
       /* Storage disabled - OD doesn't have 0x1010/0x1011 objects
 #if (CO_CONFIG_STORAGE) & CO_CONFIG_STORAGE_ENABLE
       if (storageInitError != 0) {
@@ -174,14 +224,32 @@ void CANopenTask(void *parameters) {
 
     log_printf("CANopenNode - Running...\n");
 
+    TickType_t lastRun = xTaskGetTickCount();
+    bool lateReported = false;
     while (reset == CO_RESET_NOT) {
       /* loop for normal program execution
        * ******************************************/
+      DeadlineMonitor::Report(DEADLINE_CANOPEN);
+
       /* get time difference since last function call */
-      uint32_t timeDifference_us = 500;
+      TickType_t now = xTaskGetTickCount();
+      uint32_t timeDifference_us = (now - lastRun) * portTICK_PERIOD_MS * 1000U;
+      lastRun = now;
+      uint32_t timerNext_us = CO_MAX_SLEEP_US;
+
+      /* Early warning: a task missed its deadline, the watchdog resets the
+       * MCU if it stays late. Info code is the late mask of DeadlineMonitor */
+      uint16_t lateMask = DeadlineMonitor::GetLateMask();
+      if (lateMask != 0 && !lateReported) {
+        CO_errorReport(CO->em, CO_EM_GENERIC_SOFTWARE_ERROR, CO_EMC_SOFTWARE_INTERNAL, lateMask);
+        lateReported = true;
+      } else if (lateMask == 0 && lateReported) {
+        CO_errorReset(CO->em, CO_EM_GENERIC_SOFTWARE_ERROR, 0);
+        lateReported = false;
+      }
 
       /* CANopen process */
-      reset = CO_process(CO, false, timeDifference_us, NULL);
+      reset = CO_process(CO, false, timeDifference_us, &timerNext_us);
       LED_red = CO_LED_RED(CO->LEDs, CO_LED_CANopen);
       LED_green = CO_LED_GREEN(CO->LEDs, CO_LED_CANopen);
 
@@ -189,13 +257,15 @@ void CANopenTask(void *parameters) {
 
       /* Process automatic storage */
 
-      /* optional sleep for short time */
+      /* Sleep until the next CANopenNode timer, or until CO_mainlineWake */
+      ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS((timerNext_us + 999U) / 1000U));
     }
   }
 
   /* program exit
    * ***************************************************************/
   /* stop threads */
+  DeadlineMonitor::Release(DEADLINE_CANOPEN);
 
   /* delete objects from memory */
   CO_CANsetConfigurationMode((void *)&CANptr);
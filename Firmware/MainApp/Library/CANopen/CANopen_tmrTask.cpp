@@ -1,35 +1,70 @@
 #include "CANopen_tmrTask.h"
+#include "ODExtensions.h"
+#include "DigitalInputCapture.h"
+#include "PowerManager.h"
+#include "DeadlineMonitor.h"
+
+#define CO_TMR_MAX_SLEEP_US 100000U /* longest wait, timerNext_us and debouncing only shorten it */
 
 static volatile uint32_t CO_timer1ms = 0;
+static TaskHandle_t tmrTaskHandle = NULL;
+
+void CANopen_tmrWake(void *object) {
+  (void)object;
+  PowerManager::Wake(tmrTaskHandle);
+}
 
-/* timer thread executes in constant intervals ********************************/
+/* timer thread: runs when a SYNC/RPDO arrives, an input changes or a timer is due */
 void CANopen_tmrTask(void *parameters) {
-    TickType_t lastWake = xTaskGetTickCount();
+    tmrTaskHandle = xTaskGetCurrentTaskHandle();
+    DigitalInputCapture::SetWakeTask(tmrTaskHandle);
+
+    TickType_t lastRun = xTaskGetTickCount();
     for (;;) {
+      DeadlineMonitor::Report(DEADLINE_CANOPEN_TMR);
+      TickType_t now = xTaskGetTickCount();
+      uint32_t elapsed_ms = (now - lastRun) * portTICK_PERIOD_MS;
+      lastRun = now;
+      uint32_t timerNext_us = CO_TMR_MAX_SLEEP_US;
+
+      /* Debounce digital inputs, independent of CAN state */
+      DigitalInputCapture::Changes_t diChanges = DigitalInputCapture::Process(now);
+
       if (CO != NULL && CO->CANmodule != NULL) {
         CO_LOCK_OD(CO->CANmodule);
         if (!CO->nodeIdUnconfigured && CO->CANmodule->CANnormal) {
           bool_t syncWas = false;
+
+          if (diChanges.state_changed || diChanges.counter_changed) {
+            ODExtensions::NotifyDigitalInputs(diChanges.state_changed, diChanges.counter_changed);
+          }
           /* get time difference since last function call */
-          uint32_t timeDifference_us = 1000;
-  
+          uint32_t timeDifference_us = elapsed_ms * 1000U;
+
   #if (CO_CONFIG_SYNC) & CO_CONFIG_SYNC_ENABLE
-          syncWas = CO_process_SYNC(CO, timeDifference_us, NULL);
+          syncWas = CO_process_SYNC(CO, timeDifference_us, &timerNext_us);
   #endif
   #if (CO_CONFIG_PDO) & CO_CONFIG_RPDO_ENABLE
-          CO_process_RPDO(CO, syncWas, timeDifference_us, NULL);
+          CO_process_RPDO(CO, syncWas, timeDifference_us, &timerNext_us);
   #endif
   #if (CO_CONFIG_PDO) & CO_CONFIG_TPDO_ENABLE
-          CO_process_TPDO(CO, syncWas, timeDifference_us, NULL);
+          CO_process_TPDO(CO, syncWas, timeDifference_us, &timerNext_us);
   #endif
-  
+
           /* Further I/O or nonblocking application code may go here. */
         }
         CO_UNLOCK_OD(CO->CANmodule);
       }
-  
-      CO_timer1ms++; // increments every 1 ms
-  
-      vTaskDelayUntil(&lastWake, pdMS_TO_TICKS(1)); // 1 ms period
+
+      CO_timer1ms += elapsed_ms; // milliseconds since start
+
+      /* Sleep until the next PDO/SYNC timer or debounce deadline; CANopen_tmrWake
+       * and the input edge interrupt end the wait early */
+      TickType_t wait = pdMS_TO_TICKS((timerNext_us + 999U) / 1000U);
+      uint32_t debounce_ms = DigitalInputCapture::NextDeadlineMs(now);
+      if (debounce_ms != UINT32_MAX && pdMS_TO_TICKS(debounce_ms) < wait) {
+        wait = pdMS_TO_TICKS(debounce_ms);
+      }
+      ulTaskNotifyTake(pdTRUE, wait);
     }
-  }
\ No newline at end of file
+  }
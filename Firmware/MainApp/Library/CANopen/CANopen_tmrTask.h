@@ -8,4 +8,7 @@
 
 void CANopen_tmrTask(void *parameters);
 
+/* Pre-callback of SYNC and RPDO objects: wakes CANopen_tmrTask (task or interrupt context) */
+void CANopen_tmrWake(void *object);
+
 #endif
\ No newline at end of file
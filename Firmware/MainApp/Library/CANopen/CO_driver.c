@@ -28,6 +28,7 @@
 #include "at32f403a_407_can.h"
 #include "can_driver.h"
 #include "MyMath.h"
+#include "TaskProfiler.h"
 #include <string.h>
 
 /* TODO overview (FuncName | IsItCompleted)
@@ -484,6 +485,7 @@ typedef struct {
  *                   being processed.
  */
 void CO_CANinterrupt(CO_CANmodule_t *CANmodule) {
+  ProfilerIsrFrame profile = TaskProfiler_IsrEnter();
   can_type *can = (can_type *)CANmodule->CANptr;
 
   /* receive interrupt */
@@ -614,4 +616,6 @@ void CO_CANinterrupt(CO_CANmodule_t *CANmodule) {
     /* Clear error interrupt flag */
     can_flag_clear(can, CAN_EOIF_FLAG);
   }
+
+  TaskProfiler_IsrExit(PROFILER_ISR_CAN, profile);
 }
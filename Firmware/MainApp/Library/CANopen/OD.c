@@ -298,6 +298,7 @@ typedef struct {
     OD_obj_record_t o_2302_TRIAC[4];
     OD_obj_var_t o_2400_configureAmountOfExtraAnalogOutputs0242OnlyBTerminals;
     OD_obj_record_t o_2401_AI_ConfigurationAnalogInputDOL12OrDigitalInput[8];
+    OD_obj_var_t o_2500_taskProfile;
     OD_obj_array_t o_6100_digitalInput;
     OD_obj_array_t o_6106_interruptMaskAnyChange;
     OD_obj_array_t o_6300_relayOutput;
@@ -1373,6 +1374,11 @@ static CO_PROGMEM ODObjs_t ODObjs = {
             .dataLength = 1
         }
     },
+    .o_2500_taskProfile = {
+        .dataOrig = NULL,
+        .attribute = ODA_SDO_R,
+        .dataLength = 0
+    },
     .o_6100_digitalInput = {
         .dataOrig0 = &OD_RAM.x6100_digitalInput_sub0,
         .dataOrig = NULL,
@@ -1475,6 +1481,7 @@ static OD_ATTR_OD OD_entry_t ODList[] = {
     {0x2302, 0x04, ODT_REC, &ODObjs.o_2302_TRIAC, NULL},
     {0x2400, 0x01, ODT_VAR, &ODObjs.o_2400_configureAmountOfExtraAnalogOutputs0242OnlyBTerminals, NULL},
     {0x2401, 0x08, ODT_REC, &ODObjs.o_2401_AI_ConfigurationAnalogInputDOL12OrDigitalInput, NULL},
+    {0x2500, 0x01, ODT_VAR, &ODObjs.o_2500_taskProfile, NULL},
     {0x6100, 0x0D, ODT_ARR, &ODObjs.o_6100_digitalInput, NULL},
     {0x6106, 0x04, ODT_ARR, &ODObjs.o_6106_interruptMaskAnyChange, NULL},
     {0x6300, 0x02, ODT_ARR, &ODObjs.o_6300_relayOutput, NULL},
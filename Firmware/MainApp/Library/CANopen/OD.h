@@ -363,12 +363,13 @@ extern OD_ATTR_OD OD_t *OD;
 #define OD_ENTRY_H2302 &OD->list[44]
 #define OD_ENTRY_H2400 &OD->list[45]
 #define OD_ENTRY_H2401 &OD->list[46]
-#define OD_ENTRY_H6100 &OD->list[47]
-#define OD_ENTRY_H6106 &OD->list[48]
-#define OD_ENTRY_H6300 &OD->list[49]
-#define OD_ENTRY_H6401 &OD->list[50]
-#define OD_ENTRY_H6411 &OD->list[51]
-#define OD_ENTRY_H6426 &OD->list[52]
+#define OD_ENTRY_H2500 &OD->list[47]
+#define OD_ENTRY_H6100 &OD->list[48]
+#define OD_ENTRY_H6106 &OD->list[49]
+#define OD_ENTRY_H6300 &OD->list[50]
+#define OD_ENTRY_H6401 &OD->list[51]
+#define OD_ENTRY_H6411 &OD->list[52]
+#define OD_ENTRY_H6426 &OD->list[53]
 
 
 /*******************************************************************************
@@ -421,12 +422,13 @@ extern OD_ATTR_OD OD_t *OD;
 #define OD_ENTRY_H2302_TRIAC &OD->list[44]
 #define OD_ENTRY_H2400_configureAmountOfExtraAnalogOutputs0242OnlyBTerminals &OD->list[45]
 #define OD_ENTRY_H2401_AI_ConfigurationAnalogInputDOL12OrDigitalInput &OD->list[46]
-#define OD_ENTRY_H6100_digitalInput &OD->list[47]
-#define OD_ENTRY_H6106_interruptMaskAnyChange &OD->list[48]
-#define OD_ENTRY_H6300_relayOutput &OD->list[49]
-#define OD_ENTRY_H6401_analogInputs &OD->list[50]
-#define OD_ENTRY_H6411_analogOutput &OD->list[51]
-#define OD_ENTRY_H6426_analogInputInterruptDeltaUnsigned &OD->list[52]
+#define OD_ENTRY_H2500_taskProfile &OD->list[47]
+#define OD_ENTRY_H6100_digitalInput &OD->list[48]
+#define OD_ENTRY_H6106_interruptMaskAnyChange &OD->list[49]
+#define OD_ENTRY_H6300_relayOutput &OD->list[50]
+#define OD_ENTRY_H6401_analogInputs &OD->list[51]
+#define OD_ENTRY_H6411_analogOutput &OD->list[52]
+#define OD_ENTRY_H6426_analogInputInterruptDeltaUnsigned &OD->list[53]
 
 
 /*******************************************************************************
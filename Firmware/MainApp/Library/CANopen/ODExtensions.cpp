@@ -0,0 +1,212 @@
+#include "ODExtensions.h"
+#include "DigitalInputCapture.h"
+#include "MainsSync.h"
+#include "TriacControl.h"
+#include "P-Block-struct.h"
+#include "TaskProfiler.h"
+#include <string.h>
+
+#define OD_6100_SUB_STATES     1U
+#define OD_6100_SUB_COUNTER1   2U
+#define OD_2302_SUB_NET_PERIOD 3U
+#define OD_6300_RELAY_MASK     0x0FFFU
+
+static OD_extension_t ext_6100;
+static OD_extension_t ext_2302;
+static OD_extension_t ext_6411;
+static OD_extension_t ext_6300;
+static OD_extension_t ext_2500;
+
+static TaskProfileSnapshot profile_2500; /* kept across the segments of one upload */
+
+/* 0x6100 digital inputs: sub1 debounced states, sub2..12 pulse counters ******/
+static ODR_t read_6100(OD_stream_t *stream, void *buf, OD_size_t count,
+                       OD_size_t *countRead) {
+  if (stream == NULL || buf == NULL || countRead == NULL) {
+    return ODR_DEV_INCOMPAT;
+  }
+  if (stream->subIndex == 0) {
+    return OD_readOriginal(stream, buf, count, countRead);
+  }
+  if (count < sizeof(uint16_t)) {
+    return ODR_DEV_INCOMPAT;
+  }
+
+  uint16_t value;
+  if (stream->subIndex == OD_6100_SUB_STATES) {
+    value = DigitalInputCapture::GetStates();
+  } else if (stream->subIndex < OD_6100_SUB_COUNTER1 + DI_CAPTURE_INPUTS) {
+    /* SKOV counters are 16 bit and wrap, low half of the 32-bit counter */
+    uint8_t input = stream->subIndex - OD_6100_SUB_COUNTER1 + 1;
+    value = (uint16_t)DigitalInputCapture::GetCounter(input);
+  } else {
+    return ODR_SUB_NOT_EXIST;
+  }
+
+  CO_setUint16(buf, value);
+  *countRead = sizeof(uint16_t);
+  return ODR_OK;
+}
+
+/* 0x2302 TRIAC: sub1-2 setpoints in OD_RAM, sub3 measured mains period *****/
+static ODR_t read_2302(OD_stream_t *stream, void *buf, OD_size_t count,
+                       OD_size_t *countRead) {
+  if (stream == NULL || buf == NULL || countRead == NULL) {
+    return ODR_DEV_INCOMPAT;
+  }
+  if (stream->subIndex != OD_2302_SUB_NET_PERIOD) {
+    return OD_readOriginal(stream, buf, count, countRead);
+  }
+  if (count < sizeof(uint16_t)) {
+    return ODR_DEV_INCOMPAT;
+  }
+
+  CO_setUint16(buf, MainsSync::GetPeriodUs());
+  *countRead = sizeof(uint16_t);
+  return ODR_OK;
+}
+
+static ODR_t write_2302(OD_stream_t *stream, const void *buf, OD_size_t count,
+                        OD_size_t *countWritten) {
+  if (stream == NULL || buf == NULL || countWritten == NULL) {
+    return ODR_DEV_INCOMPAT;
+  }
+  ODR_t ret = OD_writeOriginal(stream, buf, count, countWritten);
+
+  /* SDO and RPDO 3 setpoints take effect at the next zero crossing */
+  if (ret == ODR_OK) {
+    if (stream->subIndex == 1) {
+      TriacControl::SetOnTime(1, OD_RAM.x2302_TRIAC.TRIAC1ON_Time);
+    } else if (stream->subIndex == 2) {
+      TriacControl::SetOnTime(2, OD_RAM.x2302_TRIAC.TRIAC2ON_Time);
+    }
+  }
+  return ret;
+}
+
+/* 0x6411 analog outputs: one setpoint store shared with Modbus ***************/
+static ODR_t read_6411(OD_stream_t *stream, void *buf, OD_size_t count,
+                       OD_size_t *countRead) {
+  if (stream == NULL || buf == NULL || countRead == NULL) {
+    return ODR_DEV_INCOMPAT;
+  }
+  if (stream->subIndex == 0) {
+    return OD_readOriginal(stream, buf, count, countRead);
+  }
+  if (count < sizeof(uint16_t)) {
+    return ODR_DEV_INCOMPAT;
+  }
+
+  CO_setUint16(buf, PBlockRegisters_t::GetAnalogOutput(stream->subIndex));
+  *countRead = sizeof(uint16_t);
+  return ODR_OK;
+}
+
+static ODR_t write_6411(OD_stream_t *stream, const void *buf, OD_size_t count,
+                        OD_size_t *countWritten) {
+  if (stream == NULL || buf == NULL || countWritten == NULL) {
+    return ODR_DEV_INCOMPAT;
+  }
+  ODR_t ret = OD_writeOriginal(stream, buf, count, countWritten);
+
+  /* Store only, the output engine applies all pending setpoints once per cycle */
+  if (ret == ODR_OK && stream->subIndex >= 1 && stream->subIndex <= OD_CNT_ARR_6411) {
+    int16_t mv = OD_RAM.x6411_analogOutput[stream->subIndex - 1];
+    PBlockRegisters_t::SetAnalogOutput(stream->subIndex, mv < 0 ? 0 : (uint16_t)mv);
+  }
+  return ret;
+}
+
+/* 0x6300 relay outputs: RPDO 0 bits 0-11 -> relays 1-12 in one store ******/
+static ODR_t write_6300(OD_stream_t *stream, const void *buf, OD_size_t count,
+                        OD_size_t *countWritten) {
+  if (stream == NULL || buf == NULL || countWritten == NULL) {
+    return ODR_DEV_INCOMPAT;
+  }
+  ODR_t ret = OD_writeOriginal(stream, buf, count, countWritten);
+
+  /* Emergency relay (bit 12) is not part of the SKOV object and keeps its state */
+  if (ret == ODR_OK && stream->subIndex == 1) {
+    PBlockRegisters_t::SetRelayMask(OD_6300_RELAY_MASK, OD_RAM.x6300_relayOutput[0]);
+  }
+  return ret;
+}
+
+/* 0x2500 task profile: TaskProfileSnapshot as a domain, segmented SDO upload */
+static ODR_t read_2500(OD_stream_t *stream, void *buf, OD_size_t count,
+                       OD_size_t *countRead) {
+  if (stream == NULL || buf == NULL || countRead == NULL) {
+    return ODR_DEV_INCOMPAT;
+  }
+
+  /* A new upload starts at offset 0 and takes a fresh snapshot */
+  if (stream->dataOffset == 0) {
+    TaskProfiler::Snapshot(profile_2500);
+    stream->dataLength = sizeof(profile_2500);
+  }
+  if (stream->dataOffset >= sizeof(profile_2500)) {
+    return ODR_DEV_INCOMPAT;
+  }
+
+  OD_size_t left = sizeof(profile_2500) - stream->dataOffset;
+  OD_size_t size = count < left ? count : left;
+  memcpy(buf, (const uint8_t *)&profile_2500 + stream->dataOffset, size);
+  *countRead = size;
+
+  if (size < left) {
+    stream->dataOffset += size;
+    return ODR_PARTIAL;
+  }
+  stream->dataOffset = 0;
+  return ODR_OK;
+}
+
+void ODExtensions::Init(void) {
+  ext_6100.object = NULL;
+  ext_6100.read = read_6100;
+  ext_6100.write = NULL;
+  OD_extension_init(OD_ENTRY_H6100_digitalInput, &ext_6100);
+
+  ext_2302.object = NULL;
+  ext_2302.read = read_2302;
+  ext_2302.write = write_2302;
+  OD_extension_init(OD_ENTRY_H2302_TRIAC, &ext_2302);
+  TriacControl::SetOnTime(1, OD_RAM.x2302_TRIAC.TRIAC1ON_Time);
+  TriacControl::SetOnTime(2, OD_RAM.x2302_TRIAC.TRIAC2ON_Time);
+
+  ext_6411.object = NULL;
+  ext_6411.read = read_6411;
+  ext_6411.write = write_6411;
+  OD_extension_init(OD_ENTRY_H6411_analogOutput, &ext_6411);
+
+  ext_6300.object = NULL;
+  ext_6300.read = OD_readOriginal;
+  ext_6300.write = write_6300;
+  OD_extension_init(OD_ENTRY_H6300_relayOutput, &ext_6300);
+
+  ext_2500.object = NULL;
+  ext_2500.read = read_2500;
+  ext_2500.write = NULL;
+  OD_extension_init(OD_ENTRY_H2500_taskProfile, &ext_2500);
+}
+
+void ODExtensions::NotifyDigitalInputs(uint16_t state_changed, uint16_t counter_changed) {
+  uint8_t *flagsPDO = OD_getFlagsPDO(OD_ENTRY_H6100_digitalInput);
+  if (flagsPDO == NULL) {
+    return;
+  }
+
+  /* 0x6106:01 enables DI0-7, 0x6106:02 enables DI8-11 */
+  uint16_t mask = (OD_RAM.x6106_interruptMaskAnyChange[0] & 0x00FFU)
+                | ((OD_RAM.x6106_interruptMaskAnyChange[1] & 0x000FU) << 8);
+
+  if (state_changed & mask) {
+    OD_requestTPDO(flagsPDO, OD_6100_SUB_STATES);
+  }
+
+  while (counter_changed) {
+    uint8_t index = (uint8_t)__builtin_ctz(counter_changed);
+    counter_changed &= counter_changed - 1;
+    OD_requestTPDO(flagsPDO, OD_6100_SUB_COUNTER1 + index);
+  }
+}
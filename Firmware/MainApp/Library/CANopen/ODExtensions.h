@@ -0,0 +1,30 @@
+#ifndef _OD_EXTENSIONS_H_
+#define _OD_EXTENSIONS_H_
+
+#include <stdint.h>
+#include "CANopenTask.h"
+
+/**
+ * @brief Object dictionary entries served by application code
+ * Entries without dataOrig in OD.c (process values produced by drivers) get
+ * read/write callbacks here. Event-driven TPDOs are requested from the
+ * producers through the Notify* functions.
+ */
+class ODExtensions {
+public:
+  /**
+   * @brief Register OD extensions
+   * Must be called after CO_CANopenInit() and before CO_CANopenInitPDO().
+   */
+  static void Init(void);
+
+  /**
+   * @brief Request event TPDOs for changed digital inputs (0x6100)
+   * Honours the change masks in 0x6106. Call with the OD locked.
+   * @param state_changed Inputs whose debounced state changed (bit 0 = DI0)
+   * @param counter_changed Inputs whose pulse counter changed
+   */
+  static void NotifyDigitalInputs(uint16_t state_changed, uint16_t counter_changed);
+};
+
+#endif
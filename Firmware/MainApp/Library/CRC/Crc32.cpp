@@ -0,0 +1,35 @@
+#include "Crc32.h"
+
+namespace {
+
+struct Crc32Table {
+    uint32_t entry[256];
+};
+
+constexpr Crc32Table MakeCrc32Table(void) {
+    Crc32Table table{};
+    for (uint32_t i = 0; i < 256; i++) {
+        uint32_t c = i;
+        for (int bit = 0; bit < 8; bit++) {
+            c = (c & 1U) ? (0xEDB88320U ^ (c >> 1)) : (c >> 1);
+        }
+        table.entry[i] = c;
+    }
+    return table;
+}
+
+// Placed in flash, computed by the compiler
+constexpr Crc32Table crc32_table = MakeCrc32Table();
+
+static_assert(crc32_table.entry[1] == 0x77073096U, "CRC-32 table");
+static_assert(crc32_table.entry[255] == 0x2D02EF8DU, "CRC-32 table");
+
+}  // namespace
+
+uint32_t Crc32Update(uint32_t crc, const void *data, size_t size) {
+    const uint8_t *p = static_cast<const uint8_t *>(data);
+    while (size--) {
+        crc = crc32_table.entry[(crc ^ *p++) & 0xFFU] ^ (crc >> 8);
+    }
+    return crc;
+}
@@ -0,0 +1,37 @@
+#ifndef __CRC32_H__
+#define __CRC32_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define CRC32_INIT                  (0xFFFFFFFFU)
+
+/**
+ * @brief CRC-32 (IEEE 802.3, reflected, poly 0xEDB88320)
+ * Same parameters as zlib/Python binascii.crc32, so host tools can check
+ * records without a custom implementation.
+ */
+
+/**
+ * @brief Continue a running CRC over more data
+ * @param crc Value returned by the previous call, CRC32_INIT for the first block
+ * @param data Data to add
+ * @param size Data size in bytes
+ * @return Running CRC (pass to Crc32Final when done)
+ */
+uint32_t Crc32Update(uint32_t crc, const void *data, size_t size);
+
+/**
+ * @brief Finish a running CRC
+ */
+static inline uint32_t Crc32Final(uint32_t crc) { return crc ^ 0xFFFFFFFFU; }
+
+/**
+ * @brief CRC-32 of one buffer
+ */
+static inline uint32_t Crc32(const void *data, size_t size)
+{
+    return Crc32Final(Crc32Update(CRC32_INIT, data, size));
+}
+
+#endif // __CRC32_H__
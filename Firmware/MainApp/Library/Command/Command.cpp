@@ -1,48 +1,87 @@
 #include "Command.h"
 #include "Structs.h"
 #include "rtc_module.h"
-
-CMD_Map_t cmdMap[] = {
-    // Application identification
-    {REQUEST_COM_PREFIX, 0x10, 3, WhatAppIsIt_cmd, MAP_FLGS(0x0, 0x0)},
-    {REQUEST_COM_PREFIX, 0x11, 3, GetMainAppVersion_cmd, MAP_FLGS(0x0, 0x0)},
-
-    // Time commands
-    {REQUEST_COM_PREFIX, 0x30, 3, GetCurrentTimeMs_cmd, MAP_FLGS(0x0, 0x0)},
-    {REQUEST_COM_PREFIX, 0x31, 3, GetCurrentTimeS_cmd, MAP_FLGS(0x0, 0x0)},
-    {REQUEST_COM_PREFIX, 0x32, 3, GetRtcTime_cmd, MAP_FLGS(0x0, 0x0)},
-    {REQUEST_COM_PREFIX, 0x33, 11, SetRtcTime_cmd, MAP_FLGS(0x0, 0x0)},
-
-    // UART control
-    {REQUEST_COM_PREFIX, 0x34, 4, SetWorkWithUart_cmd, MAP_FLGS(0x0, 0x0)},
-
-    // Serial number and assembly
-    {REQUEST_COM_PREFIX, 0x48, 3, GetSerialNum_cmd, MAP_FLGS(0x0, 0x0)},
-    {REQUEST_COM_PREFIX, 0x49, 11, SetSerialNum_cmd, MAP_FLGS(0x0, 0x0)},
-    {REQUEST_COM_PREFIX, 0x4A, 3, GetAssemblyDate_cmd, MAP_FLGS(0x0, 0x0)},
-    {REQUEST_COM_PREFIX, 0x4B, 11, SetAssemblyDate_cmd, MAP_FLGS(0x0, 0x0)},
-
-    // Frequency and error count
-    {REQUEST_COM_PREFIX, 0x4C, 3, GetFrequency_cmd, MAP_FLGS(0x0, 0x0)},
-    {REQUEST_COM_PREFIX, 0x4D, 7, SetFrequency_cmd, MAP_FLGS(0x0, 0x0)},
-    {REQUEST_COM_PREFIX, 0x4E, 3, GetErrCnt_cmd, MAP_FLGS(0x0, 0x0)},
-
-    // Cache/handled items management
-    {REQUEST_COM_PREFIX, 0x50, 3, GetCacheSize_cmd, MAP_FLGS(0x0, 0x0)},
-    {REQUEST_COM_PREFIX, 0x51, 3, GetHandledSize_cmd, MAP_FLGS(0x0, 0x0)},
-    {REQUEST_COM_PREFIX, 0x52, 7, GetSerialByNum_cmd, MAP_FLGS(0x0, 0x0)},
-    {REQUEST_COM_PREFIX, 0x53, 11, AddSerialToHandled_cmd, MAP_FLGS(0x0, 0x0)},
-    {REQUEST_COM_PREFIX, 0x54, 11, RemoveSerialAsHandled_cmd, MAP_FLGS(0x0, 0x0)},
-    {REQUEST_COM_PREFIX, 0x55, 3, SaveHandledItems_cmd, MAP_FLGS(0x0, 0x0)},
-    {REQUEST_COM_PREFIX, 0x56, 7, GetMetricsBySerialNum_cmd, MAP_FLGS(0x0, 0x0)},
-    {REQUEST_COM_PREFIX, 0x57, 3, ClearHandledList_cmd, MAP_FLGS(0x0, 0x0)},
-
-    // Reset command
-    {REQUEST_COM_PREFIX, 0xFF, 3, Reset_cmd, MAP_FLGS(0x0, 0x0)},
-};
+#include "PBlockConfig.h"
+#include "StorageFlush.h"
+#include "ErrorLog.h"
+#include "TrendLogger.h"
+#include "TrendStream.h"
+#include "BootProfile.h"
+#include "TaskProfiler.h"
+#include "PowerManager.h"
+#include "DeadlineMonitor.h"
+
+#define TREND_READ_CHUNK (128U) // same payload size as the bootloader data packet
+#define PROFILE_READ_CHUNK (128U)
+
+// Command code, packet length and handler; cmdMap and the duplicate check below are generated from this list
+#define COMMAND_LIST(X)                         \
+    /* Application identification */            \
+    X(0x10, 3, WhatAppIsIt_cmd)                 \
+    X(0x11, 3, GetMainAppVersion_cmd)           \
+    /* Time commands */                         \
+    X(0x30, 3, GetCurrentTimeMs_cmd)            \
+    X(0x31, 3, GetCurrentTimeS_cmd)             \
+    X(0x32, 3, GetRtcTime_cmd)                  \
+    X(0x33, 11, SetRtcTime_cmd)                 \
+    /* UART control */                          \
+    X(0x34, 4, SetWorkWithUart_cmd)             \
+    /* Serial number and assembly */            \
+    X(0x48, 3, GetSerialNum_cmd)                \
+    X(0x49, 11, SetSerialNum_cmd)               \
+    X(0x4A, 3, GetAssemblyDate_cmd)             \
+    X(0x4B, 11, SetAssemblyDate_cmd)            \
+    /* Frequency and error count */             \
+    X(0x4C, 3, GetFrequency_cmd)                \
+    X(0x4D, 7, SetFrequency_cmd)                \
+    X(0x4E, 3, GetErrCnt_cmd)                   \
+    /* Trend log download */                    \
+    X(0x50, 3, GetTrendInfo_cmd)                \
+    X(0x51, 3, GetTrendPeriod_cmd)              \
+    X(0x52, 5, SetTrendPeriod_cmd)              \
+    X(0x53, 7, FindTrendBlock_cmd)              \
+    X(0x54, 9, ReadTrendBlock_cmd)              \
+    X(0x55, 3, CloseTrendBlock_cmd)             \
+    X(0x56, 3, GetTrendLastSample_cmd)          \
+    /* Bootloader start-up profile */           \
+    X(0x57, 3, GetBootProfile_cmd)              \
+    /* Runtime task profile */                  \
+    X(0x58, 5, GetTaskProfile_cmd)              \
+    /* Tickless idle statistics */              \
+    X(0x59, 3, GetPowerStats_cmd)               \
+    /* Task deadline histograms */              \
+    X(0x5A, 4, GetDeadlineStats_cmd)            \
+    /* Trend log stream */                      \
+    X(0x5B, 9, StreamTrend_cmd)                 \
+    /* Reset command */                         \
+    X(0xFF, 3, Reset_cmd)
+
+#define COMMAND_MAP_ENTRY(code, length, handler) {REQUEST_COM_PREFIX, code, length, handler, MAP_FLGS(0x0, 0x0)},
+#define COMMAND_CODE(code, length, handler) code,
+
+CMD_Map_t cmdMap[] = {COMMAND_LIST(COMMAND_MAP_ENTRY)};
 
 uint32_t command_amount = (sizeof(cmdMap) / sizeof(CMD_Map_t));
 
+static constexpr uint8_t command_codes_[] = {COMMAND_LIST(COMMAND_CODE)};
+
+static constexpr bool command_codes_unique(void)
+{
+    for (uint32_t i = 0; i < sizeof(command_codes_); i++)
+    {
+        for (uint32_t j = i + 1; j < sizeof(command_codes_); j++)
+        {
+            if (command_codes_[i] == command_codes_[j])
+            {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+static_assert(command_codes_unique(), "two commands share a code, the second would never run");
+
 // Command implementations
 
 bool WhatAppIsIt_cmd(uint8_t* buff)
@@ -147,75 +186,165 @@ bool SetFrequency_cmd(uint8_t* buff)
 
 bool GetErrCnt_cmd(uint8_t* buff)
 {
-    // TODO: Implement Error Count retrieval
-    uint32_t errCnt = 0;
+    uint32_t errCnt = ErrorLog::GetCount();
     CmdHandler.SetResponce(SUCCESS_CS, &errCnt, sizeof(errCnt));
     return true;
 }
 
-bool GetCacheSize_cmd(uint8_t* buff)
+bool GetTrendInfo_cmd(uint8_t* buff)
 {
-    // TODO: Implement Cache Size retrieval
-    uint32_t cacheSize = 0;
-    CmdHandler.SetResponce(SUCCESS_CS, &cacheSize, sizeof(cacheSize));
+    TrendInfo info;
+    TrendLogger::GetInfo(info);
+    CmdHandler.SetResponce(SUCCESS_CS, &info, sizeof(info));
     return true;
 }
 
-bool GetHandledSize_cmd(uint8_t* buff)
+bool GetTrendPeriod_cmd(uint8_t* buff)
 {
-    // TODO: Implement Handled Size retrieval
-    uint32_t handledSize = 0;
-    CmdHandler.SetResponce(SUCCESS_CS, &handledSize, sizeof(handledSize));
+    uint16_t period = TrendLogger::GetPeriod();
+    CmdHandler.SetResponce(SUCCESS_CS, &period, sizeof(period));
     return true;
 }
 
-bool GetSerialByNum_cmd(uint8_t* buff)
+bool SetTrendPeriod_cmd(uint8_t* buff)
 {
-    // TODO: Implement Get Serial By Number
-    uint32_t serialNum = 0;
-    CmdHandler.SetResponce(SUCCESS_CS, &serialNum, sizeof(serialNum));
+    uint16_t period = *reinterpret_cast<uint16_t*>(buff + COMMAND_PACK_POS);
+    CmdHandler.SetResponce(TrendLogger::SetPeriod(period) ? SUCCESS_CS : ERROR_CS);
     return true;
 }
 
-bool AddSerialToHandled_cmd(uint8_t* buff)
+bool FindTrendBlock_cmd(uint8_t* buff)
 {
-    // TODO: Implement Add Serial To Handled
-    CmdHandler.SetResponce(SUCCESS_CS);
+    uint32_t rtc_time = *reinterpret_cast<uint32_t*>(buff + COMMAND_PACK_POS);
+    uint32_t sequence = TrendLogger::FindBlock(rtc_time);
+    CmdHandler.SetResponce(SUCCESS_CS, &sequence, sizeof(sequence));
     return true;
 }
 
-bool RemoveSerialAsHandled_cmd(uint8_t* buff)
+bool ReadTrendBlock_cmd(uint8_t* buff)
 {
-    // TODO: Implement Remove Serial As Handled
-    CmdHandler.SetResponce(SUCCESS_CS);
+    // A block is read in chunks, the host asks for offsets 0 and TREND_READ_CHUNK
+    uint32_t sequence = *reinterpret_cast<uint32_t*>(buff + COMMAND_PACK_POS);
+    uint16_t offset = *reinterpret_cast<uint16_t*>(buff + COMMAND_PACK_POS + sizeof(sequence));
+
+    if (offset >= TREND_BLOCK_SIZE)
+    {
+        CmdHandler.SetResponce(ERROR_CS);
+        return true;
+    }
+    uint16_t size = TREND_BLOCK_SIZE - offset < TREND_READ_CHUNK ? TREND_BLOCK_SIZE - offset : TREND_READ_CHUNK;
+
+    // Blocks in flash go straight into the response; an erase meanwhile turns it into an error
+    const uint8_t* stored = TrendLogger::StoredBlock(sequence);
+    if (stored != nullptr)
+    {
+        CmdHandler.SetResponce(SUCCESS_CS, stored + offset, size);
+        if (!TrendLogger::IsStored(sequence))
+        {
+            CmdHandler.SetResponce(ERROR_CS);
+        }
+        return true;
+    }
+
+    // Queued and open blocks change under the input task, they are copied out first
+    uint8_t chunk[TREND_READ_CHUNK];
+    if (TrendLogger::ReadBlock(sequence, offset, chunk, size))
+    {
+        CmdHandler.SetResponce(SUCCESS_CS, chunk, size);
+    }
+    else
+    {
+        CmdHandler.SetResponce(ERROR_CS);
+    }
     return true;
 }
 
-bool SaveHandledItems_cmd(uint8_t* buff)
+bool CloseTrendBlock_cmd(uint8_t* buff)
 {
-    // TODO: Implement Save Handled Items
+    TrendLogger::CloseBlock();
     CmdHandler.SetResponce(SUCCESS_CS);
     return true;
 }
 
-bool GetMetricsBySerialNum_cmd(uint8_t* buff)
+bool GetTrendLastSample_cmd(uint8_t* buff)
 {
-    // TODO: Implement Get Metrics By Serial Number
-    uint8_t metrics[64] = {0}; // Example metrics buffer
-    CmdHandler.SetResponce(SUCCESS_CS, metrics, sizeof(metrics));
+    uint16_t values[TREND_CHANNELS];
+    TrendLogger::GetLastSample(values);
+    CmdHandler.SetResponce(SUCCESS_CS, values, sizeof(values));
     return true;
 }
 
-bool ClearHandledList_cmd(uint8_t* buff)
+bool StreamTrend_cmd(uint8_t* buff)
 {
-    // TODO: Implement Clear Handled List
-    CmdHandler.SetResponce(SUCCESS_CS);
+    // The blocks follow the answer back to back, sent by the transport task
+    uint32_t first = *reinterpret_cast<uint32_t*>(buff + COMMAND_PACK_POS);
+    uint16_t count = *reinterpret_cast<uint16_t*>(buff + COMMAND_PACK_POS + sizeof(first));
+    TrendStreamRange range;
+    bool started = TrendStream::Start(first, count, range);
+    CmdHandler.SetResponce(started ? SUCCESS_CS : ERROR_CS, &range, sizeof(range));
+    return true;
+}
+
+bool GetBootProfile_cmd(uint8_t* buff)
+{
+    BootProfileRecord record = BootProfile::Get();
+    CmdHandler.SetResponce(record.marker == BOOT_PROFILE_MARKER ? SUCCESS_CS : ERROR_CS, &record, sizeof(record));
+    return true;
+}
+
+bool GetTaskProfile_cmd(uint8_t* buff)
+{
+    // Read in chunks like a trend block; offset 0 takes the snapshot the later offsets read from
+    static TaskProfileSnapshot snapshot;
+    uint16_t offset = *reinterpret_cast<uint16_t*>(buff + COMMAND_PACK_POS);
+
+    if (offset >= sizeof(snapshot))
+    {
+        CmdHandler.SetResponce(ERROR_CS);
+        return true;
+    }
+    if (offset == 0)
+    {
+        TaskProfiler::Snapshot(snapshot);
+    }
+    uint16_t size = sizeof(snapshot) - offset < PROFILE_READ_CHUNK ? sizeof(snapshot) - offset : PROFILE_READ_CHUNK;
+    CmdHandler.SetResponce(SUCCESS_CS, reinterpret_cast<uint8_t*>(&snapshot) + offset, size);
+    return true;
+}
+
+bool GetPowerStats_cmd(uint8_t* buff)
+{
+    PowerStats stats;
+    PowerManager::GetStats(stats);
+    CmdHandler.SetResponce(SUCCESS_CS, &stats, sizeof(stats));
+    return true;
+}
+
+bool GetDeadlineStats_cmd(uint8_t* buff)
+{
+    // Subject index, DEADLINE_SUBJECTS reads the trip record from before the last reset
+    uint8_t subject = buff[COMMAND_PACK_POS];
+    if (subject == DEADLINE_SUBJECTS)
+    {
+        DeadlineTrip trip = DeadlineMonitor::GetLastTrip();
+        CmdHandler.SetResponce(trip.marker == DEADLINE_TRIP_MARKER ? SUCCESS_CS : ERROR_CS, &trip, sizeof(trip));
+        return true;
+    }
+    DeadlineStats stats;
+    if (!DeadlineMonitor::GetStats(subject, stats))
+    {
+        CmdHandler.SetResponce(ERROR_CS);
+        return true;
+    }
+    CmdHandler.SetResponce(SUCCESS_CS, &stats, sizeof(stats));
     return true;
 }
 
 bool Reset_cmd(uint8_t* buff)
 {
-    // Reset the system
+    // Reset the system, config changes, error log entries and trend blocks still in RAM go first
+    PBlockConfig::Flush();
+    StorageFlush::Flush();
     NVIC_SystemReset();
     return true;
 }
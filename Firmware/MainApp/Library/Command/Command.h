@@ -33,14 +33,18 @@ bool SetFrequency_cmd(uint8_t* buff);
 
 bool GetErrCnt_cmd(uint8_t* buff);
 
-bool GetCacheSize_cmd(uint8_t* buff);
-bool GetHandledSize_cmd(uint8_t* buff);
-bool GetSerialByNum_cmd(uint8_t* buff);
-bool AddSerialToHandled_cmd(uint8_t* buff);
-bool RemoveSerialAsHandled_cmd(uint8_t* buff);
-bool SaveHandledItems_cmd(uint8_t* buff);
-bool GetMetricsBySerialNum_cmd(uint8_t* buff);
-bool ClearHandledList_cmd(uint8_t* buff);
+bool GetTrendInfo_cmd(uint8_t* buff);
+bool GetTrendPeriod_cmd(uint8_t* buff);
+bool SetTrendPeriod_cmd(uint8_t* buff);
+bool FindTrendBlock_cmd(uint8_t* buff);
+bool ReadTrendBlock_cmd(uint8_t* buff);
+bool CloseTrendBlock_cmd(uint8_t* buff);
+bool GetTrendLastSample_cmd(uint8_t* buff);
+bool StreamTrend_cmd(uint8_t* buff);
+bool GetBootProfile_cmd(uint8_t* buff);
+bool GetTaskProfile_cmd(uint8_t* buff);
+bool GetPowerStats_cmd(uint8_t* buff);
+bool GetDeadlineStats_cmd(uint8_t* buff);
 
 bool Reset_cmd(uint8_t* buff);
 
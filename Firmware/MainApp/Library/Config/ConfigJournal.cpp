@@ -0,0 +1,428 @@
+#include "ConfigJournal.h"
+#include "Crc32.h"
+#include "string.h"
+
+#define RECORD_HEADER_SIZE (sizeof(uint32_t))
+#define RECORD_CRC_SIZE (sizeof(uint32_t))
+#define ERASED_WORD (0xFFFFFFFFU)
+
+uint8_t ConfigJournal::active_sector;
+uint32_t ConfigJournal::sequence;
+uint32_t ConfigJournal::write_offset;
+uint16_t ConfigJournal::key_offset[CONFIG_JOURNAL_MAX_KEYS];
+uint16_t ConfigJournal::staged_offset[CONFIG_JOURNAL_MAX_KEYS];
+
+static inline uint32_t PaddedSize(uint16_t size)
+{
+    return (size + 3U) & ~3U;
+}
+
+static inline uint32_t RecordSize(uint16_t size)
+{
+    return RECORD_HEADER_SIZE + PaddedSize(size) + RECORD_CRC_SIZE;
+}
+
+static inline uint32_t ReadWord(uint32_t address)
+{
+    return *reinterpret_cast<const volatile uint32_t *>(address);
+}
+
+static uint32_t RecordCRC(uint32_t header, const void *data, uint16_t size)
+{
+    uint32_t crc = Crc32Update(CRC32_INIT, &header, sizeof(header));
+    return Crc32Final(Crc32Update(crc, data, size));
+}
+
+static bool HasStaged(const uint16_t (&staged)[CONFIG_JOURNAL_MAX_KEYS])
+{
+    for (uint16_t offset : staged)
+    {
+        if (offset != 0)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+/// @brief Space taken by the records listed in a key table
+static uint32_t TableSize(uint32_t base, const uint16_t (&table)[CONFIG_JOURNAL_MAX_KEYS])
+{
+    uint32_t total = 0;
+    for (uint16_t offset : table)
+    {
+        if (offset != 0)
+        {
+            total += RecordSize(static_cast<uint16_t>(ReadWord(base + offset) >> 16));
+        }
+    }
+    return total;
+}
+
+bool ConfigJournal::Init(void)
+{
+    bool found = false;
+
+    for (uint8_t i = 0; i < CONFIG_JOURNAL_SECTORS; i++)
+    {
+        const SectorHeader *header = reinterpret_cast<const SectorHeader *>(SectorAddress(i));
+        if (header->magic != CONFIG_JOURNAL_MAGIC)
+        {
+            continue;
+        }
+        // An interrupted garbage collection leaves two valid sectors, the newer one is complete
+        if (!found || header->sequence > sequence)
+        {
+            found = true;
+            active_sector = i;
+            sequence = header->sequence;
+        }
+    }
+
+    bool ok = true;
+    flash_unlock();
+    if (!found)
+    {
+        active_sector = 0;
+        sequence = 1;
+        ok = Format(active_sector, sequence);
+    }
+    if (ok)
+    {
+        Scan();
+        // A batch cut short by a reset must not be completed by the next commit marker
+        if (HasStaged(staged_offset))
+        {
+            uint16_t offset;
+            AppendRecord(CONFIG_JOURNAL_ABORT_KEY, NULL, 0, offset);
+            memset(staged_offset, 0, sizeof(staged_offset));
+        }
+    }
+    flash_lock();
+
+    return ok;
+}
+
+uint32_t ConfigJournal::SectorAddress(uint8_t sector)
+{
+    return CONFIG_JOURNAL_ADDRESS + sector * FLASH_SECTOR_SIZE;
+}
+
+/// @brief Rebuild the key tables from the records of the active sector
+void ConfigJournal::Scan(void)
+{
+    const uint32_t base = SectorAddress(active_sector);
+    uint32_t offset = sizeof(SectorHeader);
+
+    memset(key_offset, 0, sizeof(key_offset));
+    memset(staged_offset, 0, sizeof(staged_offset));
+
+    while (offset + RECORD_HEADER_SIZE + RECORD_CRC_SIZE <= FLASH_SECTOR_SIZE)
+    {
+        const uint32_t header = ReadWord(base + offset);
+        if (header == ERASED_WORD)
+        {
+            break;
+        }
+
+        const uint16_t header_key = header & 0xFFFFU;
+        const uint16_t size = header >> 16;
+        const uint32_t length = RecordSize(size);
+        if (size > CONFIG_JOURNAL_MAX_VALUE || offset + length > FLASH_SECTOR_SIZE)
+        {
+            // Corrupted tail, the next write moves the live records to a fresh sector
+            offset = FLASH_SECTOR_SIZE;
+            break;
+        }
+
+        const uint8_t *payload = reinterpret_cast<const uint8_t *>(base + offset + RECORD_HEADER_SIZE);
+        const uint32_t crc = ReadWord(base + offset + RECORD_HEADER_SIZE + PaddedSize(size));
+        // Torn records fail the CRC and are skipped, the key keeps its previous value
+        if (crc == RecordCRC(header, payload, size))
+        {
+            const uint16_t key = header_key & ~CONFIG_JOURNAL_STAGED;
+            if (header_key == CONFIG_JOURNAL_COMMIT_KEY)
+            {
+                for (uint16_t k = 0; k < CONFIG_JOURNAL_MAX_KEYS; k++)
+                {
+                    if (staged_offset[k] != 0)
+                    {
+                        key_offset[k] = staged_offset[k];
+                    }
+                }
+                memset(staged_offset, 0, sizeof(staged_offset));
+            }
+            else if (header_key == CONFIG_JOURNAL_ABORT_KEY)
+            {
+                memset(staged_offset, 0, sizeof(staged_offset));
+            }
+            else if (key < CONFIG_JOURNAL_MAX_KEYS)
+            {
+                uint16_t *table = (header_key & CONFIG_JOURNAL_STAGED) ? staged_offset : key_offset;
+                table[key] = static_cast<uint16_t>(offset);
+            }
+        }
+        offset += length;
+    }
+
+    write_offset = offset;
+}
+
+bool ConfigJournal::Contains(uint16_t key)
+{
+    return key < CONFIG_JOURNAL_MAX_KEYS && key_offset[key] != 0;
+}
+
+uint16_t ConfigJournal::GetSize(uint16_t key)
+{
+    if (!Contains(key))
+    {
+        return 0;
+    }
+    return static_cast<uint16_t>(ReadWord(SectorAddress(active_sector) + key_offset[key]) >> 16);
+}
+
+bool ConfigJournal::Read(uint16_t key, void *data, uint16_t size)
+{
+    if (!Contains(key))
+    {
+        return false;
+    }
+
+    const uint32_t record = SectorAddress(active_sector) + key_offset[key];
+    if ((ReadWord(record) >> 16) != size)
+    {
+        return false;
+    }
+
+    memcpy(data, reinterpret_cast<const void *>(record + RECORD_HEADER_SIZE), size);
+    return true;
+}
+
+bool ConfigJournal::IsUnchanged(uint16_t key, const void *data, uint16_t size)
+{
+    if (!Contains(key))
+    {
+        return false;
+    }
+
+    const uint32_t record = SectorAddress(active_sector) + key_offset[key];
+    return (ReadWord(record) >> 16) == size &&
+           memcmp(reinterpret_cast<const void *>(record + RECORD_HEADER_SIZE), data, size) == 0;
+}
+
+bool ConfigJournal::Write(uint16_t key, const void *data, uint16_t size)
+{
+    if (key >= CONFIG_JOURNAL_MAX_KEYS || size > CONFIG_JOURNAL_MAX_VALUE)
+    {
+        return false;
+    }
+    if (IsUnchanged(key, data, size))
+    {
+        return true;
+    }
+
+    uint16_t offset;
+    flash_unlock();
+    bool ok = AppendRecord(key, data, size, offset);
+    flash_lock();
+
+    if (ok)
+    {
+        key_offset[key] = offset;
+    }
+    return ok;
+}
+
+bool ConfigJournal::Stage(uint16_t key, const void *data, uint16_t size)
+{
+    if (key >= CONFIG_JOURNAL_MAX_KEYS || size > CONFIG_JOURNAL_MAX_VALUE)
+    {
+        return false;
+    }
+    if (staged_offset[key] == 0 && IsUnchanged(key, data, size))
+    {
+        return true;
+    }
+
+    uint16_t offset;
+    flash_unlock();
+    bool ok = AppendRecord(key | CONFIG_JOURNAL_STAGED, data, size, offset);
+    flash_lock();
+
+    if (ok)
+    {
+        staged_offset[key] = offset;
+    }
+    return ok;
+}
+
+bool ConfigJournal::Commit(void)
+{
+    if (!HasStaged(staged_offset))
+    {
+        return true;
+    }
+
+    // Garbage collection may run here and move the staged records, so offsets are taken after it
+    uint16_t offset;
+    flash_unlock();
+    bool ok = AppendRecord(CONFIG_JOURNAL_COMMIT_KEY, NULL, 0, offset);
+    flash_lock();
+
+    if (ok)
+    {
+        for (uint16_t k = 0; k < CONFIG_JOURNAL_MAX_KEYS; k++)
+        {
+            if (staged_offset[k] != 0)
+            {
+                key_offset[k] = staged_offset[k];
+            }
+        }
+        memset(staged_offset, 0, sizeof(staged_offset));
+    }
+    return ok;
+}
+
+uint32_t ConfigJournal::GetEraseCount(void)
+{
+    // One erase to format, one per garbage collection
+    return sequence;
+}
+
+uint32_t ConfigJournal::GetFreeBytes(void)
+{
+    return FLASH_SECTOR_SIZE - write_offset;
+}
+
+bool ConfigJournal::Format(uint8_t sector, uint32_t new_sequence)
+{
+    const uint32_t base = SectorAddress(sector);
+
+    return flash_sector_erase(base) == FLASH_OPERATE_DONE &&
+           ProgramWord(base + offsetof(SectorHeader, sequence), new_sequence) &&
+           ProgramWord(base + offsetof(SectorHeader, magic), CONFIG_JOURNAL_MAGIC);
+}
+
+/// @brief Append at the end of the log, collecting garbage first if the sector is full
+/// @param offset Offset of the new record within the (possibly new) active sector
+bool ConfigJournal::AppendRecord(uint16_t header_key, const void *data, uint16_t size, uint16_t &offset)
+{
+    const uint32_t length = RecordSize(size);
+
+    if (write_offset + length > FLASH_SECTOR_SIZE)
+    {
+        if (!Collect(length))
+        {
+            return false;
+        }
+    }
+
+    offset = static_cast<uint16_t>(write_offset);
+    // Skip the space even on failure, partially programmed words cannot be reused
+    write_offset += length;
+    return Append(SectorAddress(active_sector) + offset, header_key, data, size);
+}
+
+/// @brief Program one record, CRC last so an interrupted write is never accepted
+bool ConfigJournal::Append(uint32_t address, uint16_t header_key, const void *data, uint16_t size)
+{
+    const uint8_t *bytes = static_cast<const uint8_t *>(data);
+    const uint32_t header = header_key | (static_cast<uint32_t>(size) << 16);
+
+    if (!ProgramWord(address, header))
+    {
+        return false;
+    }
+    address += RECORD_HEADER_SIZE;
+
+    for (uint16_t i = 0; i < size; i += sizeof(uint32_t))
+    {
+        const uint32_t left = static_cast<uint32_t>(size - i);
+        uint32_t word = ERASED_WORD;
+        memcpy(&word, bytes + i, left < sizeof(uint32_t) ? left : sizeof(uint32_t));
+        if (!ProgramWord(address, word))
+        {
+            return false;
+        }
+        address += sizeof(uint32_t);
+    }
+
+    return ProgramWord(address, RecordCRC(header, data, size));
+}
+
+/// @brief Re-append the records listed in a key table to another sector
+bool ConfigJournal::CopyRecords(uint32_t target_base, const uint16_t (&from)[CONFIG_JOURNAL_MAX_KEYS],
+                                uint16_t header_flag, uint16_t (&to)[CONFIG_JOURNAL_MAX_KEYS], uint32_t &offset)
+{
+    const uint32_t source_base = SectorAddress(active_sector);
+
+    for (uint16_t k = 0; k < CONFIG_JOURNAL_MAX_KEYS; k++)
+    {
+        if (from[k] == 0)
+        {
+            continue;
+        }
+        const uint32_t record = source_base + from[k];
+        const uint16_t size = ReadWord(record) >> 16;
+        if (!Append(target_base + offset, k | header_flag,
+                    reinterpret_cast<const void *>(record + RECORD_HEADER_SIZE), size))
+        {
+            return false;
+        }
+        to[k] = static_cast<uint16_t>(offset);
+        offset += RecordSize(size);
+    }
+    return true;
+}
+
+/// @brief Move the newest committed record of every key and the open batch to the next sector
+/// @param reserve Length of the record to append after the collection
+/// @return false, before anything is erased, if the records and the reserve do not fit a sector
+bool ConfigJournal::Collect(uint32_t reserve)
+{
+    const uint8_t target = (active_sector + 1) % CONFIG_JOURNAL_SECTORS;
+    const uint32_t target_base = SectorAddress(target);
+    const uint32_t source_base = SectorAddress(active_sector);
+    uint16_t new_key_offset[CONFIG_JOURNAL_MAX_KEYS] = {};
+    uint16_t new_staged_offset[CONFIG_JOURNAL_MAX_KEYS] = {};
+    uint32_t offset = sizeof(SectorHeader);
+
+    // 16 keys of CONFIG_JOURNAL_MAX_VALUE, let alone a batch of them, exceed a sector
+    if (offset + TableSize(source_base, key_offset) + TableSize(source_base, staged_offset) + reserve >
+        FLASH_SECTOR_SIZE)
+    {
+        return false;
+    }
+
+    if (flash_sector_erase(target_base) != FLASH_OPERATE_DONE)
+    {
+        return false;
+    }
+
+    // Committed values are rewritten as plain records, the open batch stays staged
+    if (!CopyRecords(target_base, key_offset, 0, new_key_offset, offset) ||
+        !CopyRecords(target_base, staged_offset, CONFIG_JOURNAL_STAGED, new_staged_offset, offset))
+    {
+        return false;
+    }
+
+    // The header makes the new sector valid, until then the old one stays in effect
+    if (!ProgramWord(target_base + offsetof(SectorHeader, sequence), sequence + 1) ||
+        !ProgramWord(target_base + offsetof(SectorHeader, magic), CONFIG_JOURNAL_MAGIC))
+    {
+        return false;
+    }
+
+    active_sector = target;
+    sequence++;
+    write_offset = offset;
+    memcpy(key_offset, new_key_offset, sizeof(key_offset));
+    memcpy(staged_offset, new_staged_offset, sizeof(staged_offset));
+    return true;
+}
+
+bool ConfigJournal::ProgramWord(uint32_t address, uint32_t value)
+{
+    return flash_word_program(address, value) == FLASH_OPERATE_DONE;
+}
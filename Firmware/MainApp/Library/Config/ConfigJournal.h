@@ -0,0 +1,106 @@
+#ifndef _CONFIG_JOURNAL_H
+#define _CONFIG_JOURNAL_H
+
+#include <stddef.h>
+#include "at32f403a_407.h"
+#include "flash_map.h"
+
+#define CONFIG_JOURNAL_MAGIC (0x4E524A43U) // "CJRN"
+#define CONFIG_JOURNAL_MAX_KEYS (16U)
+#define CONFIG_JOURNAL_MAX_VALUE (128U)
+#define CONFIG_JOURNAL_STAGED (0x8000U)     // header key flag: record belongs to an open batch
+#define CONFIG_JOURNAL_COMMIT_KEY (0x7FFFU) // empty record closing a batch
+#define CONFIG_JOURNAL_ABORT_KEY (0x7FFEU)  // empty record discarding an unfinished batch
+
+/// @brief Log-structured key/value store for configuration
+///
+/// Values are appended as records to the active sector; the newest record of
+/// a key wins. A RAM table maps each key to its newest record, so reads and
+/// writes cost O(1) and a write programs only the record itself, without
+/// erasing anything. When the active sector is full, the newest record of
+/// every key is copied to the next sector (garbage collection), which is the
+/// only time a sector is erased.
+///
+/// Sector:  | magic | sequence | record | record | ... | 0xFF... |
+/// Record:  | key:16 size:16 | payload, padded to 4 | crc32 |
+///
+/// Power-fail safety: the record CRC is programmed last and the sector header
+/// after all copied records, so a torn write leaves either the previous value
+/// or the previous sector in effect. Several keys can be changed atomically:
+/// Stage() appends records flagged as staged, which take effect only when
+/// Commit() appends the commit marker; a batch cut short by a reset is
+/// discarded as a whole. Not reentrant, callers serialise access.
+///
+/// Capacity: the newest record of every key, the open batch and the record
+/// being written must fit one sector together (CONFIG_JOURNAL_MAX_KEYS values
+/// of CONFIG_JOURNAL_MAX_VALUE do not); a write beyond that fails without
+/// erasing anything and the stored values stay in effect.
+class ConfigJournal
+{
+public:
+    ConfigJournal(const ConfigJournal &obj) = delete;
+
+    /// @brief Find the active sector and build the key table, format on first use
+    /// @return false if the flash could not be formatted
+    static bool Init(void);
+
+    /// @brief Check whether a key has a stored value
+    static bool Contains(uint16_t key);
+
+    /// @brief Size of the newest value of a key, 0 if the key is missing
+    static uint16_t GetSize(uint16_t key);
+
+    /// @brief Read the newest value of a key
+    /// @param key Key (< CONFIG_JOURNAL_MAX_KEYS)
+    /// @param data Destination
+    /// @param size Expected value size
+    /// @return false if the key is missing or stored with a different size
+    static bool Read(uint16_t key, void *data, uint16_t size);
+
+    /// @brief Store a value, nothing is programmed if it is unchanged
+    /// @param key Key (< CONFIG_JOURNAL_MAX_KEYS)
+    /// @param data Value
+    /// @param size Value size (<= CONFIG_JOURNAL_MAX_VALUE)
+    /// @return true if the value is stored
+    static bool Write(uint16_t key, const void *data, uint16_t size);
+
+    /// @brief Append a value to the open batch, it takes effect at Commit()
+    /// @return true if the value is staged (or unchanged)
+    static bool Stage(uint16_t key, const void *data, uint16_t size);
+
+    /// @brief Close the open batch, all staged values take effect at once
+    /// @return true if the commit marker is programmed
+    static bool Commit(void);
+
+    /// @brief Sector erases over the lifetime of the journal (wear indicator)
+    static uint32_t GetEraseCount(void);
+
+    /// @brief Bytes left in the active sector before the next garbage collection
+    static uint32_t GetFreeBytes(void);
+
+private:
+    struct SectorHeader
+    {
+        uint32_t magic;
+        uint32_t sequence; // increments with every garbage collection
+    };
+
+    static uint32_t SectorAddress(uint8_t sector);
+    static void Scan(void);
+    static bool IsUnchanged(uint16_t key, const void *data, uint16_t size);
+    static bool Format(uint8_t sector, uint32_t sequence);
+    static bool AppendRecord(uint16_t header_key, const void *data, uint16_t size, uint16_t &offset);
+    static bool Append(uint32_t address, uint16_t header_key, const void *data, uint16_t size);
+    static bool CopyRecords(uint32_t target_base, const uint16_t (&from)[CONFIG_JOURNAL_MAX_KEYS],
+                            uint16_t header_flag, uint16_t (&to)[CONFIG_JOURNAL_MAX_KEYS], uint32_t &offset);
+    static bool Collect(uint32_t reserve);
+    static bool ProgramWord(uint32_t address, uint32_t value);
+
+    static uint8_t active_sector;
+    static uint32_t sequence;
+    static uint32_t write_offset;
+    static uint16_t key_offset[CONFIG_JOURNAL_MAX_KEYS];    // committed records, 0 = key not stored
+    static uint16_t staged_offset[CONFIG_JOURNAL_MAX_KEYS]; // records of the open batch
+};
+
+#endif
@@ -0,0 +1,154 @@
+#include "ConfigSchema.h"
+#include "string.h"
+
+namespace ConfigSchema
+{
+
+static uint32_t LoadHost(const uint8_t *src, uint16_t size)
+{
+    switch (size)
+    {
+    case 1:
+        return *src;
+    case 2:
+    {
+        uint16_t value;
+        memcpy(&value, src, sizeof(value));
+        return value;
+    }
+    case 4:
+    {
+        uint32_t value;
+        memcpy(&value, src, sizeof(value));
+        return value;
+    }
+    default:
+        return 0;
+    }
+}
+
+static void StoreHost(uint8_t *dst, uint16_t size, uint32_t value)
+{
+    switch (size)
+    {
+    case 1:
+        *dst = static_cast<uint8_t>(value);
+        break;
+    case 2:
+    {
+        uint16_t v = static_cast<uint16_t>(value);
+        memcpy(dst, &v, sizeof(v));
+        break;
+    }
+    case 4:
+        memcpy(dst, &value, sizeof(value));
+        break;
+    default:
+        break;
+    }
+}
+
+static uint8_t WireWidth(Wire wire)
+{
+    return wire == Wire::U8 ? 1 : (wire == Wire::U16 ? 2 : 4);
+}
+
+static void Write(const Field *schema, size_t fields, const uint8_t *object, uint8_t *&cursor, uint8_t version)
+{
+    for (size_t i = 0; i < fields; i++)
+    {
+        const Field &f = schema[i];
+        if (f.since > version)
+        {
+            continue;
+        }
+        for (uint8_t n = 0; n < f.count; n++)
+        {
+            const uint8_t *src = object + f.offset + n * f.host_size;
+            switch (f.wire)
+            {
+            case Wire::RAW:
+                memcpy(cursor, src, f.host_size);
+                cursor += f.host_size;
+                break;
+            case Wire::NESTED:
+                Write(f.nested, f.nested_count, src, cursor, version);
+                break;
+            default:
+            {
+                uint32_t value = LoadHost(src, f.host_size);
+                for (uint8_t b = 0; b < WireWidth(f.wire); b++)
+                {
+                    *cursor++ = static_cast<uint8_t>(value >> (8 * b));
+                }
+                break;
+            }
+            }
+        }
+    }
+}
+
+static void Read(const Field *schema, size_t fields, uint8_t *object, const uint8_t *&cursor, uint8_t version)
+{
+    for (size_t i = 0; i < fields; i++)
+    {
+        const Field &f = schema[i];
+        if (f.since > version)
+        {
+            continue;
+        }
+        for (uint8_t n = 0; n < f.count; n++)
+        {
+            uint8_t *dst = object + f.offset + n * f.host_size;
+            switch (f.wire)
+            {
+            case Wire::RAW:
+                memcpy(dst, cursor, f.host_size);
+                cursor += f.host_size;
+                break;
+            case Wire::NESTED:
+                Read(f.nested, f.nested_count, dst, cursor, version);
+                break;
+            default:
+            {
+                uint32_t value = 0;
+                for (uint8_t b = 0; b < WireWidth(f.wire); b++)
+                {
+                    value |= static_cast<uint32_t>(*cursor++) << (8 * b);
+                }
+                StoreHost(dst, f.host_size, value);
+                break;
+            }
+            }
+        }
+    }
+}
+
+size_t Serialize(const Field *schema, size_t fields, const void *object, uint8_t *buffer, size_t buffer_size,
+                 uint8_t version)
+{
+    const size_t size = Size(schema, fields, version);
+    if (size > buffer_size)
+    {
+        return 0;
+    }
+
+    uint8_t *cursor = buffer;
+    Write(schema, fields, static_cast<const uint8_t *>(object), cursor, version);
+    return size;
+}
+
+bool Deserialize(const Field *schema, size_t fields, void *object, const uint8_t *buffer, size_t size,
+                 uint8_t version)
+{
+    if (size < Size(schema, fields, version))
+    {
+        return false;
+    }
+
+    const uint8_t *cursor = buffer;
+    Read(schema, fields, static_cast<uint8_t *>(object), cursor, version);
+    return true;
+}
+
+} // namespace ConfigSchema
@@ -0,0 +1,124 @@
+#ifndef _CONFIG_SCHEMA_H
+#define _CONFIG_SCHEMA_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/// @brief Field-descriptor schemas for persistent configuration
+///
+/// A schema is a constexpr array of Field entries describing a plain struct.
+/// Size, serialization, deserialization (and so the CRC input) all come from
+/// the same array, so a field is listed exactly once.
+///
+/// Wire format: fields in schema order, integers little-endian with the
+/// width given by the wire type, independent of the host type. This matters
+/// for enums, whose size depends on compiler options (-fshort-enums).
+///
+/// Versioning: every field carries the config_version that introduced it.
+/// Fields are only ever appended. Reading data written by an older version
+/// leaves the newer fields at their defaults; data written by a newer
+/// version is longer and its unknown tail is ignored.
+namespace ConfigSchema
+{
+
+enum class Wire : uint8_t
+{
+    U8,     // 1 byte on the wire
+    U16,    // 2 bytes, little-endian
+    U32,    // 4 bytes, little-endian
+    RAW,    // host bytes as is (frozen legacy layouts, byte-only structs)
+    NESTED, // member described by its own schema
+};
+
+struct Field
+{
+    uint16_t offset;      // offset of the member in the host struct
+    uint16_t host_size;   // size of one element in the host struct
+    Wire wire;
+    uint8_t count;        // array elements, 1 for scalars
+    uint8_t since;        // first config_version storing the field
+    const Field *nested;  // Wire::NESTED only
+    uint8_t nested_count;
+};
+
+constexpr uint8_t ANY_VERSION = 0xFFU;
+
+constexpr size_t Size(const Field *schema, size_t fields, uint8_t version = ANY_VERSION)
+{
+    size_t size = 0;
+    for (size_t i = 0; i < fields; i++)
+    {
+        const Field &f = schema[i];
+        if (f.since > version)
+        {
+            continue;
+        }
+        size_t element = 0;
+        switch (f.wire)
+        {
+        case Wire::U8:
+            element = 1;
+            break;
+        case Wire::U16:
+            element = 2;
+            break;
+        case Wire::U32:
+            element = 4;
+            break;
+        case Wire::RAW:
+            element = f.host_size;
+            break;
+        case Wire::NESTED:
+            element = Size(f.nested, f.nested_count, version);
+            break;
+        }
+        size += element * f.count;
+    }
+    return size;
+}
+
+template <size_t N>
+constexpr size_t Size(const Field (&schema)[N], uint8_t version = ANY_VERSION)
+{
+    return Size(schema, N, version);
+}
+
+/// @brief Encode the fields present in a version
+/// @return Bytes written, 0 if the buffer is too small
+size_t Serialize(const Field *schema, size_t fields, const void *object, uint8_t *buffer, size_t buffer_size,
+                 uint8_t version = ANY_VERSION);
+
+/// @brief Decode data written with a given version
+/// Fields introduced after that version are left untouched (defaults).
+/// @return false if the data is shorter than that version's layout
+bool Deserialize(const Field *schema, size_t fields, void *object, const uint8_t *buffer, size_t size,
+                 uint8_t version = ANY_VERSION);
+
+template <size_t N>
+size_t Serialize(const Field (&schema)[N], const void *object, uint8_t *buffer, size_t buffer_size,
+                 uint8_t version = ANY_VERSION)
+{
+    return Serialize(schema, N, object, buffer, buffer_size, version);
+}
+
+template <size_t N>
+bool Deserialize(const Field (&schema)[N], void *object, const uint8_t *buffer, size_t size,
+                 uint8_t version = ANY_VERSION)
+{
+    return Deserialize(schema, N, object, buffer, size, version);
+}
+
+} // namespace ConfigSchema
+
+#define SCHEMA_FIELD(Owner, member, wire, since)                                                   \
+    {offsetof(Owner, member), sizeof(Owner::member), ConfigSchema::Wire::wire, 1, since, nullptr, 0}
+
+#define SCHEMA_ARRAY(Owner, member, wire, since)                                                   \
+    {offsetof(Owner, member), sizeof(Owner::member[0]), ConfigSchema::Wire::wire,                  \
+     sizeof(Owner::member) / sizeof(Owner::member[0]), since, nullptr, 0}
+
+#define SCHEMA_NESTED(Owner, member, schema, since)                                                \
+    {offsetof(Owner, member), sizeof(Owner::member), ConfigSchema::Wire::NESTED, 1, since, schema, \
+     sizeof(schema) / sizeof(schema[0])}
+
+#endif
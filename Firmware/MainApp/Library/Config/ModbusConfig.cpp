@@ -1,5 +1,4 @@
 #include "ModbusConfig.h"
-#include "Shared.h"
 
 void ModbusConfig::set_default(void)
 {
@@ -10,24 +9,6 @@ void ModbusConfig::set_default(void)
     stop_bits = DEFAULT_MODBUS_STOP_BITS;
 }
 
-void ModbusConfig::serialize(uint8_t *&cursor) const
-{
-    WriteToBuffer(cursor, address);
-    WriteToBuffer(cursor, baudrate);
-    WriteToBuffer(cursor, data_bits);
-    WriteToBuffer(cursor, parity);
-    WriteToBuffer(cursor, stop_bits);
-}
-
-void ModbusConfig::deserialize(const uint8_t *&cursor)
-{
-    ReadFromBuffer(cursor, address);
-    ReadFromBuffer(cursor, baudrate);
-    ReadFromBuffer(cursor, data_bits);
-    ReadFromBuffer(cursor, parity);
-    ReadFromBuffer(cursor, stop_bits);
-}
-
 eMBParity ModbusConfig::get_modbus_parity(void) const
 {
     switch (parity)
@@ -4,6 +4,7 @@
 #include <stddef.h>
 #include "at32f403a_407.h"
 #include "mbport.h"
+#include "ConfigSchema.h"
 
 #define DEFAULT_MODBUS_ADDRESS (1U)
 #define DEFAULT_MODBUS_BAUDRATE (9600U)
@@ -23,22 +24,10 @@ struct ModbusConfig
     /// @brief Set default Modbus configuration values
     void set_default(void);
 
-    /// @brief Get total size of the structure for serialization
+    /// @brief Get serialized size, see modbus_config_schema
     /// @return Size in bytes
-    static constexpr size_t get_size(void)
-    {
-        return sizeof(address) + sizeof(baudrate) + sizeof(data_bits) + 
-               sizeof(parity) + sizeof(stop_bits);
-    }
-
-    /// @brief Serialize configuration to buffer
-    /// @param cursor Pointer to buffer position
-    void serialize(uint8_t *&cursor) const;
-
-    /// @brief Deserialize configuration from buffer
-    /// @param cursor Pointer to buffer position
-    void deserialize(const uint8_t *&cursor);
-    
+    static constexpr size_t get_size(void);
+
     /// @brief Convert AT32 parity type to Modbus parity type
     /// @return Modbus parity type
     eMBParity get_modbus_parity(void) const;
@@ -52,5 +41,21 @@ struct ModbusConfig
     uint8_t get_modbus_data_bits(void) const;
 };
 
+/// @brief Stored layout of ModbusConfig
+/// AT32 enums are stored as one byte, their host size depends on -fshort-enums.
+/// Append new fields with the config_version that introduces them.
+inline constexpr ConfigSchema::Field modbus_config_schema[] = {
+    SCHEMA_FIELD(ModbusConfig, address, U8, 1),
+    SCHEMA_FIELD(ModbusConfig, baudrate, U32, 1),
+    SCHEMA_FIELD(ModbusConfig, data_bits, U8, 1),
+    SCHEMA_FIELD(ModbusConfig, parity, U8, 1),
+    SCHEMA_FIELD(ModbusConfig, stop_bits, U8, 1),
+};
+
+constexpr size_t ModbusConfig::get_size(void)
+{
+    return ConfigSchema::Size(modbus_config_schema);
+}
+
 #endif
 
@@ -1,162 +1,315 @@
 #include "PBlockConfig.h"
-#include "Shared.h"
+#include "ConfigSchema.h"
+#include "StorageFlush.h"
 #include "string.h"
+#include "FreeRTOS.h"
+#include "task.h"
 
-uint8_t PBlockConfig::config_version;
-uint32_t PBlockConfig::SerialNum;
-calendar_type PBlockConfig::AssemblyDate;
-ModbusConfig PBlockConfig::modbus_config;
+#define KEY(key) static_cast<uint16_t>(ConfigKey::key)
 
-uint8_t PBlockConfig::crc;
+/// @brief Journal layout, entry index is the ConfigKey of the record
+/// Append fields with the config_version that introduces them, never reorder.
+static constexpr ConfigSchema::Field config_schema[] = {
+    SCHEMA_FIELD(PBlockConfigData, config_version, U8, 1),
+    SCHEMA_FIELD(PBlockConfigData, SerialNum, U32, 1),
+    SCHEMA_FIELD(PBlockConfigData, AssemblyDate, RAW, 1), // byte-sized fields, year little-endian
+    SCHEMA_NESTED(PBlockConfigData, modbus_config, modbus_config_schema, 1),
+    SCHEMA_ARRAY(PBlockConfigData, relay_cycles, U32, 2),
+    SCHEMA_FIELD(PBlockConfigData, trend_period_ms, U16, 4),
+};
+
+/// @brief Frozen layout of versions 1 and 2: enums stored with their host size
+static constexpr ConfigSchema::Field legacy_modbus_schema[] = {
+    SCHEMA_FIELD(ModbusConfig, address, U8, 1),
+    SCHEMA_FIELD(ModbusConfig, baudrate, U32, 1),
+    SCHEMA_FIELD(ModbusConfig, data_bits, RAW, 1),
+    SCHEMA_FIELD(ModbusConfig, parity, RAW, 1),
+    SCHEMA_FIELD(ModbusConfig, stop_bits, RAW, 1),
+};
+
+/// @brief Sector 253 record and journal records up to VERSION_DEVICE_CONFIG_SCHEMA
+static constexpr ConfigSchema::Field legacy_config_schema[] = {
+    SCHEMA_FIELD(PBlockConfigData, config_version, U8, 1),
+    SCHEMA_FIELD(PBlockConfigData, SerialNum, U32, 1),
+    SCHEMA_FIELD(PBlockConfigData, AssemblyDate, RAW, 1),
+    SCHEMA_NESTED(PBlockConfigData, modbus_config, legacy_modbus_schema, 1),
+    SCHEMA_ARRAY(PBlockConfigData, relay_cycles, U32, 2),
+    SCHEMA_FIELD(PBlockConfigData, trend_period_ms, U16, 4),
+};
+
+template <size_t N>
+static constexpr bool MatchesKeys(const ConfigSchema::Field (&schema)[N])
+{
+    return N == KEY(COUNT) && schema[KEY(VERSION)].offset == offsetof(PBlockConfigData, config_version) &&
+           schema[KEY(SERIAL_NUM)].offset == offsetof(PBlockConfigData, SerialNum) &&
+           schema[KEY(ASSEMBLY_DATE)].offset == offsetof(PBlockConfigData, AssemblyDate) &&
+           schema[KEY(MODBUS)].offset == offsetof(PBlockConfigData, modbus_config) &&
+           schema[KEY(RELAY_CYCLES)].offset == offsetof(PBlockConfigData, relay_cycles) &&
+           schema[KEY(TREND_PERIOD)].offset == offsetof(PBlockConfigData, trend_period_ms);
+}
+
+static_assert(MatchesKeys(config_schema), "config_schema order must follow ConfigKey");
+static_assert(MatchesKeys(legacy_config_schema), "legacy_config_schema order must follow ConfigKey");
+static_assert(ConfigSchema::Size(config_schema) <= CONFIG_JOURNAL_MAX_VALUE, "config record too large");
+static_assert(ConfigSchema::Size(modbus_config_schema) == 8U, "Modbus record layout changed");
+
+PBlockConfigData PBlockConfig::data;
 bool PBlockConfig::isOkay;
 
+volatile uint32_t PBlockConfig::dirty_mask;
+uint32_t PBlockConfig::flush_window_ms = CONFIG_FLUSH_WINDOW_MS;
+
+static TaskHandle_t flush_task;
+
 void PBlockConfig::Init(void)
 {
-    LoadConfig();
-    isOkay = CheckCRC();
-    if (!isOkay)
+    bool journal = ConfigJournal::Init();
+    uint8_t stored_version = 0;
+
+    if (journal && ConfigJournal::Contains(KEY(VERSION)))
+    {
+        stored_version = LoadFromJournal();
+    }
+    else
     {
-        SetDefault();
-        SaveConfig();
-        isOkay = true;
+        // First start with the journal: the legacy record is taken over and its sector
+        // left untouched, so older firmware still finds its config
+        LoadLegacyConfig();
     }
+
+    data.config_version = VERSION_DEVICE_CONFIG;
+    if (journal && stored_version != VERSION_DEVICE_CONFIG)
+    {
+        // Migration, forward or back: rewrite every record in the layout of this version.
+        // One batch, a reset in between leaves the previous records in effect.
+        WriteBatch(CONFIG_ALL_KEYS, data);
+    }
+    isOkay = true;
 }
 
-void PBlockConfig::LoadConfig(void)
+/// @brief Load fields from the journal, fields without a record keep their defaults
+/// @return config_version the records were written with
+uint8_t PBlockConfig::LoadFromJournal(void)
 {
-    size_t size = GetSize();
-    uint8_t buff[size];
-    FlashService::Read(ADDRESS_DEVICE_CONGIG, buff, size);
-    Deserialize(buff, size);
+    uint8_t version = 0;
+    uint8_t buff[CONFIG_JOURNAL_MAX_VALUE];
+
+    SetDefault();
+    ConfigJournal::Read(KEY(VERSION), &version, sizeof(version));
+
+    // Fields newer than the stored version keep their defaults, a newer record's unknown tail is skipped
+    const ConfigSchema::Field *schema =
+        version < VERSION_DEVICE_CONFIG_SCHEMA ? legacy_config_schema : config_schema;
+    for (uint16_t key = KEY(VERSION) + 1; key < KEY(COUNT); key++)
+    {
+        uint16_t size = ConfigJournal::GetSize(key);
+        if (size != 0 && size <= sizeof(buff) && ConfigJournal::Read(key, buff, size))
+        {
+            ConfigSchema::Deserialize(&schema[key], 1, &data, buff, size, version);
+        }
+    }
+    return version;
 }
 
-void PBlockConfig::SaveConfig(void)
+/// @brief Stage the dirty fields and commit them together
+/// @param dirty ConfigKey bits to write
+/// @param snapshot Field values
+/// @return true if the batch is committed
+bool PBlockConfig::WriteBatch(uint32_t dirty, const PBlockConfigData &snapshot)
 {
-    size_t size = GetSize();
-    uint8_t buff[size];
-    Serialize(buff, size);
-    FlashService::CheckDiffAndReprogramm(ADDRESS_DEVICE_CONGIG, buff, size);
+    uint8_t buff[ConfigSchema::Size(config_schema)];
+    bool ok = true;
+
+    // VERSION goes last, so the stored version always matches the records in effect
+    for (uint16_t key = KEY(VERSION) + 1; ok && key <= KEY(COUNT); key++)
+    {
+        uint16_t field = key < KEY(COUNT) ? key : KEY(VERSION);
+        if (dirty & (1UL << field))
+        {
+            size_t size = ConfigSchema::Serialize(&config_schema[field], 1, &snapshot, buff, sizeof(buff));
+            ok = ConfigJournal::Stage(field, buff, static_cast<uint16_t>(size));
+        }
+    }
+
+    return ok && ConfigJournal::Commit();
 }
 
-bool PBlockConfig::CheckCRC(void)
+/// @brief Record a change in RAM and wake the flush task, flash is not touched here
+/// @param key Changed field
+void PBlockConfig::MarkDirty(ConfigKey key)
 {
-    return CountCRC() == crc;
+    __atomic_fetch_or(&dirty_mask, CONFIG_KEY_BIT(key), __ATOMIC_RELEASE);
+    RequestFlush();
+}
+
+void PBlockConfig::RequestFlush(void)
+{
+    if (flush_task != NULL)
+    {
+        xTaskNotifyGive(flush_task);
+    }
+}
+
+bool PBlockConfig::Flush(void)
+{
+    PBlockConfigData snapshot;
+    uint32_t dirty;
+    bool ok;
+
+    StorageFlush::Lock();
+
+    taskENTER_CRITICAL();
+    dirty = dirty_mask;
+    dirty_mask = 0;
+    snapshot = data;
+    taskEXIT_CRITICAL();
+
+    ok = (dirty == 0) || WriteBatch(dirty, snapshot);
+    if (!ok)
+    {
+        // Keep the fields pending, the next flush retries them
+        __atomic_fetch_or(&dirty_mask, dirty, __ATOMIC_RELEASE);
+    }
+
+    StorageFlush::Unlock();
+    return ok;
+}
+
+void PBlockConfig::SetFlushWindow(uint32_t window_ms)
+{
+    flush_window_ms = window_ms;
+}
+
+void PBlockConfig::FlushTask(void *parameters)
+{
+    (void)parameters;
+    flush_task = xTaskGetCurrentTaskHandle();
+
+    for (;;)
+    {
+        if (dirty_mask == 0)
+        {
+            ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        }
+        // Related changes (several Modbus writes, a config tool session) end up in one batch
+        vTaskDelay(pdMS_TO_TICKS(flush_window_ms));
+        Flush();
+    }
+}
+
+/// @brief Take over the legacy sector 253 record, defaults if there is none
+/// @return true if a valid version 1 or 2 record was found
+bool PBlockConfig::LoadLegacyConfig(void)
+{
+    uint8_t buff[ConfigSchema::Size(legacy_config_schema) + sizeof(uint8_t)];
+
+    SetDefault();
+    FlashService::Read(ADDRESS_DEVICE_CONGIG, buff, sizeof(buff));
+
+    // The record length depends on its version, the CRC byte follows the fields
+    const uint8_t version = buff[0];
+    if (version < 1U || version > VERSION_LEGACY_CONFIG_MAX)
+    {
+        return false;
+    }
+    const size_t size = ConfigSchema::Size(legacy_config_schema, version);
+    if (count_CRC(buff, size) != buff[size])
+    {
+        return false;
+    }
+    return ConfigSchema::Deserialize(legacy_config_schema, &data, buff, size, version);
 }
 
 /// @brief Set default values to DEVICE config
 /// @param
 void PBlockConfig::SetDefault(void)
 {
-    config_version = VERSION_DEVICE_CONFIG;
-    SerialNum = DEFAULT_DEVICE_CONFIG_SERIAL_NUM;
-    AssemblyDate = DEFAULT_DEVICE_CONFIG_ASSEMBLY_DATE;
-    modbus_config.set_default();
-    SetCRC();
+    data.config_version = VERSION_DEVICE_CONFIG;
+    data.SerialNum = DEFAULT_DEVICE_CONFIG_SERIAL_NUM;
+    data.AssemblyDate = DEFAULT_DEVICE_CONFIG_ASSEMBLY_DATE;
+    data.modbus_config.set_default();
+    memset(data.relay_cycles, 0, sizeof(data.relay_cycles));
+    data.trend_period_ms = DEFAULT_DEVICE_CONFIG_TREND_PERIOD_MS;
 }
 
 uint32_t PBlockConfig::GetSerialNum(void)
 {
-    return isOkay ? SerialNum : DEFAULT_DEVICE_CONFIG_SERIAL_NUM;
+    return isOkay ? data.SerialNum : DEFAULT_DEVICE_CONFIG_SERIAL_NUM;
 }
 
 void PBlockConfig::SetSerialNum(uint32_t new_SerialNum)
 {
-    if (SerialNum != new_SerialNum)
+    if (data.SerialNum != new_SerialNum)
     {
-        SerialNum = new_SerialNum;
-        SetCRC();
-        SaveConfig();
+        data.SerialNum = new_SerialNum;
+        MarkDirty(ConfigKey::SERIAL_NUM);
     }
 }
 
 calendar_type PBlockConfig::GetAssemblyDate(void)
 {
-    return isOkay ? AssemblyDate : DEFAULT_DEVICE_CONFIG_ASSEMBLY_DATE;
+    return isOkay ? data.AssemblyDate : DEFAULT_DEVICE_CONFIG_ASSEMBLY_DATE;
 }
 
 void PBlockConfig::SetAssemblyDate(calendar_type new_AssemblyDate)
 {
-    if (memcmp(&AssemblyDate, &new_AssemblyDate, sizeof(calendar_type)) != 0)
+    if (memcmp(&data.AssemblyDate, &new_AssemblyDate, sizeof(calendar_type)) != 0)
     {
-        AssemblyDate = new_AssemblyDate;
-        SetCRC();
-        SaveConfig();
+        taskENTER_CRITICAL();
+        data.AssemblyDate = new_AssemblyDate;
+        taskEXIT_CRITICAL();
+        MarkDirty(ConfigKey::ASSEMBLY_DATE);
     }
 }
 
 ModbusConfig& PBlockConfig::GetModbusConfig(void)
 {
-    return modbus_config;
+    return data.modbus_config;
 }
 
 void PBlockConfig::SetModbusConfig(const ModbusConfig &new_modbus_config)
 {
-    if (memcmp(&modbus_config, &new_modbus_config, sizeof(ModbusConfig)) != 0)
+    if (memcmp(&data.modbus_config, &new_modbus_config, sizeof(ModbusConfig)) != 0)
     {
-        modbus_config = new_modbus_config;
-        SetCRC();
-        SaveConfig();
+        taskENTER_CRITICAL();
+        data.modbus_config = new_modbus_config;
+        taskEXIT_CRITICAL();
+        MarkDirty(ConfigKey::MODBUS);
     }
 }
 
-/// @brief count current crc value and set it to PBlockConfig
-/// @param
-void PBlockConfig::SetCRC(void)
+uint32_t PBlockConfig::GetRelayCycles(uint8_t relay_number)
 {
-    crc = CountCRC();
-}
-
-/// @brief count crc
-/// @param
-/// @return crc as uint8_t
-uint8_t PBlockConfig::CountCRC(void)
-{
-    uint16_t size = GetSize() - sizeof(crc);
-    uint8_t buff[size];
-    uint8_t *cursor = buff;
-
-    WriteToBuffer(cursor, config_version);
-    WriteToBuffer(cursor, SerialNum);
-    WriteToBuffer(cursor, AssemblyDate);
-    
-    modbus_config.serialize(cursor);
-
-    return count_CRC(buff, size);
+    if (!isOkay || relay_number < 1 || relay_number > RELAY_COUNT)
+    {
+        return 0;
+    }
+    return data.relay_cycles[relay_number - 1];
 }
 
-// Serialize function
-void PBlockConfig::Serialize(uint8_t *buffer, size_t &size)
+void PBlockConfig::SetRelayCycles(const uint32_t (&new_relay_cycles)[RELAY_COUNT])
 {
-    size = GetSize();
-    uint8_t *cursor = buffer;
-    
-    WriteToBuffer(cursor, config_version);
-    WriteToBuffer(cursor, SerialNum);
-    WriteToBuffer(cursor, AssemblyDate);
-    
-    modbus_config.serialize(cursor);
-
-    WriteToBuffer(cursor, crc);
+    if (memcmp(data.relay_cycles, new_relay_cycles, sizeof(data.relay_cycles)) != 0)
+    {
+        taskENTER_CRITICAL();
+        memcpy(data.relay_cycles, new_relay_cycles, sizeof(data.relay_cycles));
+        taskEXIT_CRITICAL();
+        MarkDirty(ConfigKey::RELAY_CYCLES);
+    }
 }
 
-// Deserialize function
-void PBlockConfig::Deserialize(const uint8_t *buffer, size_t size)
+uint16_t PBlockConfig::GetTrendPeriod(void)
 {
-    size = GetSize();
-    
-    ReadFromBuffer(buffer, config_version);
-    ReadFromBuffer(buffer, SerialNum);
-    ReadFromBuffer(buffer, AssemblyDate);
-    
-    modbus_config.deserialize(buffer);
-    
-    ReadFromBuffer(buffer, crc);
+    return isOkay ? data.trend_period_ms : DEFAULT_DEVICE_CONFIG_TREND_PERIOD_MS;
 }
 
-size_t PBlockConfig::GetSize(void)
+void PBlockConfig::SetTrendPeriod(uint16_t new_trend_period_ms)
 {
-    return sizeof(config_version) + sizeof(SerialNum) + sizeof(AssemblyDate) + 
-           ModbusConfig::get_size() + sizeof(crc);
+    if (data.trend_period_ms != new_trend_period_ms)
+    {
+        data.trend_period_ms = new_trend_period_ms;
+        MarkDirty(ConfigKey::TREND_PERIOD);
+    }
 }
 
 // PBlockConfig* _PBlockConfig;
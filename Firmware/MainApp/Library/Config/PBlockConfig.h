@@ -5,32 +5,62 @@
 #include "FlashService.h"
 #include "CRC.h"
 #include "ModbusConfig.h"
+#include "P-Block-struct.h"
+#include "ConfigJournal.h"
 
-#define VERSION_DEVICE_CONFIG (1U)
+#define VERSION_DEVICE_CONFIG (4U)
+// Journal records written before this version use the legacy layout (host-sized enums)
+#define VERSION_DEVICE_CONFIG_SCHEMA (3U)
+#define VERSION_LEGACY_CONFIG_MAX (2U)
+// Legacy single-record location, read once to migrate into the journal
 #define SEC_DEVICE_CONGIG (253U)
 #define ADDRESS_DEVICE_CONGIG (SECTOR_ADDRESS(SEC_DEVICE_CONGIG))
 
+#define CONFIG_FLUSH_WINDOW_MS (500U)  // changes arriving within this window are written as one batch
+#define CONFIG_FLUSH_TASK_STACK (192U) // words
+
+/// @brief Config journal keys, one record per field
+enum class ConfigKey : uint16_t
+{
+    VERSION = 0,
+    SERIAL_NUM = 1,
+    ASSEMBLY_DATE = 2,
+    MODBUS = 3,
+    RELAY_CYCLES = 4,
+    TREND_PERIOD = 5,
+    COUNT
+};
+
+#define CONFIG_KEY_BIT(key) (1UL << static_cast<uint16_t>(key))
+#define CONFIG_ALL_KEYS ((1UL << static_cast<uint16_t>(ConfigKey::COUNT)) - 1UL)
+
+/// @brief Persistent fields, described by the schemas in PBlockConfig.cpp
+struct PBlockConfigData
+{
+    uint8_t config_version;
+    uint32_t SerialNum;
+    calendar_type AssemblyDate;
+    ModbusConfig modbus_config;
+    uint32_t relay_cycles[RELAY_COUNT];
+    uint16_t trend_period_ms;
+};
+
 /*Singletone*/
 struct PBlockConfig
 {
 private:
-    static uint8_t config_version;
-    static uint32_t SerialNum;
-    static calendar_type AssemblyDate;
-    static ModbusConfig modbus_config;
-    
-    static uint8_t crc;
+    static PBlockConfigData data;
+
+    static volatile uint32_t dirty_mask; // ConfigKey bits changed in RAM, not yet in flash
+    static uint32_t flush_window_ms;
 
-    static bool CheckCRC(void);
     static void SetDefault(void);
-    static void SetCRC(void);
-    static uint8_t CountCRC(void);
-    static void Serialize(uint8_t *buffer, size_t &size);
-    static void Deserialize(const uint8_t *buffer, size_t size);
-    static size_t GetSize(void);
+    static uint8_t LoadFromJournal(void);
+    static bool WriteBatch(uint32_t dirty, const PBlockConfigData &snapshot);
+    static void MarkDirty(ConfigKey key);
 
-    static void LoadConfig(void);
-    static void SaveConfig(void);
+    // Legacy sector 253 record (versions 1 and 2), whole config with 8-bit CRC
+    static bool LoadLegacyConfig(void);
 
     static bool isOkay; // doesn't save to flash
 
@@ -53,15 +83,33 @@ public:
     static ModbusConfig& GetModbusConfig(void);
     static void SetModbusConfig(const ModbusConfig &new_modbus_config);
 
-    static uint8_t GetCRC(void);
+    static uint32_t GetRelayCycles(uint8_t relay_number);
+    static void SetRelayCycles(const uint32_t (&new_relay_cycles)[RELAY_COUNT]);
+
+    static uint16_t GetTrendPeriod(void);
+    static void SetTrendPeriod(uint16_t new_trend_period_ms);
+
+    /// @brief Write pending changes now (e.g. before a reset), blocks for the flash operation
+    /// @return true if nothing is left pending
+    static bool Flush(void);
+
+    /// @brief Wake the flush task
+    static void RequestFlush(void);
+
+    /// @brief Set the coalescing window of the flush task
+    static void SetFlushWindow(uint32_t window_ms);
+
+    /// @brief Background task writing pending changes to flash, lowest application priority
+    static void FlushTask(void *parameters) __attribute__((noreturn));
 };
 // -----------------------
-// FlashMap
+// Legacy FlashMap (sector 253), see legacy_config_schema
 // -----------------------
 // config_version    1b
 // SerialNum         4b
-// AssemblyDate      4b
-// modbus_config     variable size (see ModbusConfig::get_size())
+// AssemblyDate      sizeof(calendar_type)
+// modbus_config     address 1b, baudrate 4b, enums sizeof(enum) each
+// relay_cycles      4b * RELAY_COUNT (since version 2)
 // crc               1b  crc must be last
 // -----------------------
 
@@ -74,5 +122,6 @@ const uint8_t DEFAULT_DEVICE_CONFIG_APP_KEY[] = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0
 const calendar_type DEFAULT_DEVICE_CONFIG_ASSEMBLY_DATE{0, 0, 0, 0, 0, 0, 0};
 #define DEFAULT_DEVICE_CONFIG_JOIN_EUI (0U)
 #define DEFAULT_DEVICE_CONFIG_FREQUENCY (868900000U)
+#define DEFAULT_DEVICE_CONFIG_TREND_PERIOD_MS (1000U)
 
 #endif
@@ -0,0 +1,222 @@
+#include "DeadlineMonitor.h"
+#include <string.h>
+#include "at32f403a_407.h"
+#include "ErrorLog.h"
+#include "PowerManager.h"
+
+#define DEADLINE_WDT_RELOAD         (DEADLINE_WDT_TIMEOUT_MS * 40000U / 64U / 1000U)
+#define DEADLINE_TRIP_WORDS         (sizeof(DeadlineTrip) / sizeof(uint16_t))
+
+static_assert(DEADLINE_SUBJECTS <= 16, "the late mask is one register");
+static_assert(DEADLINE_WDT_RELOAD <= 0x0FFFU, "the watchdog counter is 12 bits");
+static_assert(DEADLINE_TRIP_WORDS + 1U == 6U, "the trip record and its check fill BPR_DATA23..BPR_DATA28");
+
+struct DeadlineConfig {
+    uint16_t period_ms;
+    uint16_t warn_ms;
+    uint16_t limit_ms;
+};
+
+// Periods follow the task loops: inputUpdate and outputUpdate run at a fixed
+// rate, the CANopen tasks wait at most CO_MAX_SLEEP_US/CO_TMR_MAX_SLEEP_US,
+// uartFun and usbFun poll every 5 ms, unitControl runs every 500 ms
+static const DeadlineConfig config_[DEADLINE_SUBJECTS] = {
+    {100, 300, 1500},   // DEADLINE_INPUT_UPDATE
+    {10, 50, 1500},     // DEADLINE_OUTPUT_UPDATE
+    {100, 300, 1500},   // DEADLINE_CANOPEN
+    {100, 300, 1500},   // DEADLINE_CANOPEN_TMR
+    {5, 300, 1500},     // DEADLINE_UART
+    {5, 300, 1500},     // DEADLINE_USB
+    {500, 1000, 1500},  // DEADLINE_UNIT_CONTROL
+    {10, 300, 1500},    // DEADLINE_LED, LITE_GATEWAY only
+};
+
+struct SubjectState {
+    TickType_t last;
+    uint32_t reports;
+    uint16_t max_ms;
+    uint16_t warnings;
+    uint16_t buckets[DEADLINE_BUCKETS];
+    bool armed;
+};
+
+// BPR_DATA29 onwards belong to the system errors and measurements, see FlashMap.md
+static const bpr_data_type trip_regs_[DEADLINE_TRIP_WORDS + 1U] = {
+    BPR_DATA23, BPR_DATA24, BPR_DATA25, BPR_DATA26, BPR_DATA27, BPR_DATA28,
+};
+
+volatile uint16_t DeadlineMonitor::late_mask_;
+DeadlineTrip DeadlineMonitor::last_trip_;
+
+static SubjectState state_[DEADLINE_SUBJECTS];
+static TaskHandle_t wake_task_ = NULL;
+static bool tripped_ = false;
+
+static uint16_t saturate(uint32_t value) {
+    return value > 0xFFFFU ? 0xFFFFU : static_cast<uint16_t>(value);
+}
+
+static uint16_t trip_check(const uint16_t *words) {
+    uint16_t check = 0;
+    for (uint32_t i = 0; i < DEADLINE_TRIP_WORDS; i++) {
+        check ^= words[i];
+    }
+    return static_cast<uint16_t>(~check);
+}
+
+/**
+ * @brief 2-bit level of each bucket, see DeadlineTrip
+ */
+static uint32_t bucket_levels(const uint16_t (&buckets)[DEADLINE_BUCKETS]) {
+    uint32_t levels = 0;
+    for (uint32_t k = 0; k < DEADLINE_BUCKETS; k++) {
+        const uint32_t count = buckets[k];
+        const uint32_t level = count == 0 ? 0U : (count < 16U ? 1U : (count < 256U ? 2U : 3U));
+        levels |= level << (2U * k);
+    }
+    return levels;
+}
+
+/**
+ * @brief Write the trip record, the marker last
+ */
+static void save_trip(uint8_t subject, uint32_t late_ms) {
+    DeadlineTrip trip;
+    trip.marker = DEADLINE_TRIP_MARKER;
+    trip.subject = subject;
+    trip.late_ms = saturate(late_ms);
+    trip.levels = bucket_levels(state_[subject].buckets);
+
+    uint16_t words[DEADLINE_TRIP_WORDS];
+    memcpy(words, &trip, sizeof(words));
+    bpr_data_write(trip_regs_[DEADLINE_TRIP_WORDS], trip_check(words));
+    for (uint32_t i = DEADLINE_TRIP_WORDS; i-- > 0;) {
+        bpr_data_write(trip_regs_[i], words[i]);
+    }
+}
+
+void DeadlineMonitor::Init(void) {
+    uint16_t words[DEADLINE_TRIP_WORDS];
+    for (uint32_t i = 0; i < DEADLINE_TRIP_WORDS; i++) {
+        words[i] = bpr_data_read(trip_regs_[i]);
+    }
+    memcpy(&last_trip_, words, sizeof(last_trip_));
+
+    if (last_trip_.marker == DEADLINE_TRIP_MARKER && last_trip_.subject < DEADLINE_SUBJECTS &&
+        bpr_data_read(trip_regs_[DEADLINE_TRIP_WORDS]) == trip_check(words)) {
+        ErrorLog::Add(static_cast<uint16_t>(DEADLINE_ERROR_CODE | last_trip_.subject));
+        bpr_data_write(trip_regs_[0], 0);
+    } else {
+        memset(&last_trip_, 0, sizeof(last_trip_));
+        last_trip_.subject = DEADLINE_NO_TRIP;
+    }
+
+#ifdef USE_WDT
+    wdt_register_write_enable(TRUE);
+    wdt_divider_set(WDT_CLK_DIV_64);
+    wdt_reload_value_set(DEADLINE_WDT_RELOAD);
+    wdt_counter_reload();
+    wdt_enable();
+#endif
+}
+
+void DeadlineMonitor::Report(DeadlineSubject subject) {
+    SubjectState &s = state_[subject];
+    const TickType_t now = xTaskGetTickCount();
+
+    taskENTER_CRITICAL();
+    if (s.armed) {
+        const uint32_t interval_ms = (now - s.last) * portTICK_PERIOD_MS;
+        uint32_t bucket = interval_ms == 0 ? 0U : 32U - static_cast<uint32_t>(__builtin_clz(interval_ms));
+        if (bucket >= DEADLINE_BUCKETS) {
+            bucket = DEADLINE_BUCKETS - 1U;
+        }
+        if (s.buckets[bucket] != UINT16_MAX) {
+            s.buckets[bucket]++;
+        }
+        if (interval_ms > s.max_ms) {
+            s.max_ms = saturate(interval_ms);
+        }
+    }
+    s.last = now;
+    s.armed = true;
+    s.reports++;
+    late_mask_ = static_cast<uint16_t>(late_mask_ & ~(1U << subject));
+    taskEXIT_CRITICAL();
+}
+
+void DeadlineMonitor::Release(DeadlineSubject subject) {
+    taskENTER_CRITICAL();
+    state_[subject].armed = false;
+    late_mask_ = static_cast<uint16_t>(late_mask_ & ~(1U << subject));
+    taskEXIT_CRITICAL();
+}
+
+void DeadlineMonitor::Tick(void) {
+    if (tripped_) {
+        return; // Feed() stopped, the watchdog resets the MCU
+    }
+
+    const TickType_t now = xTaskGetTickCountFromISR();
+    for (uint8_t i = 0; i < DEADLINE_SUBJECTS; i++) {
+        SubjectState &s = state_[i];
+        if (!s.armed) {
+            continue;
+        }
+        const uint32_t gap_ms = (now - s.last) * portTICK_PERIOD_MS;
+        if (gap_ms > config_[i].warn_ms && !(late_mask_ & (1U << i))) {
+            late_mask_ = static_cast<uint16_t>(late_mask_ | (1U << i));
+            if (s.warnings != UINT16_MAX) {
+                s.warnings++;
+            }
+            PowerManager::Wake(wake_task_);
+        }
+        if (gap_ms > config_[i].limit_ms) {
+            save_trip(i, gap_ms);
+            tripped_ = true;
+            return;
+        }
+    }
+}
+
+void DeadlineMonitor::Feed(void) {
+    // Checked here as well: after a tickless sleep the idle hook can run before the next tick hook
+    const TickType_t now = xTaskGetTickCount();
+    taskENTER_CRITICAL();
+    bool met = !tripped_;
+    for (uint8_t i = 0; met && i < DEADLINE_SUBJECTS; i++) {
+        met = !state_[i].armed || (now - state_[i].last) * portTICK_PERIOD_MS <= config_[i].limit_ms;
+    }
+    taskEXIT_CRITICAL();
+
+#ifdef USE_WDT
+    if (met) {
+        wdt_counter_reload();
+    }
+#else
+    (void)met;
+#endif
+}
+
+void DeadlineMonitor::SetWakeTask(TaskHandle_t task) {
+    wake_task_ = task;
+}
+
+bool DeadlineMonitor::GetStats(uint8_t subject, DeadlineStats &out) {
+    if (subject >= DEADLINE_SUBJECTS) {
+        return false;
+    }
+    const SubjectState &s = state_[subject];
+    out.period_ms = config_[subject].period_ms;
+    out.warn_ms = config_[subject].warn_ms;
+    out.limit_ms = config_[subject].limit_ms;
+
+    taskENTER_CRITICAL();
+    out.max_ms = s.max_ms;
+    out.reports = s.reports;
+    out.warnings = s.warnings;
+    out.late_ms = s.armed ? saturate((xTaskGetTickCount() - s.last) * portTICK_PERIOD_MS) : 0U;
+    memcpy(out.buckets, s.buckets, sizeof(out.buckets));
+    taskEXIT_CRITICAL();
+    return true;
+}
@@ -0,0 +1,124 @@
+#ifndef __DEADLINE_MONITOR_H__
+#define __DEADLINE_MONITOR_H__
+
+#include <stdint.h>
+#include "FreeRTOS.h"
+#include "task.h"
+
+#define DEADLINE_BUCKETS            (16U)       /// log2 interval histogram, bucket k = [2^(k-1), 2^k) ms
+#define DEADLINE_TRIP_MARKER        (0xD101U)   /// BPR_DATA23, a trip record follows
+#define DEADLINE_NO_TRIP            (0xFFFFU)   /// trip subject when the last reset was not a trip
+#define DEADLINE_ERROR_CODE         (0xDE00U)   /// ErrorLog code of a trip, ORed with the subject
+#define DEADLINE_WDT_TIMEOUT_MS     (2000U)     /// hardware watchdog, LICK 40 kHz / 64 * 1250
+#define DEADLINE_MB_ADDRESS         (23U)       /// first Modbus input register of the status
+#define DEADLINE_MB_REGS            (3U)        /// late mask, trip subject, trip late_ms
+
+/** @brief Monitored task loops, bit n of the late mask is subject n */
+enum DeadlineSubject : uint8_t {
+    DEADLINE_INPUT_UPDATE = 0,
+    DEADLINE_OUTPUT_UPDATE,
+    DEADLINE_CANOPEN,
+    DEADLINE_CANOPEN_TMR,
+    DEADLINE_UART,
+    DEADLINE_USB,
+    DEADLINE_UNIT_CONTROL,
+    DEADLINE_LED,
+    DEADLINE_SUBJECTS
+};
+
+#pragma pack(push, 1)
+/** @brief Report intervals of one subject, exported by GetDeadlineStats */
+struct DeadlineStats {
+    uint16_t period_ms;                 /// expected interval
+    uint16_t warn_ms;                   /// a longer gap raises the early warning
+    uint16_t limit_ms;                  /// a longer gap stops feeding the watchdog
+    uint16_t max_ms;                    /// longest interval since start-up, saturates
+    uint32_t reports;                   /// Report() calls since start-up
+    uint16_t warnings;                  /// gaps longer than warn_ms, saturates
+    uint16_t late_ms;                   /// time since the last report, 0 before the first one
+    uint16_t buckets[DEADLINE_BUCKETS]; /// interval counts, saturate
+};
+
+/**
+ * @brief Trip record kept in BPR_DATA23..BPR_DATA27 across the watchdog reset, check word in BPR_DATA28
+ * The histogram is summarised as a 2-bit level per bucket: 0 = empty,
+ * 1 = 1-15, 2 = 16-255, 3 = 256 or more intervals.
+ */
+struct DeadlineTrip {
+    uint16_t marker;                    /// DEADLINE_TRIP_MARKER, else no trip
+    uint16_t subject;                   /// DeadlineSubject that missed its limit
+    uint16_t late_ms;                   /// gap when the limit was missed
+    uint32_t levels;                    /// bits 2k+1..2k: level of bucket k of the subject at that moment
+};
+#pragma pack(pop)
+
+/**
+ * @brief Per-task deadline monitor in front of the hardware watchdog
+ * Each task loop calls Report() once per pass. The interval since the
+ * previous report goes into a log2 histogram of the subject; a subject is
+ * armed by its first report, so tasks still initialising are not checked.
+ *
+ * Tick() runs in the tick hook and checks the gap of every armed subject:
+ * - longer than warn_ms: the subject bit is set in the late mask (Modbus
+ *   input register DEADLINE_MB_ADDRESS, CANopen EMCY from CANopenTask) and
+ *   the wake task is notified; the bit clears on the next report;
+ * - longer than limit_ms: the subject and its histogram are written to the
+ *   backup registers (histogram as bucket levels) and the monitor trips.
+ *
+ * Feed() in the idle hook is the only place that reloads the watchdog
+ * (IWDG). It reloads only while no armed subject is over its limit and the
+ * monitor has not tripped, so a stuck task loop stops the reloads, and so
+ * does starving the idle task; the MCU resets DEADLINE_WDT_TIMEOUT_MS
+ * later. A tickless sleep (at most 559 ms) runs the idle hook before and
+ * after it. The watchdog is only started in USE_WDT builds; otherwise trips
+ * are still recorded but nothing resets.
+ *
+ * Init() reads a trip record left before the reset, logs it to the
+ * ErrorLog as DEADLINE_ERROR_CODE | subject and clears it.
+ */
+class DeadlineMonitor {
+public:
+    /**
+     * @brief Capture the previous trip and start the watchdog
+     * Called once before the scheduler starts, after ErrorLog::Init().
+     */
+    static void Init(void);
+
+    /**
+     * @brief Record one pass of a task loop, task context only
+     */
+    static void Report(DeadlineSubject subject);
+
+    /**
+     * @brief Stop checking a subject until its next report
+     * For a task that leaves its loop on purpose, e.g. before a CANopen reset.
+     */
+    static void Release(DeadlineSubject subject);
+
+    /**
+     * @brief Check the deadlines, raise warnings and record a trip
+     * Call from vApplicationTickHook.
+     */
+    static void Tick(void);
+
+    /**
+     * @brief Reload the watchdog if all deadlines are met
+     * Call from vApplicationIdleHook; nothing else reloads the IWDG.
+     */
+    static void Feed(void);
+
+    /**
+     * @brief Task notified (PowerManager::Wake) when a subject becomes late
+     */
+    static void SetWakeTask(TaskHandle_t task);
+
+    static uint16_t GetLateMask(void) { return late_mask_; }
+    static bool GetStats(uint8_t subject, DeadlineStats &out);
+    static const DeadlineTrip& GetLastTrip(void) { return last_trip_; }
+
+private:
+    static volatile uint16_t late_mask_;
+    static DeadlineTrip last_trip_;
+};
+
+#endif // __DEADLINE_MONITOR_H__
@@ -1,15 +1,109 @@
 #include "DisplayApp.h"
+#include "DisplayPanel.h"
+#include "PowerManager.h"
 #include "FreeRTOS.h"
 #include "task.h"
+#include "ui.h"
+#include "P-Block-struct.h"
 #include <cstdint>
+#include <cstdio>
+
+#define DISPLAY_FAST_MS     (50U)       /// changes within this time are drawn together
+#define DISPLAY_IDLE_MS     (500U)      /// longest wait for the LVGL timers while nothing changes
+
+/**
+ * @brief UI label bound to a register value
+ * The label is set only when a change of its value is notified, so LVGL
+ * invalidates and redraws that label's area and nothing else.
+ */
+struct DisplayBinding {
+    lv_obj_t **label;
+    const char *format;
+    uint16_t (*read)(void);
+    uint32_t change;                    /// PBLOCK_CHANGE_* bit of the value
+};
+
+static uint16_t read_status(void) { return PBlockRegisters_t::holding_registers.status; }
+static uint16_t read_input_1(void) { return PBlockRegisters_t::GetUniversalInput(1); }
+
+static const DisplayBinding bindings_[] = {
+    {&ui_Text1, "Status %u", read_status, PBLOCK_CHANGE_STATUS},
+    {&ui_Text2, "UI1 %u mV", read_input_1, PBLOCK_CHANGE_INPUT(1)},
+};
+
+static TaskHandle_t display_task_;
+static volatile uint32_t changed_;      /// PBLOCK_CHANGE_* bits not drawn yet
+
+/**
+ * @brief Change subscription, runs in the writer's context
+ */
+static void on_change(uint32_t changed)
+{
+    __atomic_fetch_or(&changed_, changed, __ATOMIC_RELEASE);
+    PowerManager::Wake(display_task_);
+}
+
+/**
+ * @brief Set the labels of the changed values
+ */
+static void update_bindings(uint32_t changed)
+{
+    for (const DisplayBinding &binding : bindings_)
+    {
+        if ((binding.change & changed) == 0 || *binding.label == NULL)
+        {
+            continue;
+        }
+        char text[24];
+        snprintf(text, sizeof(text), binding.format, binding.read());
+        lv_label_set_text(*binding.label, text);
+    }
+}
 
 void displayFun(void *parameters)
 {
     (void)parameters;
-    // Display management task
+
+    // Starts LVGL and registers the panel; flushes wake this task
+    display_task_ = xTaskGetCurrentTaskHandle();
+    DisplayPanel::Init();
+    ui_init();
+
+    uint32_t subscribed = 0;
+    for (const DisplayBinding &binding : bindings_)
+    {
+        subscribed |= binding.change;
+    }
+    changed_ = subscribed;              // first pass shows every value
+    PBlockRegisters_t::Subscribe(subscribed, on_change);
+
+    TickType_t last_run = xTaskGetTickCount();
     for (;;)
     {
-        // Display updates and management - to be implemented
-        vTaskDelay(100); // Update display periodically
+        const TickType_t now = xTaskGetTickCount();
+        lv_tick_inc((now - last_run) * portTICK_PERIOD_MS);
+        last_run = now;
+
+        const uint32_t changed = __atomic_exchange_n(&changed_, 0U, __ATOMIC_ACQUIRE);
+        update_bindings(changed);
+
+        // Redraws only the invalidated areas; returns when the next LVGL timer is due
+        uint32_t wait_ms = lv_timer_handler();
+
+        if (changed != 0)
+        {
+            // Fast while values move: collect what changes meanwhile
+            vTaskDelay(pdMS_TO_TICKS(DISPLAY_FAST_MS));
+        }
+        else if (__atomic_load_n(&changed_, __ATOMIC_ACQUIRE) == 0)
+        {
+            // Static screen: sleep until a change or the next LVGL timer. A change
+            // notified while a flush was waited on is caught by the check above.
+            if (wait_ms > DISPLAY_IDLE_MS)
+            {
+                wait_ms = DISPLAY_IDLE_MS;
+            }
+            ulTaskNotifyTake(pdTRUE, wait_ms < portTICK_PERIOD_MS ? 1 : pdMS_TO_TICKS(wait_ms));
+        }
     }
 }
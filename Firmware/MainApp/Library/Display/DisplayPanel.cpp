@@ -0,0 +1,210 @@
+#include "DisplayPanel.h"
+#include "PowerManager.h"
+
+#define DISPLAY_BUF_PIXELS          (DISPLAY_WIDTH * DISPLAY_BUF_LINES)
+#define DISPLAY_TX_BYTES            (DISPLAY_WIDTH * DISPLAY_BUF_LINES / DISPLAY_PAGE_LINES)
+#define DISPLAY_FLUSH_TIMEOUT_MS    (20U)       /// a full buffer takes about 0.3 ms at 7.5 MHz
+#define DISPLAY_DARK_BRIGHTNESS     (128U)      /// pixels below this brightness are set on the panel
+
+// ST7567 commands
+#define ST7567_PAGE_ADDRESS         (0xB0U)
+#define ST7567_COLUMN_HIGH          (0x10U)
+#define ST7567_COLUMN_LOW           (0x00U)
+
+volatile uint8_t DisplayPanel::page_ = 0;
+uint8_t DisplayPanel::first_page_ = 0;
+uint8_t DisplayPanel::last_page_ = 0;
+uint8_t DisplayPanel::first_column_ = 0;
+uint8_t DisplayPanel::columns_ = 0;
+uint32_t DisplayPanel::flush_count_ = 0;
+TaskHandle_t DisplayPanel::wake_task_ = NULL;
+
+static lv_disp_draw_buf_t draw_buf_;
+static lv_disp_drv_t disp_drv_;
+static lv_color_t buf_[2][DISPLAY_BUF_PIXELS];
+static uint8_t tx_[DISPLAY_TX_BYTES];       /// DMA source, one run of columns_ bytes per page
+
+void DisplayPanel::Init(void) {
+    wake_task_ = xTaskGetCurrentTaskHandle();
+    InitHardware();
+
+    gpio_bits_reset(DISPLAY_PORT, DISPLAY_PIN_RST);
+    vTaskDelay(pdMS_TO_TICKS(1));
+    gpio_bits_set(DISPLAY_PORT, DISPLAY_PIN_RST);
+    vTaskDelay(pdMS_TO_TICKS(5));
+
+    static const uint8_t init[] = {
+        0xE2,           // software reset
+        0xA2,           // bias 1/9
+        0xA0,           // column order normal
+        0xC8,           // rows bottom to top
+        0x25,           // regulation ratio
+        0x81, 0x20,     // contrast
+        0x2F,           // booster, regulator and follower on
+        0x40,           // start line 0
+        0xAF,           // display on
+    };
+    gpio_bits_reset(DISPLAY_PORT, DISPLAY_PIN_CS);
+    SendCommands(init, sizeof(init));
+    gpio_bits_set(DISPLAY_PORT, DISPLAY_PIN_CS);
+
+    lv_init();
+    lv_disp_draw_buf_init(&draw_buf_, buf_[0], buf_[1], DISPLAY_BUF_PIXELS);
+    lv_disp_drv_init(&disp_drv_);
+    disp_drv_.hor_res = DISPLAY_WIDTH;
+    disp_drv_.ver_res = DISPLAY_HEIGHT;
+    disp_drv_.draw_buf = &draw_buf_;
+    disp_drv_.flush_cb = Flush;
+    disp_drv_.rounder_cb = Rounder;
+    disp_drv_.wait_cb = Wait;
+    lv_disp_drv_register(&disp_drv_);
+}
+
+void DisplayPanel::InitHardware(void) {
+    gpio_init_type gpio_init_struct;
+    spi_init_type spi_init_struct;
+    dma_init_type dma_init_struct;
+
+    crm_periph_clock_enable(DISPLAY_PORT_CLOCK, TRUE);
+    crm_periph_clock_enable(DISPLAY_SPI_CLOCK, TRUE);
+    crm_periph_clock_enable(CRM_DMA1_PERIPH_CLOCK, TRUE);
+
+    gpio_default_para_init(&gpio_init_struct);
+    gpio_init_struct.gpio_drive_strength = GPIO_DRIVE_STRENGTH_STRONGER;
+    gpio_init_struct.gpio_out_type = GPIO_OUTPUT_PUSH_PULL;
+    gpio_init_struct.gpio_pull = GPIO_PULL_NONE;
+    gpio_init_struct.gpio_mode = GPIO_MODE_MUX;
+    gpio_init_struct.gpio_pins = DISPLAY_PIN_SCK | DISPLAY_PIN_MOSI;
+    gpio_init(DISPLAY_PORT, &gpio_init_struct);
+    gpio_init_struct.gpio_mode = GPIO_MODE_OUTPUT;
+    gpio_init_struct.gpio_pins = DISPLAY_PIN_RST | DISPLAY_PIN_CS | DISPLAY_PIN_DC;
+    gpio_init(DISPLAY_PORT, &gpio_init_struct);
+    gpio_bits_set(DISPLAY_PORT, DISPLAY_PIN_RST | DISPLAY_PIN_CS);
+
+    // Mode 3, MSB first, APB1/16; the panel only receives
+    spi_default_para_init(&spi_init_struct);
+    spi_init_struct.transmission_mode = SPI_TRANSMIT_HALF_DUPLEX_TX;
+    spi_init_struct.master_slave_mode = SPI_MODE_MASTER;
+    spi_init_struct.mclk_freq_division = SPI_MCLK_DIV_16;
+    spi_init_struct.first_bit_transmission = SPI_FIRST_BIT_MSB;
+    spi_init_struct.frame_bit_num = SPI_FRAME_8BIT;
+    spi_init_struct.clock_polarity = SPI_CLOCK_POLARITY_HIGH;
+    spi_init_struct.clock_phase = SPI_CLOCK_PHASE_2EDGE;
+    spi_init_struct.cs_mode_selection = SPI_CS_SOFTWARE_MODE;
+    spi_init(DISPLAY_SPI, &spi_init_struct);
+    spi_i2s_dma_transmitter_enable(DISPLAY_SPI, TRUE);
+    spi_enable(DISPLAY_SPI, TRUE);
+
+    dma_reset(DISPLAY_DMA);
+    dma_default_para_init(&dma_init_struct);
+    dma_init_struct.buffer_size = 0;
+    dma_init_struct.direction = DMA_DIR_MEMORY_TO_PERIPHERAL;
+    dma_init_struct.memory_base_addr = static_cast<uint32_t>(reinterpret_cast<uintptr_t>(tx_));
+    dma_init_struct.memory_data_width = DMA_MEMORY_DATA_WIDTH_BYTE;
+    dma_init_struct.memory_inc_enable = TRUE;
+    dma_init_struct.peripheral_base_addr = static_cast<uint32_t>(reinterpret_cast<uintptr_t>(&DISPLAY_SPI->dt));
+    dma_init_struct.peripheral_data_width = DMA_PERIPHERAL_DATA_WIDTH_BYTE;
+    dma_init_struct.peripheral_inc_enable = FALSE;
+    dma_init_struct.priority = DMA_PRIORITY_LOW;
+    dma_init_struct.loop_mode_enable = FALSE;
+    dma_init(DISPLAY_DMA, &dma_init_struct);
+    dma_interrupt_enable(DISPLAY_DMA, DMA_FDT_INT, TRUE);
+    nvic_irq_enable(DISPLAY_DMA_IRQ, DISPLAY_IRQ_PRIORITY, 0);
+}
+
+void DisplayPanel::SendCommands(const uint8_t *commands, uint8_t count) {
+    gpio_bits_reset(DISPLAY_PORT, DISPLAY_PIN_DC);
+    for (uint8_t i = 0; i < count; i++) {
+        while (spi_i2s_flag_get(DISPLAY_SPI, SPI_I2S_TDBE_FLAG) == RESET) {
+        }
+        spi_i2s_data_transmit(DISPLAY_SPI, commands[i]);
+    }
+    while (spi_i2s_flag_get(DISPLAY_SPI, SPI_I2S_BF_FLAG) != RESET) {
+    }
+    gpio_bits_set(DISPLAY_PORT, DISPLAY_PIN_DC);
+}
+
+/**
+ * @brief Widen the area to whole controller pages
+ */
+void DisplayPanel::Rounder(lv_disp_drv_t *drv, lv_area_t *area) {
+    (void)drv;
+    area->y1 = static_cast<lv_coord_t>(area->y1 & ~static_cast<lv_coord_t>(DISPLAY_PAGE_LINES - 1U));
+    area->y2 = static_cast<lv_coord_t>(area->y2 | static_cast<lv_coord_t>(DISPLAY_PAGE_LINES - 1U));
+}
+
+/**
+ * @brief Block until the DMA interrupt ends the flush
+ */
+void DisplayPanel::Wait(lv_disp_drv_t *drv) {
+    (void)drv;
+    ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(DISPLAY_FLUSH_TIMEOUT_MS));
+}
+
+void DisplayPanel::Flush(lv_disp_drv_t *drv, const lv_area_t *area, lv_color_t *colors) {
+    (void)drv;
+    const uint32_t width = static_cast<uint32_t>(lv_area_get_width(area));
+    const uint32_t pages = static_cast<uint32_t>(lv_area_get_height(area)) / DISPLAY_PAGE_LINES;
+
+    // Page byte: bit n is row n of the page, LSB at the top
+    uint8_t *out = tx_;
+    for (uint32_t page = 0; page < pages; page++) {
+        const lv_color_t *column = colors + page * DISPLAY_PAGE_LINES * width;
+        for (uint32_t x = 0; x < width; x++, column++) {
+            uint8_t bits = 0;
+            for (uint32_t row = 0; row < DISPLAY_PAGE_LINES; row++) {
+                if (lv_color_brightness(column[row * width]) < DISPLAY_DARK_BRIGHTNESS) {
+                    bits = static_cast<uint8_t>(bits | (1U << row));
+                }
+            }
+            *out++ = bits;
+        }
+    }
+
+    first_page_ = static_cast<uint8_t>(area->y1 / DISPLAY_PAGE_LINES);
+    last_page_ = static_cast<uint8_t>(first_page_ + pages - 1U);
+    first_column_ = static_cast<uint8_t>(area->x1);
+    columns_ = static_cast<uint8_t>(width);
+    page_ = first_page_;
+    flush_count_++;
+
+    gpio_bits_reset(DISPLAY_PORT, DISPLAY_PIN_CS);
+    StartPage();
+}
+
+void DisplayPanel::StartPage(void) {
+    const uint8_t address[3] = {
+        static_cast<uint8_t>(ST7567_PAGE_ADDRESS | page_),
+        static_cast<uint8_t>(ST7567_COLUMN_HIGH | (first_column_ >> 4)),
+        static_cast<uint8_t>(ST7567_COLUMN_LOW | (first_column_ & 0x0FU)),
+    };
+    SendCommands(address, sizeof(address));
+
+    DISPLAY_DMA->maddr = static_cast<uint32_t>(reinterpret_cast<uintptr_t>(&tx_[(page_ - first_page_) * columns_]));
+    dma_data_number_set(DISPLAY_DMA, columns_);
+    dma_channel_enable(DISPLAY_DMA, TRUE);
+}
+
+void DisplayPanel::DmaIrqHandler(void) {
+    if (dma_flag_get(DISPLAY_DMA_DONE_FLAG) == RESET) {
+        return;
+    }
+    dma_flag_clear(DISPLAY_DMA_DONE_FLAG);
+    dma_channel_enable(DISPLAY_DMA, FALSE);
+
+    // The last byte is still shifting out; DC must not change before it is sent
+    while (spi_i2s_flag_get(DISPLAY_SPI, SPI_I2S_BF_FLAG) != RESET) {
+    }
+    if (page_ < last_page_) {
+        page_ = static_cast<uint8_t>(page_ + 1U);
+        StartPage();    // three command bytes, about 3 us
+        return;
+    }
+    gpio_bits_set(DISPLAY_PORT, DISPLAY_PIN_CS);
+    lv_disp_flush_ready(&disp_drv_);
+    PowerManager::Wake(wake_task_);
+}
+
+extern "C" void DMA1_Channel5_IRQHandler(void) {
+    DisplayPanel::DmaIrqHandler();
+}
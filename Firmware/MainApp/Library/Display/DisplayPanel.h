@@ -0,0 +1,82 @@
+#ifndef __DISPLAY_PANEL_H__
+#define __DISPLAY_PANEL_H__
+
+#include <stdint.h>
+#include "at32f403a_407_spi.h"
+#include "at32f403a_407_dma.h"
+#include "at32f403a_407_gpio.h"
+#include "at32f403a_407_crm.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include "lvgl/lvgl.h"
+
+#define DISPLAY_WIDTH               (128U)
+#define DISPLAY_HEIGHT              (64U)
+#define DISPLAY_PAGE_LINES          (8U)        /// rows per controller page, one byte per column
+#define DISPLAY_BUF_LINES           (16U)       /// rows per LVGL draw buffer, a multiple of DISPLAY_PAGE_LINES
+#define DISPLAY_IRQ_PRIORITY        (7U)
+
+// Pins are an assumption, adjust them to the board; SPI2 on PB12..PB15 stays clear of the universal inputs (PB0..PB10)
+#define DISPLAY_SPI                 SPI2
+#define DISPLAY_SPI_CLOCK           CRM_SPI2_PERIPH_CLOCK
+#define DISPLAY_DMA                 DMA1_CHANNEL5           /// SPI2 TX request
+#define DISPLAY_DMA_IRQ             DMA1_Channel5_IRQn
+#define DISPLAY_DMA_DONE_FLAG       DMA1_FDT5_FLAG
+#define DISPLAY_PORT                GPIOB
+#define DISPLAY_PORT_CLOCK          CRM_GPIOB_PERIPH_CLOCK
+#define DISPLAY_PIN_RST             GPIO_PINS_11
+#define DISPLAY_PIN_CS              GPIO_PINS_12
+#define DISPLAY_PIN_SCK             GPIO_PINS_13
+#define DISPLAY_PIN_DC              GPIO_PINS_14            /// low: command, high: data
+#define DISPLAY_PIN_MOSI            GPIO_PINS_15
+
+static_assert(DISPLAY_BUF_LINES % DISPLAY_PAGE_LINES == 0, "flushes are whole controller pages");
+
+/**
+ * @brief LVGL display driver of the 128x64 monochrome panel (ST7567 on SPI)
+ * LVGL renders into two partial draw buffers of DISPLAY_BUF_LINES rows.
+ * The rounder widens every invalidated area to whole controller pages;
+ * the flush callback packs the area into page bytes (a pixel is on when
+ * its colour is dark) and hands it to DMA, one page per transfer, with
+ * the page address commands sent in between from the transfer-complete
+ * interrupt. LVGL renders the next area into the other buffer meanwhile.
+ *
+ * While LVGL waits for a flush to end, the calling task blocks in
+ * ulTaskNotifyTake and the DMA interrupt wakes it (PowerManager::Wake)
+ * instead of the task spinning on the flushing flag.
+ */
+class DisplayPanel {
+public:
+    /**
+     * @brief Reset the panel, start LVGL and register the display
+     * Task context, waits for the panel reset; the calling task is the one
+     * woken at the end of each flush.
+     */
+    static void Init(void);
+
+    /**
+     * @brief Flushes started since start-up
+     */
+    static uint32_t GetFlushCount(void) { return flush_count_; }
+
+    static void DmaIrqHandler(void);
+
+private:
+    static void InitHardware(void);
+    static void SendCommands(const uint8_t *commands, uint8_t count);
+    static void StartPage(void);
+
+    static void Rounder(lv_disp_drv_t *drv, lv_area_t *area);
+    static void Flush(lv_disp_drv_t *drv, const lv_area_t *area, lv_color_t *colors);
+    static void Wait(lv_disp_drv_t *drv);
+
+    static volatile uint8_t page_;          /// page being sent
+    static uint8_t first_page_;
+    static uint8_t last_page_;
+    static uint8_t first_column_;
+    static uint8_t columns_;
+    static uint32_t flush_count_;
+    static TaskHandle_t wake_task_;
+};
+
+#endif // __DISPLAY_PANEL_H__
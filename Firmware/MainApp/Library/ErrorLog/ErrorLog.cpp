@@ -0,0 +1,326 @@
+#include "ErrorLog.h"
+#include "StorageFlush.h"
+#include "FreeRTOS.h"
+#include "task.h"
+
+#define ERROR_LOG_HEADER_SIZE       (8U)    // magic, sequence
+#define ERROR_LOG_ENTRY_SIZE        (12U)
+#define ERROR_LOG_SECTOR_ENTRIES    ((FLASH_SECTOR_SIZE - ERROR_LOG_HEADER_SIZE) / ERROR_LOG_ENTRY_SIZE)
+#define ERROR_LOG_RAM_MASK          (ERROR_LOG_RAM_ENTRIES - 1U)
+#define ERASED_WORD                 (0xFFFFFFFFU)
+
+static_assert((ERROR_LOG_RAM_ENTRIES & ERROR_LOG_RAM_MASK) == 0, "RAM ring size must be a power of two");
+static_assert(ERROR_LOG_SECTORS >= 2, "flash ring needs two sectors");
+
+ErrorLogEntry ErrorLog::ring_[ERROR_LOG_RAM_ENTRIES];
+uint32_t ErrorLog::head_ = 0;
+uint32_t ErrorLog::tail_ = 0;
+uint32_t ErrorLog::spill_end_ = 0;
+uint32_t ErrorLog::visible_ = 0;
+uint32_t ErrorLog::dropped_ = 0;
+
+uint8_t ErrorLog::active_ = 0;
+uint32_t ErrorLog::sequence_ = 0;
+uint32_t ErrorLog::active_used_ = 0;
+uint8_t ErrorLog::older_ = 0;
+
+static inline uint32_t ReadWord(uint32_t address) {
+    return *reinterpret_cast<const volatile uint32_t *>(address);
+}
+
+static inline uint32_t SectorBase(uint8_t sector) {
+    return (ERROR_JOURNAL_ADDRESS) + sector * FLASH_SECTOR_SIZE;
+}
+
+uint32_t ErrorLog::SlotAddress(uint8_t sector, uint32_t slot) {
+    return SectorBase(sector) + ERROR_LOG_HEADER_SIZE + slot * ERROR_LOG_ENTRY_SIZE;
+}
+
+bool ErrorLog::Init(void) {
+    bool found = false;
+
+    StorageFlush::Register(Spill, HasPending);
+
+    for (uint8_t sector = 0; sector < ERROR_LOG_SECTORS; sector++) {
+        const uint32_t base = SectorBase(sector);
+        const uint32_t sequence = ReadWord(base + 4);
+        if (ReadWord(base) == ERROR_LOG_MAGIC && (!found || static_cast<int32_t>(sequence - sequence_) > 0)) {
+            found = true;
+            active_ = sector;
+            sequence_ = sequence;
+        }
+    }
+
+    if (!found) {
+        flash_unlock();
+        bool ok = Format(0, 1);
+        flash_lock();
+        if (!ok) {
+            return false;
+        }
+        active_ = 0;
+        sequence_ = 1;
+    }
+
+    // Entries are appended in order, the first fully erased slot is the end
+    active_used_ = 0;
+    while (active_used_ < ERROR_LOG_SECTOR_ENTRIES) {
+        const uint32_t address = SlotAddress(active_, active_used_);
+        if (ReadWord(address) == ERASED_WORD && ReadWord(address + 4) == ERASED_WORD &&
+            ReadWord(address + 8) == ERASED_WORD) {
+            break;
+        }
+        active_used_++;
+    }
+
+    // Older sectors count only while their sequences are contiguous
+    older_ = 0;
+    while (older_ < ERROR_LOG_SECTORS - 1) {
+        const uint8_t sector = static_cast<uint8_t>((active_ + ERROR_LOG_SECTORS - older_ - 1) % ERROR_LOG_SECTORS);
+        const uint32_t base = SectorBase(sector);
+        if (ReadWord(base) != ERROR_LOG_MAGIC || ReadWord(base + 4) != sequence_ - older_ - 1) {
+            break;
+        }
+        older_++;
+    }
+
+    // Entries behind the newest clear marker stay hidden
+    const uint32_t stored = FlashCount();
+    visible_ = 0;
+    while (visible_ < stored) {
+        ErrorLogEntry entry;
+        ReadFlash(visible_, entry);
+        if (entry.code == ERROR_LOG_CLEAR_CODE) {
+            break;
+        }
+        visible_++;
+    }
+
+    head_ = tail_ = spill_end_ = 0;
+    return true;
+}
+
+void ErrorLog::Add(uint16_t code) {
+    if (code == ERROR_LOG_CLEAR_CODE) {
+        return;
+    }
+
+    const uint32_t rtc_time = rtc_counter_get();
+    const uint32_t uptime_ms = xTaskGetTickCount() * portTICK_PERIOD_MS;
+    bool request_spill;
+
+    taskENTER_CRITICAL();
+    ErrorLogEntry *last = &ring_[(head_ - 1U) & ERROR_LOG_RAM_MASK];
+    // The newest entry absorbs repeats unless it is already being programmed
+    if (head_ != tail_ && static_cast<int32_t>(head_ - 1U - spill_end_) >= 0 && last->code == code &&
+        last->count != UINT16_MAX) {
+        last->count++;
+        last->rtc_time = rtc_time;
+        last->uptime_ms = uptime_ms;
+    } else {
+        Push({code, 1, rtc_time, uptime_ms});
+    }
+    request_spill = (head_ - tail_) >= ERROR_LOG_PAGE_ENTRIES;
+    taskEXIT_CRITICAL();
+
+    if (request_spill) {
+        StorageFlush::Request();
+    }
+}
+
+void ErrorLog::Clear(void) {
+    const uint32_t rtc_time = rtc_counter_get();
+    const uint32_t uptime_ms = xTaskGetTickCount() * portTICK_PERIOD_MS;
+
+    taskENTER_CRITICAL();
+    Push({ERROR_LOG_CLEAR_CODE, 0, rtc_time, uptime_ms});
+    visible_ = 0;
+    taskEXIT_CRITICAL();
+
+    StorageFlush::Request();
+}
+
+/**
+ * @brief Append to the RAM ring, called inside a critical section
+ */
+void ErrorLog::Push(const ErrorLogEntry &entry) {
+    if ((head_ - tail_) == ERROR_LOG_RAM_ENTRIES) {
+        if (tail_ != spill_end_) {
+            // Oldest entry is being programmed, keep it and lose this one
+            dropped_++;
+            return;
+        }
+        tail_++;
+        spill_end_ = tail_;
+        dropped_++;
+    }
+    ring_[head_ & ERROR_LOG_RAM_MASK] = entry;
+    head_++;
+    visible_++;
+}
+
+uint32_t ErrorLog::FlashCount(void) {
+    return active_used_ + older_ * ERROR_LOG_SECTOR_ENTRIES;
+}
+
+uint32_t ErrorLog::GetCount(void) {
+    taskENTER_CRITICAL();
+    const uint32_t stored = (head_ - tail_) + FlashCount();
+    const uint32_t count = visible_ < stored ? visible_ : stored;
+    taskEXIT_CRITICAL();
+    return count;
+}
+
+/**
+ * @brief Read a flash entry, index 0 = newest in flash
+ */
+void ErrorLog::ReadFlash(uint32_t index, ErrorLogEntry &entry) {
+    uint8_t sector = active_;
+    uint32_t slot;
+
+    if (index < active_used_) {
+        slot = active_used_ - 1U - index;
+    } else {
+        index -= active_used_;
+        sector = static_cast<uint8_t>((active_ + ERROR_LOG_SECTORS - 1U - index / ERROR_LOG_SECTOR_ENTRIES) %
+                                      ERROR_LOG_SECTORS);
+        slot = ERROR_LOG_SECTOR_ENTRIES - 1U - index % ERROR_LOG_SECTOR_ENTRIES;
+    }
+
+    const uint32_t address = SlotAddress(sector, slot);
+    const uint32_t word = ReadWord(address);
+    entry.code = static_cast<uint16_t>(word);
+    entry.count = static_cast<uint16_t>(word >> 16);
+    entry.rtc_time = ReadWord(address + 4);
+    entry.uptime_ms = ReadWord(address + 8);
+}
+
+bool ErrorLog::GetEntry(uint32_t index, ErrorLogEntry &entry) {
+    bool found = true;
+
+    taskENTER_CRITICAL();
+    const uint32_t pending = head_ - tail_;
+    const uint32_t stored = pending + FlashCount();
+    if (index >= visible_ || index >= stored) {
+        found = false;
+    } else if (index < pending) {
+        entry = ring_[(head_ - 1U - index) & ERROR_LOG_RAM_MASK];
+    } else {
+        ReadFlash(index - pending, entry);
+    }
+    taskEXIT_CRITICAL();
+
+    return found;
+}
+
+uint16_t ErrorLog::GetField(uint32_t index, ErrorLogField field) {
+    ErrorLogEntry entry;
+
+    if (!GetEntry(index, entry)) {
+        return 0;
+    }
+
+    const uint32_t uptime_s = entry.uptime_ms / 1000U;
+    switch (field) {
+        case ErrorLogField::CODE:           return entry.code;
+        case ErrorLogField::COUNT:          return entry.count;
+        case ErrorLogField::RTC_HIGH:       return static_cast<uint16_t>(entry.rtc_time >> 16);
+        case ErrorLogField::RTC_LOW:        return static_cast<uint16_t>(entry.rtc_time);
+        case ErrorLogField::UPTIME_S_HIGH:  return static_cast<uint16_t>(uptime_s >> 16);
+        case ErrorLogField::UPTIME_S_LOW:   return static_cast<uint16_t>(uptime_s);
+        default:                            return 0;
+    }
+}
+
+bool ErrorLog::Format(uint8_t sector, uint32_t sequence) {
+    const uint32_t base = SectorBase(sector);
+
+    // Magic last: a sector erased but cut short before its header stays invalid
+    return flash_sector_erase(base) == FLASH_OPERATE_DONE &&
+           flash_word_program(base + 4, sequence) == FLASH_OPERATE_DONE &&
+           flash_word_program(base, ERROR_LOG_MAGIC) == FLASH_OPERATE_DONE;
+}
+
+/**
+ * @brief Continue in the next sector, erasing the oldest one
+ */
+bool ErrorLog::Rotate(void) {
+    const uint8_t next = static_cast<uint8_t>((active_ + 1U) % ERROR_LOG_SECTORS);
+
+    // Stop showing the sector before it is erased
+    taskENTER_CRITICAL();
+    if (older_ == ERROR_LOG_SECTORS - 1U) {
+        older_--;
+    }
+    taskEXIT_CRITICAL();
+
+    if (!Format(next, sequence_ + 1U)) {
+        return false;
+    }
+
+    taskENTER_CRITICAL();
+    active_ = next;
+    sequence_++;
+    active_used_ = 0;
+    older_++;
+    taskEXIT_CRITICAL();
+    return true;
+}
+
+bool ErrorLog::ProgramEntry(uint32_t address, const ErrorLogEntry &entry) {
+    const uint32_t word = entry.code | (static_cast<uint32_t>(entry.count) << 16);
+
+    // Code first, a torn entry still tells what happened
+    return flash_word_program(address, word) == FLASH_OPERATE_DONE &&
+           flash_word_program(address + 4, entry.rtc_time) == FLASH_OPERATE_DONE &&
+           flash_word_program(address + 8, entry.uptime_ms) == FLASH_OPERATE_DONE;
+}
+
+bool ErrorLog::Spill(void) {
+    bool ok = true;
+
+    if (!HasPending()) {
+        return true;
+    }
+
+    flash_unlock();
+    while (ok) {
+        ErrorLogEntry entry;
+
+        taskENTER_CRITICAL();
+        const bool any = head_ != tail_;
+        if (any) {
+            entry = ring_[tail_ & ERROR_LOG_RAM_MASK];
+            spill_end_ = tail_ + 1U;
+        }
+        taskEXIT_CRITICAL();
+
+        if (!any) {
+            break;
+        }
+
+        if (active_used_ == ERROR_LOG_SECTOR_ENTRIES) {
+            ok = Rotate();
+        }
+        if (ok) {
+            ok = ProgramEntry(SlotAddress(active_, active_used_), entry);
+
+            // The slot is used even if programming failed, Init() would count it too.
+            // On success the entry moves from RAM to flash in one step.
+            taskENTER_CRITICAL();
+            active_used_++;
+            if (ok) {
+                tail_++;
+            }
+            spill_end_ = tail_;
+            taskEXIT_CRITICAL();
+        } else {
+            taskENTER_CRITICAL();
+            spill_end_ = tail_;
+            taskEXIT_CRITICAL();
+        }
+    }
+    flash_lock();
+
+    return ok;
+}
@@ -0,0 +1,132 @@
+#ifndef __ERROR_LOG_H__
+#define __ERROR_LOG_H__
+
+#include <stdint.h>
+#include "at32f403a_407.h"
+#include "flash_map.h"
+
+#define ERROR_LOG_MAGIC             (0x474C5245U)   /// "ERLG", sector header
+#define ERROR_LOG_SECTORS           (ERROR_JOURNAL_SIZE / FLASH_SECTOR_SIZE)
+#define ERROR_LOG_RAM_ENTRIES       (32U)           /// entries waiting for flash, power of two
+#define ERROR_LOG_PAGE_ENTRIES      (10U)           /// spill batch and Modbus page (registers 210-219)
+#define ERROR_LOG_CLEAR_CODE        (0U)            /// marker entry written by Clear()
+
+/**
+ * @brief One journal entry, consecutive repeats of a code are merged
+ */
+struct ErrorLogEntry {
+    uint16_t code;
+    uint16_t count;         /// occurrences, saturates at 0xFFFF
+    uint32_t rtc_time;      /// RTC counter at the last occurrence, s
+    uint32_t uptime_ms;     /// uptime at the last occurrence
+};
+
+/**
+ * @brief Entry field shown in the Modbus page window
+ */
+enum class ErrorLogField : uint8_t {
+    CODE = 0,
+    COUNT = 1,
+    RTC_HIGH = 2,
+    RTC_LOW = 3,
+    UPTIME_S_HIGH = 4,
+    UPTIME_S_LOW = 5,
+};
+
+/**
+ * @brief Error journal: RAM ring in front of a flash ring
+ * Add() is O(1): the entry goes to a RAM ring, or only bumps the counter and
+ * timestamps of the newest entry when the same code repeats. Spill() moves
+ * the RAM entries to the ERROR_JOURNAL sectors; it runs from the storage
+ * task (StorageFlush), requested once a page of entries is waiting and at
+ * the latest STORAGE_FLUSH_PERIOD_MS after an entry is added.
+ *
+ * Flash: ERROR_LOG_SECTORS sectors used as a ring, each with a
+ * {magic, sequence} header followed by 12-byte entries. When the active
+ * sector is full the oldest one is erased and reused. The code/count word of
+ * an entry is programmed first: an entry cut short by a reset keeps its code,
+ * its timestamps read as 0xFFFFFFFF. Entries still in RAM are lost on power
+ * failure.
+ *
+ * Entries are addressed newest first, index 0 is the latest error. Clear()
+ * appends a marker entry; older entries stay in flash but are hidden.
+ */
+class ErrorLog {
+public:
+    /**
+     * @brief Find the active sector and count the stored entries
+     * Called once before the scheduler starts.
+     * @return false if the flash could not be formatted
+     */
+    static bool Init(void);
+
+    /**
+     * @brief Record an error occurrence, task context only
+     * @param code Error code, ERROR_LOG_CLEAR_CODE is ignored
+     */
+    static void Add(uint16_t code);
+
+    /**
+     * @brief Hide all entries logged so far
+     */
+    static void Clear(void);
+
+    /**
+     * @brief Get number of visible entries (RAM and flash)
+     */
+    static uint32_t GetCount(void);
+
+    /**
+     * @brief Get entry by index
+     * @param index 0 = newest
+     * @param entry Destination
+     * @return false if there is no such entry
+     */
+    static bool GetEntry(uint32_t index, ErrorLogEntry &entry);
+
+    /**
+     * @brief Get one field of an entry as a 16-bit register value
+     * @return Field value, 0 if there is no such entry
+     */
+    static uint16_t GetField(uint32_t index, ErrorLogField field);
+
+    /**
+     * @brief Check whether entries are waiting in RAM
+     */
+    static bool HasPending(void) { return head_ != tail_; }
+
+    /**
+     * @brief Program all RAM entries into flash
+     * Caller holds StorageFlush::Lock().
+     * @return true if nothing is left in RAM
+     */
+    static bool Spill(void);
+
+    /**
+     * @brief Get number of entries lost because the RAM ring was full
+     */
+    static uint32_t GetDroppedCount(void) { return dropped_; }
+
+private:
+    static uint32_t SlotAddress(uint8_t sector, uint32_t slot);
+    static uint32_t FlashCount(void);
+    static void ReadFlash(uint32_t index, ErrorLogEntry &entry);
+    static void Push(const ErrorLogEntry &entry);
+    static bool Format(uint8_t sector, uint32_t sequence);
+    static bool Rotate(void);
+    static bool ProgramEntry(uint32_t address, const ErrorLogEntry &entry);
+
+    static ErrorLogEntry ring_[ERROR_LOG_RAM_ENTRIES];
+    static uint32_t head_;          /// next RAM entry, free running
+    static uint32_t tail_;          /// oldest RAM entry not in flash
+    static uint32_t spill_end_;     /// entries before this one are being programmed
+    static uint32_t visible_;       /// entries newer than the last clear marker
+    static uint32_t dropped_;
+
+    static uint8_t active_;         /// sector being appended to
+    static uint32_t sequence_;      /// sequence of the active sector
+    static uint32_t active_used_;   /// slots used in the active sector
+    static uint8_t older_;          /// full sectors before the active one
+};
+
+#endif // __ERROR_LOG_H__
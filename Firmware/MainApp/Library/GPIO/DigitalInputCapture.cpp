@@ -0,0 +1,240 @@
+#include "DigitalInputCapture.h"
+#include "at32f403a_407_misc.h"
+#include "PowerManager.h"
+#include "ButtonsApp.h"
+
+SpscRing<DigitalInputCapture::EdgeEvent_t, DI_CAPTURE_QUEUE_SIZE> DigitalInputCapture::queue_;
+DigitalInputCapture::Debounce_t DigitalInputCapture::debounce_[DI_CAPTURE_INPUTS] = {};
+uint32_t DigitalInputCapture::counters_[DI_CAPTURE_INPUTS] = {};
+volatile uint16_t DigitalInputCapture::stable_mask_ = 0;
+uint16_t DigitalInputCapture::line_mask_ = 0;
+uint16_t DigitalInputCapture::debounce_ms_ = DI_CAPTURE_DEBOUNCE_MS;
+uint32_t DigitalInputCapture::last_dropped_ = 0;
+TaskHandle_t DigitalInputCapture::wake_task_ = NULL;
+bool DigitalInputCapture::initialized_ = false;
+
+// EXINT line -> input index, 0xFF when line is not used by inputs
+static uint8_t line_to_input[16];
+
+static uint8_t PinToLine(uint32_t pin) {
+    return static_cast<uint8_t>(__builtin_ctz(pin));
+}
+
+static gpio_port_source_type PortToSource(gpio_type* port) {
+    if (port == GPIOA) return GPIO_PORT_SOURCE_GPIOA;
+    if (port == GPIOC) return GPIO_PORT_SOURCE_GPIOC;
+    if (port == GPIOD) return GPIO_PORT_SOURCE_GPIOD;
+    if (port == GPIOE) return GPIO_PORT_SOURCE_GPIOE;
+    return GPIO_PORT_SOURCE_GPIOB;
+}
+
+static void EnableLineIrq(uint8_t line) {
+    IRQn_Type irq;
+    if (line <= 4) {
+        irq = static_cast<IRQn_Type>(EXINT0_IRQn + line);
+    } else if (line <= 9) {
+        irq = EXINT9_5_IRQn;
+    } else {
+        irq = EXINT15_10_IRQn;
+    }
+    nvic_irq_enable(irq, DI_CAPTURE_IRQ_PRIORITY, 0);
+}
+
+bool DigitalInputCapture::Init(void) {
+    exint_init_type exint_init_struct;
+
+    crm_periph_clock_enable(CRM_IOMUX_PERIPH_CLOCK, TRUE);
+
+    for (uint8_t line = 0; line < 16; line++) {
+        line_to_input[line] = 0xFF;
+    }
+
+    line_mask_ = 0;
+    for (uint8_t i = 0; i < DI_CAPTURE_INPUTS; i++) {
+        GPIOInputDriver::GPIOPin pin = GPIOInputDriver::GetPinMapping(i + 1);
+        uint8_t line = PinToLine(pin.pin);
+
+        // One EXINT line per pin number: two inputs must not share a pin number
+        if (line_mask_ & (1U << line)) {
+            return false;
+        }
+        line_mask_ |= static_cast<uint16_t>(1U << line);
+        line_to_input[line] = i;
+
+        gpio_exint_line_config(PortToSource(pin.port), static_cast<gpio_pins_source_type>(line));
+    }
+
+    // Start from the current levels so the first edges are not counted twice
+    stable_mask_ = ReadRawLevels();
+
+    exint_default_para_init(&exint_init_struct);
+    exint_init_struct.line_enable = TRUE;
+    exint_init_struct.line_mode = EXINT_LINE_INTERRUPUT;
+    exint_init_struct.line_select = line_mask_;
+    exint_init_struct.line_polarity = EXINT_TRIGGER_BOTH_EDGE;
+    exint_init(&exint_init_struct);
+    exint_flag_clear(line_mask_);
+
+    for (uint8_t line = 0; line < 16; line++) {
+        if (line_mask_ & (1U << line)) {
+            EnableLineIrq(line);
+        }
+    }
+
+    initialized_ = true;
+    return true;
+}
+
+uint16_t DigitalInputCapture::ReadRawLevels(void) {
+    uint16_t levels = 0;
+    for (uint8_t i = 0; i < DI_CAPTURE_INPUTS; i++) {
+        GPIOInputDriver::GPIOPin pin = GPIOInputDriver::GetPinMapping(i + 1);
+        if (pin.port->idt & pin.pin) {
+            levels |= static_cast<uint16_t>(1U << i);
+        }
+    }
+    return levels;
+}
+
+void DigitalInputCapture::IrqHandler(void) {
+    uint32_t pending = EXINT->intsts & line_mask_;
+    if (pending == 0) {
+        return;
+    }
+    EXINT->intsts = pending;
+
+    EdgeEvent_t event;
+    event.tick_ms = xTaskGetTickCountFromISR();
+    event.levels = ReadRawLevels();
+    event.lines = 0;
+    while (pending) {
+        uint8_t line = PinToLine(pending);
+        pending &= pending - 1;
+        event.lines |= static_cast<uint16_t>(1U << line_to_input[line]);
+    }
+
+    queue_.Push(event);
+    PowerManager::Wake(wake_task_);
+}
+
+void DigitalInputCapture::Confirm(uint8_t index, Changes_t& changes) {
+    uint16_t bit = static_cast<uint16_t>(1U << index);
+
+    debounce_[index].pending = false;
+    stable_mask_ = stable_mask_ ^ bit;
+    changes.state_changed |= bit;
+
+    if (stable_mask_ & bit) {
+        counters_[index]++;
+        changes.counter_changed |= bit;
+    }
+}
+
+void DigitalInputCapture::ApplyEdge(uint8_t index, bool level, uint32_t tick_ms, Changes_t& changes) {
+    Debounce_t& db = debounce_[index];
+
+    // Candidate that was stable long enough before this edge is accepted first
+    if (db.pending && (tick_ms - db.since_ms) >= debounce_ms_) {
+        Confirm(index, changes);
+    }
+
+    bool stable = (stable_mask_ >> index) & 1U;
+    if (level == stable) {
+        db.pending = false;     // bounced back within debounce time
+    } else if (!db.pending) {
+        db.pending = true;
+        db.since_ms = tick_ms;
+    }
+
+    if (db.pending && debounce_ms_ == 0) {
+        Confirm(index, changes);
+    }
+}
+
+DigitalInputCapture::Changes_t DigitalInputCapture::Process(uint32_t now_ms) {
+    Changes_t changes = {0, 0};
+
+    if (!initialized_) {
+        return changes;
+    }
+
+    EdgeEvent_t event;
+    while (queue_.Pop(event)) {
+        uint16_t lines = event.lines;
+        while (lines) {
+            uint8_t index = static_cast<uint8_t>(__builtin_ctz(lines));
+            lines &= lines - 1;
+            ApplyEdge(index, (event.levels >> index) & 1U, event.tick_ms, changes);
+        }
+    }
+
+    // Queue overflowed: edges were lost, resynchronise with the pins
+    uint32_t dropped = queue_.Dropped();
+    if (dropped != last_dropped_) {
+        last_dropped_ = dropped;
+        uint16_t levels = ReadRawLevels();
+        for (uint8_t i = 0; i < DI_CAPTURE_INPUTS; i++) {
+            ApplyEdge(i, (levels >> i) & 1U, now_ms, changes);
+        }
+    }
+
+    for (uint8_t i = 0; i < DI_CAPTURE_INPUTS; i++) {
+        if (debounce_[i].pending && (now_ms - debounce_[i].since_ms) >= debounce_ms_) {
+            Confirm(i, changes);
+        }
+    }
+
+    return changes;
+}
+
+uint32_t DigitalInputCapture::NextDeadlineMs(uint32_t now_ms) {
+    uint32_t next = UINT32_MAX;
+
+    for (uint8_t i = 0; i < DI_CAPTURE_INPUTS; i++) {
+        if (!debounce_[i].pending) {
+            continue;
+        }
+        uint32_t stable_for = now_ms - debounce_[i].since_ms;
+        uint32_t left = stable_for >= debounce_ms_ ? 0 : debounce_ms_ - stable_for;
+        if (left < next) {
+            next = left;
+        }
+    }
+    return next;
+}
+
+bool DigitalInputCapture::GetState(uint8_t input_number) {
+    if (input_number < 1 || input_number > DI_CAPTURE_INPUTS) {
+        return false;
+    }
+    return (stable_mask_ >> (input_number - 1)) & 1U;
+}
+
+uint32_t DigitalInputCapture::GetCounter(uint8_t input_number) {
+    if (input_number < 1 || input_number > DI_CAPTURE_INPUTS) {
+        return 0;
+    }
+    return counters_[input_number - 1];
+}
+
+void DigitalInputCapture::SetCounter(uint8_t input_number, uint32_t value) {
+    if (input_number < 1 || input_number > DI_CAPTURE_INPUTS) {
+        return;
+    }
+    counters_[input_number - 1] = value;
+}
+
+extern "C" {
+
+void EXINT0_IRQHandler(void) { DigitalInputCapture::IrqHandler(); }
+void EXINT1_IRQHandler(void) { DigitalInputCapture::IrqHandler(); }
+void EXINT2_IRQHandler(void) { DigitalInputCapture::IrqHandler(); }
+void EXINT3_IRQHandler(void) { DigitalInputCapture::IrqHandler(); }
+void EXINT4_IRQHandler(void) { DigitalInputCapture::IrqHandler(); }
+void EXINT9_5_IRQHandler(void) { DigitalInputCapture::IrqHandler(); }
+void EXINT15_10_IRQHandler(void) {
+    DigitalInputCapture::IrqHandler();
+    buttonsIrqHandler();
+}
+
+}
@@ -0,0 +1,142 @@
+#ifndef __DIGITAL_INPUT_CAPTURE_H__
+#define __DIGITAL_INPUT_CAPTURE_H__
+
+#include <stdint.h>
+#include "at32f403a_407_exint.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include "GPIOInputDriver.h"
+#include "SpscRing.h"
+
+#define DI_CAPTURE_INPUTS           (11U)
+#define DI_CAPTURE_QUEUE_SIZE       (64U)     /// edge events buffered between ISR and Process()
+#define DI_CAPTURE_DEBOUNCE_MS      (5U)      /// default stable time before an edge is accepted
+#define DI_CAPTURE_IRQ_PRIORITY     (6U)
+
+/**
+ * @brief Interrupt-driven capture of universal digital inputs
+ * Every input pin is routed to an EXINT line triggered on both edges. The ISR
+ * only timestamps the port snapshot and pushes it into a lock-free queue;
+ * debouncing and pulse counting run in task context from Process(), so no
+ * pulse longer than the debounce time is lost between polling sweeps.
+ * The task running Process() may sleep between edges: the ISR wakes the
+ * task set by SetWakeTask(), NextDeadlineMs() says when a pending edge
+ * needs another Process() call.
+ *
+ * Bit N of masks returned by this class corresponds to input N+1 (DI N).
+ */
+class DigitalInputCapture {
+public:
+    /**
+     * @brief Result of one Process() call
+     */
+    struct Changes_t {
+        uint16_t state_changed;     /// inputs whose debounced level changed
+        uint16_t counter_changed;   /// inputs whose pulse counter was incremented
+    };
+
+    /**
+     * @brief Configure EXINT lines for all input pins and enable interrupts
+     * GPIOInputDriver::Init() must be called first.
+     * @return true on success
+     */
+    static bool Init(void);
+
+    /**
+     * @brief Drain the edge queue and advance the debounce state machines
+     * Call from a single task, after an edge wake-up and once the
+     * NextDeadlineMs() time has passed.
+     * @param now_ms Current tick count in milliseconds
+     * @return Masks of inputs whose state or counter changed since last call
+     */
+    static Changes_t Process(uint32_t now_ms);
+
+    /**
+     * @brief Time until a pending edge has been stable for the debounce time
+     * @param now_ms Current tick count in milliseconds
+     * @return Milliseconds until Process() must run, UINT32_MAX when no edge is pending
+     */
+    static uint32_t NextDeadlineMs(uint32_t now_ms);
+
+    /**
+     * @brief Task notified (ulTaskNotifyTake) on every edge, NULL for none
+     */
+    static void SetWakeTask(TaskHandle_t task) { wake_task_ = task; }
+
+    /**
+     * @brief Debounced input states
+     * @return Bit-mapped states (bit 0 = input 1)
+     */
+    static uint16_t GetStates(void) { return stable_mask_; }
+
+    /**
+     * @brief Debounced state of single input
+     * @param input_number Input number (1-11)
+     */
+    static bool GetState(uint8_t input_number);
+
+    /**
+     * @brief Rising-edge pulse counter of single input
+     * @param input_number Input number (1-11)
+     * @return 32-bit wrapping counter, 0 on invalid input
+     */
+    static uint32_t GetCounter(uint8_t input_number);
+
+    /**
+     * @brief Preset pulse counter (SDO/Modbus reset)
+     * Call from the task that runs Process().
+     * @param input_number Input number (1-11)
+     * @param value New counter value
+     */
+    static void SetCounter(uint8_t input_number, uint32_t value);
+
+    /**
+     * @brief Set debounce time for all inputs
+     * @param debounce_ms Stable time in milliseconds (0 disables debouncing)
+     */
+    static void SetDebounceTime(uint16_t debounce_ms) { debounce_ms_ = debounce_ms; }
+
+    /**
+     * @brief Number of edge events lost because the queue overflowed
+     */
+    static uint32_t GetDroppedEvents(void) { return queue_.Dropped(); }
+
+    /**
+     * @brief EXINT interrupt body, shared by all lines used by the inputs
+     */
+    static void IrqHandler(void);
+
+private:
+    /**
+     * @brief Raw edge event captured in ISR
+     */
+    struct EdgeEvent_t {
+        uint32_t tick_ms;   /// tick count at interrupt
+        uint16_t lines;     /// inputs that triggered
+        uint16_t levels;    /// raw levels of all inputs at interrupt
+    };
+
+    /**
+     * @brief Debounce state of one input
+     */
+    struct Debounce_t {
+        uint32_t since_ms;  /// time the candidate level was first seen
+        bool pending;       /// candidate level differs from stable level
+    };
+
+    static uint16_t ReadRawLevels(void);
+    static void ApplyEdge(uint8_t index, bool level, uint32_t tick_ms, Changes_t& changes);
+    static void Confirm(uint8_t index, Changes_t& changes);
+
+    static SpscRing<EdgeEvent_t, DI_CAPTURE_QUEUE_SIZE> queue_;
+    static Debounce_t debounce_[DI_CAPTURE_INPUTS];
+    static uint32_t counters_[DI_CAPTURE_INPUTS];
+    static volatile uint16_t stable_mask_;
+    static uint16_t line_mask_;             /// EXINT lines owned by the inputs
+    static uint16_t debounce_ms_;
+    static uint32_t last_dropped_;
+    static TaskHandle_t wake_task_;
+    static bool initialized_;
+};
+
+#endif // __DIGITAL_INPUT_CAPTURE_H__
@@ -51,12 +51,6 @@ public:
      */
     static bool IsDigitalMode(uint8_t input_number);
 
-private:
-    /**
-     * @brief Configure GPIO pins for all digital inputs
-     */
-    static void ConfigurePins(void);
-
     /**
      * @brief Get GPIO pin mapping for input number
      * @param input_number Input number (1-11)
@@ -64,6 +58,12 @@ private:
      */
     static GPIOPin GetPinMapping(uint8_t input_number);
 
+private:
+    /**
+     * @brief Configure GPIO pins for all digital inputs
+     */
+    static void ConfigurePins(void);
+
     // GPIO pin mappings (to be configured based on actual hardware)
     static const GPIOPin INPUT_PINS[11];
 };
@@ -1,4 +1,5 @@
 #include "UniversalInputManager.h"
+#include "DigitalInputCapture.h"
 // #include "ADCDriver.h"  // TODO: Recreate ADCDriver.h/cpp for ADC functionality
 
 
@@ -18,8 +19,8 @@ bool UniversalInputManager::Init(void) {
     //     adc_initialized_ = true;
     // }
 
-    // Initialize GPIO driver
-    if (!GPIOInputDriver::Init()) {
+    // Initialize GPIO driver and edge capture on top of it
+    if (!GPIOInputDriver::Init() || !DigitalInputCapture::Init()) {
         // Log error: GPIO initialization failed
         success = false;
     } else {
@@ -111,8 +112,7 @@ bool UniversalInputManager::ConfigureInputMode(uint8_t input_number, UniversalIn
 void UniversalInputManager::UpdateAnalogInput(uint8_t input_number) {
     if (!adc_initialized_) {
         // Set error value
-        PBlockRegisters_t::universal_inputs[input_number - 1].analog_value = 0xFFFF;
-        PBlockRegisters_t::universal_inputs[input_number - 1].discrete_value = 0;
+        PBlockRegisters_t::SetUniversalInput(input_number, 0xFFFF, 0);
         return;
     }
 
@@ -120,58 +120,51 @@ void UniversalInputManager::UpdateAnalogInput(uint8_t input_number) {
 
     // if (adc_value_mv == 0xFFFF) {
     //     // ADC read error
-    //     PBlockRegisters_t::universal_inputs[input_number - 1].analog_value = 0xFFFF;
-    //     PBlockRegisters_t::universal_inputs[input_number - 1].discrete_value = 0;
+    //     PBlockRegisters_t::SetUniversalInput(input_number, 0xFFFF, 0);
     //     // TODO: Log error
     // } else {
-    //     PBlockRegisters_t::universal_inputs[input_number - 1].analog_value = adc_value_mv;
     //     // For analog mode, discrete value represents over/under voltage
-    //     PBlockRegisters_t::universal_inputs[input_number - 1].discrete_value =
-    //         (adc_value_mv > 9500) ? 1 : 0;  // High if > 9.5V
+    //     PBlockRegisters_t::SetUniversalInput(input_number, adc_value_mv,
+    //                                          (adc_value_mv > 9500) ? 1 : 0);  // High if > 9.5V
     // }
 }
 
 void UniversalInputManager::UpdateDigitalInput(uint8_t input_number) {
     if (!gpio_initialized_) {
         // Set error state
-        PBlockRegisters_t::universal_inputs[input_number - 1].analog_value = 0;
-        PBlockRegisters_t::universal_inputs[input_number - 1].discrete_value = 0;
+        PBlockRegisters_t::SetUniversalInput(input_number, 0, 0);
         return;
     }
 
-    bool digital_value = GPIOInputDriver::ReadDigitalInput(input_number);
+    // Debounced state maintained by the EXINT capture, not a raw pin sample
+    bool digital_value = DigitalInputCapture::GetState(input_number);
 
     // For digital mode, analog value represents digital state in mV equivalent
-    PBlockRegisters_t::universal_inputs[input_number - 1].analog_value =
-        digital_value ? 10000 : 0;  // 10V = HIGH, 0V = LOW
-
-    PBlockRegisters_t::universal_inputs[input_number - 1].discrete_value = digital_value ? 1 : 0;
+    PBlockRegisters_t::SetUniversalInput(input_number,
+                                         digital_value ? 10000 : 0,  // 10V = HIGH, 0V = LOW
+                                         digital_value ? 1 : 0);
 }
 
 void UniversalInputManager::UpdateDol12Temperature(uint8_t input_number) {
     // TODO: Implement Dol12 sensor reading
     // For now, set placeholder values
-    PBlockRegisters_t::universal_inputs[input_number - 1].analog_value = 2500;  // 25°C equivalent
-    PBlockRegisters_t::universal_inputs[input_number - 1].discrete_value = 0;   // Normal state
+    PBlockRegisters_t::SetUniversalInput(input_number, 2500, 0);  // 25°C equivalent, normal state
 
     // When implemented:
     // float temperature = Dol12Sensor::ReadTemperature(input_number);
     // uint16_t temp_mv = TemperatureToMillivolts(temperature);
-    // PBlockRegisters_t::universal_inputs[input_number - 1].analog_value = temp_mv;
-    // PBlockRegisters_t::universal_inputs[input_number - 1].discrete_value = (temperature > 50.0f) ? 1 : 0;
+    // PBlockRegisters_t::SetUniversalInput(input_number, temp_mv, (temperature > 50.0f) ? 1 : 0);
 }
 
 void UniversalInputManager::UpdateTafcoTemperature(uint8_t input_number) {
     // TODO: Implement Tafco sensor reading
     // For now, set placeholder values
-    PBlockRegisters_t::universal_inputs[input_number - 1].analog_value = 2000;  // 20°C equivalent
-    PBlockRegisters_t::universal_inputs[input_number - 1].discrete_value = 0;   // Normal state
+    PBlockRegisters_t::SetUniversalInput(input_number, 2000, 0);  // 20°C equivalent, normal state
 
     // When implemented:
     // float temperature = TafcoSensor::ReadTemperature(input_number);
     // uint16_t temp_mv = TemperatureToMillivolts(temperature);
-    // PBlockRegisters_t::universal_inputs[input_number - 1].analog_value = temp_mv;
-    // PBlockRegisters_t::universal_inputs[input_number - 1].discrete_value = (temperature > 50.0f) ? 1 : 0;
+    // PBlockRegisters_t::SetUniversalInput(input_number, temp_mv, (temperature > 50.0f) ? 1 : 0);
 }
 
 uint16_t UniversalInputManager::TemperatureToMillivolts(float temperature_celsius) {
@@ -0,0 +1,225 @@
+#include "MainsSync.h"
+#include "at32f403a_407_misc.h"
+
+#define MAINS_PERIOD_MIN_TICKS      (MAINS_PERIOD_MIN_US * MAINS_TICKS_PER_US)
+#define MAINS_PERIOD_MAX_TICKS      (MAINS_PERIOD_MAX_US * MAINS_TICKS_PER_US)
+#define MAINS_ZC_OFFSET_TICKS       (MAINS_ZC_PHASE_OFFSET_US * MAINS_TICKS_PER_US)
+
+static_assert((MAINS_AVERAGE_CYCLES & (MAINS_AVERAGE_CYCLES - 1)) == 0, "MAINS_AVERAGE_CYCLES must be a power of two");
+
+volatile uint32_t MainsSync::last_capture_ = 0;
+uint32_t MainsSync::period_sum_ = 0;
+volatile uint32_t MainsSync::period_avg_ = 0;
+uint32_t MainsSync::periods_[MAINS_AVERAGE_CYCLES] = {};
+uint8_t MainsSync::period_index_ = 0;
+volatile uint8_t MainsSync::valid_cycles_ = 0;
+volatile uint32_t MainsSync::rejected_ = 0;
+bool MainsSync::has_capture_ = false;
+uint32_t MainsSync::sample_base_ = 0;
+uint8_t MainsSync::sample_slot_ = 0;
+MainsSync::ZeroCrossHandler MainsSync::zero_cross_handler_ = nullptr;
+MainsSync::SampleHandler MainsSync::sample_handler_ = nullptr;
+MainsSync::ChannelHandler MainsSync::channel3_handler_ = nullptr;
+MainsSync::ChannelHandler MainsSync::channel4_handler_ = nullptr;
+
+bool MainsSync::Init(void) {
+    gpio_init_type gpio_init_struct;
+    tmr_input_config_type input_config;
+    tmr_output_config_type output_config;
+
+    crm_periph_clock_enable(MAINS_ZC_PORT_CLOCK, TRUE);
+    crm_periph_clock_enable(MAINS_TMR_CLOCK, TRUE);
+
+    gpio_default_para_init(&gpio_init_struct);
+    gpio_init_struct.gpio_mode = GPIO_MODE_INPUT;
+    gpio_init_struct.gpio_pull = GPIO_PULL_NONE;
+    gpio_init_struct.gpio_pins = MAINS_ZC_PIN;
+    gpio_init(MAINS_ZC_PORT, &gpio_init_struct);
+
+    uint32_t div = GetTimerClock() / (MAINS_TICKS_PER_US * 1000000U);
+    if (div == 0) {
+        return false;
+    }
+
+    // Free running 32-bit counter: wraps every ~7 minutes, all math is modulo 2^32
+    tmr_32_bit_function_enable(MAINS_TMR, TRUE);
+    tmr_base_init(MAINS_TMR, 0xFFFFFFFFU, div - 1);
+    tmr_cnt_dir_set(MAINS_TMR, TMR_COUNT_UP);
+
+    // CH1: zero-cross capture, strongest digital filter against mains spikes
+    input_config.input_channel_select = TMR_SELECT_CHANNEL_1;
+    input_config.input_mapped_select = TMR_CC_CHANNEL_MAPPED_DIRECT;
+    input_config.input_polarity_select = TMR_INPUT_RISING_EDGE;
+    input_config.input_filter_value = 0x0F;
+    tmr_input_channel_init(MAINS_TMR, &input_config, TMR_CHANNEL_INPUT_DIV_1);
+
+    // CH2: timing-only compare for synchronous sample slots
+    tmr_output_default_para_init(&output_config);
+    output_config.oc_mode = TMR_OUTPUT_CONTROL_OFF;
+    tmr_output_channel_config(MAINS_TMR, TMR_SELECT_CHANNEL_2, &output_config);
+
+    tmr_flag_clear(MAINS_TMR, TMR_C1_FLAG | TMR_C1_RECAPTURE_FLAG | TMR_C2_FLAG);
+    tmr_interrupt_enable(MAINS_TMR, TMR_C1_INT, TRUE);
+    nvic_irq_enable(MAINS_TMR_IRQn, MAINS_TMR_IRQ_PRIORITY, 0);
+
+    tmr_counter_enable(MAINS_TMR, TRUE);
+    return true;
+}
+
+uint32_t MainsSync::GetTimerClock(void) {
+    crm_clocks_freq_type clocks;
+    crm_clocks_freq_get(&clocks);
+
+    // APB1 timers run at twice the bus clock when APB1 is divided
+    if (clocks.apb1_freq == clocks.ahb_freq) {
+        return clocks.apb1_freq;
+    }
+    return clocks.apb1_freq * 2U;
+}
+
+bool MainsSync::IsPresent(void) {
+    uint32_t period = period_avg_;
+    if (valid_cycles_ == 0 || period == 0) {
+        return false;
+    }
+
+    // Read capture before counter so the difference can not underflow
+    uint32_t last = last_capture_;
+    return (Now() - last) < (period * MAINS_LOST_CYCLES);
+}
+
+uint32_t MainsSync::GetPeriodTicks(void) {
+    return IsPresent() ? period_avg_ : 0;
+}
+
+uint16_t MainsSync::GetPeriodUs(void) {
+    uint32_t period = GetPeriodTicks();
+    return static_cast<uint16_t>((period + MAINS_TICKS_PER_US / 2) / MAINS_TICKS_PER_US);
+}
+
+uint32_t MainsSync::GetFrequencyMilliHz(void) {
+    uint32_t period = GetPeriodTicks();
+    if (period == 0) {
+        return 0;
+    }
+    const uint64_t ticks_per_ks = static_cast<uint64_t>(MAINS_TICKS_PER_US) * 1000000000ULL;
+    return static_cast<uint32_t>((ticks_per_ks + period / 2) / period);
+}
+
+bool MainsSync::SetChannelHandler(tmr_channel_select_type channel, ChannelHandler handler) {
+    if (channel == TMR_SELECT_CHANNEL_3) {
+        channel3_handler_ = handler;
+    } else if (channel == TMR_SELECT_CHANNEL_4) {
+        channel4_handler_ = handler;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+void MainsSync::OnCapture(uint32_t capture) {
+    capture += MAINS_ZC_OFFSET_TICKS;
+
+    if (!has_capture_) {
+        has_capture_ = true;
+        last_capture_ = capture;
+        return;
+    }
+
+    uint32_t period = capture - last_capture_;
+
+    // Glitch inside the period: ignore edge, keep the reference crossing
+    if (period < MAINS_PERIOD_MIN_TICKS) {
+        rejected_ = rejected_ + 1;
+        return;
+    }
+
+    last_capture_ = capture;
+
+    // Missed crossings or mains dropout: restart averaging from this edge
+    if (period > MAINS_PERIOD_MAX_TICKS) {
+        rejected_ = rejected_ + 1;
+        for (uint8_t i = 0; i < MAINS_AVERAGE_CYCLES; i++) {
+            periods_[i] = 0;
+        }
+        period_sum_ = 0;
+        period_index_ = 0;
+        valid_cycles_ = 0;
+        period_avg_ = 0;
+        return;
+    }
+
+    period_sum_ = period_sum_ - periods_[period_index_] + period;
+    periods_[period_index_] = period;
+    period_index_ = (period_index_ + 1) & (MAINS_AVERAGE_CYCLES - 1);
+    if (valid_cycles_ < MAINS_AVERAGE_CYCLES) {
+        valid_cycles_ = valid_cycles_ + 1;
+    }
+    uint32_t avg = period_sum_ / valid_cycles_;
+    period_avg_ = avg;
+
+    // Sample slots are centred in N equal parts of the period so the first
+    // compare is always in the future
+    sample_base_ = capture;
+    sample_slot_ = 0;
+    if (sample_handler_ != nullptr) {
+        tmr_channel_value_set(MAINS_TMR, TMR_SELECT_CHANNEL_2, capture + avg / (2U * MAINS_SAMPLES_PER_CYCLE));
+        tmr_flag_clear(MAINS_TMR, TMR_C2_FLAG);
+        tmr_interrupt_enable(MAINS_TMR, TMR_C2_INT, TRUE);
+    }
+
+    if (zero_cross_handler_ != nullptr) {
+        zero_cross_handler_(capture, avg);
+    }
+}
+
+void MainsSync::OnSampleCompare(void) {
+    uint8_t slot = sample_slot_;
+
+    if (sample_handler_ != nullptr) {
+        sample_handler_(slot);
+    }
+
+    slot++;
+    sample_slot_ = slot;
+    if (slot >= MAINS_SAMPLES_PER_CYCLE) {
+        tmr_interrupt_enable(MAINS_TMR, TMR_C2_INT, FALSE);
+        return;
+    }
+
+    uint32_t offset = (period_avg_ * (2U * slot + 1U)) / (2U * MAINS_SAMPLES_PER_CYCLE);
+    tmr_channel_value_set(MAINS_TMR, TMR_SELECT_CHANNEL_2, sample_base_ + offset);
+}
+
+void MainsSync::IrqHandler(void) {
+    uint32_t enabled = MAINS_TMR->iden;
+
+    if (tmr_flag_get(MAINS_TMR, TMR_C1_FLAG) != RESET) {
+        uint32_t capture = tmr_channel_value_get(MAINS_TMR, TMR_SELECT_CHANNEL_1);
+        tmr_flag_clear(MAINS_TMR, TMR_C1_FLAG | TMR_C1_RECAPTURE_FLAG);
+        OnCapture(capture);
+    }
+
+    if ((enabled & TMR_C2_INT) && tmr_flag_get(MAINS_TMR, TMR_C2_FLAG) != RESET) {
+        tmr_flag_clear(MAINS_TMR, TMR_C2_FLAG);
+        OnSampleCompare();
+    }
+
+    if ((enabled & TMR_C3_INT) && tmr_flag_get(MAINS_TMR, TMR_C3_FLAG) != RESET) {
+        tmr_flag_clear(MAINS_TMR, TMR_C3_FLAG);
+        if (channel3_handler_ != nullptr) {
+            channel3_handler_(TMR_SELECT_CHANNEL_3);
+        }
+    }
+
+    if ((enabled & TMR_C4_INT) && tmr_flag_get(MAINS_TMR, TMR_C4_FLAG) != RESET) {
+        tmr_flag_clear(MAINS_TMR, TMR_C4_FLAG);
+        if (channel4_handler_ != nullptr) {
+            channel4_handler_(TMR_SELECT_CHANNEL_4);
+        }
+    }
+}
+
+extern "C" void TMR5_GLOBAL_IRQHandler(void) {
+    MainsSync::IrqHandler();
+}
@@ -0,0 +1,133 @@
+#ifndef __MAINS_SYNC_H__
+#define __MAINS_SYNC_H__
+
+#include <stdint.h>
+#include "at32f403a_407_tmr.h"
+#include "at32f403a_407_gpio.h"
+#include "at32f403a_407_crm.h"
+
+/* ==== Hardware ==== */
+#define MAINS_TMR                   TMR5                /// 32-bit timebase shared by capture and compare users
+#define MAINS_TMR_CLOCK             CRM_TMR5_PERIPH_CLOCK
+#define MAINS_TMR_IRQn              TMR5_GLOBAL_IRQn
+#define MAINS_TMR_IRQ_PRIORITY      (4U)                /// above Modbus/EXINT, still FreeRTOS-safe
+#define MAINS_ZC_PORT               GPIOA
+#define MAINS_ZC_PIN                GPIO_PINS_0         /// TMR5_CH1, zero-cross detector output
+#define MAINS_ZC_PORT_CLOCK         CRM_GPIOA_PERIPH_CLOCK
+
+/* ==== Timing ==== */
+#define MAINS_TICKS_PER_US          (10U)               /// 0.1 us timer resolution
+#define MAINS_PERIOD_MIN_US         (15000U)            /// 66.7 Hz, shorter periods are rejected as noise
+#define MAINS_PERIOD_MAX_US         (22500U)            /// 44.4 Hz, 45 Hz mains with margin
+#define MAINS_AVERAGE_CYCLES        (8U)                /// period moving average length, power of two
+#define MAINS_LOST_CYCLES           (3U)                /// mains lost after this many missing crossings
+#define MAINS_ZC_PHASE_OFFSET_US    (0U)                /// detector edge lead/lag vs. true zero crossing
+#define MAINS_SAMPLES_PER_CYCLE     (16U)               /// synchronous sample slots per mains period
+
+/**
+ * @brief Mains zero-cross capture and synchronous timebase
+ * TMR5 runs free at 10 MHz in 32-bit mode. CH1 captures the rising edge of the
+ * zero-cross detector once per mains period, CH2 generates sample triggers
+ * evenly spread over each period. Averaging all samples of one period cancels
+ * 50/60 Hz pickup and its harmonics up to MAINS_SAMPLES_PER_CYCLE / 2.
+ * Channels CH3/CH4 are left to compare users (TRIAC gates) via SetChannelHandler.
+ */
+class MainsSync {
+public:
+    /**
+     * @brief Zero-cross callback, called from timer ISR
+     * @param capture Timer value at the (offset-compensated) zero crossing
+     * @param period_ticks Averaged mains period in timer ticks
+     */
+    typedef void (*ZeroCrossHandler)(uint32_t capture, uint32_t period_ticks);
+
+    /**
+     * @brief Synchronous sample callback, called from timer ISR
+     * @param slot Sample index within the current period (0..MAINS_SAMPLES_PER_CYCLE-1)
+     */
+    typedef void (*SampleHandler)(uint8_t slot);
+
+    /**
+     * @brief Compare channel callback, called from timer ISR
+     * @param channel TMR_SELECT_CHANNEL_3 or TMR_SELECT_CHANNEL_4
+     */
+    typedef void (*ChannelHandler)(tmr_channel_select_type channel);
+
+    /**
+     * @brief Configure TMR5 capture/compare and start the timebase
+     * @return true on success
+     */
+    static bool Init(void);
+
+    /**
+     * @brief Check that zero crossings arrive with a plausible period
+     * @return false before the first valid period or after MAINS_LOST_CYCLES missing crossings
+     */
+    static bool IsPresent(void);
+
+    /**
+     * @brief Averaged mains period
+     * @return Period in timer ticks (0.1 us), 0 when mains is not present
+     */
+    static uint32_t GetPeriodTicks(void);
+
+    /**
+     * @brief Averaged mains period rounded to microseconds (0x2302:03)
+     * @return Period in us, 0 when mains is not present
+     */
+    static uint16_t GetPeriodUs(void);
+
+    /**
+     * @brief Mains frequency
+     * @return Frequency in mHz, 0 when mains is not present
+     */
+    static uint32_t GetFrequencyMilliHz(void);
+
+    /**
+     * @brief Number of captures rejected by the plausibility window
+     */
+    static uint32_t GetRejectedCount(void) { return rejected_; }
+
+    /**
+     * @brief Current timer value, same timebase as captures
+     */
+    static uint32_t Now(void) { return tmr_counter_value_get(MAINS_TMR); }
+
+    static void SetZeroCrossHandler(ZeroCrossHandler handler) { zero_cross_handler_ = handler; }
+    static void SetSampleHandler(SampleHandler handler) { sample_handler_ = handler; }
+
+    /**
+     * @brief Attach compare interrupt handler to CH3 or CH4
+     * @return false for channels owned by MainsSync
+     */
+    static bool SetChannelHandler(tmr_channel_select_type channel, ChannelHandler handler);
+
+    /**
+     * @brief Timer interrupt body
+     */
+    static void IrqHandler(void);
+
+private:
+    static void OnCapture(uint32_t capture);
+    static void OnSampleCompare(void);
+    static uint32_t GetTimerClock(void);
+
+    static volatile uint32_t last_capture_;
+    static uint32_t period_sum_;                        /// sum of the last MAINS_AVERAGE_CYCLES periods
+    static volatile uint32_t period_avg_;               /// published as one word, readers need no lock
+    static uint32_t periods_[MAINS_AVERAGE_CYCLES];
+    static uint8_t period_index_;
+    static volatile uint8_t valid_cycles_;              /// saturates at MAINS_AVERAGE_CYCLES
+    static volatile uint32_t rejected_;
+    static bool has_capture_;
+
+    static uint32_t sample_base_;                       /// zero crossing the current sample slots refer to
+    static uint8_t sample_slot_;
+
+    static ZeroCrossHandler zero_cross_handler_;
+    static SampleHandler sample_handler_;
+    static ChannelHandler channel3_handler_;
+    static ChannelHandler channel4_handler_;
+};
+
+#endif // __MAINS_SYNC_H__
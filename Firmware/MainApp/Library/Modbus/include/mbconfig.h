@@ -173,7 +173,7 @@ PR_BEGIN_EXTERN_C
 
 /*! \brief If the <em>Read File Record</em> function should be enabled. */
 #ifndef MB_FUNC_READ_FILE_ENABLED
-#define MB_FUNC_READ_FILE_ENABLED               (  0 )
+#define MB_FUNC_READ_FILE_ENABLED               (  1 )
 #endif
 
 /*! @} */
@@ -5,6 +5,7 @@
 #include "at32f403a_407_usart.h"
 #include "at32f403a_407_gpio.h"
 #include "at32f403a_407_dma.h"
+#include "TaskProfiler.h"
 
 /* UART handle for Modbus */
 static usart_type* mb_usart = MB_USART;
@@ -123,6 +124,8 @@ BOOL xMBPortSerialGetByte(CHAR *byte)
 /* UART interrupt handler */
 void USART1_IRQHandler(void)
 {
+    ProfilerIsrFrame profile = TaskProfiler_IsrEnter();
+
     /* Check if RX interrupt is enabled AND data is available */
     if ((mb_usart->ctrl1_bit.rdbfien) && (mb_usart->sts_bit.rdbf))
     {
@@ -135,4 +138,6 @@ void USART1_IRQHandler(void)
     {
         pxMBFrameCBTransmitterEmpty();
     }
+
+    TaskProfiler_IsrExit(PROFILER_ISR_USART1, profile);
 }
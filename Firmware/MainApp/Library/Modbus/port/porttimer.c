@@ -3,6 +3,7 @@
 #include "port_internal.h"
 #include "at32f403a_407_tmr.h"
 #include "TimerDrv.h"
+#include "TaskProfiler.h"
 #include <stddef.h>
 
 /* Static variables */
@@ -92,6 +93,12 @@ void vMBPortTimersDisable(void)
 /* Timer interrupt handler */
 void TMR2_GLOBAL_IRQHandler(void)
 {
+    ProfilerIsrFrame profile = TaskProfiler_IsrEnter();
+
+    /* The counter restarted from 0 at the overflow: its value is the entry latency.
+     * TMR2 runs at the core clock (APB1 x2), one count is div + 1 cycles */
+    uint32_t latency = mb_timer_handle->cval * (mb_timer_handle->div + 1U);
+
     /* Check if overflow interrupt flag is set */
     if (drv_timer_get_flag(mb_timer_handle, TIMER_INT_OVERFLOW))
     {
@@ -105,5 +112,8 @@ void TMR2_GLOBAL_IRQHandler(void)
             vMBTimerDebugSetLow();
             pxMBPortCBTimerExpired();
         }
+        TaskProfiler_IsrLatency(latency);
     }
+
+    TaskProfiler_IsrExit(PROFILER_ISR_TMR2, profile);
 }
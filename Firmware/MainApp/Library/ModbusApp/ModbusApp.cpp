@@ -2,10 +2,15 @@
 #include "FreeRTOS.h"
 #include "P-Block-struct.h"
 #include "PBlockConfig.h"
+#include "ErrorLog.h"
+#include "TrendLogger.h"
 #include "UniversalInputManager.h"
+#include "TaskProfiler.h"
+#include "DeadlineMonitor.h"
 #include "at32f403a_407_usart.h"
 #include "mbutils.h"
 #include "task.h"
+#include "string.h"
 #include "UartDrv.h"  // For drv_uart_transmit in DEBUG mode
 
 /**
@@ -20,6 +25,10 @@
  * INPUT REGISTERS (Read-Only, 30001+):
  *   1-11  : Universal Inputs - Analog values from ADC (0-10000 mV)
  *   20-22 : Emergency Block (reserved)
+ *   23    : Deadline late mask (bit n = DeadlineSubject n missed its warning deadline)
+ *   24    : Deadline trip before the last reset (DeadlineSubject, 0xFFFF = none)
+ *   25    : Deadline trip gap, ms
+ *   300-385: Task profile (TaskProfileSnapshot as 16-bit words, 32-bit fields low word first)
  * 
  * HOLDING REGISTERS (Read/Write, 40001+):
  *   0-5    : Analog Outputs (6 channels, 0-10000 mV)
@@ -27,7 +36,14 @@
  *   119    : Hybrid Channel Config (0/2/4)
  *   200    : System Status (0=OK, else error code)
  *   201    : Boot Count (restart counter)
- *   210-219: Error Log (10 most recent errors)
+ *   208    : Error Log entry count (write 0 to clear)
+ *   209    : Error Log view (page | field << 8)
+ *   210-219: Error Log page (entries page*10..page*10+9, newest first)
+ *
+ * FILE RECORDS (Read File Record, FC20):
+ *   1-1024 : Trend log slots, file n = newest block in slot n-1 (256 bytes, 128 records)
+ *   65535  : Trend log info (TrendInfo, 10 records)
+ *   Records carry the raw little-endian bytes, record r = bytes 2r and 2r+1.
  */
 
 void modbusFun(void *parameters) {
@@ -93,7 +109,9 @@ void modbusFun(void *parameters) {
  *   119    : Hybrid Config (1 register)
  *   200    : System Status (1 register)
  *   201    : Boot Count (1 register)
- *   210-219: Error Log (10 registers)
+ *   208    : Error Log Count (1 register)
+ *   209    : Error Log View (1 register)
+ *   210-219: Error Log Page (10 registers)
  */
 eMBErrorCode eMBRegHoldingCB(UCHAR *pucRegBuffer, USHORT usAddress,
                              USHORT usNRegs, eMBRegisterMode eMode) {
@@ -155,7 +173,7 @@ eMBErrorCode eMBRegHoldingCB(UCHAR *pucRegBuffer, USHORT usAddress,
       } else { // MB_REG_WRITE
         value = *pucRegBuffer++ << 8;
         value |= *pucRegBuffer++;
-        PBlockRegisters_t::holding_registers.status = value;
+        PBlockRegisters_t::SetStatus(value);
       }
     }
     // [201] Boot Count
@@ -170,17 +188,43 @@ eMBErrorCode eMBRegHoldingCB(UCHAR *pucRegBuffer, USHORT usAddress,
         PBlockRegisters_t::holding_registers.boot_count = value;
       }
     }
-    // [210-219] Error Log
-    else if (usAddress >= 210 && usAddress <= 219) {
-      const uint8_t error_index = static_cast<uint8_t>(usAddress - 210);
+    // [208] Error Log Count
+    else if (usAddress == 208) {
+      if (eMode == MB_REG_READ) {
+        const uint32_t count = ErrorLog::GetCount();
+        value = static_cast<USHORT>(count > 0xFFFFU ? 0xFFFFU : count);
+        *pucRegBuffer++ = static_cast<UCHAR>(value >> 8);
+        *pucRegBuffer++ = static_cast<UCHAR>(value & 0xFF);
+      } else { // MB_REG_WRITE - 0 clears the log
+        value = *pucRegBuffer++ << 8;
+        value |= *pucRegBuffer++;
+        if (value == 0) {
+          ErrorLog::Clear();
+        }
+      }
+    }
+    // [209] Error Log View: page in the low byte, ErrorLogField in the high byte
+    else if (usAddress == 209) {
       if (eMode == MB_REG_READ) {
-        value = PBlockRegisters_t::holding_registers.error_log[error_index];
+        value = PBlockRegisters_t::holding_registers.error_log_view;
         *pucRegBuffer++ = static_cast<UCHAR>(value >> 8);
         *pucRegBuffer++ = static_cast<UCHAR>(value & 0xFF);
-      } else { // MB_REG_WRITE - typically read-only, but allow clearing
+      } else { // MB_REG_WRITE
         value = *pucRegBuffer++ << 8;
         value |= *pucRegBuffer++;
-        PBlockRegisters_t::holding_registers.error_log[error_index] = value;
+        PBlockRegisters_t::holding_registers.error_log_view = value;
+      }
+    }
+    // [210-219] Error Log Page
+    else if (usAddress >= 210 && usAddress <= 219) {
+      const uint16_t view = PBlockRegisters_t::holding_registers.error_log_view;
+      const uint32_t index = (view & 0xFFU) * ERROR_LOG_PAGE_ENTRIES + (usAddress - 210);
+      if (eMode == MB_REG_READ) {
+        value = ErrorLog::GetField(index, static_cast<ErrorLogField>(view >> 8));
+        *pucRegBuffer++ = static_cast<UCHAR>(value >> 8);
+        *pucRegBuffer++ = static_cast<UCHAR>(value & 0xFF);
+      } else { // MB_REG_WRITE - read-only, write is ignored
+        pucRegBuffer += 2;
       }
     }
     // Invalid address
@@ -201,9 +245,12 @@ eMBErrorCode eMBRegHoldingCB(UCHAR *pucRegBuffer, USHORT usAddress,
  *   20   : Emergency Battery Voltage (reserved)
  *   21   : Emergency Room State 1 (reserved)
  *   22   : Emergency Room State 2 (reserved)
+ *   300+ : Task profile, PROFILER_MB_REGS words, one snapshot per request
  */
 eMBErrorCode eMBRegInputCB(UCHAR *pucRegBuffer, USHORT usAddress,
                            USHORT usNRegs) {
+  TaskProfileSnapshot profile;
+  bool have_profile = false;
 
   while (usNRegs > 0) {
     USHORT value = 0;
@@ -224,6 +271,26 @@ eMBErrorCode eMBRegInputCB(UCHAR *pucRegBuffer, USHORT usAddress,
     // [22] Emergency Room State 2
     else if (usAddress == 22) {
       value = 0; // reserved
+    }
+    // [23-25] Deadline monitor status
+    else if (usAddress >= DEADLINE_MB_ADDRESS && usAddress < DEADLINE_MB_ADDRESS + DEADLINE_MB_REGS) {
+      const DeadlineTrip &trip = DeadlineMonitor::GetLastTrip();
+      if (usAddress == DEADLINE_MB_ADDRESS) {
+        value = DeadlineMonitor::GetLateMask();
+      } else if (usAddress == DEADLINE_MB_ADDRESS + 1U) {
+        value = trip.subject;
+      } else {
+        value = trip.late_ms;
+      }
+    }
+    // [300+] Task profile
+    else if (usAddress >= PROFILER_MB_ADDRESS && usAddress < PROFILER_MB_ADDRESS + PROFILER_MB_REGS) {
+      if (!have_profile) {
+        TaskProfiler::Snapshot(profile);
+        have_profile = true;
+      }
+      memcpy(&value, reinterpret_cast<const uint8_t *>(&profile) + (usAddress - PROFILER_MB_ADDRESS) * sizeof(uint16_t),
+             sizeof(value));
     } else {
       return MB_ENOREG;
     }
@@ -288,61 +355,65 @@ eMBErrorCode eMBRegDiscreteCB(UCHAR *pucRegBuffer, USHORT usAddress,
  */
 eMBErrorCode eMBRegCoilsCB(UCHAR *pucRegBuffer, USHORT usAddress,
                            USHORT usNCoils, eMBRegisterMode eMode) {
-  UCHAR currentByte = 0;
-  UCHAR bitInByte = 0;
-
-  if (eMode == MB_REG_READ) {
-    // Read relay states and pack into buffer
-    for (USHORT i = 0; i < usNCoils; i++) {
-      const USHORT coilAddr = usAddress + i;
-      // [1-13] Relays (1-12 standard, 13 emergency)
-      if (coilAddr >= 1 && coilAddr <= 13) {
-        const uint8_t relayNum = static_cast<uint8_t>(coilAddr);
-        const bool state = PBlockRegisters_t::GetRelay(relayNum);
-        if (state) {
-          currentByte |= (1u << bitInByte);
-        }
-      } else {
-        return MB_ENOREG;
-      }
+  // [1-13] Relays (1-12 standard, 13 emergency), coil n = bit n-1 of the relay mask
+  if (usAddress < 1 || usNCoils == 0 || usAddress + usNCoils - 1 > RELAY_COUNT) {
+    return MB_ENOREG;
+  }
 
-      bitInByte++;
-      if (bitInByte == 8) {
-        *pucRegBuffer++ = currentByte;
-        currentByte = 0;
-        bitInByte = 0;
-      }
-    }
+  const USHORT shift = usAddress - 1;
+  const uint16_t span = static_cast<uint16_t>(((1u << usNCoils) - 1u) << shift);
 
-    // Flush remaining bits
-    if (bitInByte != 0) {
-      *pucRegBuffer++ = currentByte;
+  if (eMode == MB_REG_READ) {
+    // Snapshot once so all coils in the response come from the same state
+    const uint16_t bits = (PBlockRegisters_t::GetRelayMask() & span) >> shift;
+    pucRegBuffer[0] = static_cast<UCHAR>(bits & 0xFFu);
+    if (usNCoils > 8) {
+      pucRegBuffer[1] = static_cast<UCHAR>(bits >> 8);
     }
   } else // MB_REG_WRITE
   {
-    // Unpack buffer and write relay states
-    for (USHORT i = 0; i < usNCoils; i++) {
-      const USHORT coilAddr = usAddress + i;
-      // [1-13] Relays (1-12 standard, 13 emergency)
-      if (coilAddr >= 1 && coilAddr <= 13) {
-        // Extract bit from buffer
-        if (bitInByte == 0) {
-          currentByte = *pucRegBuffer++;
-        }
+    // Unpack all coils first, then update the relays in a single store
+    uint16_t bits = pucRegBuffer[0];
+    if (usNCoils > 8) {
+      bits |= static_cast<uint16_t>(pucRegBuffer[1]) << 8;
+    }
+    PBlockRegisters_t::SetRelayMask(span, static_cast<uint16_t>(bits << shift));
+  }
 
-        const bool state = (currentByte & (1u << bitInByte)) != 0;
-        const uint8_t relayNum = static_cast<uint8_t>(coilAddr);
-        PBlockRegisters_t::SetRelay(relayNum, state);
+  return MB_ENOERR;
+}
 
-        bitInByte++;
-        if (bitInByte == 8) {
-          bitInByte = 0;
-        }
-      } else {
-        return MB_ENOREG;
-      }
+/* File records (Read-Only, Trend Log)
+ * The host reads the info file, then walks slots from first_sequence to
+ * open_sequence; the sequence word in each block tells which block it got.
+ */
+eMBErrorCode eMBRegFileCB(UCHAR *pucFileBuffer, USHORT usFileNumber,
+                          USHORT usRecordNumber, USHORT usRecordLength,
+                          eMBRegisterMode eMode) {
+  const uint32_t offset = static_cast<uint32_t>(usRecordNumber) * 2u;
+  const uint32_t size = static_cast<uint32_t>(usRecordLength) * 2u;
+
+  if (eMode != MB_REG_READ || usRecordLength == 0) {
+    return MB_ENOREG;
+  }
+
+  if (usFileNumber == TREND_INFO_FILE) {
+    TrendInfo info;
+    if (offset + size > sizeof(info)) {
+      return MB_ENOREG;
     }
+    TrendLogger::GetInfo(info);
+    memcpy(pucFileBuffer, reinterpret_cast<const uint8_t *>(&info) + offset, size);
+    return MB_ENOERR;
   }
 
+  if (usFileNumber < 1 || usFileNumber > TREND_BLOCK_SLOTS || offset + size > TREND_BLOCK_SIZE) {
+    return MB_ENOREG;
+  }
+  const uint32_t sequence = TrendLogger::SlotSequence(usFileNumber - 1);
+  if (!TrendLogger::ReadBlock(sequence, static_cast<uint16_t>(offset), pucFileBuffer,
+                              static_cast<uint16_t>(size))) {
+    return MB_ENOREG;
+  }
   return MB_ENOERR;
 }
@@ -1,4 +1,6 @@
 #include "P-Block-struct.h"
+#include "AnalogOutputEngine.h"
+#include "ErrorLog.h"
 
 
 // Define static data members based on P-Block-struct.h  
@@ -7,6 +9,11 @@ Coils_t PBlockRegisters_t::coils;
 UniversalInput_t PBlockRegisters_t::universal_inputs[11];  
 uint16_t PBlockRegisters_t::analog_output[6];  
 
+// Change subscriptions, filled once at start-up before the writers run
+static PBlockRegisters_t::ChangeListener_t listeners[PBLOCK_SUBSCRIBERS];
+static uint32_t listener_masks[PBLOCK_SUBSCRIBERS];
+static uint8_t listener_count;
+
 /**
  * @brief Initialize all registers with default values (static member function)
  */
@@ -53,22 +60,10 @@ void PBlockRegisters_t::UpdateInputs(void)
  */
 void PBlockRegisters_t::SetRelay(uint8_t relay_number, bool state)  
 {  
-    switch (relay_number)
+    if (relay_number >= 1 && relay_number <= RELAY_COUNT)
     {
-        case 1:  coils.relay_bits.relay1 = state; break;
-        case 2:  coils.relay_bits.relay2 = state; break;
-        case 3:  coils.relay_bits.relay3 = state; break;
-        case 4:  coils.relay_bits.relay4 = state; break;
-        case 5:  coils.relay_bits.relay5 = state; break;
-        case 6:  coils.relay_bits.relay6 = state; break;
-        case 7:  coils.relay_bits.relay7 = state; break;
-        case 8:  coils.relay_bits.relay8 = state; break;
-        case 9:  coils.relay_bits.relay9 = state; break;
-        case 10: coils.relay_bits.relay10 = state; break;
-        case 11: coils.relay_bits.relay11 = state; break;
-        case 12: coils.relay_bits.relay12 = state; break;
-        case 13: coils.relay_bits.emergency_relay = state; break;
-        default: break;  
+        uint16_t bit = static_cast<uint16_t>(1U << (relay_number - 1));
+        SetRelayMask(bit, state ? bit : 0);
     }
 }  
 
@@ -79,25 +74,41 @@ void PBlockRegisters_t::SetRelay(uint8_t relay_number, bool state)
  */
 bool PBlockRegisters_t::GetRelay(uint8_t relay_number)  
 {  
-    switch (relay_number)
+    if (relay_number < 1 || relay_number > RELAY_COUNT)
     {
-        case 1:  return coils.relay_bits.relay1;
-        case 2:  return coils.relay_bits.relay2;
-        case 3:  return coils.relay_bits.relay3;
-        case 4:  return coils.relay_bits.relay4;
-        case 5:  return coils.relay_bits.relay5;
-        case 6:  return coils.relay_bits.relay6;
-        case 7:  return coils.relay_bits.relay7;
-        case 8:  return coils.relay_bits.relay8;
-        case 9:  return coils.relay_bits.relay9;
-        case 10: return coils.relay_bits.relay10;
-        case 11: return coils.relay_bits.relay11;
-        case 12: return coils.relay_bits.relay12;
-        case 13: return coils.relay_bits.emergency_relay;
-        default: return false;  
+        return false;
     }
+    return (coils.relay_mask >> (relay_number - 1)) & 1U;
 }  
 
+/**
+ * @brief Update several relays in one store (static member function)
+ * Safe against concurrent writers (Modbus task, CANopen RPDO); the relay
+ * driver applies the resulting mask to hardware in one port write.
+ * @param mask Relays to change, bit n-1 = relay n
+ * @param bits New states for the relays selected by mask
+ */
+void PBlockRegisters_t::SetRelayMask(uint16_t mask, uint16_t bits)
+{
+    mask &= RELAY_ALL_MASK;
+    uint16_t expected = coils.relay_mask;
+    uint16_t desired;
+    do
+    {
+        desired = static_cast<uint16_t>((expected & ~mask) | (bits & mask));
+    } while (!__atomic_compare_exchange_n(&coils.relay_mask, &expected, desired, false,
+                                          __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+}
+
+/**
+ * @brief Get all relay states (static member function)
+ * @return Relay mask, bit n-1 = relay n
+ */
+uint16_t PBlockRegisters_t::GetRelayMask(void)
+{
+    return coils.relay_mask;
+}
+
 /**
  * @brief Set analog output value (static member function)
  * @param output_number Output number (1-6, corresponds to array index 0-5)
@@ -109,6 +120,8 @@ void PBlockRegisters_t::SetAnalogOutput(uint8_t output_number, uint16_t value)
     if (output_number >= 1 && output_number <= 6)  
     {  
         analog_output[output_number - 1] = value;  
+        // Hardware is updated by the output engine on its next cycle
+        AnalogOutputEngine::MarkDirty(output_number - 1);
     }  
 }  
 
@@ -183,17 +196,49 @@ bool PBlockRegisters_t::GetUniversalInputDiscrete(uint8_t input_number)
 }  
 
 /**
- * @brief Log an error to the error log buffer (static member function)
+ * @brief Store a universal input reading and notify the subscribers if it changed
+ * @param input_number Input number (1-11, corresponds to array index 0-10)
+ * @param analog_value Analog value (0-10000 mV)
+ * @param discrete_value Discrete value (0/1)
+ */
+void PBlockRegisters_t::SetUniversalInput(uint8_t input_number, uint16_t analog_value, uint16_t discrete_value)
+{
+    if (input_number < 1 || input_number > 11)
+    {
+        return;
+    }
+    UniversalInput_t &input = universal_inputs[input_number - 1];
+    if (input.analog_value == analog_value && input.discrete_value == discrete_value)
+    {
+        return;
+    }
+    input.analog_value = analog_value;
+    input.discrete_value = discrete_value;
+    NotifyChange(PBLOCK_CHANGE_INPUT(input_number));
+}
+
+/**
+ * @brief Set the STATUS register and notify the subscribers if it changed
+ * @param status 0=normal, 1-65535=error code
+ */
+void PBlockRegisters_t::SetStatus(uint16_t status)
+{
+    if (holding_registers.status == status)
+    {
+        return;
+    }
+    holding_registers.status = status;
+    NotifyChange(PBLOCK_CHANGE_STATUS);
+}
+
+/**
+ * @brief Log an error to the error journal (static member function)
  * @param error_code Error code to log
  */
 void PBlockRegisters_t::LogError(uint16_t error_code)  
 {  
-    for (int8_t i = 9; i > 0; i--)  
-    {  
-        holding_registers.error_log[i] = holding_registers.error_log[i - 1];  
-    }  
-    holding_registers.error_log[0] = error_code;  
-    holding_registers.status = error_code;  
+    ErrorLog::Add(error_code);  
+    SetStatus(error_code);
 }  
 
 /**
@@ -201,7 +246,7 @@ void PBlockRegisters_t::LogError(uint16_t error_code)
  */
 void PBlockRegisters_t::ClearErrorStatus(void)  
 {  
-    holding_registers.status = 0;  
+    SetStatus(0);
 }  
 
 /**
@@ -212,3 +257,36 @@ void PBlockRegisters_t::IncrementBootCount(void)
     holding_registers.boot_count++;  
 }  
 
+/**
+ * @brief Call listener whenever a value selected by mask changes
+ * Register before the writers start; listeners run in the writer's context
+ * (task or interrupt) and must only record the change and wake their task.
+ * @param mask PBLOCK_CHANGE_* bits of interest
+ * @return false if all PBLOCK_SUBSCRIBERS slots are taken
+ */
+bool PBlockRegisters_t::Subscribe(uint32_t mask, ChangeListener_t listener)
+{
+    if (listener_count == PBLOCK_SUBSCRIBERS)
+    {
+        return false;
+    }
+    listener_masks[listener_count] = mask;
+    listeners[listener_count] = listener;
+    listener_count++;
+    return true;
+}
+
+/**
+ * @brief Pass changed values to their subscribers
+ * @param changed PBLOCK_CHANGE_* bits of the values written
+ */
+void PBlockRegisters_t::NotifyChange(uint32_t changed)
+{
+    for (uint8_t i = 0; i < listener_count; i++)
+    {
+        if ((listener_masks[i] & changed) != 0)
+        {
+            listeners[i](listener_masks[i] & changed);
+        }
+    }
+}
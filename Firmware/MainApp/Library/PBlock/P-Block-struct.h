@@ -25,26 +25,21 @@ struct UniversalInput_t {
   uint16_t discrete_value;       // Discrete/digital value: true/false
 };
 
+#define RELAY_COUNT           (13U)     // 12 standard relays + emergency relay
+#define RELAY_EMERGENCY       (13U)     // Relay number of the emergency relay
+#define RELAY_ALL_MASK        ((1U << RELAY_COUNT) - 1U)
+
+// Change bits passed to the subscribers (Subscribe)
+#define PBLOCK_CHANGE_STATUS      (1UL << 0)            // holding_registers.status
+#define PBLOCK_CHANGE_INPUT(n)    (1UL << (n))          // universal input n (1-11)
+#define PBLOCK_SUBSCRIBERS        (2U)
+
 // Coils (Read/Write bits) - Relay Outputs
 struct Coils_t {
   // Discrete Outputs (00001-00013, addresses 0-12)
-  // Bit field structure for individual relay control
-  struct RelayBits_t {
-    bool relay1 : 1;          // Relay 1 (address 0)
-    bool relay2 : 1;          // Relay 2 (address 1)
-    bool relay3 : 1;          // Relay 3 (address 2)
-    bool relay4 : 1;          // Relay 4 (address 3)
-    bool relay5 : 1;          // Relay 5 (address 4)
-    bool relay6 : 1;          // Relay 6 (address 5)
-    bool relay7 : 1;          // Relay 7 (address 6)
-    bool relay8 : 1;          // Relay 8 (address 7)
-    bool relay9 : 1;          // Relay 9 (address 8)
-    bool relay10 : 1;         // Relay 10 (address 9)
-    bool relay11 : 1;         // Relay 11 (address 10)
-    bool relay12 : 1;         // Relay 12 (address 11)
-    bool emergency_relay : 1; // Emergency relay (address 12)
-    bool : 3;                 // Padding bits (unused)
-  } relay_bits;
+  // Bit n-1 = relay n, bit 12 = emergency relay. Held as one word so that
+  // multi-coil writes and RPDO 0 are a single masked store.
+  volatile uint16_t relay_mask;
 };
 
 /**
@@ -60,10 +55,11 @@ struct PBlockRegisters_t {
     HybridConfigType hybrid_config; // 0=4 outputs, 2=2 inputs (B terminals),
                                     // 4=4 extra inputs
 
-    // Diagnostic Registers (40201-40219, addresses 200-218)
-    uint16_t status;        // STATUS register (0=normal, 1-65535=error code)
-    uint16_t boot_count;    // BOOT_CNT register (restart counter)
-    uint16_t error_log[10]; // ERROR_LOG (10 latest errors, ERR1-ERR10)
+    // Diagnostic Registers (40201-40220, addresses 200-219)
+    uint16_t status;         // STATUS register (0=normal, 1-65535=error code)
+    uint16_t boot_count;     // BOOT_CNT register (restart counter)
+    uint16_t error_log_view; // ERROR_LOG_VIEW (209): page | field << 8, window
+                             // 210-219 shows entries page*10.. of ErrorLog
   };
 
   // Static data members (declared inside struct, defined outside)
@@ -87,6 +83,8 @@ struct PBlockRegisters_t {
   static void UpdateInputs(void);
   static void SetRelay(uint8_t relay_number, bool state);
   static bool GetRelay(uint8_t relay_number);
+  static void SetRelayMask(uint16_t mask, uint16_t bits);
+  static uint16_t GetRelayMask(void);
   static void SetAnalogOutput(uint8_t output_number, uint16_t value);
   static uint16_t GetAnalogOutput(uint8_t output_number);
   static void SetInputMode(uint8_t input_number, UniversalInputType mode);
@@ -94,9 +92,17 @@ struct PBlockRegisters_t {
   static uint16_t GetUniversalInput(uint8_t input_number);
   static uint16_t GetUniversalInputType(uint8_t input_number);
   static bool GetUniversalInputDiscrete(uint8_t input_number);
+  static void SetUniversalInput(uint8_t input_number, uint16_t analog_value, uint16_t discrete_value);
+  static void SetStatus(uint16_t status);
   static void LogError(uint16_t error_code);
   static void ClearErrorStatus(void);
   static void IncrementBootCount(void);
+
+  // Change subscriptions: the setters above call the listeners whose mask
+  // has a bit of the value that changed, in the writer's context
+  typedef void (*ChangeListener_t)(uint32_t changed);
+  static bool Subscribe(uint32_t mask, ChangeListener_t listener);
+  static void NotifyChange(uint32_t changed);
 };
 #pragma pack(pop)
 
@@ -1,17 +1,39 @@
 #include "Periphery.h"
 #include "P-Block-struct.h"
+#include "AnalogOutputEngine.h"
+#include "RelayDriver.h"
+#include "TrendLogger.h"
+#include "DeadlineMonitor.h"
 #include "FreeRTOS.h"
 #include "task.h"
 
 void inputUpdateTask(void *parameters)
 {
     (void)parameters;
+    TickType_t lastWake = xTaskGetTickCount();
 
     for (;;)
     {
-        // Update universal inputs every 100ms
+        // Update universal inputs every 100ms, at a fixed rate so trend samples stay on schedule
         PBlockRegisters_t::UpdateInputs();
-        vTaskDelay(pdMS_TO_TICKS(100));
+        // Nominal wake time, the input update duration does not shift the schedule
+        TrendLogger::Sample(lastWake * portTICK_PERIOD_MS);
+        DeadlineMonitor::Report(DEADLINE_INPUT_UPDATE);
+        vTaskDelayUntil(&lastWake, pdMS_TO_TICKS(TREND_MIN_PERIOD_MS));
     }
 }
 
+void outputUpdateTask(void *parameters)
+{
+    (void)parameters;
+    TickType_t lastWake = xTaskGetTickCount();
+
+    for (;;)
+    {
+        // Apply coalesced setpoint changes and slew limiting at a fixed rate
+        AnalogOutputEngine::Process();
+        RelayDriver::Process(xTaskGetTickCount());
+        DeadlineMonitor::Report(DEADLINE_OUTPUT_UPDATE);
+        vTaskDelayUntil(&lastWake, pdMS_TO_TICKS(AO_ENGINE_PERIOD_MS));
+    }
+}
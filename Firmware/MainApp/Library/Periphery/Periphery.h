@@ -12,6 +12,12 @@ extern "C"
  */
 void inputUpdateTask(void *parameters);
 
+/**
+ * @brief Task driving analog and relay outputs at a fixed rate
+ * @param parameters Task parameters (unused)
+ */
+void outputUpdateTask(void *parameters);
+
 #ifdef __cplusplus
 }
 #endif
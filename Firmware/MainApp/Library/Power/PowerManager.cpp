@@ -0,0 +1,170 @@
+#include "PowerManager.h"
+#include "at32f403a_407.h"
+
+#define POWER_COUNTS_PER_TICK       (configSYSTICK_CLOCK_HZ / configTICK_RATE_HZ)
+#define POWER_MAX_SLEEP_TICKS       (SysTick_LOAD_RELOAD_Msk / POWER_COUNTS_PER_TICK)
+#define POWER_STOPPED_COUNTS        (94UL / (configCPU_CLOCK_HZ / configSYSTICK_CLOCK_HZ)) /// SysTick counts lost while it is stopped
+
+static_assert(configSYSTICK_CLOCK_HZ != configCPU_CLOCK_HZ, "the wake-up timer expects SysTick on the HCLK/8 reference");
+
+static uint32_t wakeups_;
+static uint32_t timer_wakeups_;
+static uint32_t sleep_ticks_;
+static uint32_t longest_ticks_;
+
+// Current window, written by the sleep
+static uint32_t window_sleep_;
+static uint32_t window_wakeups_;
+static TickType_t window_start_;
+
+// Last complete window, written by Tick()
+static uint16_t sleep_permille_;
+static uint16_t window_wakeups_last_;
+
+#if (configUSE_TICKLESS_IDLE == 2)
+
+static void account_sleep(TickType_t ticks, bool by_timer) {
+    wakeups_++;
+    if (by_timer) {
+        timer_wakeups_++;
+    }
+    sleep_ticks_ += ticks;
+    window_sleep_ += ticks;
+    window_wakeups_++;
+    if (ticks > longest_ticks_) {
+        longest_ticks_ = ticks;
+    }
+}
+
+/**
+ * @brief portSUPPRESS_TICKS_AND_SLEEP, called by the idle task with the scheduler suspended
+ * Follows the SysTick implementation of the port, except that interrupts stay
+ * masked until the tick count has been stepped: the handler that ended the
+ * sleep runs afterwards and reads the current tick, not the one from before
+ * the sleep (DigitalInputCapture timestamps its edges with it).
+ */
+extern "C" void vPortSuppressTicksAndSleep(TickType_t expected_ticks) {
+    if (expected_ticks > POWER_MAX_SLEEP_TICKS) {
+        expected_ticks = POWER_MAX_SLEEP_TICKS;
+    }
+
+    __disable_irq();
+    __DSB();
+    __ISB();
+
+    if (eTaskConfirmSleepModeStatus() == eAbortSleep) {
+        __enable_irq();
+        return;
+    }
+
+    // Counts left of the current tick, then whole ticks up to the expected wake-up
+    SysTick->CTRL = SysTick_CTRL_TICKINT_Msk;
+    uint32_t counts_left = SysTick->VAL;
+    if (counts_left == 0) {
+        counts_left = POWER_COUNTS_PER_TICK;
+    }
+    uint32_t reload = counts_left + POWER_COUNTS_PER_TICK * (expected_ticks - 1U);
+    if (SCB->ICSR & SCB_ICSR_PENDSTSET_Msk) {
+        SCB->ICSR = SCB_ICSR_PENDSTCLR_Msk;
+        reload -= POWER_COUNTS_PER_TICK;
+    }
+    if (reload > POWER_STOPPED_COUNTS) {
+        reload -= POWER_STOPPED_COUNTS;
+    }
+    SysTick->LOAD = reload;
+    SysTick->VAL = 0;
+    SysTick->CTRL = SysTick_CTRL_TICKINT_Msk | SysTick_CTRL_ENABLE_Msk;
+
+    __DSB();
+    __WFI();
+    __ISB();
+
+    // Stop without reading CTRL, the read would clear COUNTFLAG
+    SysTick->CTRL = SysTick_CTRL_TICKINT_Msk;
+
+    TickType_t complete_ticks;
+    bool by_timer;
+    if (SysTick->CTRL & SysTick_CTRL_COUNTFLAG_Msk) {
+        // The wake-up timer expired; its tick is pending and counts the last tick itself
+        uint32_t load = (POWER_COUNTS_PER_TICK - 1U) - (reload - SysTick->VAL);
+        if (load <= POWER_STOPPED_COUNTS || load > POWER_COUNTS_PER_TICK) {
+            load = POWER_COUNTS_PER_TICK - 1U;
+        }
+        SysTick->LOAD = load;
+        complete_ticks = expected_ticks - 1U;
+        by_timer = true;
+    } else {
+        // Another interrupt; the reference clock may not have reloaded VAL yet
+        uint32_t counts_to_go = SysTick->VAL;
+        if (counts_to_go == 0) {
+            counts_to_go = reload;
+        }
+        const uint32_t counts_done = expected_ticks * POWER_COUNTS_PER_TICK - counts_to_go;
+        complete_ticks = counts_done / POWER_COUNTS_PER_TICK;
+        uint32_t load = (complete_ticks + 1U) * POWER_COUNTS_PER_TICK - counts_done;
+        if (load <= POWER_STOPPED_COUNTS) {
+            // Would run out during the clock switch and restart a whole tick late: count it now
+            complete_ticks++;
+            load += POWER_COUNTS_PER_TICK;
+        }
+        SysTick->LOAD = load;
+        by_timer = false;
+    }
+
+    // Load the remainder of the tick at once on the core clock, then go back to the reference clock
+    SysTick->VAL = 0;
+    SysTick->CTRL = SysTick_CTRL_CLKSOURCE_Msk | SysTick_CTRL_TICKINT_Msk | SysTick_CTRL_ENABLE_Msk;
+    SysTick->CTRL = SysTick_CTRL_CLKSOURCE_Msk | SysTick_CTRL_TICKINT_Msk;
+    if (SysTick->CTRL & SysTick_CTRL_COUNTFLAG_Msk) {
+        SysTick->VAL = 0; // the partial tick already ended, count it once
+    }
+    SysTick->LOAD = POWER_COUNTS_PER_TICK - 1U;
+    SysTick->CTRL = SysTick_CTRL_TICKINT_Msk | SysTick_CTRL_ENABLE_Msk;
+
+    vTaskStepTick(complete_ticks);
+    account_sleep(by_timer ? expected_ticks : complete_ticks, by_timer);
+
+    __enable_irq();
+}
+
+#endif // configUSE_TICKLESS_IDLE
+
+void PowerManager::Tick(void) {
+    // Runs on the first tick after a sleep, the window may come out longer than POWER_WINDOW_MS
+    const TickType_t now = xTaskGetTickCountFromISR();
+    const TickType_t length = now - window_start_;
+    if (length < pdMS_TO_TICKS(POWER_WINDOW_MS)) {
+        return;
+    }
+    const uint32_t permille = window_sleep_ * 1000U / length;
+    sleep_permille_ = permille > 1000U ? 1000U : static_cast<uint16_t>(permille);
+    window_wakeups_last_ = window_wakeups_ > 0xFFFFU ? 0xFFFFU : static_cast<uint16_t>(window_wakeups_);
+    window_sleep_ = 0;
+    window_wakeups_ = 0;
+    window_start_ = now;
+}
+
+void PowerManager::GetStats(PowerStats &out) {
+    taskENTER_CRITICAL();
+    out.wakeups = wakeups_;
+    out.timer_wakeups = timer_wakeups_;
+    out.sleep_ms = sleep_ticks_ * portTICK_PERIOD_MS;
+    out.sleep_permille = sleep_permille_;
+    out.window_wakeups = window_wakeups_last_;
+    out.longest_sleep_ms = static_cast<uint16_t>(longest_ticks_ * portTICK_PERIOD_MS);
+    out.reserved = 0;
+    taskEXIT_CRITICAL();
+}
+
+void PowerManager::Wake(TaskHandle_t task) {
+    if (task == NULL) {
+        return;
+    }
+    if (xPortIsInsideInterrupt()) {
+        BaseType_t woken = pdFALSE;
+        vTaskNotifyGiveFromISR(task, &woken);
+        portYIELD_FROM_ISR(woken);
+    } else {
+        xTaskNotifyGive(task);
+    }
+}
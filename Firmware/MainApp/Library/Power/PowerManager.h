@@ -0,0 +1,53 @@
+#ifndef __POWER_MANAGER_H__
+#define __POWER_MANAGER_H__
+
+#include <stdint.h>
+#include "FreeRTOS.h"
+#include "task.h"
+
+#define POWER_WINDOW_MS             (1000U)     /// sleep_permille covers this much time
+
+#pragma pack(push, 1)
+/** @brief Sleep statistics exported by GetPowerStats */
+struct PowerStats {
+    uint32_t wakeups;                   /// sleeps ended since start-up
+    uint32_t timer_wakeups;             /// of these, ended by the wake-up timer instead of an interrupt
+    uint32_t sleep_ms;                  /// time asleep since start-up, wraps
+    uint16_t sleep_permille;            /// share of the last window spent asleep
+    uint16_t window_wakeups;            /// sleeps ended in the last window, saturates
+    uint16_t longest_sleep_ms;          /// longest single sleep since start-up
+    uint16_t reserved;
+};
+#pragma pack(pop)
+
+/**
+ * @brief Tickless idle and event wake-ups
+ * With nothing to run for configEXPECTED_IDLE_TIME_BEFORE_SLEEP ticks the
+ * idle task stops the tick and sleeps (WFI, sleep mode) until the next task
+ * timeout or an interrupt. SysTick, clocked from HCLK/8, is the wake-up
+ * timer, which bounds one sleep to about 559 ms.
+ *
+ * Deep sleep, an RTC wake-up and a lower core clock are not used yet: mains
+ * synchronisation, TRIAC gates, PWM outputs, USART and CAN run on the APB
+ * timers and clocks and must keep their timing while the core idles. Both
+ * are a separate request, see Power_todo.md.
+ */
+class PowerManager {
+public:
+    /**
+     * @brief Close the statistics window every POWER_WINDOW_MS
+     * Call from vApplicationTickHook.
+     */
+    static void Tick(void);
+
+    static void GetStats(PowerStats &out);
+
+    /**
+     * @brief Wake a task waiting in ulTaskNotifyTake
+     * Safe from tasks and interrupts, for drivers that signal work to a
+     * task which otherwise sleeps until its next deadline.
+     */
+    static void Wake(TaskHandle_t task);
+};
+
+#endif // __POWER_MANAGER_H__
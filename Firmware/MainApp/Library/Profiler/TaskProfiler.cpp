@@ -0,0 +1,199 @@
+#include "TaskProfiler.h"
+#include <FreeRTOS.h>
+#include <task.h>
+#include <string.h>
+
+#define PROFILER_STATUS_MAX (PROFILER_MAX_TASKS + 4U) // uxTaskGetSystemState fails if the array is short
+
+struct ProfilerCounters {
+    uint32_t count;
+    uint32_t cycles;
+};
+
+// Current window, written by the hooks
+static ProfilerCounters task_window_[PROFILER_MAX_TASKS];
+static ProfilerCounters isr_window_[PROFILER_ISR_COUNT];
+static uint32_t latency_window_;
+
+// Last complete window, written by Tick()
+static ProfilerCounters task_last_[PROFILER_MAX_TASKS];
+static ProfilerCounters isr_last_[PROFILER_ISR_COUNT];
+static uint32_t latency_last_;
+static uint32_t window_last_;
+
+static uint32_t isr_max_[PROFILER_ISR_COUNT];
+static uint32_t latency_peak_;
+
+static volatile uint32_t isr_total_;    // exclusive cycles of all instrumented handlers, wraps
+static uint32_t current_slot_;
+static uint32_t switched_in_at_;
+static uint32_t isr_at_switch_in_;
+static uint32_t window_start_;
+static TickType_t window_tick_;
+
+static TaskStatus_t status_[PROFILER_STATUS_MAX];
+
+static inline uint32_t slot_of(uint32_t task_number) {
+    return (task_number == 0 || task_number > PROFILER_MAX_TASKS) ? PROFILER_MAX_TASKS - 1 : task_number - 1;
+}
+
+static inline uint16_t saturate16(uint32_t value) {
+    return value > 0xFFFFU ? 0xFFFFU : static_cast<uint16_t>(value);
+}
+
+static inline uint16_t permille(uint32_t cycles, uint32_t window) {
+    if (window == 0) {
+        return 0;
+    }
+    const uint64_t value = static_cast<uint64_t>(cycles) * 1000U / window;
+    return value > 1000U ? 1000U : static_cast<uint16_t>(value);
+}
+
+/// Charge the running task up to now, kernel interrupt priority or masked
+static void charge_current(uint32_t now) {
+    const uint32_t elapsed = now - switched_in_at_;
+    const uint32_t in_isr = isr_total_ - isr_at_switch_in_;
+    task_window_[current_slot_].cycles += elapsed > in_isr ? elapsed - in_isr : 0;
+    switched_in_at_ = now;
+    isr_at_switch_in_ = isr_total_;
+}
+
+extern "C" void TaskProfiler_SwitchedOut(void) {
+    charge_current(PROFILER_CYCLES());
+}
+
+extern "C" void TaskProfiler_SwitchedIn(uint32_t task_number) {
+    current_slot_ = slot_of(task_number);
+    task_window_[current_slot_].count++;
+    switched_in_at_ = PROFILER_CYCLES();
+    isr_at_switch_in_ = isr_total_;
+}
+
+extern "C" ProfilerIsrFrame TaskProfiler_IsrEnter(void) {
+    ProfilerIsrFrame frame;
+    frame.nested = isr_total_;
+    frame.start = PROFILER_CYCLES();
+    return frame;
+}
+
+extern "C" void TaskProfiler_IsrExit(ProfilerIsr isr, ProfilerIsrFrame frame) {
+    const uint32_t now = PROFILER_CYCLES();
+
+    // A nested handler must not land between reading and writing isr_total_
+    const UBaseType_t mask = taskENTER_CRITICAL_FROM_ISR();
+    const uint32_t elapsed = now - frame.start;
+    const uint32_t nested = isr_total_ - frame.nested;
+    const uint32_t own = elapsed > nested ? elapsed - nested : 0;
+    isr_total_ = isr_total_ + own;
+    isr_window_[isr].count++;
+    isr_window_[isr].cycles += own;
+    if (own > isr_max_[isr]) {
+        isr_max_[isr] = own;
+    }
+    taskEXIT_CRITICAL_FROM_ISR(mask);
+}
+
+extern "C" void TaskProfiler_IsrLatency(uint32_t cycles) {
+    const UBaseType_t mask = taskENTER_CRITICAL_FROM_ISR();
+    if (cycles > latency_window_) {
+        latency_window_ = cycles;
+    }
+    if (cycles > latency_peak_) {
+        latency_peak_ = cycles;
+    }
+    taskEXIT_CRITICAL_FROM_ISR(mask);
+}
+
+void TaskProfiler::Init(void) {
+#ifdef DWT
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+#endif
+    window_start_ = PROFILER_CYCLES();
+    switched_in_at_ = window_start_;
+}
+
+void TaskProfiler::Tick(void) {
+    // Tick count, not hook calls: ticks stepped over by tickless idle do not run the hook
+    const TickType_t tick = xTaskGetTickCountFromISR();
+    if (tick - window_tick_ < pdMS_TO_TICKS(PROFILER_WINDOW_MS)) {
+        return;
+    }
+    window_tick_ = tick;
+
+    const UBaseType_t mask = taskENTER_CRITICAL_FROM_ISR();
+    const uint32_t now = PROFILER_CYCLES();
+    charge_current(now);
+    window_last_ = now - window_start_;
+    window_start_ = now;
+    memcpy(task_last_, task_window_, sizeof(task_last_));
+    memset(task_window_, 0, sizeof(task_window_));
+    memcpy(isr_last_, isr_window_, sizeof(isr_last_));
+    memset(isr_window_, 0, sizeof(isr_window_));
+    latency_last_ = latency_window_;
+    latency_window_ = 0;
+    taskEXIT_CRITICAL_FROM_ISR(mask);
+}
+
+void TaskProfiler::Snapshot(TaskProfileSnapshot &out) {
+    ProfilerCounters tasks[PROFILER_MAX_TASKS];
+
+    memset(&out, 0, sizeof(out));
+
+    vTaskSuspendAll(); // status_ is shared by all callers
+    const UBaseType_t count = uxTaskGetSystemState(status_, PROFILER_STATUS_MAX, NULL);
+    const TaskHandle_t idle = xTaskGetIdleTaskHandle();
+
+    taskENTER_CRITICAL();
+    memcpy(tasks, task_last_, sizeof(tasks));
+    for (uint8_t i = 0; i < PROFILER_ISR_COUNT; i++) {
+        out.isr[i].count = saturate16(isr_last_[i].count);
+        out.isr[i].cpu_permille = permille(isr_last_[i].cycles, window_last_);
+        out.isr[i].max_cycles = isr_max_[i];
+    }
+    out.window_cycles = window_last_;
+    out.latency_cycles = latency_last_;
+    out.latency_peak_cycles = latency_peak_;
+    taskEXIT_CRITICAL();
+
+    out.version = out.window_cycles != 0 ? PROFILER_LAYOUT : 0;
+    out.cpu_load_permille = PROFILER_NO_LOAD;
+
+    // One entry per slot in use, in task number order
+    for (uint32_t slot = 0; slot < PROFILER_MAX_TASKS; slot++) {
+        TaskProfileTask &task = out.tasks[out.task_count];
+        bool used = false;
+        bool shared = false;
+        bool has_idle = false;
+        for (UBaseType_t i = 0; i < count; i++) {
+            if (slot_of(status_[i].xTaskNumber) != slot) {
+                continue;
+            }
+            if (used) {
+                shared = true; // only the last slot is ever shared
+                continue;
+            }
+            used = true;
+            task.number = static_cast<uint16_t>(status_[i].xTaskNumber);
+            strncpy(task.name, status_[i].pcTaskName, PROFILER_NAME_LEN);
+            task.stack_free = saturate16(status_[i].usStackHighWaterMark);
+            has_idle = status_[i].xHandle == idle;
+        }
+        if (!used) {
+            continue;
+        }
+        if (shared) {
+            task.number = 0;
+            memset(task.name, 0, sizeof(task.name));
+            strncpy(task.name, "other", PROFILER_NAME_LEN);
+            task.stack_free = 0;
+        }
+        task.cpu_permille = permille(tasks[slot].cycles, out.window_cycles);
+        if (has_idle && !shared) {
+            out.cpu_load_permille = 1000U - task.cpu_permille;
+        }
+        task.switches = saturate16(tasks[slot].count);
+        out.task_count++;
+    }
+    xTaskResumeAll();
+}
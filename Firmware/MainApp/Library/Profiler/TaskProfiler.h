@@ -0,0 +1,126 @@
+#ifndef __TASK_PROFILER_H__
+#define __TASK_PROFILER_H__
+
+#include <stdint.h>
+
+#define PROFILER_LAYOUT             (1U)        /// TaskProfileSnapshot::version
+#define PROFILER_MAX_TASKS          (8U)        /// the last slot also takes every task numbered above it
+#define PROFILER_NAME_LEN           (8U)
+#define PROFILER_WINDOW_MS          (1000U)     /// per-window figures cover this much time
+#define PROFILER_MB_ADDRESS         (300U)      /// first Modbus input register of the snapshot
+#define PROFILER_NO_LOAD            (0xFFFFU)   /// cpu_load_permille when the idle task has no slot
+
+/// Cycle counter; a host build defines its own before including this header
+#ifndef PROFILER_CYCLES
+#include "at32f403a_407.h"
+#define PROFILER_CYCLES()           (DWT->CYCCNT)
+#endif
+
+/** @brief Instrumented interrupt vectors */
+typedef enum {
+    PROFILER_ISR_USART1 = 0,    /// Modbus RTU UART
+    PROFILER_ISR_TMR2,          /// Modbus T3.5 timer, also the latency probe
+    PROFILER_ISR_CAN,           /// CO_CANinterrupt
+    PROFILER_ISR_COUNT,
+} ProfilerIsr;
+
+/** @brief State taken by TaskProfiler_IsrEnter */
+typedef struct {
+    uint32_t start;
+    uint32_t nested;
+} ProfilerIsrFrame;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Kernel trace hooks, wired in FreeRTOSConfig.h */
+void TaskProfiler_SwitchedIn(uint32_t task_number);
+void TaskProfiler_SwitchedOut(void);
+
+/* Interrupt handlers: Enter first thing, Exit last */
+ProfilerIsrFrame TaskProfiler_IsrEnter(void);
+void TaskProfiler_IsrExit(ProfilerIsr isr, ProfilerIsrFrame frame);
+
+/** @brief Cycles from the interrupt event to the handler, kept as window and all-time maximum */
+void TaskProfiler_IsrLatency(uint32_t cycles);
+
+#ifdef __cplusplus
+}
+
+#pragma pack(push, 1)
+/** @brief One task of a snapshot */
+struct TaskProfileTask {
+    uint16_t number;                    /// FreeRTOS TCB number (creation order from 1), 0 = several tasks
+    char name[PROFILER_NAME_LEN];       /// not terminated when the name fills it
+    uint16_t cpu_permille;              /// share of the last window, instrumented ISRs excluded
+    uint16_t switches;                  /// times switched in during the last window, saturates
+    uint16_t stack_free;                /// stack high-water mark, words never used
+};
+
+/** @brief One interrupt vector of a snapshot */
+struct TaskProfileIsr {
+    uint16_t count;                     /// entries in the last window, saturates
+    uint16_t cpu_permille;              /// share of the last window, nested ISRs excluded
+    uint32_t max_cycles;                /// longest single run since start-up
+};
+
+/**
+ * @brief Profile exported by GetTaskProfile, the Modbus input registers from
+ * PROFILER_MB_ADDRESS and OD 0x2500
+ * Every field sits on a 16-bit boundary, so the struct is also read as an
+ * array of words (32-bit fields low word first).
+ */
+struct TaskProfileSnapshot {
+    uint16_t version;                   /// PROFILER_LAYOUT, 0 before the first window completed
+    uint16_t task_count;                /// valid entries of tasks[]
+    uint32_t window_cycles;             /// length of the last window
+    uint16_t cpu_load_permille;         /// 1000 - idle task share, or PROFILER_NO_LOAD
+    uint16_t reserved;
+    uint32_t latency_cycles;            /// largest TMR2 entry latency in the last window
+    uint32_t latency_peak_cycles;       /// largest since start-up
+    TaskProfileTask tasks[PROFILER_MAX_TASKS];
+    TaskProfileIsr isr[PROFILER_ISR_COUNT];
+};
+#pragma pack(pop)
+
+#define PROFILER_MB_REGS            (sizeof(TaskProfileSnapshot) / sizeof(uint16_t))
+
+/**
+ * @brief Per-task CPU time, context switches, stack watermarks and ISR time
+ * Based on the DWT cycle counter. The kernel switch hooks charge each task
+ * the cycles it ran, minus the cycles spent in instrumented interrupt
+ * handlers meanwhile; an instrumented handler is charged the same way
+ * against handlers nested in it. Other interrupts (SysTick, PendSV, EXINT,
+ * TMR5) stay in the time of the task they preempted. A tickless sleep is
+ * charged to the idle task only as far as the DWT counter runs in sleep
+ * mode; PowerManager reports the time asleep from the tick count.
+ *
+ * Counters run for PROFILER_WINDOW_MS and are then copied as the last
+ * window by Tick(), called from the tick hook, so a starved idle task
+ * does not stop the profile. Snapshot() combines the last window with
+ * task names and stack high-water marks; it runs in task context.
+ */
+class TaskProfiler {
+public:
+    /**
+     * @brief Start the cycle counter, before the scheduler
+     */
+    static void Init(void);
+
+    /**
+     * @brief Close the window every PROFILER_WINDOW_MS
+     * Call from vApplicationTickHook.
+     */
+    static void Tick(void);
+
+    /**
+     * @brief Last complete window with names and stack watermarks
+     * Walks every task stack for the watermark, task context only.
+     */
+    static void Snapshot(TaskProfileSnapshot &out);
+};
+
+#endif // __cplusplus
+
+#endif // __TASK_PROFILER_H__
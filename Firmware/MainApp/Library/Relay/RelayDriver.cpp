@@ -0,0 +1,74 @@
+#include "RelayDriver.h"
+#include "PBlockConfig.h"
+
+#define RELAY_PIN_MASK              (RELAY_ALL_MASK << RELAY_FIRST_PIN)
+
+uint16_t RelayDriver::applied_mask_ = 0;
+uint32_t RelayDriver::switch_count_[RELAY_COUNT] = {};
+bool RelayDriver::counters_dirty_ = false;
+uint32_t RelayDriver::last_save_ms_ = 0;
+
+bool RelayDriver::Init(void) {
+    gpio_init_type gpio_init_struct;
+
+    crm_periph_clock_enable(RELAY_PORT_CLOCK, TRUE);
+
+    // Note: pin mapping needs to be updated based on actual hardware design
+    RELAY_PORT->clr = RELAY_PIN_MASK;
+    gpio_default_para_init(&gpio_init_struct);
+    gpio_init_struct.gpio_drive_strength = GPIO_DRIVE_STRENGTH_MODERATE;
+    gpio_init_struct.gpio_out_type = GPIO_OUTPUT_PUSH_PULL;
+    gpio_init_struct.gpio_mode = GPIO_MODE_OUTPUT;
+    gpio_init_struct.gpio_pins = RELAY_PIN_MASK;
+    gpio_init_struct.gpio_pull = GPIO_PULL_NONE;
+    gpio_init(RELAY_PORT, &gpio_init_struct);
+    applied_mask_ = 0;
+
+    for (uint8_t i = 0; i < RELAY_COUNT; i++) {
+        switch_count_[i] = PBlockConfig::GetRelayCycles(i + 1);
+    }
+    return true;
+}
+
+void RelayDriver::Apply(uint16_t mask) {
+    // Upper half clears, lower half sets: every relay pin changes in the same write
+    uint32_t set = static_cast<uint32_t>(mask) << RELAY_FIRST_PIN;
+    uint32_t clear = (~set) & RELAY_PIN_MASK;
+    RELAY_PORT->scr = (clear << 16) | set;
+}
+
+void RelayDriver::Process(uint32_t now_ms) {
+    uint16_t mask = PBlockRegisters_t::GetRelayMask();
+
+    if (mask != applied_mask_) {
+        uint16_t switched_on = mask & ~applied_mask_;
+        Apply(mask);
+        applied_mask_ = mask;
+
+        if (switched_on) {
+            counters_dirty_ = true;
+        }
+        while (switched_on) {
+            uint8_t i = static_cast<uint8_t>(__builtin_ctz(switched_on));
+            switched_on &= switched_on - 1;
+            switch_count_[i]++;
+        }
+    }
+
+    if (counters_dirty_ && (now_ms - last_save_ms_) >= RELAY_COUNTER_SAVE_MS) {
+        SaveCounters(now_ms);
+    }
+}
+
+void RelayDriver::SaveCounters(uint32_t now_ms) {
+    PBlockConfig::SetRelayCycles(switch_count_);
+    counters_dirty_ = false;
+    last_save_ms_ = now_ms;
+}
+
+uint32_t RelayDriver::GetSwitchCount(uint8_t relay_number) {
+    if (relay_number < 1 || relay_number > RELAY_COUNT) {
+        return 0;
+    }
+    return switch_count_[relay_number - 1];
+}
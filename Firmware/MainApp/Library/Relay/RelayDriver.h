@@ -0,0 +1,65 @@
+#ifndef __RELAY_DRIVER_H__
+#define __RELAY_DRIVER_H__
+
+#include <stdint.h>
+#include "at32f403a_407_gpio.h"
+#include "at32f403a_407_crm.h"
+#include "P-Block-struct.h"
+
+#define RELAY_PORT                  GPIOE
+#define RELAY_PORT_CLOCK            CRM_GPIOE_PERIPH_CLOCK
+#define RELAY_FIRST_PIN             (0U)        /// relay n drives pin RELAY_FIRST_PIN + n - 1
+#define RELAY_COUNTER_SAVE_MS       (3600000U)  /// minimum interval between counter saves to flash
+
+/**
+ * @brief Relay output driver with switch-cycle counters
+ * The relay state lives in one word (PBlockRegisters_t::coils.relay_mask);
+ * writers only store into it. Process() compares it with the state on the
+ * pins and applies all changes with a single write to the port set/clear
+ * register, so relays switched together by one Modbus or RPDO frame also
+ * switch together on the board.
+ *
+ * Every off->on transition increments the relay's switch-cycle counter
+ * (contact wear). Counters are kept in RAM and written to the device config
+ * at most once per RELAY_COUNTER_SAVE_MS, and only if they changed; up to
+ * that interval of cycles is lost on power failure.
+ */
+class RelayDriver {
+public:
+    /**
+     * @brief Configure relay pins (all off) and load the saved counters
+     * PBlockConfig::Init() must be called first.
+     * @return true on success
+     */
+    static bool Init(void);
+
+    /**
+     * @brief Apply pending relay changes and save counters when due
+     * Called every output task cycle.
+     * @param now_ms Current time in ms
+     */
+    static void Process(uint32_t now_ms);
+
+    /**
+     * @brief Get switch-cycle counter
+     * @param relay_number Relay number (1-13)
+     * @return Number of off->on transitions, 0 on invalid relay
+     */
+    static uint32_t GetSwitchCount(uint8_t relay_number);
+
+    /**
+     * @brief Get relay states currently driven on the pins
+     */
+    static uint16_t GetAppliedMask(void) { return applied_mask_; }
+
+private:
+    static void Apply(uint16_t mask);
+    static void SaveCounters(uint32_t now_ms);
+
+    static uint16_t applied_mask_;
+    static uint32_t switch_count_[RELAY_COUNT];
+    static bool counters_dirty_;
+    static uint32_t last_save_ms_;
+};
+
+#endif // __RELAY_DRIVER_H__
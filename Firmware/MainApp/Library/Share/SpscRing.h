@@ -0,0 +1,62 @@
+#ifndef _SPSC_RING_H_
+#define _SPSC_RING_H_
+
+#include <cstdint>
+#include "at32f403a_407.h"
+
+/**
+ * @brief Lock-free single-producer/single-consumer ring buffer
+ * Producer is usually an ISR, consumer a task (or the other way around).
+ * No critical sections: each side owns exactly one index, the data slot is
+ * published with a memory barrier before the index is advanced.
+ * @tparam T element type (trivially copyable)
+ * @tparam N capacity, must be a power of two
+ */
+template<typename T, uint32_t N>
+class SpscRing {
+    static_assert(N >= 2 && (N & (N - 1)) == 0, "SpscRing size must be a power of two");
+
+    T buf[N];
+    volatile uint32_t head = 0;     /// written by producer only
+    volatile uint32_t tail = 0;     /// written by consumer only
+    volatile uint32_t dropped = 0;  /// pushes rejected because the ring was full
+
+  public:
+    /**
+     * @brief Producer side: append element
+     * @return false if the ring is full (element is dropped and counted)
+     */
+    bool Push(const T& item) {
+        uint32_t h = head;
+        if ((h - tail) >= N) {
+            dropped = dropped + 1;
+            return false;
+        }
+        buf[h & (N - 1)] = item;
+        __DMB();
+        head = h + 1;
+        return true;
+    }
+
+    /**
+     * @brief Consumer side: take oldest element
+     * @return false if the ring is empty
+     */
+    bool Pop(T& item) {
+        uint32_t t = tail;
+        if (t == head) {
+            return false;
+        }
+        __DMB();
+        item = buf[t & (N - 1)];
+        __DMB();
+        tail = t + 1;
+        return true;
+    }
+
+    bool IsEmpty(void) const { return head == tail; }
+    uint32_t Count(void) const { return head - tail; }
+    uint32_t Dropped(void) const { return dropped; }
+};
+
+#endif
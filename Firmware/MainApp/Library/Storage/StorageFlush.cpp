@@ -0,0 +1,74 @@
+#include "StorageFlush.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include "semphr.h"
+
+StorageFlush::Client StorageFlush::clients_[STORAGE_FLUSH_CLIENTS];
+uint8_t StorageFlush::client_count_ = 0;
+
+static TaskHandle_t storage_task;
+static SemaphoreHandle_t flash_mutex;
+static StaticSemaphore_t flash_mutex_buffer;
+
+void StorageFlush::Init(void) {
+    flash_mutex = xSemaphoreCreateMutexStatic(&flash_mutex_buffer);
+}
+
+bool StorageFlush::Register(Spill_t spill, Pending_t pending) {
+    for (uint8_t i = 0; i < client_count_; i++) {
+        if (clients_[i].spill == spill) {
+            return true;
+        }
+    }
+    if (client_count_ == STORAGE_FLUSH_CLIENTS) {
+        return false;
+    }
+    clients_[client_count_++] = {spill, pending};
+    return true;
+}
+
+void StorageFlush::Request(void) {
+    if (storage_task != NULL) {
+        xTaskNotifyGive(storage_task);
+    }
+}
+
+void StorageFlush::Lock(void) {
+    xSemaphoreTake(flash_mutex, portMAX_DELAY);
+}
+
+void StorageFlush::Unlock(void) {
+    xSemaphoreGive(flash_mutex);
+}
+
+bool StorageFlush::HasPending(void) {
+    for (uint8_t i = 0; i < client_count_; i++) {
+        if (clients_[i].pending()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool StorageFlush::Flush(void) {
+    bool ok = true;
+
+    Lock();
+    for (uint8_t i = 0; i < client_count_; i++) {
+        ok = clients_[i].spill() && ok;
+    }
+    Unlock();
+    return ok;
+}
+
+void StorageFlush::Task(void *parameters) {
+    (void)parameters;
+    storage_task = xTaskGetCurrentTaskHandle();
+
+    for (;;) {
+        // Data short of a batch is written after a while anyway,
+        // blocks left over by a failed write are retried then too
+        ulTaskNotifyTake(pdTRUE, HasPending() ? pdMS_TO_TICKS(STORAGE_FLUSH_PERIOD_MS) : portMAX_DELAY);
+        Flush();
+    }
+}
@@ -0,0 +1,70 @@
+#ifndef __STORAGE_FLUSH_H__
+#define __STORAGE_FLUSH_H__
+
+#include <stdint.h>
+
+#define STORAGE_FLUSH_CLIENTS       (4U)
+#define STORAGE_FLUSH_PERIOD_MS     (60000U)    /// data short of a batch waits at most this long
+#define STORAGE_FLUSH_TASK_STACK    (160U)      // words
+
+/**
+ * @brief Flash lock and background writer of the RAM-buffered logs
+ * All flash programming of the application (config journal, error log,
+ * trend log) takes Lock() so only one erase/program sequence runs at a time.
+ *
+ * A log registers its Spill() and HasPending() once. It calls Request() when
+ * a batch is waiting; the storage task then spills every client under the
+ * lock, and retries leftovers every STORAGE_FLUSH_PERIOD_MS. The config has
+ * its own flush task (PBlockConfig::FlushTask) with a coalescing window.
+ */
+class StorageFlush {
+public:
+    typedef bool (*Spill_t)(void);          /// program what is queued, true if nothing is left
+    typedef bool (*Pending_t)(void);        /// something is queued
+
+    /**
+     * @brief Create the lock, called once before any client's Init()
+     */
+    static void Init(void);
+
+    /**
+     * @brief Add a client, registering the same one again is ignored
+     * @return false if all STORAGE_FLUSH_CLIENTS slots are taken
+     */
+    static bool Register(Spill_t spill, Pending_t pending);
+
+    /**
+     * @brief Wake the storage task, e.g. when a page of error log entries is waiting
+     */
+    static void Request(void);
+
+    /**
+     * @brief Serialise flash programming, blocks while another task programs
+     */
+    static void Lock(void);
+    static void Unlock(void);
+
+    /**
+     * @brief Spill every client now (e.g. before a reset), blocks for the flash operations
+     * @return true if nothing is left queued
+     */
+    static bool Flush(void);
+
+    /**
+     * @brief Background task spilling the clients, lowest application priority
+     */
+    static void Task(void *parameters) __attribute__((noreturn));
+
+private:
+    struct Client {
+        Spill_t spill;
+        Pending_t pending;
+    };
+
+    static bool HasPending(void);
+
+    static Client clients_[STORAGE_FLUSH_CLIENTS];
+    static uint8_t client_count_;
+};
+
+#endif // __STORAGE_FLUSH_H__
@@ -0,0 +1,100 @@
+#include "Trace.h"
+
+#ifndef TRACE_CYCLES
+#include "at32f403a_407.h"
+#define TRACE_CYCLES()      (DWT->CYCCNT)   /// started by TaskProfiler::Init
+#endif
+
+#ifdef GLOB_USE_RTT
+#include "SEGGER_RTT.h"
+#else
+#include "UartDrv.h"
+#endif
+
+#define TRACE_MASK          (TRACE_RING_WORDS - 1U)
+#define TRACE_RECORD_MAX    (TRACE_MAX_ARGS + 2U)
+#define TRACE_HEADER(fmt, count) \
+    (TRACE_SYNC | (count) << 24 | ((reinterpret_cast<uintptr_t>(fmt) - TRACE_FMT_BASE) & 0x00FFFFFFU))
+
+static_assert((TRACE_RING_WORDS & TRACE_MASK) == 0, "TRACE_RING_WORDS must be a power of two");
+
+uint32_t Trace::ring_[TRACE_RING_WORDS];
+volatile uint32_t Trace::reserve_;
+volatile uint32_t Trace::tail_;
+volatile uint32_t Trace::dropped_;
+
+#ifdef GLOB_USE_RTT
+static uint8_t rtt_buffer_[TRACE_RTT_SIZE];
+#endif
+
+/// @return false if the sink could not take the record
+static bool send_record(const uint32_t *record, uint32_t words) {
+#ifdef GLOB_USE_RTT
+    return SEGGER_RTT_Write(TRACE_RTT_CHANNEL, record, words * sizeof(uint32_t)) != 0;
+#else
+    drv_uart_transmit(TRACE_UART, reinterpret_cast<const uint8_t *>(record), static_cast<uint16_t>(words * sizeof(uint32_t)));
+    return true;
+#endif
+}
+
+void Trace::Init(void) {
+#ifdef GLOB_USE_RTT
+    // Skip mode: a record that does not fit is lost whole, the host never sees half of one
+    SEGGER_RTT_ConfigUpBuffer(TRACE_RTT_CHANNEL, "Trace", rtt_buffer_, sizeof(rtt_buffer_), SEGGER_RTT_MODE_NO_BLOCK_SKIP);
+#endif
+}
+
+void Trace::Write(const char *fmt, const uint32_t *args, uint32_t count) {
+    const uint32_t size = count + 2U;
+    uint32_t start = reserve_;
+
+    do {
+        if (start + size - tail_ > TRACE_RING_WORDS) {
+            __atomic_fetch_add(&dropped_, 1U, __ATOMIC_RELAXED);
+            return;
+        }
+    } while (!__atomic_compare_exchange_n(&reserve_, &start, start + size, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+
+    ring_[(start + 1U) & TRACE_MASK] = TRACE_CYCLES();
+    for (uint32_t i = 0; i < count; i++) {
+        ring_[(start + 2U + i) & TRACE_MASK] = args[i];
+    }
+    __atomic_store_n(&ring_[start & TRACE_MASK], TRACE_HEADER(fmt, count), __ATOMIC_RELEASE);
+}
+
+void Trace::Flush(void) {
+    static const char dropped_fmt[] = "trace: %u records dropped";
+    static uint32_t reported = 0;
+    uint32_t record[TRACE_RECORD_MAX];
+
+    uint32_t tail = tail_;
+    for (;;) {
+        // 0 until the producer has finished the record
+        const uint32_t header = __atomic_load_n(&ring_[tail & TRACE_MASK], __ATOMIC_ACQUIRE);
+        if (header == 0) {
+            break;
+        }
+        const uint32_t size = ((header >> 24) & 0x0FU) + 2U;
+        for (uint32_t i = 0; i < size; i++) {
+            record[i] = ring_[(tail + i) & TRACE_MASK];
+            ring_[(tail + i) & TRACE_MASK] = 0;
+        }
+        tail += size;
+        __atomic_store_n(&tail_, tail, __ATOMIC_RELEASE);
+
+        if (!send_record(record, size)) {
+            __atomic_fetch_add(&dropped_, 1U, __ATOMIC_RELAXED);
+        }
+    }
+
+    // Sent directly: the ring may be full again, and this record must not be lost with the rest
+    const uint32_t dropped = dropped_;
+    if (dropped != reported) {
+        record[0] = TRACE_HEADER(dropped_fmt, 1U);
+        record[1] = TRACE_CYCLES();
+        record[2] = dropped - reported;
+        if (send_record(record, 3U)) {
+            reported = dropped;
+        }
+    }
+}
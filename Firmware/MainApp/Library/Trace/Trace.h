@@ -0,0 +1,80 @@
+#ifndef __TRACE_H__
+#define __TRACE_H__
+
+#include <stdint.h>
+#include <string.h>
+#include <type_traits>
+
+#define TRACE_RING_WORDS    (512U)          /// ring capacity, power of two
+#define TRACE_MAX_ARGS      (4U)
+#define TRACE_SYNC          (0xA0000000U)   /// top nibble of every record header
+#define TRACE_FMT_BASE      (0x08000000U)   /// format strings live in flash, the header keeps the offset
+#define TRACE_RTT_CHANNEL   (1U)            /// RTT up-buffer "Trace", channel 0 stays with hal_print_trace
+#define TRACE_RTT_SIZE      (1024U)
+
+#ifndef TRACE_UART
+#define TRACE_UART          USART1          /// sink without GLOB_USE_RTT, shared with Modbus: bench use only
+#endif
+
+/**
+ * @brief Trace point: format string stays in flash, only its address and the arguments are recorded
+ * Up to TRACE_MAX_ARGS integer, enum, pointer or float arguments, printf
+ * conversions without '*' widths. %s prints strings that are in flash.
+ * Tools/trace_decode.py formats the records with the ELF of the firmware.
+ */
+#define TRACE(fmt, ...)                                                         \
+    do {                                                                        \
+        static const char trace_fmt_[] = fmt;                                   \
+        Trace::Emit(trace_fmt_, ##__VA_ARGS__);                                 \
+    } while (0)
+
+/**
+ * @brief Binary event trace
+ * A record is TRACE_SYNC | argument count << 24 | format offset, the DWT
+ * cycle counter, then the arguments, as 32-bit words. Emit may be called
+ * from any task or interrupt: the space is reserved with a compare-and-swap
+ * on the write index, the header word is written last and marks the record
+ * complete. Flush, the only consumer, runs in the idle hook and copies
+ * complete records to RTT channel TRACE_RTT_CHANNEL (GLOB_USE_RTT) or to
+ * TRACE_UART. A full ring drops the record; Flush then sends the number
+ * dropped as a record of its own.
+ */
+class Trace {
+public:
+    static void Init(void);
+    static void Flush(void);
+
+    template <typename... Args>
+    static inline void Emit(const char *fmt, Args... args) {
+        static_assert(sizeof...(Args) <= TRACE_MAX_ARGS, "too many trace arguments");
+        const uint32_t words[sizeof...(Args) + 1] = {Word(args)..., 0};
+        Write(fmt, words, sizeof...(Args));
+    }
+
+private:
+    static void Write(const char *fmt, const uint32_t *args, uint32_t count);
+
+    static inline uint32_t Word(float value) {
+        uint32_t word;
+        memcpy(&word, &value, sizeof(word));
+        return word;
+    }
+    static inline uint32_t Word(double value) { return Word(static_cast<float>(value)); }
+
+    template <typename T>
+    static inline uint32_t Word(T value) {
+        static_assert(std::is_integral_v<T> || std::is_enum_v<T> || std::is_pointer_v<T>, "unsupported trace argument");
+        if constexpr (std::is_pointer_v<T>) {
+            return static_cast<uint32_t>(reinterpret_cast<uintptr_t>(value));
+        } else {
+            return static_cast<uint32_t>(value);
+        }
+    }
+
+    static uint32_t ring_[TRACE_RING_WORDS];
+    static volatile uint32_t reserve_;  /// next free word, producers
+    static volatile uint32_t tail_;     /// oldest unread word, Flush only
+    static volatile uint32_t dropped_;
+};
+
+#endif // __TRACE_H__
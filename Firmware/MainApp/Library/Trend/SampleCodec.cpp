@@ -0,0 +1,105 @@
+#include "SampleCodec.h"
+#include "string.h"
+
+static inline uint32_t ZigZag(int32_t value) {
+    return (static_cast<uint32_t>(value) << 1) ^ static_cast<uint32_t>(value >> 31);
+}
+
+static inline int32_t UnZigZag(uint32_t value) {
+    return static_cast<int32_t>(value >> 1) ^ -static_cast<int32_t>(value & 1U);
+}
+
+void SampleEncoder::Reset(uint8_t channels, SampleCodecOrder order) {
+    channels_ = channels > SAMPLE_CODEC_MAX_CHANNELS ? SAMPLE_CODEC_MAX_CHANNELS : channels;
+    order_ = order;
+    count_ = 0;
+    memset(previous_, 0, sizeof(previous_));
+    memset(delta_, 0, sizeof(delta_));
+}
+
+size_t SampleEncoder::Encode(const uint16_t *values, uint8_t *out, size_t size) {
+    uint8_t buffer[SampleCodecMaxSize(SAMPLE_CODEC_MAX_CHANNELS)];
+    uint16_t changed = 0;
+    size_t used = 2;
+
+    // Encode into a scratch buffer first, the state only moves once the sample fits
+    for (uint8_t ch = 0; ch < channels_; ch++) {
+        const int32_t delta = static_cast<int32_t>(values[ch]) - previous_[ch];
+        uint32_t residual = ZigZag(delta - delta_[ch]);
+        if (residual != 0) {
+            changed |= static_cast<uint16_t>(1U << ch);
+            while (residual >= 0x80U) {
+                buffer[used++] = static_cast<uint8_t>(residual | 0x80U);
+                residual >>= 7;
+            }
+            buffer[used++] = static_cast<uint8_t>(residual);
+        }
+    }
+    if (used > size) {
+        return 0;
+    }
+    buffer[0] = static_cast<uint8_t>(changed);
+    buffer[1] = static_cast<uint8_t>(changed >> 8);
+    memcpy(out, buffer, used);
+
+    for (uint8_t ch = 0; ch < channels_; ch++) {
+        // The first sample carries the value, the slope starts with the second one
+        if (order_ == SampleCodecOrder::DELTA_OF_DELTA && count_ != 0) {
+            delta_[ch] = static_cast<int32_t>(values[ch]) - previous_[ch];
+        }
+        previous_[ch] = values[ch];
+    }
+    count_++;
+    return used;
+}
+
+void SampleDecoder::Reset(uint8_t channels, SampleCodecOrder order) {
+    channels_ = channels > SAMPLE_CODEC_MAX_CHANNELS ? SAMPLE_CODEC_MAX_CHANNELS : channels;
+    order_ = order;
+    count_ = 0;
+    memset(previous_, 0, sizeof(previous_));
+    memset(delta_, 0, sizeof(delta_));
+}
+
+size_t SampleDecoder::Decode(const uint8_t *in, size_t size, uint16_t *values) {
+    int32_t next[SAMPLE_CODEC_MAX_CHANNELS];
+
+    if (size < 2) {
+        return 0;
+    }
+    const uint16_t changed = static_cast<uint16_t>(in[0] | (in[1] << 8));
+    if (changed >> channels_) {
+        return 0;
+    }
+
+    size_t used = 2;
+    for (uint8_t ch = 0; ch < channels_; ch++) {
+        uint32_t residual = 0;
+        if (changed & (1U << ch)) {
+            uint8_t shift = 0;
+            uint8_t byte;
+            do {
+                if (used == size || shift >= 7U * SAMPLE_CODEC_MAX_VARINT) {
+                    return 0;
+                }
+                byte = in[used++];
+                residual |= static_cast<uint32_t>(byte & 0x7FU) << shift;
+                shift += 7;
+            } while (byte & 0x80U);
+        }
+        next[ch] = previous_[ch] + delta_[ch] + UnZigZag(residual);
+        if (next[ch] < 0 || next[ch] > UINT16_MAX) {
+            return 0;
+        }
+    }
+
+    for (uint8_t ch = 0; ch < channels_; ch++) {
+        if (order_ == SampleCodecOrder::DELTA_OF_DELTA && count_ != 0) {
+            delta_[ch] = next[ch] - previous_[ch];
+        }
+        previous_[ch] = static_cast<uint16_t>(next[ch]);
+        values[ch] = previous_[ch];
+    }
+    count_++;
+    return used;
+}
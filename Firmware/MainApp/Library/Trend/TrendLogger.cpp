@@ -0,0 +1,409 @@
+#include "TrendLogger.h"
+#include "PBlockConfig.h"
+#include "StorageFlush.h"
+#include "P-Block-struct.h"
+#include "Crc32.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include "string.h"
+
+#define TREND_SAMPLE_MAX_SIZE       (SampleCodecMaxSize(TREND_CHANNELS))
+#define TREND_BLOCK_WORDS           (TREND_BLOCK_SIZE / 4U)
+#define TREND_CRC_OFFSET            (offsetof(TrendBlockHeader, crc))
+#define ERASED_WORD                 (0xFFFFFFFFU)
+
+static_assert(TREND_BLOCK_HEADER_SIZE == 20U, "block header layout changed");
+static_assert(sizeof(TrendInfo) == 20U, "info layout changed");
+static_assert(TREND_BLOCK_PAYLOAD_SIZE <= UINT8_MAX, "payload size must fit the header");
+static_assert(TREND_LOG_SIZE % FLASH_SECTOR_SIZE == 0, "log must be whole sectors");
+static_assert(TREND_CHANNELS <= SAMPLE_CODEC_MAX_CHANNELS, "too many channels for the codec");
+
+TrendLogger::Block TrendLogger::ram_[TREND_RAM_BLOCKS];
+uint32_t TrendLogger::ram_head_ = 0;
+uint32_t TrendLogger::ram_tail_ = 0;
+uint32_t TrendLogger::spill_end_ = 0;
+uint32_t TrendLogger::next_sequence_ = 0;
+uint32_t TrendLogger::first_sequence_ = 0;
+uint32_t TrendLogger::dropped_ = 0;
+
+uint16_t TrendLogger::period_ms_ = 0;
+uint32_t TrendLogger::next_sample_ms_ = 0;
+bool TrendLogger::block_open_ = false;
+volatile bool TrendLogger::close_request_ = false;
+uint16_t TrendLogger::last_[TREND_CHANNELS];
+SampleEncoder TrendLogger::encoder_;
+
+static inline uint32_t ReadWord(uint32_t address) {
+    return *reinterpret_cast<const volatile uint32_t *>(address);
+}
+
+static inline bool Before(uint32_t a, uint32_t b) {
+    return static_cast<int32_t>(a - b) < 0;
+}
+
+uint32_t TrendLogger::SlotAddress(uint32_t sequence) {
+    return TREND_LOG_ADDRESS + (sequence % TREND_BLOCK_SLOTS) * TREND_BLOCK_SIZE;
+}
+
+static bool SlotErased(uint32_t address) {
+    for (uint32_t i = 0; i < TREND_BLOCK_WORDS; i++) {
+        if (ReadWord(address + i * 4U) != ERASED_WORD) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool TrendLogger::Init(void) {
+    bool found = false;
+    uint32_t newest = 0;
+
+    StorageFlush::Register(Spill, HasPending);
+
+    // A block is valid when its sequence matches the slot it was written to
+    for (uint32_t slot = 0; slot < TREND_BLOCK_SLOTS; slot++) {
+        const uint32_t sequence = ReadWord(TREND_LOG_ADDRESS + slot * TREND_BLOCK_SIZE);
+        if (sequence != ERASED_WORD && sequence % TREND_BLOCK_SLOTS == slot && (!found || sequence > newest)) {
+            found = true;
+            newest = sequence;
+        }
+    }
+    next_sequence_ = found ? newest + 1U : 0U;
+
+    // Slots of blocks cut short by a reset cannot be programmed until their sector is erased
+    while (next_sequence_ % TREND_BLOCKS_PER_SECTOR != 0 && !SlotErased(SlotAddress(next_sequence_))) {
+        next_sequence_++;
+    }
+
+    // The sector holding the next slot was erased when its first slot was written
+    const uint32_t sector_start = next_sequence_ - next_sequence_ % TREND_BLOCKS_PER_SECTOR;
+    const uint32_t kept = (next_sequence_ == sector_start) ? TREND_BLOCK_SLOTS
+                                                           : TREND_BLOCK_SLOTS - TREND_BLOCKS_PER_SECTOR;
+    first_sequence_ = sector_start > kept ? sector_start - kept : 0U;
+
+    ram_head_ = ram_tail_ = spill_end_ = 0;
+    block_open_ = false;
+    memset(last_, 0, sizeof(last_));
+
+    period_ms_ = PBlockConfig::GetTrendPeriod();
+    if (period_ms_ != 0 && (period_ms_ < TREND_MIN_PERIOD_MS || period_ms_ > TREND_MAX_PERIOD_MS ||
+                            period_ms_ % TREND_MIN_PERIOD_MS != 0)) {
+        period_ms_ = DEFAULT_DEVICE_CONFIG_TREND_PERIOD_MS;
+    }
+    return true;
+}
+
+bool TrendLogger::SetPeriod(uint16_t period_ms) {
+    if (period_ms != 0 && (period_ms < TREND_MIN_PERIOD_MS || period_ms > TREND_MAX_PERIOD_MS ||
+                           period_ms % TREND_MIN_PERIOD_MS != 0)) {
+        return false;
+    }
+    if (period_ms != period_ms_) {
+        // A block has one period, the input task closes it before the next sample
+        close_request_ = true;
+        period_ms_ = period_ms;
+        PBlockConfig::SetTrendPeriod(period_ms);
+    }
+    return true;
+}
+
+void TrendLogger::CloseBlock(void) {
+    close_request_ = true;
+}
+
+/**
+ * @brief Start a block in the next RAM buffer, input task only
+ * @return false if every buffer is still waiting for flash
+ */
+bool TrendLogger::OpenBlock(uint32_t now_ms) {
+    bool ok = true;
+
+    taskENTER_CRITICAL();
+    if ((ram_head_ - ram_tail_) == TREND_RAM_BLOCKS) {
+        if (ram_tail_ != spill_end_) {
+            // Oldest block is being programmed, skip samples until it is done
+            ok = false;
+        } else {
+            ram_tail_++;
+            spill_end_ = ram_tail_;
+            dropped_++;
+        }
+    }
+    taskEXIT_CRITICAL();
+
+    if (!ok) {
+        return false;
+    }
+
+    // The buffer is not readable before block_open_ is set
+    TrendBlockHeader &header = ram_[ram_head_ % TREND_RAM_BLOCKS].header;
+    header.sequence = ERASED_WORD;
+    header.start_rtc = rtc_counter_get();
+    header.start_uptime_ms = now_ms;
+    header.period_ms = period_ms_;
+    header.samples = 0;
+    header.payload_size = 0;
+    header.crc = ERASED_WORD;
+    encoder_.Reset(TREND_CHANNELS);
+
+    taskENTER_CRITICAL();
+    block_open_ = true;
+    taskEXIT_CRITICAL();
+    next_sample_ms_ = now_ms;
+    return true;
+}
+
+/**
+ * @brief Queue the open block for flash, input task only
+ */
+void TrendLogger::Close(void) {
+    if (!block_open_) {
+        return;
+    }
+
+    Block &block = ram_[ram_head_ % TREND_RAM_BLOCKS];
+    if (block.header.samples == 0) {
+        taskENTER_CRITICAL();
+        block_open_ = false;
+        taskEXIT_CRITICAL();
+        return;
+    }
+
+    // Sequence and CRC fields are excluded, the sequence is only known when programmed
+    uint32_t crc = Crc32Update(CRC32_INIT, &block.header.start_rtc, TREND_CRC_OFFSET - sizeof(uint32_t));
+    crc = Crc32Update(crc, block.payload, block.header.payload_size);
+
+    taskENTER_CRITICAL();
+    block.header.crc = Crc32Final(crc);
+    block_open_ = false;
+    ram_head_++;
+    taskEXIT_CRITICAL();
+
+    StorageFlush::Request();
+}
+
+void TrendLogger::Sample(uint32_t now_ms) {
+    uint16_t values[TREND_CHANNELS];
+
+    if (close_request_) {
+        close_request_ = false;
+        Close();
+    }
+    if (period_ms_ == 0) {
+        return;
+    }
+
+    if (block_open_) {
+        if (Before(now_ms, next_sample_ms_)) {
+            return;
+        }
+        // Sample times are implied by the block start, a missed one starts a new block
+        if (now_ms - next_sample_ms_ >= period_ms_) {
+            Close();
+        }
+    }
+    if (!block_open_ && !OpenBlock(now_ms)) {
+        return;
+    }
+
+    for (uint8_t ch = 0; ch < TREND_CHANNELS; ch++) {
+        values[ch] = PBlockRegisters_t::GetUniversalInput(ch + 1U);
+    }
+
+    // Encoded in place past payload_size, readers see the sample once the size covers it
+    Block *block = &ram_[ram_head_ % TREND_RAM_BLOCKS];
+    size_t size = 0;
+    if (block->header.samples != UINT8_MAX) {
+        size = encoder_.Encode(values, &block->payload[block->header.payload_size],
+                               TREND_BLOCK_PAYLOAD_SIZE - block->header.payload_size);
+    }
+    if (size == 0) {
+        Close();
+        if (!OpenBlock(now_ms)) {
+            return;
+        }
+        block = &ram_[ram_head_ % TREND_RAM_BLOCKS];
+        size = encoder_.Encode(values, block->payload, TREND_BLOCK_PAYLOAD_SIZE);
+    }
+
+    taskENTER_CRITICAL();
+    block->header.payload_size = static_cast<uint8_t>(block->header.payload_size + size);
+    block->header.samples++;
+    memcpy(last_, values, sizeof(last_));
+    taskEXIT_CRITICAL();
+
+    next_sample_ms_ += period_ms_;
+
+    // Flush as soon as a worst-case sample no longer fits
+    if (TREND_BLOCK_PAYLOAD_SIZE - block->header.payload_size < TREND_SAMPLE_MAX_SIZE) {
+        Close();
+    }
+}
+
+void TrendLogger::GetInfo(TrendInfo &info) {
+    taskENTER_CRITICAL();
+    info.first_sequence = first_sequence_;
+    info.open_sequence = next_sequence_ + (ram_head_ - ram_tail_);
+    info.dropped_blocks = dropped_;
+    taskEXIT_CRITICAL();
+
+    info.block_size = TREND_BLOCK_SIZE;
+    info.block_slots = TREND_BLOCK_SLOTS;
+    info.period_ms = period_ms_;
+    info.channels = TREND_CHANNELS;
+    info.format_version = TREND_FORMAT_VERSION;
+}
+
+bool TrendLogger::ReadBlock(uint32_t sequence, uint16_t offset, void *data, uint16_t size) {
+    uint8_t *dst = static_cast<uint8_t *>(data);
+    bool in_flash = false;
+    bool found = true;
+
+    if (offset + size > TREND_BLOCK_SIZE) {
+        return false;
+    }
+
+    taskENTER_CRITICAL();
+    const uint32_t queued = ram_head_ - ram_tail_;
+    if (!Before(sequence, first_sequence_) && Before(sequence, next_sequence_)) {
+        in_flash = true;
+    } else if (!Before(sequence, next_sequence_) && sequence - next_sequence_ < queued + (block_open_ ? 1U : 0U)) {
+        // Queued and open blocks carry the sequence they will be programmed with
+        const Block &block = ram_[(ram_tail_ + (sequence - next_sequence_)) % TREND_RAM_BLOCKS];
+        memcpy(dst, reinterpret_cast<const uint8_t *>(&block) + offset, size);
+        for (uint16_t i = offset; i < sizeof(sequence) && i < offset + size; i++) {
+            dst[i - offset] = static_cast<uint8_t>(sequence >> (8U * i));
+        }
+    } else {
+        found = false;
+    }
+    taskEXIT_CRITICAL();
+
+    if (in_flash) {
+        memcpy(dst, reinterpret_cast<const void *>(SlotAddress(sequence) + offset), size);
+        found = IsStored(sequence);
+    }
+    return found;
+}
+
+const uint8_t *TrendLogger::StoredBlock(uint32_t sequence) {
+    taskENTER_CRITICAL();
+    const bool in_flash = !Before(sequence, first_sequence_) && Before(sequence, next_sequence_);
+    taskEXIT_CRITICAL();
+    return in_flash ? reinterpret_cast<const uint8_t *>(SlotAddress(sequence)) : nullptr;
+}
+
+bool TrendLogger::IsStored(uint32_t sequence) {
+    // Erasing moves first_sequence_ before the sector is touched, recheck after the copy
+    taskENTER_CRITICAL();
+    const bool found = !Before(sequence, first_sequence_);
+    taskEXIT_CRITICAL();
+    return found && ReadWord(SlotAddress(sequence)) == sequence;
+}
+
+uint32_t TrendLogger::SlotSequence(uint16_t slot) {
+    TrendInfo info;
+
+    GetInfo(info);
+    return info.open_sequence - (info.open_sequence + TREND_BLOCK_SLOTS - slot % TREND_BLOCK_SLOTS) %
+                                TREND_BLOCK_SLOTS;
+}
+
+uint32_t TrendLogger::FindBlock(uint32_t rtc_time) {
+    TrendInfo info;
+
+    GetInfo(info);
+
+    // Blocks are in time order unless the RTC was set back; unreadable blocks are skipped
+    uint32_t found = info.open_sequence;
+    uint32_t low = info.first_sequence;
+    uint32_t high = info.open_sequence + 1U;
+    while (low < high) {
+        const uint32_t middle = low + (high - low) / 2U;
+        uint32_t probe = middle;
+        uint32_t start_rtc = 0;
+        while (probe < high &&
+               !ReadBlock(probe, offsetof(TrendBlockHeader, start_rtc), &start_rtc, sizeof(start_rtc))) {
+            probe++;
+        }
+        if (probe == high || start_rtc >= rtc_time) {
+            if (probe != high) {
+                found = probe;
+            }
+            high = middle;
+        } else {
+            low = probe + 1U;
+        }
+    }
+    return found;
+}
+
+void TrendLogger::GetLastSample(uint16_t (&values)[TREND_CHANNELS]) {
+    taskENTER_CRITICAL();
+    memcpy(values, last_, sizeof(last_));
+    taskEXIT_CRITICAL();
+}
+
+bool TrendLogger::ProgramBlock(uint32_t sequence, const Block &block) {
+    const uint32_t address = SlotAddress(sequence);
+    const uint32_t *words = reinterpret_cast<const uint32_t *>(&block);
+
+    // Sequence last: a block cut short by a reset is not taken for a valid one
+    for (uint32_t i = 1; i < TREND_BLOCK_WORDS; i++) {
+        if (flash_word_program(address + i * 4U, words[i]) != FLASH_OPERATE_DONE) {
+            return false;
+        }
+    }
+    return flash_word_program(address, sequence) == FLASH_OPERATE_DONE;
+}
+
+bool TrendLogger::Spill(void) {
+    bool ok = true;
+
+    if (!HasPending()) {
+        return true;
+    }
+
+    flash_unlock();
+    while (ok) {
+        const Block *block = nullptr;
+        uint32_t sequence;
+
+        taskENTER_CRITICAL();
+        if (ram_head_ != ram_tail_) {
+            block = &ram_[ram_tail_ % TREND_RAM_BLOCKS];
+            spill_end_ = ram_tail_ + 1U;
+        }
+        sequence = next_sequence_;
+        taskEXIT_CRITICAL();
+
+        if (block == nullptr) {
+            break;
+        }
+
+        if (sequence % TREND_BLOCKS_PER_SECTOR == 0) {
+            // Hide the oldest blocks before their sector is erased
+            taskENTER_CRITICAL();
+            if (sequence + TREND_BLOCKS_PER_SECTOR > TREND_BLOCK_SLOTS &&
+                Before(first_sequence_, sequence + TREND_BLOCKS_PER_SECTOR - TREND_BLOCK_SLOTS)) {
+                first_sequence_ = sequence + TREND_BLOCKS_PER_SECTOR - TREND_BLOCK_SLOTS;
+            }
+            taskEXIT_CRITICAL();
+            ok = flash_sector_erase(SlotAddress(sequence)) == FLASH_OPERATE_DONE;
+        }
+        ok = ok && ProgramBlock(sequence, *block);
+
+        // The slot is used even if programming failed, the block is retried in the next one.
+        // On success the block moves from RAM to flash in one step.
+        taskENTER_CRITICAL();
+        next_sequence_++;
+        if (ok) {
+            ram_tail_++;
+        }
+        spill_end_ = ram_tail_;
+        taskEXIT_CRITICAL();
+    }
+    flash_lock();
+
+    return ok;
+}
@@ -0,0 +1,188 @@
+#ifndef __TREND_LOGGER_H__
+#define __TREND_LOGGER_H__
+
+#include <stdint.h>
+#include <stddef.h>
+#include "at32f403a_407.h"
+#include "flash_map.h"
+#include "SampleCodec.h"
+
+#define TREND_CHANNELS              (11U)       /// universal inputs 1-11, analog value in mV
+#define TREND_BLOCK_SIZE            (256U)
+#define TREND_BLOCK_SLOTS           (TREND_LOG_SIZE / TREND_BLOCK_SIZE)
+#define TREND_BLOCKS_PER_SECTOR     (FLASH_SECTOR_SIZE / TREND_BLOCK_SIZE)
+#define TREND_RAM_BLOCKS            (3U)        /// open block + blocks waiting for flash
+#define TREND_MIN_PERIOD_MS         (100U)      /// input update period
+#define TREND_MAX_PERIOD_MS         (60000U)
+#define TREND_FORMAT_VERSION        (1U)        /// SampleCodec, SampleCodecOrder::DELTA
+
+/**
+ * @brief Block header, followed by the encoded samples
+ * Sample n of a block was taken at start + n * period_ms (nominal, the
+ * input task runs every TREND_MIN_PERIOD_MS).
+ */
+#pragma pack(push, 1)
+struct TrendBlockHeader {
+    uint32_t sequence;          /// block number, programmed last; 0xFFFFFFFF = empty slot
+    uint32_t start_rtc;         /// RTC counter at the first sample, s
+    uint32_t start_uptime_ms;   /// uptime at the first sample
+    uint16_t period_ms;
+    uint8_t samples;
+    uint8_t payload_size;
+    uint32_t crc;               /// CRC-32 from start_rtc to the end of the payload, crc field excluded
+};
+
+/**
+ * @brief Download state, returned by GetTrendInfo_cmd and Modbus file TREND_INFO_FILE
+ */
+struct TrendInfo {
+    uint32_t first_sequence;    /// oldest block still stored
+    uint32_t open_sequence;     /// block being filled, blocks first..open are readable
+    uint16_t block_size;
+    uint16_t block_slots;
+    uint16_t period_ms;         /// 0 = logging stopped
+    uint8_t channels;
+    uint8_t format_version;
+    uint32_t dropped_blocks;    /// blocks lost because flash writes fell behind
+};
+#pragma pack(pop)
+
+#define TREND_BLOCK_HEADER_SIZE     (sizeof(TrendBlockHeader))
+#define TREND_BLOCK_PAYLOAD_SIZE    (TREND_BLOCK_SIZE - TREND_BLOCK_HEADER_SIZE)
+#define TREND_INFO_FILE             (0xFFFFU)   /// Modbus file number of TrendInfo, file n (1-1024) is slot n-1
+
+/**
+ * @brief Compressed trend log of the universal inputs in a flash ring
+ * Every period the 11 analog input values are appended to the open RAM
+ * block as one SampleCodec sample (changed-channel mask and zigzag varint
+ * deltas). The codec restarts with every block, so each block decodes on
+ * its own. Steady inputs cost 2 bytes per sample.
+ *
+ * Full blocks are queued in RAM and programmed into TREND_LOG sectors by the
+ * storage task (StorageFlush, which serialises flash access).
+ * Block n lives in slot n % TREND_BLOCK_SLOTS; starting a sector erases the
+ * oldest TREND_BLOCKS_PER_SECTOR blocks. The sequence word is programmed
+ * last, so a block cut short by a reset stays an empty slot. The log is in
+ * flash bank 2, programming it does not stall code fetch from bank 1.
+ *
+ * Readers address blocks by sequence: flash blocks, queued blocks and the
+ * open block (with its current contents, crc still 0xFFFFFFFF) are all
+ * readable. Sequences of queued blocks are provisional until programmed.
+ */
+class TrendLogger {
+public:
+    /**
+     * @brief Find the newest stored block and load the period from config
+     * PBlockConfig::Init() must be called first.
+     */
+    static bool Init(void);
+
+    /**
+     * @brief Take a sample when one is due, called by the input task
+     * @param now_ms Current time in ms
+     */
+    static void Sample(uint32_t now_ms);
+
+    /**
+     * @brief Set and save the sampling period
+     * @param period_ms Multiple of TREND_MIN_PERIOD_MS up to TREND_MAX_PERIOD_MS, 0 stops logging
+     * @return false if the period is out of range
+     */
+    static bool SetPeriod(uint16_t period_ms);
+
+    /**
+     * @brief Get the sampling period, 0 = stopped
+     */
+    static uint16_t GetPeriod(void) { return period_ms_; }
+
+    /**
+     * @brief Close the open block so it is written to flash with the next flush
+     * Takes effect at the next input update.
+     */
+    static void CloseBlock(void);
+
+    /**
+     * @brief Get download state
+     */
+    static void GetInfo(TrendInfo &info);
+
+    /**
+     * @brief Copy part of a block
+     * @param sequence Block number (first_sequence..open_sequence)
+     * @param offset Byte offset in the block
+     * @param data Destination
+     * @param size Bytes to copy, offset + size <= TREND_BLOCK_SIZE
+     * @return false if the block is no longer (or not yet) stored
+     */
+    static bool ReadBlock(uint32_t sequence, uint16_t offset, void *data, uint16_t size);
+
+    /**
+     * @brief Get a block in flash for reading it in place
+     * The sector may be erased while the caller reads; confirm the data
+     * with IsStored() afterwards.
+     * @return Block address, nullptr for queued, open or missing blocks
+     */
+    static const uint8_t *StoredBlock(uint32_t sequence);
+
+    /**
+     * @brief Check that a block read through StoredBlock() is still in flash
+     */
+    static bool IsStored(uint32_t sequence);
+
+    /**
+     * @brief Get the newest sequence stored in a slot (Modbus file access)
+     */
+    static uint32_t SlotSequence(uint16_t slot);
+
+    /**
+     * @brief Find the first block starting at or after an RTC time
+     * @return Block number, open_sequence if there is none
+     */
+    static uint32_t FindBlock(uint32_t rtc_time);
+
+    /**
+     * @brief Get the last sample
+     * @param values Destination, TREND_CHANNELS values in mV
+     */
+    static void GetLastSample(uint16_t (&values)[TREND_CHANNELS]);
+
+    /**
+     * @brief Check whether blocks are waiting for flash
+     */
+    static bool HasPending(void) { return ram_head_ != ram_tail_; }
+
+    /**
+     * @brief Program the queued blocks into flash
+     * Caller holds StorageFlush::Lock().
+     * @return true if nothing is left queued
+     */
+    static bool Spill(void);
+
+private:
+    struct Block {
+        TrendBlockHeader header;
+        uint8_t payload[TREND_BLOCK_PAYLOAD_SIZE];
+    };
+
+    static uint32_t SlotAddress(uint32_t sequence);
+    static bool OpenBlock(uint32_t now_ms);
+    static void Close(void);
+    static bool ProgramBlock(uint32_t sequence, const Block &block);
+
+    static Block ram_[TREND_RAM_BLOCKS];
+    static uint32_t ram_head_;          /// open block, free running
+    static uint32_t ram_tail_;          /// oldest closed block not in flash
+    static uint32_t spill_end_;         /// closed blocks before this one are being programmed
+    static uint32_t next_sequence_;     /// number of the next block programmed to flash
+    static uint32_t first_sequence_;
+    static uint32_t dropped_;
+
+    static uint16_t period_ms_;
+    static uint32_t next_sample_ms_;
+    static bool block_open_;
+    static volatile bool close_request_;    /// set by other tasks, handled by Sample()
+    static uint16_t last_[TREND_CHANNELS];
+    static SampleEncoder encoder_;      /// state of the open block
+};
+
+#endif // __TREND_LOGGER_H__
@@ -0,0 +1,49 @@
+#include "TrendStream.h"
+#include <string.h>
+
+uint32_t TrendStream::next_;
+uint16_t TrendStream::left_;
+uint8_t TrendStream::copy_[2][TREND_BLOCK_SIZE];
+uint8_t TrendStream::copy_index_;
+
+bool TrendStream::Start(uint32_t first, uint16_t count, TrendStreamRange &range) {
+    TrendInfo info;
+    TrendLogger::GetInfo(info);
+
+    if (static_cast<int32_t>(first - info.first_sequence) < 0) {
+        first = info.first_sequence;
+    }
+    const int32_t available = static_cast<int32_t>(info.open_sequence - first) + 1;
+    if (available <= 0) {
+        count = 0;
+    } else if (count > static_cast<uint32_t>(available)) {
+        count = static_cast<uint16_t>(available);
+    }
+
+    next_ = first;
+    left_ = count;
+    range.first_sequence = first;
+    range.count = count;
+    return count != 0;
+}
+
+bool TrendStream::Next(const uint8_t *&data, uint16_t &size) {
+    if (left_ == 0) {
+        return false;
+    }
+    const uint32_t sequence = next_++;
+    left_--;
+
+    size = TREND_BLOCK_SIZE;
+    data = TrendLogger::StoredBlock(sequence);
+    if (data == nullptr) {
+        // The other buffer may still hold the piece being sent
+        uint8_t *copy = copy_[copy_index_];
+        copy_index_ ^= 1U;
+        if (!TrendLogger::ReadBlock(sequence, 0, copy, TREND_BLOCK_SIZE)) {
+            memset(copy, 0xFF, TREND_BLOCK_SIZE);
+        }
+        data = copy;
+    }
+    return true;
+}
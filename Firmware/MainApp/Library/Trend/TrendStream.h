@@ -0,0 +1,58 @@
+#ifndef __TREND_STREAM_H__
+#define __TREND_STREAM_H__
+
+#include <stdint.h>
+#include "TrendLogger.h"
+
+#pragma pack(push, 1)
+/** @brief Blocks a stream sends, the answer of StreamTrend_cmd */
+struct TrendStreamRange {
+    uint32_t first_sequence;    /// first block sent
+    uint16_t count;             /// blocks sent, TREND_BLOCK_SIZE bytes each
+};
+#pragma pack(pop)
+
+/**
+ * @brief Trend download as one back-to-back transfer
+ * StreamTrend_cmd answers with the range, then the transport task sends
+ * the blocks raw, one Next() piece per Send(), without a request per
+ * chunk. Blocks in flash are sent from their flash address, queued and
+ * open blocks from a RAM copy; a block erased before it is sent goes out
+ * as an erased slot (0xFF). The host checks each block by its sequence
+ * word and header CRC.
+ *
+ * RAM copies alternate between two buffers: a piece stays intact until
+ * the second Next() after it, so a transport whose Send() returns before
+ * the endpoint has read the data can prepare the next block meanwhile.
+ *
+ * There is a single stream, owned by the task that runs the command
+ * handlers; a new Start() replaces it.
+ */
+class TrendStream {
+public:
+    /**
+     * @brief Start a stream
+     * @param first First block wanted, moved up to the oldest stored block
+     * @param count Blocks wanted, cut at the open block
+     * @param range Blocks that will be sent
+     * @return false if no block is left to send
+     */
+    static bool Start(uint32_t first, uint16_t count, TrendStreamRange &range);
+
+    /**
+     * @brief Get the next piece to send
+     * The piece is valid until the second call after this one.
+     * @return false when the stream is done
+     */
+    static bool Next(const uint8_t *&data, uint16_t &size);
+
+    static void Cancel(void) { left_ = 0; }
+
+private:
+    static uint32_t next_;
+    static uint16_t left_;
+    static uint8_t copy_[2][TREND_BLOCK_SIZE];
+    static uint8_t copy_index_;
+};
+
+#endif // __TREND_STREAM_H__
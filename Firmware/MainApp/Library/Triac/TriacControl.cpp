@@ -0,0 +1,205 @@
+#include "TriacControl.h"
+
+#define TRIAC_GATE_PULSE_TICKS      (TRIAC_GATE_PULSE_US * MAINS_TICKS_PER_US)
+#define TRIAC_MIN_DELAY_TICKS       (TRIAC_MIN_DELAY_US * MAINS_TICKS_PER_US)
+#define TRIAC_END_GUARD_TICKS       (TRIAC_END_GUARD_US * MAINS_TICKS_PER_US)
+#define TRIAC_FULL_SCALE_Q16        (0x10000U)
+
+/* ==== Compile-time firing angle table ==== */
+namespace {
+
+constexpr double kPi = 3.14159265358979323846;
+
+constexpr double ConstSin(double x) {
+    while (x > kPi) x -= 2.0 * kPi;
+    while (x < -kPi) x += 2.0 * kPi;
+    double term = x;
+    double sum = x;
+    for (int n = 1; n < 12; n++) {
+        term *= -x * x / ((2.0 * n) * (2.0 * n + 1.0));
+        sum += term;
+    }
+    return sum;
+}
+
+// Fraction of full power delivered when firing at angle a (0..pi) in each half-cycle
+constexpr double PhaseCutPower(double a) {
+    return 1.0 - a / kPi + ConstSin(2.0 * a) / (2.0 * kPi);
+}
+
+// Inverse of PhaseCutPower by bisection, returned as fraction of the half-cycle
+constexpr double FiringAngleFraction(double power) {
+    double lo = 0.0;
+    double hi = kPi;
+    for (int i = 0; i < 48; i++) {
+        double mid = (lo + hi) / 2.0;
+        if (PhaseCutPower(mid) > power) {
+            lo = mid;
+        } else {
+            hi = mid;
+        }
+    }
+    return (lo + hi) / 2.0 / kPi;
+}
+
+constexpr uint32_t FIRING_TABLE_SHIFT = 8;      // 256 segments over 0..65536, worst 0.15 % of full power near 0 %
+constexpr uint32_t FIRING_TABLE_STEPS = TRIAC_FULL_SCALE_Q16 >> FIRING_TABLE_SHIFT;
+
+struct FiringTable {
+    uint32_t fraction_q16[FIRING_TABLE_STEPS + 1];
+};
+
+constexpr FiringTable MakeFiringTable(void) {
+    FiringTable table{};
+    for (uint32_t i = 0; i <= FIRING_TABLE_STEPS; i++) {
+        double fraction = FiringAngleFraction(static_cast<double>(i) / FIRING_TABLE_STEPS);
+        table.fraction_q16[i] = static_cast<uint32_t>(fraction * TRIAC_FULL_SCALE_Q16 + 0.5);
+    }
+    return table;
+}
+
+constexpr FiringTable firing_table = MakeFiringTable();
+
+static_assert(firing_table.fraction_q16[0] == TRIAC_FULL_SCALE_Q16, "0 % power must never fire");
+static_assert(firing_table.fraction_q16[FIRING_TABLE_STEPS] == 0, "100 % power must fire at zero cross");
+static_assert(firing_table.fraction_q16[FIRING_TABLE_STEPS / 2] == TRIAC_FULL_SCALE_Q16 / 2,
+              "50 % power is delivered at 90 degrees");
+
+}  // namespace
+
+TriacControl::Channel_t TriacControl::channels_[TRIAC_CHANNELS] = {
+    {TMR_SELECT_CHANNEL_3, TMR_C3_INT, 0, GateState::IDLE, 0, 0, 0},
+    {TMR_SELECT_CHANNEL_4, TMR_C4_INT, 0, GateState::IDLE, 0, 0, 0},
+};
+
+bool TriacControl::Init(void) {
+    gpio_init_type gpio_init_struct;
+    tmr_output_config_type output_config;
+
+    crm_periph_clock_enable(TRIAC_GATE_PORT_CLOCK, TRUE);
+
+    gpio_default_para_init(&gpio_init_struct);
+    gpio_init_struct.gpio_drive_strength = GPIO_DRIVE_STRENGTH_STRONGER;
+    gpio_init_struct.gpio_out_type = GPIO_OUTPUT_PUSH_PULL;
+    gpio_init_struct.gpio_mode = GPIO_MODE_MUX;
+    gpio_init_struct.gpio_pins = TRIAC1_GATE_PIN | TRIAC2_GATE_PIN;
+    gpio_init_struct.gpio_pull = GPIO_PULL_DOWN;
+    gpio_init(TRIAC_GATE_PORT, &gpio_init_struct);
+
+    // Gates are driven by compare hardware only, parked low until a sequence is armed
+    tmr_output_default_para_init(&output_config);
+    output_config.oc_mode = TMR_OUTPUT_CONTROL_FORCE_LOW;
+    output_config.oc_polarity = TMR_OUTPUT_ACTIVE_HIGH;
+    output_config.oc_output_state = TRUE;
+    for (uint8_t i = 0; i < TRIAC_CHANNELS; i++) {
+        tmr_output_channel_config(MAINS_TMR, channels_[i].tmr_channel, &output_config);
+        MainsSync::SetChannelHandler(channels_[i].tmr_channel, OnCompare);
+    }
+
+    MainsSync::SetZeroCrossHandler(OnZeroCross);
+    return true;
+}
+
+bool TriacControl::SetOnTime(uint8_t channel, uint16_t on_time_us) {
+    if (channel < 1 || channel > TRIAC_CHANNELS) {
+        return false;
+    }
+    // Takes effect at the next zero crossing
+    channels_[channel - 1].on_time_us = on_time_us;
+    return true;
+}
+
+uint16_t TriacControl::GetOnTime(uint8_t channel) {
+    if (channel < 1 || channel > TRIAC_CHANNELS) {
+        return 0;
+    }
+    return channels_[channel - 1].on_time_us;
+}
+
+uint32_t TriacControl::FiringFraction(uint32_t power_q16) {
+    if (power_q16 >= TRIAC_FULL_SCALE_Q16) {
+        return 0;
+    }
+    uint32_t index = power_q16 >> FIRING_TABLE_SHIFT;
+    uint32_t frac = power_q16 & ((1U << FIRING_TABLE_SHIFT) - 1);
+    uint32_t a = firing_table.fraction_q16[index];
+    uint32_t b = firing_table.fraction_q16[index + 1];
+
+    // Table is monotonically decreasing
+    return a - (((a - b) * frac) >> FIRING_TABLE_SHIFT);
+}
+
+void TriacControl::Arm(Channel_t& ch, uint32_t at, tmr_output_control_mode_type mode) {
+    tmr_channel_value_set(MAINS_TMR, ch.tmr_channel, at);
+    tmr_output_channel_mode_select(MAINS_TMR, ch.tmr_channel, mode);
+    tmr_interrupt_enable(MAINS_TMR, ch.int_flag, TRUE);
+}
+
+void TriacControl::OnZeroCross(uint32_t capture, uint32_t period_ticks) {
+    uint32_t half = period_ticks / 2U;
+
+    for (uint8_t i = 0; i < TRIAC_CHANNELS; i++) {
+        Channel_t& ch = channels_[i];
+
+        // A sequence still running here means the period shrank: start over cleanly
+        if (ch.state != GateState::IDLE) {
+            tmr_interrupt_enable(MAINS_TMR, ch.int_flag, FALSE);
+            tmr_output_channel_mode_select(MAINS_TMR, ch.tmr_channel, TMR_OUTPUT_CONTROL_FORCE_LOW);
+            ch.state = GateState::IDLE;
+        }
+
+        uint32_t on_ticks = static_cast<uint32_t>(ch.on_time_us) * MAINS_TICKS_PER_US;
+        if (on_ticks == 0) {
+            continue;
+        }
+
+        uint32_t power_q16 = TRIAC_FULL_SCALE_Q16;
+        if (on_ticks < half) {
+            power_q16 = static_cast<uint32_t>((static_cast<uint64_t>(on_ticks) << 16) / half);
+        }
+
+        uint32_t delay = static_cast<uint32_t>((static_cast<uint64_t>(half) * FiringFraction(power_q16)) >> 16);
+        if (delay < TRIAC_MIN_DELAY_TICKS) {
+            delay = TRIAC_MIN_DELAY_TICKS;
+        }
+        // Too late in the half-cycle to latch and commutate safely
+        if (delay + TRIAC_GATE_PULSE_TICKS + TRIAC_END_GUARD_TICKS > half) {
+            continue;
+        }
+
+        ch.zero_cross = capture;
+        ch.half_ticks = half;
+        ch.delay_ticks = delay;
+        ch.state = GateState::FIRE_FIRST;
+        Arm(ch, capture + delay, TMR_OUTPUT_CONTROL_HIGH);
+    }
+}
+
+void TriacControl::OnCompare(tmr_channel_select_type channel) {
+    Channel_t& ch = (channel == TMR_SELECT_CHANNEL_3) ? channels_[0] : channels_[1];
+    uint32_t fire_second = ch.zero_cross + ch.half_ticks + ch.delay_ticks;
+
+    // Output level changed in hardware at the compare match, only the next edge is set up here
+    switch (ch.state) {
+        case GateState::FIRE_FIRST:
+            Arm(ch, ch.zero_cross + ch.delay_ticks + TRIAC_GATE_PULSE_TICKS, TMR_OUTPUT_CONTROL_LOW);
+            ch.state = GateState::END_FIRST;
+            break;
+
+        case GateState::END_FIRST:
+            Arm(ch, fire_second, TMR_OUTPUT_CONTROL_HIGH);
+            ch.state = GateState::FIRE_SECOND;
+            break;
+
+        case GateState::FIRE_SECOND:
+            Arm(ch, fire_second + TRIAC_GATE_PULSE_TICKS, TMR_OUTPUT_CONTROL_LOW);
+            ch.state = GateState::END_SECOND;
+            break;
+
+        case GateState::END_SECOND:
+        default:
+            tmr_interrupt_enable(MAINS_TMR, ch.int_flag, FALSE);
+            ch.state = GateState::IDLE;
+            break;
+    }
+}
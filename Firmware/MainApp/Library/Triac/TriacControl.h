@@ -0,0 +1,89 @@
+#ifndef __TRIAC_CONTROL_H__
+#define __TRIAC_CONTROL_H__
+
+#include <stdint.h>
+#include "MainsSync.h"
+
+#define TRIAC_CHANNELS              (2U)
+#define TRIAC_MAX_ON_TIME_US        (10000U)    /// SKOV 0x2302: full half-cycle at 50 Hz
+#define TRIAC_GATE_PULSE_US         (100U)      /// gate pulse width
+#define TRIAC_MIN_DELAY_US          (200U)      /// earliest firing after zero cross (latching current)
+#define TRIAC_END_GUARD_US          (300U)      /// pulse must end this long before the next zero cross
+#define TRIAC_GATE_PORT             GPIOA
+#define TRIAC_GATE_PORT_CLOCK       CRM_GPIOA_PERIPH_CLOCK
+#define TRIAC1_GATE_PIN             GPIO_PINS_2 /// TMR5_CH3
+#define TRIAC2_GATE_PIN             GPIO_PINS_3 /// TMR5_CH4
+
+/**
+ * @brief Phase-cut control of the two TRIAC outputs (0x2302)
+ * The setpoint is the SKOV "ON time" in us per half-cycle, which the master
+ * treats as linear power: ON time / half period = delivered power fraction.
+ * A compile-time table inverts the phase-cut power curve
+ *     P(a) = 1 - a/pi + sin(2a) / (2pi)
+ * so the firing angle delivers the requested power, not the requested time.
+ *
+ * Gate edges are produced by TMR5 compare hardware relative to the captured
+ * zero crossing; the ISR only re-arms the next edge, so firing jitter does
+ * not depend on interrupt latency or task scheduling. Without mains
+ * (no zero crossings) nothing is scheduled and the gates stay low.
+ */
+class TriacControl {
+public:
+    /**
+     * @brief Configure gate pins and attach to the MainsSync timebase
+     * MainsSync::Init() must be called first.
+     * @return true on success
+     */
+    static bool Init(void);
+
+    /**
+     * @brief Set ON time setpoint
+     * @param channel TRIAC channel (1-2)
+     * @param on_time_us ON time per half-cycle in us (0 = off, >= half period = full power)
+     * @return false on invalid channel
+     */
+    static bool SetOnTime(uint8_t channel, uint16_t on_time_us);
+
+    /**
+     * @brief Get ON time setpoint
+     * @param channel TRIAC channel (1-2)
+     */
+    static uint16_t GetOnTime(uint8_t channel);
+
+    /**
+     * @brief Firing angle for a power fraction
+     * @param power_q16 Power fraction, 0..65536 = 0..100 %
+     * @return Firing delay as fraction of the half period, 0..65536
+     */
+    static uint32_t FiringFraction(uint32_t power_q16);
+
+private:
+    /**
+     * @brief Gate sequence state of one channel within a mains period
+     */
+    enum class GateState : uint8_t {
+        IDLE,
+        FIRE_FIRST,     /// waiting for first half-cycle firing edge
+        END_FIRST,      /// waiting for end of first gate pulse
+        FIRE_SECOND,
+        END_SECOND,
+    };
+
+    struct Channel_t {
+        tmr_channel_select_type tmr_channel;
+        uint32_t int_flag;
+        volatile uint16_t on_time_us;
+        GateState state;
+        uint32_t zero_cross;        /// capture the current sequence refers to
+        uint32_t half_ticks;
+        uint32_t delay_ticks;
+    };
+
+    static void OnZeroCross(uint32_t capture, uint32_t period_ticks);
+    static void OnCompare(tmr_channel_select_type channel);
+    static void Arm(Channel_t& ch, uint32_t at, tmr_output_control_mode_type mode);
+
+    static Channel_t channels_[TRIAC_CHANNELS];
+};
+
+#endif // __TRIAC_CONTROL_H__
@@ -1,4 +1,6 @@
 #include "UartApp.h"
+#include "TrendStream.h"
+#include "DeadlineMonitor.h"
 
 /*void uartFun(void *parameters) {
   UartService uartService = UartService();
@@ -9,9 +11,6 @@
         uartService.HandleCurrentRxBuff();
         uartService.Send(CmdHandler.GetRespBuff(), CmdHandler.GetRespCnt());
       }
-#if USE_WDT
-    simple_wdt_reload();
-#endif
   }
 }*/
 
@@ -20,15 +19,21 @@ void uartFun(void *parameters) {
   // Initialize USART1 here
   UartService uartService = UartService();
   for (;;) {
-    if (uartService.Read() > 0)
+    // UartService frames and checks the packets: answer each complete one, send nothing otherwise
+    if (uartService.Read() > 0) {
       while (uartService.TryGetCommand()) {
         uartService.HandleCurrentRxBuff();
-        vTaskDelay(5);
+        uartService.Send(CmdHandler.GetRespBuff(), CmdHandler.GetRespCnt());
+        vTaskDelay(pdMS_TO_TICKS(UART_TX_DRAIN_MS));
+        CmdHandler.DoPostCommand();
       }
-    uartService.Send(CmdHandler.GetRespBuff(), CmdHandler.GetRespCnt());
-    CmdHandler.SetResponce(UNKNOWN_CS, NULL, 0);
-    
+    }
+    const uint8_t *data;
+    uint16_t size;
+    while (TrendStream::Next(data, size)) {
+      uartService.Send(data, size);
+    }
+    DeadlineMonitor::Report(DEADLINE_UART);
+    vTaskDelay(pdMS_TO_TICKS(UART_POLL_MS)); // the idle task runs (and sleeps) between polls
   }
-  wdt_notify_to_subject({.uart = true});
-  vTaskDelay(20); // Delay to prevent spamming the transmission
 }
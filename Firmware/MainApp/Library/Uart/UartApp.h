@@ -23,6 +23,9 @@ extern "C"
 
 #include "at32f403a_407_usart.h"
 
+#define UART_POLL_MS        (5U)    /// receive poll period, bounds the command latency
+#define UART_TX_DRAIN_MS    (5U)    /// response on the wire before a post-command (reset, jump) runs
+
 void uartFun(void *parameters);
 
 #endif /* _UART_APP_H_ */
\ No newline at end of file
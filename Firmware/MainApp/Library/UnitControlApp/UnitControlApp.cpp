@@ -1,11 +1,12 @@
 #include "UnitControlApp.h"
+#include "DeadlineMonitor.h"
 
 void unitControlFun(void* parameters) {
 
 
     for (;;) {
         unit_control_wave();
-        wdt_notify_to_subject({.unit_control = true});
+        DeadlineMonitor::Report(DEADLINE_UNIT_CONTROL);
         vTaskDelay(500);
     }
 }
@@ -1,4 +1,6 @@
 #include "usbApp.h"
+#include "TrendStream.h"
+#include "DeadlineMonitor.h"
 
 
 // UsbService usbService = UsbService();
@@ -9,21 +11,38 @@ void usbFun(void *parameters)
     usbService.Init();
     while (true)
     {
+        bool handled = false;
         if (usbService.IsConnect())
         {
             uint16_t new_data_len = usbService.Read();
             if (new_data_len)
             {
-                if (usbService.TryGetCommand())
+                while (usbService.TryGetCommand())
                 {
                     usbService.HandleCurrentRxBuff();
                     usbService.Send(CmdHandler.GetRespBuff(), CmdHandler.GetRespCnt());
-                    vTaskDelay(10);
+                    // No MainApp handler sets a post-command (Reset_cmd resets in place), nothing to wait for
                     CmdHandler.DoPostCommand();
+                    handled = true;
                 }
             }
+
+            // A stream started by the command goes out back to back, one block per Send
+            const uint8_t *data;
+            uint16_t size;
+            while (usbService.IsConnect() && TrendStream::Next(data, size))
+            {
+                usbService.Send(data, size);
+            }
+        }
+        else
+        {
+            TrendStream::Cancel();
+        }
+        DeadlineMonitor::Report(DEADLINE_USB);
+        if (!handled)
+        {
+            vTaskDelay(5); // poll again at once while the host keeps sending commands
         }
-        wdt_notify_to_subject({.usb = true});
-        vTaskDelay(5);
     }
 }
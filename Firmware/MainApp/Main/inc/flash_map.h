@@ -40,6 +40,12 @@
 #define BOOTLOADER_UPDATE_SIZE 0x8000U  // 32 KB
 #define BOOTLOADER_UPDATE_SECTOR 173U
 
+/// Configuration journal (log-structured key/value store, rotating sectors)
+#define CONFIG_JOURNAL_ADDRESS (0x08000000U + (241 * 2048U))
+#define CONFIG_JOURNAL_SIZE 0x1000U  // 4 KB
+#define CONFIG_JOURNAL_SECTOR 241U
+#define CONFIG_JOURNAL_SECTORS 2U
+
 /// Block error journal
 #define ERROR_JOURNAL_ADDRESS 0x08000000U + (243 * 2048U)
 #define ERROR_JOURNAL_SIZE 0x2800U  // 10 KB
@@ -70,6 +76,12 @@
 #define RESERVE_APPLICATION_SIZE 0x40000U  // 256 KB
 #define RESERVE_APPLICATION_SECTOR 256U
 
+/// Trend log (universal input history, ring of 256-byte blocks).
+/// Bank 2: programming it does not stall code fetch from bank 1.
+#define TREND_LOG_ADDRESS 0x080C0000U
+#define TREND_LOG_SIZE 0x40000U  // 256 KB
+#define TREND_LOG_SECTOR 384U
+
 /* ============================================================================
  * Flash Sector Information
  * ========================================================================== */
@@ -91,10 +103,13 @@
  * 0x08001000 - 0x08008FFF (32 KB)  : Bootloader0
  * 0x08009000 - 0x08048FFF (256 KB) : Main Application
  * ...
+ * 0x8078800  - 0x80797FF (4 KB)    : Config Journal
+ * 0x8079800  - 0x807BFFF (10 KB)   : Error Journal
  * 0x807E800  - 0x807EFFF (2 KB)    : App Config
  * 0x807F000  - 0x807FFFF (2 KB)    : Bootloader Journal
  * 0x807F800  - 0x807FFFF (2 KB)    : Bootloader Config
  * 0x8080000  - 0x80BFFFF (256 KB)  : Reserve Application
+ * 0x80C0000  - 0x80FFFFF (256 KB)  : Trend Log
  */
 
 #endif /* FLASH_MAP_H */
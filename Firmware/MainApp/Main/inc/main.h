@@ -21,6 +21,18 @@
 #include "P-Block-struct.h"
 #include "UniversalInputManager.h"
 #include "Periphery.h"
+#include "MainsSync.h"
+#include "TriacControl.h"
+#include "AnalogOutputEngine.h"
+#include "RelayDriver.h"
+#include "StorageFlush.h"
+#include "ErrorLog.h"
+#include "TrendLogger.h"
+#include "BootProfile.h"
+#include "TaskProfiler.h"
+#include "Trace.h"
+#include "PowerManager.h"
+#include "DeadlineMonitor.h"
 #include "CANopenTask.h"
 #include "CANopen_tmrTask.h"
 
@@ -225,35 +225,4 @@ void SysTick_Handler(void)
   /* add user code end SysTick_IRQ 1 */
 }
 #endif
-/**
-  * @brief  this function handles EXINT Line 0 handler.
-  * @param  none
-  * @retval none
-  */
-void EXINT0_IRQHandler(void)
-{
-  /* add user code begin EXINT0_IRQ 0 */
-
-  /* add user code end EXINT0_IRQ 0 */
-  /* add user code begin EXINT0_IRQ 1 */
-
-  /* add user code end EXINT0_IRQ 1 */
-}
-
-/**
-  * @brief  this function handles EXINT Line 1 handler.
-  * @param  none
-  * @retval none
-  */
-void EXINT1_IRQHandler(void)
-{
-  /* add user code begin EXINT1_IRQ 0 */
-
-  /* add user code end EXINT1_IRQ 0 */
-  /* add user code begin EXINT1_IRQ 1 */
-
-  /* add user code end EXINT1_IRQ 1 */
-}
-
-
-
+/* EXINT line handlers are implemented in Library/GPIO/DigitalInputCapture.cpp */
@@ -35,6 +35,30 @@ SystemServices_t services = {
   .BootloaderConfig = true,
 };
 
+/// Stack and TCB of a task created with xTaskCreateStatic
+template <uint32_t StackWords>
+struct TaskMemory {
+  StackType_t stack[StackWords];
+  StaticTask_t tcb;
+};
+
+// Task memory is collected in one input section so the map file shows it as a block
+#define TASK_MEMORY __attribute__((section(".bss.task_memory"), aligned(8)))
+
+static TaskMemory<configMINIMAL_STACK_SIZE> idle_task_memory TASK_MEMORY;
+static TaskMemory<128> input_update_task_memory TASK_MEMORY;
+static TaskMemory<128> output_update_task_memory TASK_MEMORY;
+static TaskMemory<CONFIG_FLUSH_TASK_STACK> config_flush_task_memory TASK_MEMORY;
+static TaskMemory<STORAGE_FLUSH_TASK_STACK> storage_flush_task_memory TASK_MEMORY;
+static TaskMemory<256> canopen_tmr_task_memory TASK_MEMORY;
+static TaskMemory<512> canopen_task_memory TASK_MEMORY;
+
+template <uint32_t StackWords>
+static TaskHandle_t create_task(TaskFunction_t function, const char *name, UBaseType_t priority,
+                                TaskMemory<StackWords> &memory) {
+  return xTaskCreateStatic(function, name, StackWords, NULL, priority, memory.stack, &memory.tcb);
+}
+
 /**
  * @brief main function.
  * @param  none
@@ -45,26 +69,38 @@ int main(void) {
   SystemApi::Init(NVIC_PRIORITY_GROUP_4, _240Mhz, true, reinterpret_cast<uint32_t>(_sapp));
   SystemApi::InitServices(services);
 
-  // ErrorJournal_LoadData();
-
+  BootProfile::Capture(); // Bootloader start-up profile, before anything touches the BPR
   // rtc_module_init();
 
   CmdHandler.SetCommands(cmdMap, command_amount);
 
+  StorageFlush::Init(); // Flash lock shared by the config journal and the logs
   PBlockConfig::Init(); // Initialize P-Block configuration
+  ErrorLog::Init();     // Error journal (RAM ring spilled to flash)
+  TrendLogger::Init();  // Universal input trend log (flash ring in bank 2)
   PBlockRegisters_t::Init();   // Initialize P-Block Modbus registers
   UniversalInputManager::Init(); // Initialize universal input hardware interfaces
+  MainsSync::Init();             // Zero-cross capture timebase (net period, TRIAC, synchronous sampling)
+  TriacControl::Init();          // Phase-cut TRIAC gates on the mains timebase
+  AnalogOutputEngine::Init();    // PWM/DMA driven 0-10 V outputs
+  RelayDriver::Init();           // Relay outputs and switch-cycle counters
+  TaskProfiler::Init();          // DWT cycle counter for per-task and ISR time
+  Trace::Init();                 // Binary event trace, drained in the idle hook
+  DeadlineMonitor::Init();       // Per-task deadlines, previous trip to the ErrorLog, watchdog start
 
   // xTaskCreate(modbusFun, "modbus", 256, NULL, tskIDLE_PRIORITY + 1, NULL);
-  xTaskCreate(inputUpdateTask, "inputUpdate", 128, NULL, tskIDLE_PRIORITY + 1, NULL);
+  create_task(inputUpdateTask, "inputUpdate", tskIDLE_PRIORITY + 1, input_update_task_memory);
+  create_task(outputUpdateTask, "outputUpdate", tskIDLE_PRIORITY + 1, output_update_task_memory);
+  create_task(PBlockConfig::FlushTask, "configFlush", tskIDLE_PRIORITY + 1, config_flush_task_memory);
+  create_task(StorageFlush::Task, "storageFlush", tskIDLE_PRIORITY + 1, storage_flush_task_memory);
   // xTaskCreate(uartFun, "uart", 256, NULL, tskIDLE_PRIORITY + 1, NULL);
   // xTaskCreate(ledFun, "led", 128, NULL, tskIDLE_PRIORITY + 1, NULL);
   // xTaskCreate(displayFun, "display", 256, NULL, tskIDLE_PRIORITY + 1, NULL);
   // xTaskCreate(buttonsFun, "buttons", 128, NULL, tskIDLE_PRIORITY + 1, NULL);
   // xTaskCreate(unitControlFun, "unitControl", 256, NULL, tskIDLE_PRIORITY + 1, NULL);
   // xTaskCreate(debugTask, "debug", 256, NULL, tskIDLE_PRIORITY + 1, NULL);
-  xTaskCreate(CANopen_tmrTask, "CANopen_tmr", 256, NULL, tskIDLE_PRIORITY + 2, NULL);
-  xTaskCreate(CANopenTask, "CANopen", 512, NULL, tskIDLE_PRIORITY + 2, NULL);
+  create_task(CANopen_tmrTask, "CANopen_tmr", tskIDLE_PRIORITY + 2, canopen_tmr_task_memory);
+  create_task(CANopenTask, "CANopen", tskIDLE_PRIORITY + 2, canopen_task_memory);
   // xTaskCreate(unitControlFun, "unitControl", 128, NULL, tskIDLE_PRIORITY + 1,
   // NULL);
 
@@ -92,9 +128,30 @@ void vApplicationStackOverflowHook(TaskHandle_t pxTask, char *pcTaskName) {
     ;
 }
 
+void vApplicationGetIdleTaskMemory(StaticTask_t **ppxIdleTaskTCBBuffer, StackType_t **ppxIdleTaskStackBuffer,
+                                   uint32_t *pulIdleTaskStackSize) {
+  *ppxIdleTaskTCBBuffer = &idle_task_memory.tcb;
+  *ppxIdleTaskStackBuffer = idle_task_memory.stack;
+  *pulIdleTaskStackSize = configMINIMAL_STACK_SIZE;
+}
+
+void vApplicationTickHook(void) {
+  TaskProfiler::Tick();
+  PowerManager::Tick();
+  DeadlineMonitor::Tick();
+}
+
 void vApplicationIdleHook(void) {
   // This function is called by the idle task
   // Can be used for low-priority background tasks
+  Trace::Flush();
+  DeadlineMonitor::Feed(); // the only watchdog reload
+
+  static bool running_marked = false;
+  if (!running_marked && xTaskGetTickCount() >= pdMS_TO_TICKS(BOOT_PROFILE_RUNNING_MS)) {
+    BootProfile::MarkRunning();
+    running_marked = true;
+  }
 }
 
 void Error_Handler(void) {
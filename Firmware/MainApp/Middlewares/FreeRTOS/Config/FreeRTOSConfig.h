@@ -111,21 +111,26 @@ extern "C"
  *----------------------------------------------------------*/
 #define configUSE_PREEMPTION 1
 #define configUSE_IDLE_HOOK 1
-#define configUSE_TICK_HOOK 0
+#define configUSE_TICK_HOOK 1 // TaskProfiler and PowerManager windows
 #ifndef LOW_HZ_MODE
 #define configCPU_CLOCK_HZ ((unsigned long)/* system_core_clock */ 240000000)
 #else
 #define configCPU_CLOCK_HZ ((unsigned long)/* system_core_clock */ 4800000)
 #endif
 #define configTICK_RATE_HZ ((TickType_t)1000) //( ( TickType_t ) 1000 )
+#define configSYSTICK_CLOCK_HZ (configCPU_CLOCK_HZ / 8) // HCLK/8 reference: one tickless sleep lasts up to 559 ms
+#define configUSE_TICKLESS_IDLE 2 // vPortSuppressTicksAndSleep in Library/Power/PowerManager.cpp
+#define configEXPECTED_IDLE_TIME_BEFORE_SLEEP 2
 #define configMAX_PRIORITIES (5)
 #define configMINIMAL_STACK_SIZE ((unsigned short)128)
-#define configSUPPORT_DYNAMIC_ALLOCATION 1
-#define configTOTAL_HEAP_SIZE ((size_t)(8 * 1024))
+#define configSUPPORT_STATIC_ALLOCATION 1  // application tasks and objects, see main.cpp
+#define configSUPPORT_DYNAMIC_ALLOCATION 1 // left for TafcoMcuCore services
+#define configTOTAL_HEAP_SIZE ((size_t)(2 * 1024))
 #define configMAX_TASK_NAME_LEN (16)
 #define configUSE_16_BIT_TICKS 0
 #define configIDLE_SHOULD_YIELD 1
 #define configUSE_MUTEXES       1
+#define configUSE_TRACE_FACILITY 1 // uxTaskGetSystemState and TCB numbers for TaskProfiler
 
 /* Co-routine definitions. */
 #define configUSE_CO_ROUTINES 0
@@ -142,6 +147,15 @@ extern "C"
 #define INCLUDE_vTaskDelayUntil 1
 #define INCLUDE_vTaskDelay 1
 #define INCLUDE_xTaskGetCurrentTaskHandle 1
+#define INCLUDE_xTaskGetIdleTaskHandle 1
+
+/* Task profiler hooks, Library/Profiler/TaskProfiler.h. The hooks run in
+vTaskSwitchContext, where pxCurrentTCB is the task switched in or out. */
+void TaskProfiler_SwitchedIn(uint32_t task_number);
+void TaskProfiler_SwitchedOut(void);
+#define traceTASK_SWITCHED_IN() TaskProfiler_SwitchedIn(pxCurrentTCB->uxTCBNumber)
+#define traceTASK_SWITCHED_OUT() TaskProfiler_SwitchedOut()
+
 /* Cortex-M specific definitions. */
 #ifdef __NVIC_PRIO_BITS
 /* __BVIC_PRIO_BITS will be specified when CMSIS is being used. */
@@ -0,0 +1,100 @@
+// ButtonGestures timing: each script of raw level changes is replayed the
+// way the button task drives the detector, with Process() on every level
+// change and whenever NextDeadlineMs() has passed, and the events are
+// compared as "time:TYPE/buttons/held_ms" strings.
+
+#include "Check.h"
+#include "ButtonGestures.h"
+#include <string>
+#include <utility>
+#include <vector>
+
+int failures = 0;
+
+typedef std::vector<std::pair<uint32_t, uint8_t>> Script;   /// time in ms, raw pressed mask
+
+static const char *const type_names[] = {"PRESS", "CLICK", "LONG", "REPEAT", "COMBO", "RELEASE"};
+
+/**
+ * @brief Replay a script until end_ms
+ * @param wakes Process() calls made, nullptr if not needed
+ * @return Events in order
+ */
+static std::string Run(const Script &script, uint32_t end_ms, uint32_t *wakes = nullptr) {
+    ButtonGestures gestures;
+    ButtonEvent events[BUTTON_MAX_EVENTS];
+    std::string out;
+    uint8_t raw = 0;
+    uint32_t now = 0;
+    uint32_t calls = 0;
+    size_t step = 0;
+
+    while (now <= end_ms) {
+        if (step < script.size() && script[step].first == now) {
+            raw = script[step++].second;
+        }
+        const uint8_t count = gestures.Process(raw, now, events);
+        calls++;
+        for (uint8_t i = 0; i < count; i++) {
+            char text[48];
+            snprintf(text, sizeof(text), "%u:%s/%x/%u ", now, type_names[static_cast<uint8_t>(events[i].type)],
+                     events[i].buttons, events[i].held_ms);
+            out += text;
+        }
+
+        // Sleep until the deadline or the next level change, whichever comes first
+        const uint32_t deadline = gestures.NextDeadlineMs(now);
+        const uint32_t edge = step < script.size() ? script[step].first : UINT32_MAX;
+        uint32_t next = edge;
+        if (deadline != UINT32_MAX) {
+            const uint32_t due = now + (deadline != 0 ? deadline : 1U);
+            next = due < edge ? due : edge;
+        }
+        if (next == UINT32_MAX) {
+            break;
+        }
+        now = next;
+    }
+    if (wakes != nullptr) {
+        *wakes = calls;
+    }
+    return out;
+}
+
+int main() {
+    uint32_t wakes;
+
+    // Bouncing contacts give one click
+    CHECK(Run({{100, 1}, {102, 0}, {104, 1}, {300, 0}, {301, 1}, {303, 0}}, 2000) ==
+          "124:PRESS/1/0 323:CLICK/1/199 323:RELEASE/1/199 ");
+
+    // A glitch shorter than the debounce time is ignored
+    CHECK(Run({{100, 2}, {110, 0}}, 1000).empty());
+
+    // Long press with repeats
+    CHECK(Run({{0, 4}, {1500, 0}}, 3000) ==
+          "20:PRESS/4/0 820:LONG/4/800 1020:REPEAT/4/1000 1220:REPEAT/4/1200 1420:REPEAT/4/1400 1520:RELEASE/4/1500 ");
+
+    // A combination held long gives neither LONG, REPEAT nor CLICK
+    CHECK(Run({{0, 1}, {100, 3}, {2000, 2}, {2100, 0}}, 4000) ==
+          "20:PRESS/1/0 120:PRESS/2/0 120:COMBO/3/0 2020:RELEASE/1/2000 2120:RELEASE/2/2000 ");
+
+    // Two buttons pressed together
+    CHECK(Run({{0, 5}, {50, 0}}, 500) == "20:PRESS/1/0 20:PRESS/4/0 20:COMBO/5/0 70:RELEASE/1/50 70:RELEASE/4/50 ");
+
+    // A single click works again once all buttons were up
+    CHECK(Run({{0, 3}, {50, 0}, {500, 1}, {600, 0}}, 1000).find("620:CLICK/1/100 ") != std::string::npos);
+
+    // Hold times saturate
+    const std::string held = Run({{0, 2}, {70000, 0}}, 80000);
+    CHECK(held.ends_with("70020:RELEASE/2/65535 "));
+
+    // Idle: no deadline, so no wake-ups besides the start, the level changes and the debounce ends
+    Run({}, 100000, &wakes);
+    CHECK(wakes == 1);
+    Run({{100, 1}, {300, 0}}, 100000, &wakes);
+    CHECK(wakes == 5);
+
+    printf("%s\n", failures ? "FAILED" : "OK");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,19 @@
+#ifndef __CHECK_H__
+#define __CHECK_H__
+
+#include <cstdio>
+
+/**
+ * @brief Failed checks of the test, main() returns it
+ */
+extern int failures;
+
+#define CHECK(condition)                                                    \
+    do {                                                                    \
+        if (!(condition)) {                                                 \
+            printf("%s:%d: %s failed\n", __FILE__, __LINE__, #condition);  \
+            failures++;                                                     \
+        }                                                                   \
+    } while (0)
+
+#endif // __CHECK_H__
@@ -0,0 +1,256 @@
+// ConfigJournal on SimFlash: random writes and batches against a RAM model,
+// with power cuts at random flash operations. After every cut the journal
+// is initialised again and must hold, for each key, either the value before
+// or the value of the interrupted write; a batch takes effect as a whole or
+// not at all. The write latency is estimated from the erases and word
+// programs at the device timings (SIM_SECTOR_ERASE_US, SIM_WORD_PROGRAM_US).
+
+#include "SimFlash.h"
+#include "Check.h"
+#include "ConfigJournal.h"
+#include <cstring>
+#include <random>
+
+#define TEST_KEYS                   (5U)
+#define TEST_WORDS                  (8U)
+
+int failures = 0;
+
+static std::mt19937 rng(1);
+static uint32_t model[TEST_KEYS][TEST_WORDS];
+static bool stored[TEST_KEYS];
+
+/**
+ * @brief Key k holds 4 * (k + 1) bytes, so the records differ in size
+ */
+static uint16_t KeySize(uint16_t key) {
+    return static_cast<uint16_t>(4U * (key + 1U));
+}
+
+/**
+ * @brief Flash time of the operations counted since the given counters
+ */
+static uint32_t FlashTimeUs(uint32_t erases, uint32_t programs) {
+    return (SimFlash::sector_erases - erases) * SIM_SECTOR_ERASE_US +
+           (SimFlash::word_programs - programs) * SIM_WORD_PROGRAM_US;
+}
+
+static bool MatchesModel(void) {
+    for (uint16_t key = 0; key < TEST_KEYS; key++) {
+        uint32_t value[TEST_WORDS];
+        if (stored[key] != ConfigJournal::Contains(key)) {
+            return false;
+        }
+        if (stored[key] && (!ConfigJournal::Read(key, value, KeySize(key)) ||
+                            memcmp(value, model[key], KeySize(key)) != 0)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void Reset(void) {
+    SimFlash::Init();
+    memset(model, 0, sizeof(model));
+    memset(stored, 0, sizeof(stored));
+    CHECK(ConfigJournal::Init());
+}
+
+static void TestBasics(void) {
+    Reset();
+    const uint32_t free_bytes = ConfigJournal::GetFreeBytes();
+    uint32_t value = 0x12345678U;
+    uint32_t read = 0;
+
+    CHECK(!ConfigJournal::Contains(1));
+    CHECK(!ConfigJournal::Read(1, &read, sizeof(read)));
+    CHECK(ConfigJournal::Write(1, &value, sizeof(value)));
+    CHECK(ConfigJournal::GetSize(1) == sizeof(value));
+    CHECK(ConfigJournal::Read(1, &read, sizeof(read)) && read == value);
+    CHECK(!ConfigJournal::Read(1, &read, 2));
+
+    // An unchanged value programs nothing
+    const uint32_t programs = SimFlash::word_programs;
+    CHECK(ConfigJournal::Write(1, &value, sizeof(value)));
+    CHECK(SimFlash::word_programs == programs);
+    CHECK(ConfigJournal::GetFreeBytes() < free_bytes);
+
+    // The key table is rebuilt from flash
+    CHECK(ConfigJournal::Init());
+    CHECK(ConfigJournal::Read(1, &read, sizeof(read)) && read == value);
+    CHECK(SimFlash::program_errors == 0);
+}
+
+static void TestCollection(void) {
+    Reset();
+    uint32_t value[TEST_WORDS] = {};
+
+    // Fill the active sector many times over; only collection erases
+    const uint32_t first_erases = SimFlash::sector_erases;
+    const uint32_t first_programs = SimFlash::word_programs;
+    uint32_t worst_us = 0;
+    for (uint32_t i = 0; i < 2000; i++) {
+        const uint32_t erases = SimFlash::sector_erases;
+        const uint32_t programs = SimFlash::word_programs;
+        value[0] = i;
+        CHECK(ConfigJournal::Write(static_cast<uint16_t>(i % TEST_KEYS), value, sizeof(value)));
+        const uint32_t us = FlashTimeUs(erases, programs);
+        worst_us = us > worst_us ? us : worst_us;
+    }
+    printf("writes of %u bytes: %u us average, %u us with a collection\n", static_cast<unsigned>(sizeof(value)),
+           FlashTimeUs(first_erases, first_programs) / 2000U, worst_us);
+    const uint32_t erases = ConfigJournal::GetEraseCount();
+    CHECK(erases > 0);
+    CHECK(erases == SimFlash::sector_erases);
+
+    CHECK(ConfigJournal::Init());
+    CHECK(ConfigJournal::GetEraseCount() == erases);
+    for (uint32_t key = 0; key < TEST_KEYS; key++) {
+        CHECK(ConfigJournal::Read(static_cast<uint16_t>(key), value, sizeof(value)));
+        CHECK(value[0] == 2000U - TEST_KEYS + key);
+    }
+    CHECK(SimFlash::program_errors == 0);
+}
+
+static void TestCapacity(void) {
+    Reset();
+    uint8_t value[CONFIG_JOURNAL_MAX_VALUE];
+
+    // 14 keys of the largest value and one rewrite fill the first sector
+    for (uint16_t key = 0; key < 14; key++) {
+        memset(value, key, sizeof(value));
+        CHECK(ConfigJournal::Write(key, value, sizeof(value)));
+    }
+    memset(value, 0x40, sizeof(value));
+    CHECK(ConfigJournal::Write(0, value, sizeof(value)));
+    CHECK(ConfigJournal::GetFreeBytes() == 0);
+
+    // A 15th key still fits together with the live records after a collection
+    const uint32_t erases = SimFlash::sector_erases;
+    memset(value, 14, sizeof(value));
+    CHECK(ConfigJournal::Write(14, value, sizeof(value)));
+    CHECK(SimFlash::sector_erases == erases + 1);
+    CHECK(ConfigJournal::GetFreeBytes() == 0);
+
+    // A 16th does not: refused before the erase, staged or not
+    memset(value, 15, sizeof(value));
+    CHECK(!ConfigJournal::Write(15, value, sizeof(value)));
+    CHECK(!ConfigJournal::Stage(15, value, sizeof(value)));
+    CHECK(SimFlash::sector_erases == erases + 1);
+
+    CHECK(ConfigJournal::Init());
+    CHECK(!ConfigJournal::Contains(15));
+    for (uint16_t key = 0; key < 15; key++) {
+        uint8_t read[CONFIG_JOURNAL_MAX_VALUE];
+        CHECK(ConfigJournal::Read(key, read, sizeof(read)));
+        CHECK(read[0] == (key == 0 ? 0x40 : key) && read[sizeof(read) - 1] == read[0]);
+    }
+    CHECK(SimFlash::program_errors == 0);
+}
+
+static void TestWritePowerCuts(void) {
+    Reset();
+    uint32_t cuts = 0;
+    for (uint32_t i = 0; i < 50000; i++) {
+        const uint16_t key = static_cast<uint16_t>(rng() % TEST_KEYS);
+        uint32_t value[TEST_WORDS];
+        for (uint32_t &word : value) {
+            word = rng();
+        }
+        if (rng() % 50 == 0) {
+            SimFlash::power_left = static_cast<int32_t>(rng() % 40);
+        }
+
+        try {
+            CHECK(ConfigJournal::Write(key, value, KeySize(key)));
+            memcpy(model[key], value, KeySize(key));
+            stored[key] = true;
+        } catch (const SimPowerCut &) {
+            cuts++;
+            CHECK(ConfigJournal::Init());
+            uint32_t read[TEST_WORDS];
+            if (ConfigJournal::Read(key, read, KeySize(key))) {
+                CHECK(memcmp(read, model[key], KeySize(key)) == 0 || memcmp(read, value, KeySize(key)) == 0);
+                memcpy(model[key], read, KeySize(key));
+                stored[key] = true;
+            } else {
+                CHECK(!stored[key]);
+            }
+        }
+        SimFlash::power_left = SIM_NO_POWER_CUT;
+        CHECK(MatchesModel());
+        if (failures) {
+            printf("write %u, %u power cuts\n", i, cuts);
+            return;
+        }
+    }
+    CHECK(cuts > 0);
+    printf("writes: %u power cuts, %u erases\n", cuts, ConfigJournal::GetEraseCount());
+}
+
+static void TestBatchPowerCuts(void) {
+    Reset();
+    uint32_t cuts = 0;
+    for (uint32_t i = 0; i < 20000; i++) {
+        uint32_t values[TEST_KEYS][TEST_WORDS];
+        bool staged[TEST_KEYS] = {};
+        const uint32_t count = 1U + rng() % 3U;
+        for (uint32_t n = 0; n < count; n++) {
+            const uint16_t key = static_cast<uint16_t>(rng() % TEST_KEYS);
+            staged[key] = true;
+            for (uint32_t &word : values[key]) {
+                word = rng();
+            }
+        }
+        if (rng() % 30 == 0) {
+            SimFlash::power_left = static_cast<int32_t>(rng() % 60);
+        }
+
+        bool applied = false;
+        try {
+            for (uint16_t key = 0; key < TEST_KEYS; key++) {
+                if (staged[key]) {
+                    CHECK(ConfigJournal::Stage(key, values[key], KeySize(key)));
+                }
+            }
+            CHECK(ConfigJournal::Commit());
+            applied = true;
+        } catch (const SimPowerCut &) {
+            cuts++;
+            CHECK(ConfigJournal::Init());
+            applied = !MatchesModel();
+        }
+        SimFlash::power_left = SIM_NO_POWER_CUT;
+
+        // All of the batch or none of it
+        if (applied) {
+            for (uint16_t key = 0; key < TEST_KEYS; key++) {
+                if (staged[key]) {
+                    memcpy(model[key], values[key], KeySize(key));
+                    stored[key] = true;
+                }
+            }
+        }
+        CHECK(MatchesModel());
+        if (i % 1000 == 0) {
+            CHECK(ConfigJournal::Init());
+            CHECK(MatchesModel());
+        }
+        if (failures) {
+            printf("batch %u, %u power cuts\n", i, cuts);
+            return;
+        }
+    }
+    CHECK(cuts > 0);
+    printf("batches: %u power cuts, %u erases\n", cuts, ConfigJournal::GetEraseCount());
+}
+
+int main() {
+    TestBasics();
+    TestCollection();
+    TestCapacity();
+    TestWritePowerCuts();
+    TestBatchPowerCuts();
+    printf("%s\n", failures ? "FAILED" : "OK");
+    return failures ? 1 : 0;
+}
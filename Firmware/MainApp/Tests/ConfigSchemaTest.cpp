@@ -0,0 +1,267 @@
+// ConfigSchema encoding of a test struct (wire widths, versions, short and
+// long data), then PBlockConfig::Init migrating every stored layout on
+// SimFlash: legacy sector 253 records of versions 1 and 2, a version 2
+// journal with host-sized enums and a journal written by newer firmware.
+// Last, the flash time a config write costs the request handler that makes
+// it, with the write deferred to the flush task and as the setters did it
+// before (sector 253 erased and reprogrammed in the handler), from the
+// SimFlash erase and program times.
+
+#include "SimFlash.h"
+#include "SimSystem.h"
+#include "Check.h"
+#include "ConfigSchema.h"
+#include "PBlockConfig.h"
+#include <cstring>
+#include <vector>
+
+int failures = 0;
+
+typedef std::vector<uint8_t> Bytes;
+
+struct Inner {
+    uint8_t a;
+    uint16_t b;
+};
+
+struct Sample {
+    uint32_t u32;
+    uint16_t u16[2];
+    int mode;               /// host-sized enum stand-in, one byte on the wire
+    Inner inner;
+    uint16_t added;         /// since version 2
+};
+
+static constexpr ConfigSchema::Field inner_schema[] = {
+    SCHEMA_FIELD(Inner, a, U8, 1),
+    SCHEMA_FIELD(Inner, b, U16, 1),
+};
+
+static constexpr ConfigSchema::Field sample_schema[] = {
+    SCHEMA_FIELD(Sample, u32, U32, 1),
+    SCHEMA_ARRAY(Sample, u16, U16, 1),
+    SCHEMA_FIELD(Sample, mode, U8, 1),
+    SCHEMA_NESTED(Sample, inner, inner_schema, 1),
+    SCHEMA_FIELD(Sample, added, U16, 2),
+};
+
+static constexpr uint8_t VERSION_1 = 1;
+
+static_assert(ConfigSchema::Size(sample_schema, VERSION_1) == 12U, "version 1 layout");
+static_assert(ConfigSchema::Size(sample_schema) == 14U, "version 2 layout");
+
+static void TestSchema(void) {
+    const Sample sample = {0x11223344U, {0x5566U, 0x7788U}, 3, {0x99U, 0xAABBU}, 0xCCDDU};
+    const Bytes expected = {0x44, 0x33, 0x22, 0x11, 0x66, 0x55, 0x88, 0x77, 0x03, 0x99, 0xBB, 0xAA, 0xDD, 0xCC};
+    uint8_t buffer[32];
+
+    // Little-endian, fixed wire widths, schema order
+    CHECK(ConfigSchema::Serialize(sample_schema, &sample, buffer, sizeof(buffer)) == expected.size());
+    CHECK(Bytes(buffer, buffer + expected.size()) == expected);
+    CHECK(ConfigSchema::Serialize(sample_schema, &sample, buffer, expected.size() - 1U) == 0);
+
+    Sample read = {};
+    CHECK(ConfigSchema::Deserialize(sample_schema, &read, expected.data(), expected.size()));
+    CHECK(memcmp(&read, &sample, sizeof(read)) == 0);
+
+    // Version 1 data leaves the newer field at its default
+    CHECK(ConfigSchema::Serialize(sample_schema, &sample, buffer, sizeof(buffer), VERSION_1) == 12U);
+    read = {};
+    read.added = 1000;
+    CHECK(ConfigSchema::Deserialize(sample_schema, &read, buffer, 12U, VERSION_1));
+    CHECK(read.u32 == sample.u32 && read.inner.b == sample.inner.b && read.added == 1000);
+
+    // Newer data is longer, its tail is ignored; short data is rejected
+    Bytes longer = expected;
+    longer.push_back(0xEE);
+    read = {};
+    CHECK(ConfigSchema::Deserialize(sample_schema, &read, longer.data(), longer.size()));
+    CHECK(read.added == sample.added);
+    CHECK(!ConfigSchema::Deserialize(sample_schema, &read, expected.data(), expected.size() - 1U));
+    CHECK(!ConfigSchema::Deserialize(sample_schema, &read, buffer, 11U, VERSION_1));
+}
+
+static const calendar_type assembly_date = {2024, 5, 6, 7, 8, 9, 1};
+
+template <class T>
+static void Put(Bytes &bytes, const T &value) {
+    const uint8_t *p = reinterpret_cast<const uint8_t *>(&value);
+    bytes.insert(bytes.end(), p, p + sizeof(value));
+}
+
+/**
+ * @brief Modbus fields as versions 1 and 2 stored them, enums with their host size
+ */
+static Bytes LegacyModbus(void) {
+    Bytes bytes;
+    Put<uint8_t>(bytes, 17);
+    Put<uint32_t>(bytes, 115200);
+    Put(bytes, USART_DATA_9BITS);
+    Put(bytes, USART_PARITY_EVEN);
+    Put(bytes, USART_STOP_2_BIT);
+    return bytes;
+}
+
+static Bytes LegacyRecord(uint8_t version) {
+    Bytes bytes;
+    Put<uint8_t>(bytes, version);
+    Put<uint32_t>(bytes, 12345);
+    Put(bytes, assembly_date);
+    const Bytes modbus = LegacyModbus();
+    bytes.insert(bytes.end(), modbus.begin(), modbus.end());
+    if (version == 2) {
+        for (uint32_t relay = 0; relay < RELAY_COUNT; relay++) {
+            Put<uint32_t>(bytes, 100 + relay);
+        }
+    }
+    bytes.push_back(count_CRC(bytes.data(), bytes.size()));
+    return bytes;
+}
+
+static void WriteLegacyRecord(uint8_t version) {
+    const Bytes bytes = LegacyRecord(version);
+    memcpy(SimFlash::At(ADDRESS_DEVICE_CONGIG), bytes.data(), bytes.size());
+}
+
+static uint32_t FlashTimeUs(uint32_t erases, uint32_t programs) {
+    return (SimFlash::sector_erases - erases) * SIM_SECTOR_ERASE_US +
+           (SimFlash::word_programs - programs) * SIM_WORD_PROGRAM_US;
+}
+
+static void CheckMigrated(bool relay_cycles) {
+    const calendar_type date = PBlockConfig::GetAssemblyDate();
+    const ModbusConfig &modbus = PBlockConfig::GetModbusConfig();
+    CHECK(PBlockConfig::GetSerialNum() == 12345);
+    CHECK(memcmp(&date, &assembly_date, sizeof(date)) == 0);
+    CHECK(modbus.address == 17 && modbus.baudrate == 115200);
+    CHECK(modbus.data_bits == USART_DATA_9BITS && modbus.parity == USART_PARITY_EVEN &&
+          modbus.stop_bits == USART_STOP_2_BIT);
+    CHECK(PBlockConfig::GetRelayCycles(13) == (relay_cycles ? 112U : 0U));
+    CHECK(PBlockConfig::GetTrendPeriod() == DEFAULT_DEVICE_CONFIG_TREND_PERIOD_MS);
+
+    // Rewritten in the current layout
+    uint8_t version = 0;
+    CHECK(ConfigJournal::Read(static_cast<uint16_t>(ConfigKey::VERSION), &version, sizeof(version)));
+    CHECK(version == VERSION_DEVICE_CONFIG);
+    CHECK(ConfigJournal::GetSize(static_cast<uint16_t>(ConfigKey::MODBUS)) == ModbusConfig::get_size());
+}
+
+static void TestMigration(void) {
+    SimFlash::Init();
+    WriteLegacyRecord(2);
+    PBlockConfig::Init();
+    CheckMigrated(true);
+    PBlockConfig::Init();
+    CheckMigrated(true);
+
+    SimFlash::Init();
+    WriteLegacyRecord(1);
+    PBlockConfig::Init();
+    CheckMigrated(false);
+
+    // Journal of version 2 firmware
+    SimFlash::Init();
+    CHECK(ConfigJournal::Init());
+    {
+        const uint8_t version = 2;
+        const uint32_t serial = 12345;
+        const Bytes modbus = LegacyModbus();
+        uint32_t cycles[RELAY_COUNT];
+        for (uint32_t relay = 0; relay < RELAY_COUNT; relay++) {
+            cycles[relay] = 100 + relay;
+        }
+        CHECK(ConfigJournal::Write(static_cast<uint16_t>(ConfigKey::SERIAL_NUM), &serial, sizeof(serial)));
+        CHECK(ConfigJournal::Write(static_cast<uint16_t>(ConfigKey::ASSEMBLY_DATE), &assembly_date,
+                                   sizeof(assembly_date)));
+        CHECK(ConfigJournal::Write(static_cast<uint16_t>(ConfigKey::MODBUS), modbus.data(),
+                                   static_cast<uint16_t>(modbus.size())));
+        CHECK(ConfigJournal::Write(static_cast<uint16_t>(ConfigKey::RELAY_CYCLES), cycles, sizeof(cycles)));
+        CHECK(ConfigJournal::Write(static_cast<uint16_t>(ConfigKey::VERSION), &version, sizeof(version)));
+    }
+    PBlockConfig::Init();
+    CheckMigrated(true);
+
+    // Journal of newer firmware, with a field appended to the Modbus record
+    {
+        const uint8_t version = VERSION_DEVICE_CONFIG + 1U;
+        const uint8_t modbus[] = {17, 0x00, 0xC2, 0x01, 0x00, USART_DATA_9BITS, USART_PARITY_EVEN, USART_STOP_2_BIT,
+                                  0xAA, 0xBB};
+        CHECK(ConfigJournal::Stage(static_cast<uint16_t>(ConfigKey::MODBUS), modbus, sizeof(modbus)));
+        CHECK(ConfigJournal::Stage(static_cast<uint16_t>(ConfigKey::VERSION), &version, sizeof(version)));
+        CHECK(ConfigJournal::Commit());
+    }
+    PBlockConfig::Init();
+    CheckMigrated(true);
+
+    // A legacy record with a bad CRC is ignored
+    SimFlash::Init();
+    WriteLegacyRecord(2);
+    SimFlash::At(ADDRESS_DEVICE_CONGIG)[3] ^= 1U;
+    PBlockConfig::Init();
+    CHECK(PBlockConfig::GetSerialNum() == DEFAULT_DEVICE_CONFIG_SERIAL_NUM);
+    CHECK(PBlockConfig::GetModbusConfig().address == DEFAULT_MODBUS_ADDRESS);
+
+    // Changes reach the journal at the next flush
+    PBlockConfig::SetSerialNum(777);
+    PBlockConfig::SetTrendPeriod(250);
+    CHECK(PBlockConfig::Flush());
+    PBlockConfig::Init();
+    CHECK(PBlockConfig::GetSerialNum() == 777);
+    CHECK(PBlockConfig::GetTrendPeriod() == 250);
+    CHECK(SimFlash::program_errors == 0);
+}
+
+static void TestWriteLatency(void) {
+    // A Modbus or command write of a config field runs the setter in the
+    // request handler, the response goes out when it returns. The setter used
+    // to erase sector 253 and program the whole record right there.
+    const uint32_t record_words = (static_cast<uint32_t>(LegacyRecord(2).size()) + 3U) / 4U;
+    const uint32_t before_us = SIM_SECTOR_ERASE_US + record_words * SIM_WORD_PROGRAM_US;
+
+    SimFlash::Init();
+    PBlockConfig::Init();
+    uint32_t handler_us = 0;
+    uint32_t flush_us = 0;
+    uint32_t flush_worst_us = 0;
+    const uint32_t writes = 500;
+    for (uint32_t i = 0; i < writes; i++) {
+        uint32_t erases = SimFlash::sector_erases;
+        uint32_t programs = SimFlash::word_programs;
+        PBlockConfig::SetSerialNum(1000 + i);
+        handler_us += FlashTimeUs(erases, programs);
+
+        // The flush task after the window, the handler has answered by then
+        erases = SimFlash::sector_erases;
+        programs = SimFlash::word_programs;
+        CHECK(PBlockConfig::Flush());
+        const uint32_t us = FlashTimeUs(erases, programs);
+        flush_us += us;
+        flush_worst_us = us > flush_worst_us ? us : flush_worst_us;
+    }
+    CHECK(handler_us == 0);
+    printf("config write in the request handler: %u us before, %u us now; flush task %u us average, %u us worst\n",
+           before_us, handler_us / writes, flush_us / writes, flush_worst_us);
+
+    // Writes within one window go out as one batch
+    const uint32_t erases = SimFlash::sector_erases;
+    const uint32_t programs = SimFlash::word_programs;
+    for (uint32_t i = 0; i < 10; i++) {
+        PBlockConfig::SetSerialNum(5000 + i);
+        PBlockConfig::SetTrendPeriod(static_cast<uint16_t>(100 + i));
+    }
+    CHECK(PBlockConfig::Flush());
+    const uint32_t batch_us = FlashTimeUs(erases, programs);
+    CHECK(batch_us < 2U * flush_us / writes + SIM_SECTOR_ERASE_US);
+    printf("20 writes in one window: %u us of flash\n", batch_us);
+    PBlockConfig::Init();
+    CHECK(PBlockConfig::GetSerialNum() == 5009 && PBlockConfig::GetTrendPeriod() == 109);
+}
+
+int main() {
+    SimSystem::Init();
+    TestSchema();
+    TestMigration();
+    TestWriteLatency();
+    printf("%s\n", failures ? "FAILED" : "OK");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,233 @@
+// DigitalInputCapture edge path: the test sets the GPIOB input levels and
+// the EXINT pending flags and calls the interrupt body, as the pins would,
+// then drives Process() the way the input task does, on every edge and
+// whenever NextDeadlineMs() has passed. Covers contact bounce, pulses
+// shorter and longer than the debounce time, edges queued across a late
+// Process(), a tick count wrapping during a pulse and queue overflow.
+
+#include "Check.h"
+#include "SimSystem.h"
+#include "DigitalInputCapture.h"
+#include "PowerManager.h"
+#include "ButtonsApp.h"
+
+int failures = 0;
+
+static uint32_t wakes = 0;
+
+// Input n on GPIOB pin n - 1, EXINT line n - 1
+GPIOInputDriver::GPIOPin GPIOInputDriver::GetPinMapping(uint8_t input_number) {
+    return {GPIOB, 1U << (input_number - 1U)};
+}
+
+void PowerManager::Wake(TaskHandle_t task) {
+    (void)task;
+    wakes++;
+}
+
+extern "C" void buttonsIrqHandler(void) {}
+
+/**
+ * @brief Set the level of the inputs in mask at time now_ms and raise their EXINT lines
+ */
+static void Edge(uint16_t mask, bool level, uint32_t now_ms) {
+    SimSystem::tick_ms = now_ms;
+    if (level) {
+        GPIOB->idt |= mask;
+    } else {
+        GPIOB->idt &= ~static_cast<uint32_t>(mask);
+    }
+    EXINT->intsts |= mask;
+    DigitalInputCapture::IrqHandler();
+}
+
+/**
+ * @brief Call Process() at each deadline up to end_ms
+ * @return State and counter changes of all the calls
+ */
+static DigitalInputCapture::Changes_t RunUntil(uint32_t start_ms, uint32_t end_ms) {
+    DigitalInputCapture::Changes_t all = {0, 0};
+    uint32_t now = start_ms;
+
+    while (true) {
+        const DigitalInputCapture::Changes_t changes = DigitalInputCapture::Process(now);
+        all.state_changed |= changes.state_changed;
+        all.counter_changed |= changes.counter_changed;
+        const uint32_t deadline = DigitalInputCapture::NextDeadlineMs(now);
+        if (deadline == UINT32_MAX || end_ms - now < deadline) {
+            break;
+        }
+        now += deadline != 0 ? deadline : 1U;
+    }
+    SimSystem::tick_ms = end_ms;
+    return all;
+}
+
+static void Reset(uint32_t now_ms) {
+    SimSystem::Init();
+    SimSystem::tick_ms = now_ms;
+    GPIOB->idt = 0;
+    EXINT->intsts = 0;
+    CHECK(DigitalInputCapture::Init());
+    DigitalInputCapture::SetDebounceTime(DI_CAPTURE_DEBOUNCE_MS);
+    for (uint8_t input = 1; input <= DI_CAPTURE_INPUTS; input++) {
+        DigitalInputCapture::SetCounter(input, 0);
+    }
+}
+
+static void TestCleanPulse(void) {
+    Reset(0);
+    CHECK(DigitalInputCapture::GetStates() == 0);
+    CHECK(DigitalInputCapture::NextDeadlineMs(0) == UINT32_MAX);
+
+    const uint32_t before = wakes;
+    Edge(0x001, true, 10);
+    CHECK(wakes == before + 1);
+    CHECK(DigitalInputCapture::Process(10).state_changed == 0);
+    CHECK(DigitalInputCapture::NextDeadlineMs(12) == DI_CAPTURE_DEBOUNCE_MS - 2U);
+
+    DigitalInputCapture::Changes_t changes = RunUntil(12, 50);
+    CHECK(changes.state_changed == 0x001 && changes.counter_changed == 0x001);
+    CHECK(DigitalInputCapture::GetState(1) && DigitalInputCapture::GetCounter(1) == 1);
+
+    // The falling edge changes the state, only rising edges count
+    Edge(0x001, false, 100);
+    changes = RunUntil(100, 150);
+    CHECK(changes.state_changed == 0x001 && changes.counter_changed == 0);
+    CHECK(!DigitalInputCapture::GetState(1) && DigitalInputCapture::GetCounter(1) == 1);
+    CHECK(DigitalInputCapture::GetCounter(0) == 0 && DigitalInputCapture::GetCounter(12) == 0);
+}
+
+static void TestBounce(void) {
+    Reset(0);
+
+    // A contact bouncing for 4 ms settles high: one count, confirmed 5 ms after the last bounce
+    uint32_t t = 20;
+    for (uint32_t i = 0; i < 4; i++) {
+        Edge(0x002, true, t++);
+        Edge(0x002, false, t);
+    }
+    Edge(0x002, true, t);
+    CHECK(DigitalInputCapture::Process(t).state_changed == 0);
+    CHECK(DigitalInputCapture::Process(t + DI_CAPTURE_DEBOUNCE_MS - 1U).state_changed == 0);
+    CHECK(DigitalInputCapture::Process(t + DI_CAPTURE_DEBOUNCE_MS).counter_changed == 0x002);
+    CHECK(DigitalInputCapture::GetCounter(2) == 1);
+
+    // Bouncing on release does not count either
+    t = 200;
+    for (uint32_t i = 0; i < 6; i++) {
+        Edge(0x002, false, t++);
+        Edge(0x002, true, t);
+    }
+    Edge(0x002, false, t);
+    RunUntil(t, t + 50);
+    CHECK(!DigitalInputCapture::GetState(2) && DigitalInputCapture::GetCounter(2) == 1);
+}
+
+static void TestShortPulses(void) {
+    Reset(0);
+
+    // Pulses shorter than the debounce time are noise
+    for (uint32_t t = 10; t < 1000; t += 20) {
+        Edge(0x004, true, t);
+        Edge(0x004, false, t + DI_CAPTURE_DEBOUNCE_MS - 1U);
+        CHECK(RunUntil(t, t + 19).state_changed == 0);
+    }
+    CHECK(DigitalInputCapture::GetCounter(3) == 0);
+
+    // Pulses just over it all count, even when Process() runs only after both edges
+    for (uint32_t t = 1000; t < 2000; t += 20) {
+        Edge(0x004, true, t);
+        Edge(0x004, false, t + DI_CAPTURE_DEBOUNCE_MS + 1U);
+        const DigitalInputCapture::Changes_t changes = RunUntil(t + 15, t + 19);
+        CHECK(changes.counter_changed == 0x004);
+    }
+    CHECK(DigitalInputCapture::GetCounter(3) == 50);
+    CHECK(!DigitalInputCapture::GetState(3));
+}
+
+static void TestSeveralInputs(void) {
+    Reset(0);
+
+    // One interrupt for two lines, then a third input with its own timing
+    Edge(0x030, true, 10);
+    Edge(0x400, true, 12);
+    DigitalInputCapture::Changes_t changes = DigitalInputCapture::Process(10 + DI_CAPTURE_DEBOUNCE_MS);
+    CHECK(changes.counter_changed == 0x030);
+    CHECK(DigitalInputCapture::NextDeadlineMs(10 + DI_CAPTURE_DEBOUNCE_MS) == 2);
+    changes = RunUntil(10 + DI_CAPTURE_DEBOUNCE_MS, 100);
+    CHECK(changes.counter_changed == 0x400);
+    CHECK(DigitalInputCapture::GetStates() == 0x430);
+    CHECK(DigitalInputCapture::GetCounter(5) == 1 && DigitalInputCapture::GetCounter(6) == 1 &&
+          DigitalInputCapture::GetCounter(11) == 1);
+}
+
+static void TestTickWrap(void) {
+    // Edges on both sides of the 32-bit tick wrap
+    const uint32_t start = UINT32_MAX - 2U;
+    Reset(start);
+
+    Edge(0x008, true, start);
+    CHECK(DigitalInputCapture::Process(start).state_changed == 0);
+    CHECK(DigitalInputCapture::NextDeadlineMs(start + 2U) == DI_CAPTURE_DEBOUNCE_MS - 2U);
+    CHECK(DigitalInputCapture::Process(start + DI_CAPTURE_DEBOUNCE_MS - 1U).state_changed == 0);
+    CHECK(DigitalInputCapture::Process(start + DI_CAPTURE_DEBOUNCE_MS).counter_changed == 0x008);
+
+    Edge(0x008, false, 40);
+    Edge(0x008, true, 42);
+    Edge(0x008, false, 43);
+    CHECK(RunUntil(43, 80).state_changed == 0x008);
+    CHECK(!DigitalInputCapture::GetState(4) && DigitalInputCapture::GetCounter(4) == 1);
+
+    // A counter preset from Modbus/SDO keeps counting and wraps
+    DigitalInputCapture::SetCounter(4, UINT32_MAX);
+    Edge(0x008, true, 100);
+    RunUntil(100, 150);
+    CHECK(DigitalInputCapture::GetCounter(4) == 0);
+}
+
+static void TestOverflow(void) {
+    Reset(0);
+
+    // More edges than the queue holds before Process() runs: resynchronised with the pin
+    const uint32_t dropped = DigitalInputCapture::GetDroppedEvents();
+    uint32_t t = 10;
+    for (uint32_t i = 0; i < DI_CAPTURE_QUEUE_SIZE; i++) {
+        Edge(0x010, (i & 1U) == 0, t);
+        t += 10;
+    }
+    Edge(0x020, true, t);
+    CHECK(DigitalInputCapture::GetDroppedEvents() == dropped + 1);
+
+    // The queued edges give 32 pulses, the lost one is read back from the pin
+    RunUntil(t, t + 50);
+    CHECK(DigitalInputCapture::GetCounter(5) == DI_CAPTURE_QUEUE_SIZE / 2U);
+    CHECK(!DigitalInputCapture::GetState(5));
+    CHECK(DigitalInputCapture::GetState(6) && DigitalInputCapture::GetCounter(6) == 1);
+}
+
+static void TestNoDebounce(void) {
+    Reset(0);
+    DigitalInputCapture::SetDebounceTime(0);
+
+    // Every edge is taken as it comes
+    Edge(0x001, true, 10);
+    Edge(0x001, false, 10);
+    Edge(0x001, true, 11);
+    const DigitalInputCapture::Changes_t changes = DigitalInputCapture::Process(11);
+    CHECK(changes.counter_changed == 0x001);
+    CHECK(DigitalInputCapture::GetCounter(1) == 2 && DigitalInputCapture::GetState(1));
+    CHECK(DigitalInputCapture::NextDeadlineMs(11) == UINT32_MAX);
+}
+
+int main() {
+    TestCleanPulse();
+    TestBounce();
+    TestShortPulses();
+    TestSeveralInputs();
+    TestTickWrap();
+    TestOverflow();
+    TestNoDebounce();
+    printf("%s\n", failures ? "FAILED" : "OK");
+    return failures ? 1 : 0;
+}
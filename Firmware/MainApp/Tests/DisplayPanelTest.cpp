@@ -0,0 +1,224 @@
+// DisplayPanel on the host framebuffer (SimPanel): the rounder widening
+// areas to controller pages, the flush packing LVGL's RGB332 pixels into
+// page bytes for full-width bands and partial areas, and the DMA page chain
+// (page address commands between the pages, flush ready only after the
+// last one, CS released). Last, the render time per frame on this host for
+// a full screen and for a label, with the SPI time the same bytes take on
+// the target. LVGL is not in the tree, so the frames are drawn by the test
+// and the time covers the driver (packing and page chain), not LVGL's
+// drawing.
+
+#include "Check.h"
+#include "SimPanel.h"
+#include <chrono>
+
+#define DISPLAY_SPI_HZ              (120000000U / 16U)      /// APB1 / SPI_MCLK_DIV_16
+#define BENCH_FRAMES                (2000U)
+#define RAM_FILL                    (0xA5U)                 /// page RAM not written by a flush keeps this
+
+int failures = 0;
+
+typedef bool (*Pattern)(uint32_t x, uint32_t y);
+
+static lv_disp_drv_t *driver;
+
+static bool Diagonal(uint32_t x, uint32_t y) {
+    return (x * 7U + y * 3U) % 5U == 0U;
+}
+
+/**
+ * @brief Draw the area into the active draw buffer, as LVGL renders it
+ */
+static lv_color_t *Draw(const lv_area_t &area, Pattern pattern) {
+    lv_color_t *const buf = static_cast<lv_color_t *>(driver->draw_buf->buf_act);
+    lv_color_t *pixel = buf;
+    for (int32_t y = area.y1; y <= area.y2; y++) {
+        for (int32_t x = area.x1; x <= area.x2; x++) {
+            *pixel++ = pattern(x, y) ? lv_color_black() : lv_color_white();
+        }
+    }
+    return buf;
+}
+
+/**
+ * @brief Round, draw and flush one area the way lv_refr does, then let the DMA run
+ */
+static void Refresh(lv_area_t area, Pattern pattern) {
+    driver->rounder_cb(driver, &area);
+    lv_disp_draw_buf_t *const draw_buf = driver->draw_buf;
+    lv_color_t *const buf = Draw(area, pattern);
+    draw_buf->flushing = 1;
+    driver->flush_cb(driver, &area, buf);
+    SimPanel::RunDma();
+    while (draw_buf->flushing) {
+        driver->wait_cb(driver);
+    }
+    draw_buf->buf_act = draw_buf->buf_act == draw_buf->buf1 ? draw_buf->buf2 : draw_buf->buf1;
+}
+
+/**
+ * @brief Panel pixels inside area follow pattern, the RAM outside it is untouched
+ */
+static bool Shows(const lv_area_t &area, Pattern pattern) {
+    for (uint32_t y = 0; y < DISPLAY_HEIGHT; y++) {
+        for (uint32_t x = 0; x < DISPLAY_WIDTH; x++) {
+            const bool inside = static_cast<int32_t>(x) >= area.x1 && static_cast<int32_t>(x) <= area.x2 &&
+                                static_cast<int32_t>(y) >= area.y1 && static_cast<int32_t>(y) <= area.y2;
+            const bool expected = inside ? pattern(x, y) : ((RAM_FILL >> (y % DISPLAY_PAGE_LINES)) & 1U) != 0;
+            if (SimPanel::Pixel(x, y) != expected) {
+                printf("pixel %u,%u\n", x, y);
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+static void TestInit(void) {
+    SimPanel::Init(RAM_FILL);
+    DisplayPanel::Init();
+    driver = sim_lv_disp.driver;
+    CHECK(driver != NULL && driver->hor_res == DISPLAY_WIDTH && driver->ver_res == DISPLAY_HEIGHT);
+    CHECK(driver->flush_cb != NULL && driver->rounder_cb != NULL && driver->wait_cb != NULL);
+
+    // Two partial buffers of DISPLAY_BUF_LINES rows
+    CHECK(driver->draw_buf->buf1 != NULL && driver->draw_buf->buf2 != NULL &&
+          driver->draw_buf->buf1 != driver->draw_buf->buf2);
+    CHECK(driver->draw_buf->size == DISPLAY_WIDTH * DISPLAY_BUF_LINES);
+
+    // The init sequence is all commands, the panel is deselected after it
+    CHECK(SimPanel::commands == 10U && SimPanel::data_bytes == 0 && SimPanel::dropped_bytes == 0);
+    CHECK((DISPLAY_PORT->odt & DISPLAY_PIN_CS) != 0);
+}
+
+static void TestRounder(void) {
+    lv_area_t area = {5, 3, 60, 9};
+    driver->rounder_cb(driver, &area);
+    CHECK(area.x1 == 5 && area.x2 == 60 && area.y1 == 0 && area.y2 == 15);
+
+    area = {0, 8, 127, 15};
+    driver->rounder_cb(driver, &area);
+    CHECK(area.y1 == 8 && area.y2 == 15);
+
+    area = {0, 63, 127, 63};
+    driver->rounder_cb(driver, &area);
+    CHECK(area.y1 == 56 && area.y2 == 63);
+}
+
+static void TestFullWidthBand(void) {
+    // Two pages in one flush: six address commands, 256 data bytes, one flush ready
+    SimPanel::Clear(RAM_FILL);
+    const uint32_t ready = sim_lv_flush_ready_count;
+    const uint32_t flushes = DisplayPanel::GetFlushCount();
+    const lv_area_t area = {0, 16, 127, 31};
+    Refresh(area, Diagonal);
+    CHECK(Shows(area, Diagonal));
+    CHECK(SimPanel::commands == 6U && SimPanel::data_bytes == 256U && SimPanel::dropped_bytes == 0);
+    CHECK(SimPanel::dma_transfers == 2U);
+    CHECK(sim_lv_flush_ready_count == ready + 1U && DisplayPanel::GetFlushCount() == flushes + 1U);
+    CHECK((DISPLAY_PORT->odt & DISPLAY_PIN_CS) != 0);
+}
+
+static void TestFlushReadyAfterLastPage(void) {
+    // LVGL may reuse the buffer only once the last page has left
+    SimPanel::Clear(RAM_FILL);
+    const uint32_t ready = sim_lv_flush_ready_count;
+    lv_area_t area = {0, 0, 127, 15};
+    driver->rounder_cb(driver, &area);
+    lv_color_t *const buf = Draw(area, Diagonal);
+    driver->flush_cb(driver, &area, buf);
+    CHECK(sim_lv_flush_ready_count == ready && (DISPLAY_PORT->odt & DISPLAY_PIN_CS) == 0);
+    CHECK(SimPanel::data_bytes == 0);
+    SimPanel::RunDma();
+    CHECK(sim_lv_flush_ready_count == ready + 1U && SimPanel::data_bytes == 256U);
+}
+
+static void TestPartialAreas(void) {
+    // A label: columns 10..69 of rows 42..45, rounded to page 5
+    SimPanel::Clear(RAM_FILL);
+    Refresh({10, 42, 69, 45}, Diagonal);
+    CHECK(Shows({10, 40, 69, 47}, Diagonal));
+    CHECK(SimPanel::commands == 3U && SimPanel::data_bytes == 60U);
+
+    // The right edge, two pages at the bottom
+    SimPanel::Clear(RAM_FILL);
+    Refresh({120, 48, 127, 63}, Diagonal);
+    CHECK(Shows({120, 48, 127, 63}, Diagonal));
+    CHECK(SimPanel::data_bytes == 16U && SimPanel::dropped_bytes == 0);
+}
+
+static void TestColours(void) {
+    // A pixel is on when its colour is darker than DISPLAY_DARK_BRIGHTNESS
+    SimPanel::Clear(0x00);
+    static const uint8_t greys[] = {0x00, 0x40, 0x60, 0x80, 0xA0, 0xC0, 0xFF};
+    lv_area_t area = {0, 0, static_cast<lv_coord_t>(sizeof(greys) - 1U), 7};
+    lv_color_t *const buf = static_cast<lv_color_t *>(driver->draw_buf->buf_act);
+    for (uint32_t y = 0; y < 8U; y++) {
+        for (uint32_t x = 0; x < sizeof(greys); x++) {
+            buf[y * sizeof(greys) + x] = lv_color_make(greys[x], greys[x], greys[x]);
+        }
+    }
+    driver->draw_buf->flushing = 1;
+    driver->flush_cb(driver, &area, buf);
+    SimPanel::RunDma();
+    static const uint8_t expected[] = {0xFF, 0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00};
+    CHECK(memcmp(SimPanel::ram[0], expected, sizeof(expected)) == 0);
+}
+
+static uint32_t frame_index;
+
+static bool Moving(uint32_t x, uint32_t y) {
+    return ((x + frame_index) / 4U + y / 4U) % 2U == 0U;
+}
+
+/**
+ * @brief Host time of one frame, lv_refr flushing the areas one buffer at a time
+ * @return Microseconds per frame
+ */
+static double BenchFrame(const lv_area_t &area) {
+    const auto start = std::chrono::steady_clock::now();
+    for (frame_index = 0; frame_index < BENCH_FRAMES; frame_index++) {
+        for (lv_coord_t y = area.y1; y <= area.y2; y = static_cast<lv_coord_t>(y + DISPLAY_BUF_LINES)) {
+            const lv_coord_t y2 = static_cast<lv_coord_t>(y + DISPLAY_BUF_LINES - 1U);
+            Refresh({area.x1, y, area.x2, y2 < area.y2 ? y2 : area.y2}, Moving);
+        }
+    }
+    const std::chrono::duration<double, std::micro> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count() / BENCH_FRAMES;
+}
+
+static void TestRenderTime(void) {
+    SimPanel::Clear(RAM_FILL);
+
+    const lv_area_t screen = {0, 0, DISPLAY_WIDTH - 1U, DISPLAY_HEIGHT - 1U};
+    const uint32_t before = SimPanel::data_bytes + SimPanel::commands;
+    const double screen_us = BenchFrame(screen);
+    const uint32_t screen_bytes = (SimPanel::data_bytes + SimPanel::commands - before) / BENCH_FRAMES;
+    frame_index = BENCH_FRAMES - 1U;
+    CHECK(Shows(screen, Moving));
+    CHECK(screen_bytes == DISPLAY_WIDTH * DISPLAY_HEIGHT / 8U + 3U * (DISPLAY_HEIGHT / DISPLAY_PAGE_LINES));
+
+    const lv_area_t label = {10, 40, 73, 47};
+    const uint32_t label_before = SimPanel::data_bytes + SimPanel::commands;
+    const double label_us = BenchFrame(label);
+    const uint32_t label_bytes = (SimPanel::data_bytes + SimPanel::commands - label_before) / BENCH_FRAMES;
+    CHECK(label_bytes == 64U + 3U);
+
+    printf("display frame on the host: full screen %.1f us, label 64x8 %.1f us (packing and page chain)\n",
+           screen_us, label_us);
+    printf("on SPI at %u kHz: full screen %u bytes %u us, label %u bytes %u us\n", DISPLAY_SPI_HZ / 1000U,
+           screen_bytes, static_cast<unsigned>(screen_bytes * 8ULL * 1000000U / DISPLAY_SPI_HZ), label_bytes,
+           static_cast<unsigned>(label_bytes * 8ULL * 1000000U / DISPLAY_SPI_HZ));
+}
+
+int main() {
+    TestInit();
+    TestRounder();
+    TestFullWidthBand();
+    TestFlushReadyAfterLastPage();
+    TestPartialAreas();
+    TestColours();
+    TestRenderTime();
+    printf("%s\n", failures ? "FAILED" : "OK");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,174 @@
+// ErrorLog on SimFlash: merging of repeats, RAM ring overflow, rotation of
+// the flash ring and power cuts during Spill(). Each entry is added with a
+// new code and the tick and RTC set from that code, so the order and the
+// timestamps of every entry read back can be checked. After a power cut the
+// entries in flash must still be in order, newest first; an entry cut short
+// keeps its code and reads 0xFFFFFFFF in the timestamps not yet programmed.
+
+#include "SimFlash.h"
+#include "SimSystem.h"
+#include "Check.h"
+#include "ErrorLog.h"
+#include <random>
+
+// As in ErrorLog.cpp
+#define SECTOR_ENTRIES              ((FLASH_SECTOR_SIZE - 8U) / 12U)
+#define FLASH_ENTRIES_MIN           ((ERROR_LOG_SECTORS - 1U) * SECTOR_ENTRIES)
+
+int failures = 0;
+
+static void Reset(void) {
+    SimFlash::Init();
+    SimSystem::Init();
+    CHECK(ErrorLog::Init());
+}
+
+static void AddAt(uint16_t code) {
+    SimSystem::tick_ms = code * 1000U;
+    SimSystem::rtc_s = code + 7U;
+    ErrorLog::Add(code);
+}
+
+/**
+ * @brief Check that entry index holds code with the timestamps AddAt() gives it
+ */
+static bool IsEntry(uint32_t index, uint16_t code) {
+    ErrorLogEntry entry;
+    return ErrorLog::GetEntry(index, entry) && entry.code == code && entry.count == 1 &&
+           entry.rtc_time == code + 7U && entry.uptime_ms == code * 1000U;
+}
+
+static void TestBasics(void) {
+    Reset();
+    ErrorLogEntry entry;
+
+    AddAt(5);
+    AddAt(6);
+    SimSystem::tick_ms = 9000;
+    SimSystem::rtc_s = 70000;
+    ErrorLog::Add(6);
+    ErrorLog::Add(ERROR_LOG_CLEAR_CODE);
+    CHECK(ErrorLog::GetCount() == 2);
+    CHECK(ErrorLog::GetEntry(0, entry) && entry.code == 6 && entry.count == 2 && entry.uptime_ms == 9000);
+    CHECK(IsEntry(1, 5));
+    CHECK(!ErrorLog::GetEntry(2, entry));
+    CHECK(ErrorLog::GetField(0, ErrorLogField::COUNT) == 2);
+    CHECK(ErrorLog::GetField(0, ErrorLogField::RTC_HIGH) == 1 && ErrorLog::GetField(0, ErrorLogField::RTC_LOW) == 4464);
+    CHECK(ErrorLog::GetField(0, ErrorLogField::UPTIME_S_LOW) == 9);
+    CHECK(ErrorLog::GetField(2, ErrorLogField::CODE) == 0);
+
+    // Same entries from flash, also after a reset
+    CHECK(ErrorLog::HasPending());
+    CHECK(ErrorLog::Spill());
+    CHECK(!ErrorLog::HasPending());
+    CHECK(ErrorLog::Init());
+    CHECK(ErrorLog::GetCount() == 2);
+    CHECK(ErrorLog::GetEntry(0, entry) && entry.code == 6 && entry.count == 2 && entry.rtc_time == 70000);
+    CHECK(IsEntry(1, 5));
+
+    // A spilled entry is not merged any more
+    AddAt(6);
+    CHECK(ErrorLog::GetCount() == 3);
+
+    // Clear hides everything before it, across a reset too
+    ErrorLog::Clear();
+    AddAt(8);
+    CHECK(ErrorLog::GetCount() == 1);
+    CHECK(ErrorLog::Spill());
+    CHECK(ErrorLog::Init());
+    CHECK(ErrorLog::GetCount() == 1);
+    CHECK(IsEntry(0, 8));
+    CHECK(SimFlash::program_errors == 0);
+}
+
+static void TestRamOverflow(void) {
+    Reset();
+
+    for (uint16_t code = 1; code <= ERROR_LOG_RAM_ENTRIES + 8U; code++) {
+        AddAt(code);
+    }
+    CHECK(ErrorLog::GetDroppedCount() == 8);
+    CHECK(ErrorLog::GetCount() == ERROR_LOG_RAM_ENTRIES);
+    CHECK(IsEntry(0, ERROR_LOG_RAM_ENTRIES + 8U));
+    CHECK(IsEntry(ERROR_LOG_RAM_ENTRIES - 1U, 9));
+}
+
+static void TestRotation(void) {
+    Reset();
+    const uint16_t total = static_cast<uint16_t>(3U * ERROR_LOG_SECTORS * SECTOR_ENTRIES + 17U);
+
+    for (uint16_t code = 1; code <= total; code++) {
+        AddAt(code);
+        if (code % ERROR_LOG_PAGE_ENTRIES == 0) {
+            CHECK(ErrorLog::Spill());
+        }
+    }
+    CHECK(ErrorLog::Spill());
+    CHECK(ErrorLog::Init());
+
+    // The oldest sector is erased for the next one, the others stay readable
+    const uint32_t count = ErrorLog::GetCount();
+    CHECK(count >= FLASH_ENTRIES_MIN && count <= FLASH_ENTRIES_MIN + SECTOR_ENTRIES);
+    for (uint32_t index = 0; index < count; index++) {
+        CHECK(IsEntry(index, static_cast<uint16_t>(total - index)));
+    }
+    CHECK(SimFlash::sector_erases == 3U * ERROR_LOG_SECTORS + 1U);
+    CHECK(SimFlash::program_errors == 0);
+}
+
+static void TestPowerCuts(void) {
+    Reset();
+    std::mt19937 rng(3);
+    uint16_t code = 0;
+    uint16_t spilled = 0;   /// newest code known to be in flash
+    uint32_t cuts = 0;
+
+    while (code < 60000U) {
+        const uint32_t adds = 1U + rng() % ERROR_LOG_PAGE_ENTRIES;
+        for (uint32_t i = 0; i < adds; i++) {
+            AddAt(++code);
+        }
+        if (rng() % 4 == 0) {
+            SimFlash::power_left = static_cast<int32_t>(rng() % 40);
+        }
+
+        try {
+            CHECK(ErrorLog::Spill());
+            spilled = code;
+        } catch (const SimPowerCut &) {
+            cuts++;
+            CHECK(ErrorLog::Init());
+        }
+        SimFlash::power_left = SIM_NO_POWER_CUT;
+
+        // Newest first, strictly older going down; nothing spilled before is lost
+        ErrorLogEntry entry;
+        uint32_t newer = code + 1U;
+        const uint32_t count = ErrorLog::GetCount();
+        for (uint32_t index = 0; index < count; index++) {
+            CHECK(ErrorLog::GetEntry(index, entry));
+            CHECK(entry.code < newer && entry.count == 1);
+            CHECK(entry.rtc_time == entry.code + 7U || entry.rtc_time == 0xFFFFFFFFU);
+            CHECK(entry.uptime_ms == entry.code * 1000U || entry.uptime_ms == 0xFFFFFFFFU);
+            CHECK(entry.rtc_time != 0xFFFFFFFFU || entry.uptime_ms == 0xFFFFFFFFU);
+            newer = entry.code;
+        }
+        CHECK(count >= FLASH_ENTRIES_MIN || newer == 1U);
+        CHECK(ErrorLog::GetEntry(0, entry) && entry.code >= spilled);
+        if (failures) {
+            printf("code %u, %u power cuts\n", code, cuts);
+            return;
+        }
+    }
+    CHECK(cuts > 0);
+    printf("power cuts: %u, %u sector erases\n", cuts, SimFlash::sector_erases);
+}
+
+int main() {
+    TestBasics();
+    TestRamOverflow();
+    TestRotation();
+    TestPowerCuts();
+    printf("%s\n", failures ? "FAILED" : "OK");
+    return failures ? 1 : 0;
+}
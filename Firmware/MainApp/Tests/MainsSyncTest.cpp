@@ -0,0 +1,223 @@
+// MainsSync on a modelled TMR5 (SimTimer): zero crossings are fed to the
+// CH1 capture with mains drifting over 45..65 Hz, with glitches between
+// crossings, missed crossings and a dropout, across the 32-bit counter
+// wrap. The averaged period, the frequency and the presence flag are
+// checked against the moving average of the periods actually fed.
+
+#include "Check.h"
+#include "SimTimer.h"
+#include "MainsSync.h"
+#include <deque>
+
+int failures = 0;
+
+static uint32_t now = 0;                    /// counter value of the last crossing fed
+static std::deque<uint32_t> recent;         /// accepted periods, newest last
+static uint32_t zero_crossings = 0;
+static uint32_t slots_seen = 0;
+static uint32_t slot_error = 0;             /// largest distance of a sample from its slot centre, ticks
+
+static void OnZeroCross(uint32_t capture, uint32_t period_ticks) {
+    CHECK(capture == now);
+    CHECK(period_ticks != 0);
+    zero_crossings++;
+}
+
+static void OnSample(uint8_t slot) {
+    // Slot k is centred at (2k + 1) / 32 of the averaged period after the crossing
+    const uint32_t period = MainsSync::GetPeriodTicks();
+    const uint32_t centre = now + static_cast<uint32_t>(static_cast<uint64_t>(period) * (2U * slot + 1U) /
+                                                        (2U * MAINS_SAMPLES_PER_CYCLE));
+    const uint32_t error = MainsSync::Now() > centre ? MainsSync::Now() - centre : centre - MainsSync::Now();
+    slot_error = error > slot_error ? error : slot_error;
+    CHECK(slot == slots_seen % MAINS_SAMPLES_PER_CYCLE);
+    slots_seen++;
+}
+
+/**
+ * @brief Feed the next crossing one period after the last one
+ */
+static void Cross(uint32_t period_ticks) {
+    // Slots of the ending period refer to the previous crossing
+    SimTimer::RunTo(now + period_ticks);
+    now += period_ticks;
+    SimTimer::Capture(now);
+    if (period_ticks >= MAINS_PERIOD_MIN_US * MAINS_TICKS_PER_US &&
+        period_ticks <= MAINS_PERIOD_MAX_US * MAINS_TICKS_PER_US) {
+        recent.push_back(period_ticks);
+        if (recent.size() > MAINS_AVERAGE_CYCLES) {
+            recent.pop_front();
+        }
+    } else {
+        recent.clear();
+    }
+}
+
+static uint32_t ModelAverage(void) {
+    uint64_t sum = 0;
+    for (uint32_t period : recent) {
+        sum += period;
+    }
+    return recent.empty() ? 0 : static_cast<uint32_t>(sum / recent.size());
+}
+
+/**
+ * @brief Period, frequency and presence against the periods fed
+ */
+static bool MatchesModel(void) {
+    const uint32_t average = ModelAverage();
+    if (MainsSync::GetPeriodTicks() != average) {
+        return false;
+    }
+    if (MainsSync::GetPeriodUs() != (average + MAINS_TICKS_PER_US / 2U) / MAINS_TICKS_PER_US) {
+        return false;
+    }
+    const uint32_t millihz = average == 0 ? 0 : static_cast<uint32_t>((10000000000ULL + average / 2U) / average);
+    return MainsSync::GetFrequencyMilliHz() == millihz && MainsSync::IsPresent() == (average != 0);
+}
+
+/**
+ * @brief Period in ticks of a frequency in mHz
+ */
+static uint32_t PeriodOf(uint32_t millihz) {
+    return static_cast<uint32_t>(10000000000ULL / millihz);
+}
+
+static void TestStartUp(void) {
+    CHECK(!MainsSync::IsPresent());
+    CHECK(MainsSync::GetPeriodUs() == 0 && MainsSync::GetFrequencyMilliHz() == 0);
+
+    // The first crossing only sets the reference
+    Cross(0);
+    CHECK(!MainsSync::IsPresent() && zero_crossings == 0);
+
+    Cross(PeriodOf(50000));
+    CHECK(MainsSync::IsPresent());
+    CHECK(MainsSync::GetPeriodUs() == 20000 && MainsSync::GetFrequencyMilliHz() == 50000);
+    for (uint32_t i = 0; i < 20; i++) {
+        Cross(PeriodOf(50000));
+    }
+    CHECK(MatchesModel());
+    CHECK(zero_crossings == 21);
+}
+
+static void TestDrift(void) {
+    // 50 -> 65 -> 45 -> 50 Hz in 10 mHz steps per cycle, every period checked
+    bool ok = true;
+    uint32_t millihz = 50000;
+    for (; millihz < 65000; millihz += 10) {
+        Cross(PeriodOf(millihz));
+        ok = ok && MatchesModel();
+    }
+    for (; millihz > 45000; millihz -= 10) {
+        Cross(PeriodOf(millihz));
+        ok = ok && MatchesModel();
+    }
+    for (; millihz < 50000; millihz += 10) {
+        Cross(PeriodOf(millihz));
+        ok = ok && MatchesModel();
+    }
+    CHECK(ok);
+
+    // The average lags a ramp by half its length
+    CHECK(MainsSync::GetFrequencyMilliHz() > 49900 && MainsSync::GetFrequencyMilliHz() < 50000);
+    const uint32_t rejected = MainsSync::GetRejectedCount();
+
+    // Both ends of the range hold for good
+    for (uint32_t i = 0; i < 16; i++) {
+        Cross(PeriodOf(45000));
+    }
+    CHECK(MatchesModel() && MainsSync::GetFrequencyMilliHz() == 45000);
+    for (uint32_t i = 0; i < 16; i++) {
+        Cross(PeriodOf(65000));
+    }
+    CHECK(MatchesModel() && MainsSync::GetFrequencyMilliHz() == 65000);
+    CHECK(MainsSync::GetRejectedCount() == rejected);
+}
+
+static void TestGlitches(void) {
+    for (uint32_t i = 0; i < 8; i++) {
+        Cross(PeriodOf(50000));
+    }
+    const uint32_t rejected = MainsSync::GetRejectedCount();
+
+    // A spike 3 ms after each crossing is ignored and the next crossing still measures 20 ms
+    for (uint32_t i = 0; i < 10; i++) {
+        SimTimer::Capture(now + 30000U);
+        CHECK(MainsSync::IsPresent());
+        Cross(PeriodOf(50000));
+    }
+    CHECK(MainsSync::GetRejectedCount() == rejected + 10);
+    CHECK(MatchesModel() && MainsSync::GetPeriodUs() == 20000);
+}
+
+static void TestDropouts(void) {
+    for (uint32_t i = 0; i < 8; i++) {
+        Cross(PeriodOf(60000));
+    }
+
+    // One missed crossing: the double period is rejected and averaging starts over
+    const uint32_t rejected = MainsSync::GetRejectedCount();
+    Cross(2U * PeriodOf(60000));
+    CHECK(MainsSync::GetRejectedCount() == rejected + 1);
+    CHECK(!MainsSync::IsPresent() && MainsSync::GetPeriodUs() == 0);
+    Cross(PeriodOf(60000));
+    CHECK(MatchesModel() && MainsSync::IsPresent());
+
+    // Mains lost: present until MAINS_LOST_CYCLES periods pass without a crossing
+    const uint32_t period = MainsSync::GetPeriodTicks();
+    SimTimer::RunTo(now + MAINS_LOST_CYCLES * period - 1U);
+    CHECK(MainsSync::IsPresent());
+    SimTimer::RunTo(now + MAINS_LOST_CYCLES * period);
+    CHECK(!MainsSync::IsPresent());
+    CHECK(MainsSync::GetPeriodUs() == 0 && MainsSync::GetFrequencyMilliHz() == 0);
+
+    // Back after a second: the first period is rejected, the next ones count
+    Cross(10000000U);
+    CHECK(!MainsSync::IsPresent());
+    Cross(PeriodOf(50000));
+    Cross(PeriodOf(50000));
+    CHECK(MatchesModel() && MainsSync::GetFrequencyMilliHz() == 50000);
+}
+
+static void TestSampleSlots(void) {
+    MainsSync::SetSampleHandler(OnSample);
+    slots_seen = 0;
+    for (uint32_t i = 0; i < 20; i++) {
+        Cross(PeriodOf(50000));
+    }
+    SimTimer::RunTo(now + PeriodOf(50000) - 1U);
+
+    // Every period gets all its slots, each within a tick of its centre
+    CHECK(slots_seen == 20 * MAINS_SAMPLES_PER_CYCLE);
+    CHECK(slot_error <= 1);
+    CHECK(SimTimer::late_values == 0);
+    MainsSync::SetSampleHandler(nullptr);
+}
+
+static void TestCounterWrap(void) {
+    // After a gap, crossings on both sides of the 32-bit wrap (every 7 minutes)
+    Cross(UINT32_MAX - 3U * PeriodOf(50000) - now);
+    bool ok = true;
+    for (uint32_t i = 0; i < 10; i++) {
+        Cross(PeriodOf(50000));
+        ok = ok && MatchesModel();
+    }
+    CHECK(ok && now < 7U * PeriodOf(50000));
+    CHECK(MainsSync::GetFrequencyMilliHz() == 50000);
+}
+
+int main() {
+    SimTimer::Init(MainsSync::IrqHandler, 0);
+    CHECK(MainsSync::Init());
+    MainsSync::SetZeroCrossHandler(OnZeroCross);
+
+    TestStartUp();
+    TestDrift();
+    TestGlitches();
+    TestDropouts();
+    TestSampleSlots();
+    TestCounterWrap();
+    printf("%s\n", failures ? "FAILED" : "OK");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,192 @@
+// vPortSuppressTicksAndSleep on a modelled SysTick (SimSysTick): sleeps
+// ended by the wake-up timer, by an interrupt at random points of the
+// sleep, entered with a tick already pending, and aborted. After every
+// sleep the tick count must match the time slept, and the ticks after it
+// must stay within a few counts of the grid of the ticks before it: the
+// partial tick left at the wake-up is loaded through the CLKSOURCE switch,
+// the counts lost while SysTick is stopped at entry are made up by
+// POWER_STOPPED_COUNTS. The stop at the exit is not made up (as in the
+// FreeRTOS port), so every sleep moves the grid by a few counts; the test
+// bounds that shift per sleep. Each register access is charged
+// SIM_ACCESS_CYCLES, an assumed cost of the code around it, not a
+// measurement.
+
+#include "Check.h"
+#include "SimSystem.h"
+#include "SimSysTick.h"
+#include "PowerManager.h"
+#include <random>
+
+#define SIM_ACCESS_CYCLES           (16U)
+#define COUNTS_PER_TICK             (configSYSTICK_CLOCK_HZ / configTICK_RATE_HZ)
+#define MAX_SLEEP_TICKS             (SysTick_LOAD_RELOAD_Msk / COUNTS_PER_TICK)
+#define STOPPED_COUNTS              (94UL / SIM_SYSTICK_DIVIDER)
+
+int failures = 0;
+
+extern "C" void vPortSuppressTicksAndSleep(TickType_t expected_ticks);
+
+static std::mt19937 rng(7);
+
+static uint32_t Random(uint32_t below) {
+    return std::uniform_int_distribution<uint32_t>(0, below - 1U)(rng);
+}
+
+static uint32_t sleep_handlers;             /// tick handler runs of the last Sleep()
+static bool on_time_at_wake;                /// tick count matched the time when the sleep returned
+static int64_t sleep_shift;                 /// cycles the last Sleep() moved the tick grid
+
+/**
+ * @brief Tick count against the ticks due at cycles on the grid drift cycles off time 0
+ */
+static bool TicksMatchTime(uint32_t ticks, uint64_t cycles, int64_t drift) {
+    return ticks == static_cast<uint64_t>(static_cast<int64_t>(cycles) + drift) / SIM_CYCLES_PER_TICK;
+}
+
+/**
+ * @brief Sleep from the current point, then run on for two ticks
+ * @param wake_after Cycles after the call an interrupt ends the sleep, 0 for none
+ * @return Ticks the kernel counted over the sleep
+ */
+static uint32_t SleepNow(TickType_t expected_ticks, uint64_t wake_after) {
+    const uint32_t before = SimSystem::tick_ms;
+    const uint32_t handlers = SimSysTick::tick_handlers;
+    const int64_t drift = SimSysTick::Drift();
+    if (wake_after != 0) {
+        SimSysTick::Interrupt(SimSysTick::cycles + wake_after);
+    }
+    vPortSuppressTicksAndSleep(expected_ticks);
+    const uint32_t slept = SimSystem::tick_ms - before;
+    const uint32_t ticks_at_wake = SimSystem::tick_ms;
+    const uint64_t wake = SimSysTick::cycles;
+
+    // The ticks after the sleep fall where they would have without it, up to the shift
+    SimSysTick::Run(2U * SIM_CYCLES_PER_TICK);
+    sleep_handlers = SimSysTick::tick_handlers - handlers;
+    sleep_shift = SimSysTick::Drift() - drift;
+    on_time_at_wake = TicksMatchTime(ticks_at_wake, wake, drift) ||
+                      TicksMatchTime(ticks_at_wake, wake, SimSysTick::Drift());
+    return slept;
+}
+
+/**
+ * @brief Sleep from a random point of the tick
+ */
+static uint32_t Sleep(TickType_t expected_ticks, uint64_t wake_after) {
+    SimSysTick::Run(Random(SIM_CYCLES_PER_TICK - 1000U) + 1U);
+    return SleepNow(expected_ticks, wake_after);
+}
+
+/**
+ * @brief Run to cycles before the next tick
+ */
+static void RunToBefore(uint32_t cycles) {
+    const uint64_t now = static_cast<uint64_t>(static_cast<int64_t>(SimSysTick::cycles) + SimSysTick::Drift());
+    uint64_t left = SIM_CYCLES_PER_TICK - now % SIM_CYCLES_PER_TICK;
+    left += left <= cycles ? SIM_CYCLES_PER_TICK : 0U;
+    SimSysTick::Run(left - cycles);
+}
+
+static uint64_t Distance(int64_t drift) {
+    return static_cast<uint64_t>(drift < 0 ? -drift : drift);
+}
+
+static void TestSetUp(void) {
+    CHECK(COUNTS_PER_TICK == 30000U && MAX_SLEEP_TICKS == 559U);
+    CHECK(STOPPED_COUNTS == 11U);
+
+    // Ticks on the grid while nothing sleeps
+    SimSysTick::Run(10U * SIM_CYCLES_PER_TICK);
+    CHECK(SimSystem::tick_ms == 10 && SimSysTick::Drift() == 0);
+}
+
+static void TestTimerWake(void) {
+    const TickType_t lengths[] = {2, 3, 10, 100, 558, 559};
+    uint64_t worst = 0;
+    for (TickType_t expected : lengths) {
+        for (uint32_t i = 0; i < 20; i++) {
+            CHECK(Sleep(expected, 0) == expected);
+            CHECK(on_time_at_wake && sleep_handlers == 3U);
+            worst = Distance(sleep_shift) > worst ? Distance(sleep_shift) : worst;
+        }
+    }
+
+    // The stopped stretch at entry is the one POWER_STOPPED_COUNTS stands for,
+    // the one after the wake-up is what moves the grid
+    printf("timer wake-up: SysTick stopped %u cycles at entry and %u after, each sleep moved the tick grid up "
+           "to %u cycles\n",
+           static_cast<unsigned>(SimSysTick::entry_stop), static_cast<unsigned>(SimSysTick::exit_stop),
+           static_cast<unsigned>(worst));
+    CHECK(worst < SIM_SYSTICK_DIVIDER * STOPPED_COUNTS);
+
+    // Longer than the counter reaches: the sleep is cut at 559 ticks
+    CHECK(Sleep(2000, 0) == MAX_SLEEP_TICKS);
+    CHECK(on_time_at_wake);
+
+    PowerStats stats;
+    PowerManager::GetStats(stats);
+    CHECK(stats.timer_wakeups == stats.wakeups && stats.longest_sleep_ms == MAX_SLEEP_TICKS);
+}
+
+static void TestEarlyWake(void) {
+    // An interrupt anywhere in the sleep: the complete ticks are stepped,
+    // the partial one is loaded and ends on the grid
+    uint64_t worst = 0;
+    for (uint32_t i = 0; i < 2000; i++) {
+        const TickType_t expected = 2U + Random(500);
+        const uint64_t wake_after = 1U + Random(static_cast<uint32_t>((expected - 1U) * SIM_CYCLES_PER_TICK));
+        CHECK(Sleep(expected, wake_after) < expected);
+        CHECK(on_time_at_wake);
+        worst = Distance(sleep_shift) > worst ? Distance(sleep_shift) : worst;
+    }
+    printf("early wake-up: each sleep moved the tick grid up to %u cycles\n", static_cast<unsigned>(worst));
+    CHECK(worst < SIM_SYSTICK_DIVIDER * STOPPED_COUNTS);
+
+    // Woken just before a tick: a partial tick of up to POWER_STOPPED_COUNTS
+    // is counted at once and loaded with the next one, a slightly longer one
+    // may be over before the CLKSOURCE switch has stopped, and is counted once
+    for (uint32_t shortfall = 1; shortfall < 400; shortfall += 3) {
+        RunToBefore(10000);
+        SleepNow(5, 10000U + 3U * SIM_CYCLES_PER_TICK - shortfall);
+        CHECK(on_time_at_wake);
+        CHECK(Distance(sleep_shift) < SIM_SYSTICK_DIVIDER * STOPPED_COUNTS);
+    }
+}
+
+static void TestPendingTick(void) {
+    // The tick falls due after the idle task masked interrupts: it is taken
+    // off the sleep, neither counted twice nor lost
+    const uint32_t clears = SimSysTick::pend_clears;
+    for (uint32_t i = 0; i < 200; i++) {
+        const TickType_t expected = 2U + Random(50);
+        RunToBefore(1U + Random(SIM_ACCESS_CYCLES - 1U));
+        CHECK(SleepNow(expected, (i & 1U) ? 0 : 1U + Random(static_cast<uint32_t>(expected - 1U) *
+                                                          SIM_CYCLES_PER_TICK)) <= expected);
+        CHECK(on_time_at_wake);
+        CHECK(Distance(sleep_shift) < SIM_SYSTICK_DIVIDER * STOPPED_COUNTS);
+    }
+    CHECK(SimSysTick::pend_clears == clears + 200U);
+}
+
+static void TestAbort(void) {
+    // A task became ready: nothing is touched
+    SimSysTick::sleep_status = eAbortSleep;
+    CHECK(Sleep(100, 0) == 0);
+    CHECK(sleep_handlers == 2U && sleep_shift == 0);
+    SimSysTick::sleep_status = eStandardSleep;
+}
+
+int main() {
+    SimSystem::Init();
+    SimSysTick::Init();
+    SimSysTick::access_cycles = SIM_ACCESS_CYCLES;
+
+    TestSetUp();
+    TestTimerWake();
+    TestEarlyWake();
+    TestPendingTick();
+    TestAbort();
+    CHECK(TicksMatchTime(SimSystem::tick_ms, SimSysTick::cycles, SimSysTick::Drift()));
+    printf("%s\n", failures ? "FAILED" : "OK");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,50 @@
+// Stand-in for the RAM of the application, linked with ram_map_image.ld so
+// that GNU ld writes a map file for RamMapTest.py: the task memory blocks of
+// main.cpp in .bss.task_memory, the FreeRTOS heap, initialised data and
+// other .bss. Built freestanding for the host and never run; the TCB is a
+// stand-in, so the sizes are not the target's.
+
+#include <stdint.h>
+
+#define TCB_STAND_IN_WORDS          (24U)       /// StaticTask_t differs on the port
+#define HEAP_SIZE                   (2048U)     /// configTOTAL_HEAP_SIZE
+
+typedef uint32_t StackType_t;
+
+struct StaticTask_t {
+    uint32_t words[TCB_STAND_IN_WORDS];
+};
+
+template <uint32_t StackWords>
+struct TaskMemory {
+    StackType_t stack[StackWords];
+    StaticTask_t tcb;
+};
+
+#define TASK_MEMORY __attribute__((section(".bss.task_memory"), aligned(8), used))
+
+// As main.cpp: idle, input, output, config flush, storage flush, CANopen timer, CANopen
+static TaskMemory<128> idle_task_memory TASK_MEMORY;
+static TaskMemory<128> input_update_task_memory TASK_MEMORY;
+static TaskMemory<128> output_update_task_memory TASK_MEMORY;
+static TaskMemory<192> config_flush_task_memory TASK_MEMORY;
+static TaskMemory<160> storage_flush_task_memory TASK_MEMORY;
+static TaskMemory<256> canopen_tmr_task_memory TASK_MEMORY;
+static TaskMemory<512> canopen_task_memory TASK_MEMORY;
+
+// C symbols, as heap_4.c and the libraries leave them
+extern "C" {
+uint8_t ucHeap[HEAP_SIZE];
+uint32_t boot_count = 1;
+uint8_t rx_buffer[300];
+
+void _start(void) {
+    idle_task_memory.stack[0] = input_update_task_memory.stack[0] + output_update_task_memory.stack[0] +
+                                config_flush_task_memory.stack[0] + storage_flush_task_memory.stack[0] +
+                                canopen_tmr_task_memory.stack[0] + canopen_task_memory.stack[0];
+    ucHeap[0] = rx_buffer[0];
+    boot_count++;
+    for (;;) {
+    }
+}
+}
@@ -0,0 +1,71 @@
+#!/usr/bin/env python3
+"""Tools/ram_map.py on the map GNU ld wrote for RamMapImage.cpp (ram_map_image.ld).
+
+    RamMapTest.py ram_map_image.map
+
+Checks the RAM region, the output sections, the task memory and heap
+totals and the report itself, then prints the report. The sizes follow
+RamMapImage.cpp: seven task blocks of main.cpp's stack sizes with a
+96-byte TCB stand-in, a 2 KB heap, 4 bytes of .data and 300 of other .bss.
+"""
+
+import contextlib
+import io
+import os
+import sys
+
+sys.path.insert(0, os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "Tools"))
+import ram_map  # noqa: E402
+
+RAM = ("RAM", 0x20000000, 96 * 1024)
+STACK_WORDS = (128, 128, 128, 192, 160, 256, 512)
+TCB = 96
+TASK_MEMORY = sum(words * 4 + TCB for words in STACK_WORDS)
+HEAP = 2048
+
+failures = 0
+
+
+def check(condition, what):
+    global failures
+    if not condition:
+        print("RamMapTest: %s failed" % what)
+        failures += 1
+
+
+def main(argv):
+    with open(argv[1], encoding="latin-1") as f:
+        regions, outputs, inputs = ram_map.parse(f)
+
+    ram = ram_map.ram_regions(regions)
+    check(ram == [RAM], "RAM region %s" % ram)
+    check(any(name == "FLASH" for name, _, _ in regions), "FLASH region")
+
+    sections = {name: (address, size) for name, address, size in outputs if size}
+    check(sections.get(".data", (0, 0))[1] == 4, ".data size")
+    check(".bss" in sections and ram_map.in_regions(sections[".bss"][0], ram), ".bss in RAM")
+    check(not ram_map.in_regions(sections.get(".text", (0, 0))[0], ram), ".text outside RAM")
+
+    # .bss.task_memory is longer than the name column, its address and size are on the next line
+    task_memory = [size for name, _, size, _ in inputs if name == ".bss.task_memory"]
+    check(task_memory == [TASK_MEMORY], ".bss.task_memory %s, expected %d" % (task_memory, TASK_MEMORY))
+    check(sum(size for name, _, size, _ in inputs if name.endswith(".ucHeap")) == HEAP, "ucHeap size")
+
+    report = io.StringIO()
+    with contextlib.redirect_stdout(report):
+        status = ram_map.main(["ram_map.py", argv[1]])
+    text = report.getvalue()
+    used = sum(size for address, size in sections.values() if ram_map.in_regions(address, ram))
+    check(status == 0, "ram_map.py status")
+    check("%7d of %7d bytes" % (used, RAM[2]) in text, "RAM usage line")
+    check("Static task memory (.bss.task_memory) %7d" % TASK_MEMORY in text, "task memory line")
+    check("FreeRTOS heap (ucHeap)                %7d" % HEAP in text, "heap line")
+    check("RamMapImage" in text.split("Largest RAM users\n")[-1], "largest RAM users")
+    print(text, end="")
+
+    print("FAILED" if failures else "OK")
+    return 1 if failures else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv))
@@ -0,0 +1,184 @@
+// SampleCodec: exact bytes of the zigzag varints, round trips of both orders
+// over full-scale steps and random walks, a short buffer and malformed data.
+// Prints the compressed size of synthetic input traces, the figures behind
+// the DELTA choice of the trend log (SampleCodec.h).
+
+#include "Check.h"
+#include "SampleCodec.h"
+#include <cmath>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#define TEST_CHANNELS               (11U)
+
+int failures = 0;
+
+typedef std::vector<uint8_t> Bytes;
+typedef std::vector<std::vector<uint16_t>> Trace;
+
+static Bytes Encode(SampleEncoder &encoder, const std::vector<uint16_t> &values) {
+    uint8_t buffer[SampleCodecMaxSize(SAMPLE_CODEC_MAX_CHANNELS)];
+    const size_t size = encoder.Encode(values.data(), buffer, sizeof(buffer));
+    return Bytes(buffer, buffer + size);
+}
+
+static void TestBytes(void) {
+    SampleEncoder encoder;
+    encoder.Reset(3);
+
+    // Mask little-endian, zigzag 1 -> 2, -1 -> 1, 64 -> 128 (two varint bytes)
+    CHECK(Encode(encoder, {1, 0, 64}) == Bytes({0x05, 0x00, 0x02, 0x80, 0x01}));
+    CHECK(Encode(encoder, {0, 0, 64}) == Bytes({0x01, 0x00, 0x01}));
+    CHECK(Encode(encoder, {0, 0, 64}) == Bytes({0x00, 0x00}));
+    // Full-scale step: zigzag 131070 needs all three bytes
+    CHECK(Encode(encoder, {0, 0xFFFF, 64}) == Bytes({0x02, 0x00, 0xFE, 0xFF, 0x07}));
+    CHECK(encoder.GetCount() == 4);
+
+    // A steady ramp costs only the mask once the slope is known
+    encoder.Reset(1, SampleCodecOrder::DELTA_OF_DELTA);
+    CHECK(Encode(encoder, {10}) == Bytes({0x01, 0x00, 0x14}));
+    CHECK(Encode(encoder, {15}) == Bytes({0x01, 0x00, 0x0A}));
+    CHECK(Encode(encoder, {20}) == Bytes({0x00, 0x00}));
+    CHECK(Encode(encoder, {24}) == Bytes({0x01, 0x00, 0x01}));
+}
+
+static void CheckRoundTrip(const Trace &trace, uint8_t channels, SampleCodecOrder order) {
+    SampleEncoder encoder;
+    SampleDecoder decoder;
+    encoder.Reset(channels, order);
+    decoder.Reset(channels, order);
+
+    for (const std::vector<uint16_t> &values : trace) {
+        uint8_t buffer[SampleCodecMaxSize(SAMPLE_CODEC_MAX_CHANNELS)];
+        uint16_t decoded[SAMPLE_CODEC_MAX_CHANNELS];
+        const size_t size = encoder.Encode(values.data(), buffer, sizeof(buffer));
+        CHECK(size >= 2U && size <= SampleCodecMaxSize(channels));
+        CHECK(decoder.Decode(buffer, size, decoded) == size);
+        CHECK(memcmp(decoded, values.data(), channels * sizeof(uint16_t)) == 0);
+        if (failures) {
+            return;
+        }
+    }
+}
+
+static void TestRoundTrip(void) {
+    std::mt19937 rng(5);
+    Trace extremes;
+    Trace walk;
+
+    // Full-scale swings give the largest residuals of both orders
+    for (uint32_t i = 0; i < 64; i++) {
+        std::vector<uint16_t> values(SAMPLE_CODEC_MAX_CHANNELS);
+        for (uint32_t ch = 0; ch < values.size(); ch++) {
+            values[ch] = ((i + ch) % 3 == 0) ? 0xFFFFU : (rng() % 2 ? 0U : static_cast<uint16_t>(rng()));
+        }
+        extremes.push_back(values);
+    }
+    std::vector<uint16_t> values(SAMPLE_CODEC_MAX_CHANNELS, 5000);
+    for (uint32_t i = 0; i < 20000; i++) {
+        for (uint16_t &value : values) {
+            if (rng() % 3 == 0) {
+                value = static_cast<uint16_t>(value + rng() % 201U - 100U);
+            }
+        }
+        walk.push_back(values);
+    }
+
+    for (SampleCodecOrder order : {SampleCodecOrder::DELTA, SampleCodecOrder::DELTA_OF_DELTA}) {
+        CheckRoundTrip(extremes, SAMPLE_CODEC_MAX_CHANNELS, order);
+        CheckRoundTrip(walk, TEST_CHANNELS, order);
+        CheckRoundTrip(walk, 1, order);
+    }
+}
+
+static void TestErrors(void) {
+    SampleEncoder encoder;
+    SampleDecoder decoder;
+    uint8_t buffer[SampleCodecMaxSize(TEST_CHANNELS)];
+    uint16_t values[TEST_CHANNELS] = {1000, 2000};
+    uint16_t decoded[TEST_CHANNELS];
+    encoder.Reset(TEST_CHANNELS);
+    decoder.Reset(TEST_CHANNELS);
+
+    // Too little space: nothing written, the state does not move
+    CHECK(encoder.Encode(values, buffer, 5) == 0);
+    CHECK(encoder.GetCount() == 0);
+    const size_t size = encoder.Encode(values, buffer, sizeof(buffer));
+    CHECK(size == 6);
+
+    // Truncated data is rejected without moving the state
+    CHECK(decoder.Decode(buffer, 1, decoded) == 0);
+    CHECK(decoder.Decode(buffer, size - 1U, decoded) == 0);
+    CHECK(decoder.Decode(buffer, size, decoded) == size);
+    CHECK(decoded[0] == 1000 && decoded[1] == 2000 && decoded[2] == 0);
+
+    const uint8_t beyond_channels[] = {0x00, 0x08, 0x02};
+    const uint8_t long_varint[] = {0x01, 0x00, 0x80, 0x80, 0x80, 0x01};
+    const uint8_t below_zero[] = {0x04, 0x00, 0x01};
+    CHECK(decoder.Decode(beyond_channels, sizeof(beyond_channels), decoded) == 0);
+    CHECK(decoder.Decode(long_varint, sizeof(long_varint), decoded) == 0);
+    CHECK(decoder.Decode(below_zero, sizeof(below_zero), decoded) == 0);
+}
+
+/**
+ * @brief Encoded bytes per sample, the codec restarting every block_samples
+ */
+static double BytesPerSample(const Trace &trace, SampleCodecOrder order, uint32_t block_samples) {
+    SampleEncoder encoder;
+    size_t total = 0;
+
+    for (size_t i = 0; i < trace.size(); i++) {
+        if (i % block_samples == 0) {
+            encoder.Reset(TEST_CHANNELS, order);
+        }
+        total += Encode(encoder, trace[i]).size();
+    }
+    return static_cast<double>(total) / trace.size();
+}
+
+static void ReportCompression(void) {
+    const char *names[] = {"idle inputs", "0-10 V, +-2 mV noise", "temperature ramps", "mixed P-Block unit"};
+    const uint32_t samples = 50000;
+
+    printf("%-22s %8s %8s %8s\n", "trace (11 channels)", "raw", "delta", "dod");
+    for (uint32_t kind = 0; kind < 4; kind++) {
+        std::mt19937 rng(kind);
+        double temperature[TEST_CHANNELS];
+        Trace trace;
+        for (uint32_t ch = 0; ch < TEST_CHANNELS; ch++) {
+            temperature[ch] = 200.0 + ch * 10.0;
+        }
+        for (uint32_t i = 0; i < samples; i++) {
+            std::vector<uint16_t> values(TEST_CHANNELS);
+            for (uint32_t ch = 0; ch < TEST_CHANNELS; ch++) {
+                int32_t value = 0;
+                const bool ramp = kind == 2 || (kind == 3 && ch >= 3 && ch < 7);
+                if (ramp) {
+                    temperature[ch] += 0.02 * std::sin(i / 3000.0 + ch);
+                    value = static_cast<int32_t>(temperature[ch]);
+                } else if (kind == 0) {
+                    value = ch == 0 ? 5000 : 0;
+                } else if (kind == 1 || ch < 3) {
+                    value = 5000 + static_cast<int32_t>(ch * 300U) + static_cast<int32_t>(rng() % 5U) - 2;
+                } else if (ch < 9) {
+                    value = (i / 5000U) % 2U ? 10000 : 0;
+                }
+                values[ch] = static_cast<uint16_t>(value);
+            }
+            trace.push_back(values);
+        }
+        printf("%-22s %8.2f %8.2f %8.2f  bytes/sample\n", names[kind], TEST_CHANNELS * 2.0,
+               BytesPerSample(trace, SampleCodecOrder::DELTA, 100),
+               BytesPerSample(trace, SampleCodecOrder::DELTA_OF_DELTA, 100));
+    }
+}
+
+int main() {
+    TestBytes();
+    TestRoundTrip();
+    TestErrors();
+    ReportCompression();
+    printf("%s\n", failures ? "FAILED" : "OK");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,44 @@
+#ifndef __SIM_FLASH_H__
+#define __SIM_FLASH_H__
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define SIM_FLASH_BASE              (0x08000000U)
+#define SIM_FLASH_SIZE              (0x100000U)
+#define SIM_SECTOR_SIZE             (0x800U)
+#define SIM_NO_POWER_CUT            (-1)
+#define SIM_SECTOR_ERASE_US         (30000U)    /// 2 KB sector erase, datasheet typical
+#define SIM_WORD_PROGRAM_US         (42U)       /// one 32-bit word
+
+/**
+ * @brief Thrown by the flash operation that runs out of power
+ */
+struct SimPowerCut {
+};
+
+/**
+ * @brief Host flash: RAM mapped at the device flash addresses
+ * Erase fills a sector with 0xFF, program only writes an erased word (a
+ * second write of a programmed word fails, as on the device).
+ *
+ * Power cuts: with power_left set, the operation after that many more
+ * erases and word programs throws SimPowerCut before touching the flash.
+ * The test catches it, as a reset, and calls the module's Init() again.
+ */
+class SimFlash {
+public:
+    /**
+     * @brief Map the flash and erase all of it
+     */
+    static void Init(void);
+
+    static uint8_t *At(uint32_t address) { return reinterpret_cast<uint8_t *>(static_cast<uintptr_t>(address)); }
+
+    static int32_t power_left;      /// operations until the power cut, SIM_NO_POWER_CUT for none
+    static uint32_t sector_erases;
+    static uint32_t word_programs;
+    static uint32_t program_errors;
+};
+
+#endif // __SIM_FLASH_H__
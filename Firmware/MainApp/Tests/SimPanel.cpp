@@ -0,0 +1,149 @@
+#include "SimPanel.h"
+#include <cassert>
+
+#define ST7567_CONTRAST             (0x81U)     /// followed by the contrast byte
+
+uint8_t SimPanel::ram[SIM_PANEL_PAGES][DISPLAY_WIDTH];
+uint32_t SimPanel::commands;
+uint32_t SimPanel::data_bytes;
+uint32_t SimPanel::dropped_bytes;
+uint32_t SimPanel::dma_transfers;
+
+static uint8_t page;
+static uint8_t column;
+static bool argument_next;              /// the next command byte is an argument
+static bool spi_enabled;
+static bool dma_interrupt;
+static bool dma_done;
+
+extern "C" void DMA1_Channel5_IRQHandler(void);
+
+static void Receive(uint8_t byte) {
+    const uint32_t pins = DISPLAY_PORT->odt;
+    if ((pins & DISPLAY_PIN_CS) != 0 || !spi_enabled) {
+        SimPanel::dropped_bytes++;
+        return;
+    }
+    if ((pins & DISPLAY_PIN_DC) == 0) {
+        SimPanel::commands++;
+        if (argument_next) {
+            argument_next = false;
+        } else if ((byte & 0xF0U) == 0xB0U) {
+            page = byte & 0x0FU;
+        } else if ((byte & 0xF0U) == 0x10U) {
+            column = static_cast<uint8_t>((column & 0x0FU) | (byte & 0x0FU) << 4);
+        } else if ((byte & 0xF0U) == 0x00U) {
+            column = static_cast<uint8_t>((column & 0xF0U) | (byte & 0x0FU));
+        } else if (byte == ST7567_CONTRAST) {
+            argument_next = true;
+        }
+        return;
+    }
+    if (page >= SIM_PANEL_PAGES || column >= DISPLAY_WIDTH) {
+        SimPanel::dropped_bytes++;
+        return;
+    }
+    SimPanel::ram[page][column++] = byte;
+    SimPanel::data_bytes++;
+}
+
+void SimPanel::Init(uint8_t fill) {
+    page = 0;
+    column = 0;
+    argument_next = false;
+    spi_enabled = false;
+    dma_interrupt = false;
+    dma_done = false;
+    sim_dma1_channel5 = dma_channel_type();
+    Clear(fill);
+}
+
+void SimPanel::Clear(uint8_t fill) {
+    memset(ram, fill, sizeof(ram));
+    commands = 0;
+    data_bytes = 0;
+    dropped_bytes = 0;
+    dma_transfers = 0;
+}
+
+void SimPanel::RunDma(void) {
+    while ((DMA1_CHANNEL5->ctrl & 1U) != 0 && DMA1_CHANNEL5->dtcnt != 0) {
+        assert(DMA1_CHANNEL5->paddr == static_cast<uint32_t>(reinterpret_cast<uintptr_t>(&SPI2->dt)));
+        const uint8_t *source = reinterpret_cast<const uint8_t *>(static_cast<uintptr_t>(DMA1_CHANNEL5->maddr));
+        for (uint32_t i = 0; i < DMA1_CHANNEL5->dtcnt; i++) {
+            Receive(source[i]);
+        }
+        DMA1_CHANNEL5->dtcnt = 0;
+        dma_transfers++;
+        dma_done = true;
+        if (dma_interrupt) {
+            DMA1_Channel5_IRQHandler();
+        }
+    }
+}
+
+void spi_init(spi_type *spi_x, spi_init_type *spi_init_struct) {
+    (void)spi_x;
+    assert(spi_init_struct->frame_bit_num == SPI_FRAME_8BIT && spi_init_struct->first_bit_transmission == SPI_FIRST_BIT_MSB);
+}
+
+void spi_enable(spi_type *spi_x, confirm_state new_state) {
+    (void)spi_x;
+    spi_enabled = new_state == TRUE;
+}
+
+void spi_i2s_dma_transmitter_enable(spi_type *spi_x, confirm_state new_state) {
+    (void)spi_x;
+    (void)new_state;
+}
+
+// Bytes leave at once: the buffer is always empty and the bus never busy
+flag_status spi_i2s_flag_get(spi_type *spi_x, uint32_t spi_i2s_flag) {
+    (void)spi_x;
+    return spi_i2s_flag == SPI_I2S_TDBE_FLAG ? SET : RESET;
+}
+
+void spi_i2s_data_transmit(spi_type *spi_x, uint16_t tx_data) {
+    (void)spi_x;
+    Receive(static_cast<uint8_t>(tx_data));
+}
+
+void dma_reset(dma_channel_type *dmax_channely) {
+    *dmax_channely = dma_channel_type();
+    dma_interrupt = false;
+    dma_done = false;
+}
+
+void dma_init(dma_channel_type *dmax_channely, dma_init_type *dma_init_struct) {
+    assert(dma_init_struct->direction == DMA_DIR_MEMORY_TO_PERIPHERAL && dma_init_struct->memory_inc_enable &&
+           !dma_init_struct->peripheral_inc_enable && !dma_init_struct->loop_mode_enable);
+    dmax_channely->paddr = dma_init_struct->peripheral_base_addr;
+    dmax_channely->maddr = dma_init_struct->memory_base_addr;
+    dmax_channely->dtcnt = dma_init_struct->buffer_size;
+}
+
+void dma_interrupt_enable(dma_channel_type *dmax_channely, uint32_t dma_int, confirm_state new_state) {
+    (void)dmax_channely;
+    if (dma_int & DMA_FDT_INT) {
+        dma_interrupt = new_state == TRUE;
+    }
+}
+
+void dma_data_number_set(dma_channel_type *dmax_channely, uint16_t data_number) {
+    assert((dmax_channely->ctrl & 1U) == 0);    // only while the channel is off
+    dmax_channely->dtcnt = data_number;
+}
+
+void dma_channel_enable(dma_channel_type *dmax_channely, confirm_state new_state) {
+    dmax_channely->ctrl = new_state == TRUE ? (dmax_channely->ctrl | 1U) : (dmax_channely->ctrl & ~1U);
+}
+
+flag_status dma_flag_get(uint32_t dmax_flag) {
+    return dmax_flag == DMA1_FDT5_FLAG && dma_done ? SET : RESET;
+}
+
+void dma_flag_clear(uint32_t dmax_flag) {
+    if (dmax_flag == DMA1_FDT5_FLAG) {
+        dma_done = false;
+    }
+}
@@ -0,0 +1,49 @@
+#ifndef __SIM_PANEL_H__
+#define __SIM_PANEL_H__
+
+#include <stdint.h>
+#include "DisplayPanel.h"
+
+#define SIM_PANEL_PAGES             (DISPLAY_HEIGHT / DISPLAY_PAGE_LINES)
+
+/**
+ * @brief Host ST7567 on SPI2 and DMA1 channel 5, the framebuffer the flushes land in
+ * Every byte sent on SPI2 (directly or by DMA) reaches the controller at
+ * once. With DC low it is a command: page address, column address high and
+ * low nibble, 0x81 with its contrast byte; others are accepted and ignored.
+ * With DC high it is display data, stored in ram at the current page and
+ * column, and the column moves on by one. Bytes sent while CS is high, and
+ * data outside the page RAM, are counted and dropped.
+ *
+ * The DMA channel moves its bytes from memory to the SPI data register when
+ * the test calls RunDma(). At the end of each transfer it sets the transfer
+ * complete flag and, with the interrupt enabled, calls the IRQ handler,
+ * which may start the next transfer.
+ */
+class SimPanel {
+public:
+    /**
+     * @brief Reset SPI2, the DMA channel and the controller, then Clear()
+     */
+    static void Init(uint8_t fill);
+
+    /**
+     * @brief Fill the page RAM with fill and zero the counters
+     */
+    static void Clear(uint8_t fill);
+
+    /**
+     * @brief Run DMA transfers until the channel stays idle
+     */
+    static void RunDma(void);
+
+    static bool Pixel(uint32_t x, uint32_t y) { return (ram[y / DISPLAY_PAGE_LINES][x] >> (y % DISPLAY_PAGE_LINES)) & 1U; }
+
+    static uint8_t ram[SIM_PANEL_PAGES][DISPLAY_WIDTH];
+    static uint32_t commands;           /// command bytes received
+    static uint32_t data_bytes;         /// display data bytes stored
+    static uint32_t dropped_bytes;      /// sent with CS high or outside the page RAM
+    static uint32_t dma_transfers;
+};
+
+#endif // __SIM_PANEL_H__
@@ -0,0 +1,200 @@
+#include "SimSysTick.h"
+#include "SimSystem.h"
+#include <cassert>
+
+uint32_t SimSysTick::access_cycles;
+eSleepModeStatus SimSysTick::sleep_status;
+uint64_t SimSysTick::cycles;
+uint64_t SimSysTick::stopped_cycles;
+uint64_t SimSysTick::entry_stop;
+uint64_t SimSysTick::exit_stop;
+uint32_t SimSysTick::pend_clears;
+uint32_t SimSysTick::tick_handlers;
+int64_t SimSysTick::drift;
+
+static uint32_t ctrl;                       // ENABLE, TICKINT, CLKSOURCE
+static bool count_flag;
+static uint32_t load;
+static uint32_t value;
+static bool tick_pending;
+static uint64_t tick_pended_at;
+static bool irq_masked;
+static uint64_t interrupt_at;               // UINT64_MAX for none
+static uint64_t stop_start;
+static uint32_t stops_since_mask;
+
+static void Pend(void) {
+    count_flag = true;
+    if ((ctrl & SysTick_CTRL_TICKINT_Msk) && !tick_pending) {
+        tick_pending = true;
+        tick_pended_at = SimSysTick::cycles;
+    }
+}
+
+/**
+ * @brief Move time on to target, or only up to the next count to 0 with stop_at_zero
+ */
+static void Advance(uint64_t target, bool stop_at_zero) {
+    while (SimSysTick::cycles < target) {
+        if (!(ctrl & SysTick_CTRL_ENABLE_Msk)) {
+            SimSysTick::stopped_cycles += target - SimSysTick::cycles;
+            SimSysTick::cycles = target;
+            return;
+        }
+        const uint64_t divider = (ctrl & SysTick_CTRL_CLKSOURCE_Msk) ? 1U : SIM_SYSTICK_DIVIDER;
+        const uint64_t next = (SimSysTick::cycles / divider + 1U) * divider;
+        if (next > target) {
+            SimSysTick::cycles = target;
+            return;
+        }
+        if (value == 0) {
+            SimSysTick::cycles = next;
+            value = load;
+            continue;
+        }
+        const uint64_t zero_at = next + (value - 1U) * divider;
+        if (zero_at > target) {
+            value -= static_cast<uint32_t>((target - next) / divider + 1U);
+            SimSysTick::cycles = target;
+            return;
+        }
+        SimSysTick::cycles = zero_at;
+        value = 0;
+        Pend();
+        if (stop_at_zero) {
+            return;
+        }
+    }
+}
+
+/**
+ * @brief The kernel tick handler, if it may run
+ */
+static void ServeTick(void) {
+    if (irq_masked || !tick_pending) {
+        return;
+    }
+    tick_pending = false;
+    SimSystem::tick_ms++;
+    SimSysTick::tick_handlers++;
+    SimSysTick::drift = static_cast<int64_t>(SimSystem::tick_ms) * SIM_CYCLES_PER_TICK -
+                        static_cast<int64_t>(tick_pended_at);
+}
+
+void SimSysTick::Init(void) {
+    cycles = 0;
+    stopped_cycles = 0;
+    entry_stop = 0;
+    exit_stop = 0;
+    pend_clears = 0;
+    tick_handlers = 0;
+    drift = 0;
+    sleep_status = eStandardSleep;
+    SimSystem::tick_ms = 0;
+    ctrl = SysTick_CTRL_TICKINT_Msk | SysTick_CTRL_ENABLE_Msk;
+    count_flag = false;
+    load = SIM_CYCLES_PER_TICK / SIM_SYSTICK_DIVIDER - 1U;
+    value = 0;
+    tick_pending = false;
+    irq_masked = false;
+    interrupt_at = UINT64_MAX;
+}
+
+void SimSysTick::Run(uint64_t run_cycles) {
+    const uint64_t target = cycles + run_cycles;
+    assert(!irq_masked);
+    while (cycles < target) {
+        Advance(target, true);
+        ServeTick();
+    }
+}
+
+void SimSysTick::Interrupt(uint64_t at) {
+    interrupt_at = at;
+}
+
+uint32_t sim_core_read(SimCoreRegister reg) {
+    Advance(SimSysTick::cycles + SimSysTick::access_cycles, false);
+    switch (reg) {
+    case SimCoreRegister::SYST_CTRL: {
+        const uint32_t read = ctrl | (count_flag ? SysTick_CTRL_COUNTFLAG_Msk : 0U);
+        count_flag = false;
+        return read;
+    }
+    case SimCoreRegister::SYST_LOAD:
+        return load;
+    case SimCoreRegister::SYST_VAL:
+        return value;
+    case SimCoreRegister::SCB_ICSR:
+        return tick_pending ? SCB_ICSR_PENDSTSET_Msk : 0U;
+    }
+    return 0;
+}
+
+void sim_core_write(SimCoreRegister reg, uint32_t written) {
+    Advance(SimSysTick::cycles + SimSysTick::access_cycles, false);
+    switch (reg) {
+    case SimCoreRegister::SYST_CTRL: {
+        const bool was_enabled = ctrl & SysTick_CTRL_ENABLE_Msk;
+        ctrl = written & (SysTick_CTRL_ENABLE_Msk | SysTick_CTRL_TICKINT_Msk | SysTick_CTRL_CLKSOURCE_Msk);
+        const bool enabled = ctrl & SysTick_CTRL_ENABLE_Msk;
+        if (was_enabled && !enabled) {
+            stop_start = SimSysTick::cycles;
+        } else if (!was_enabled && enabled) {
+            if (stops_since_mask++ == 0) {
+                SimSysTick::entry_stop = SimSysTick::cycles - stop_start;
+                SimSysTick::exit_stop = 0;
+            } else {
+                SimSysTick::exit_stop += SimSysTick::cycles - stop_start;
+            }
+        }
+        break;
+    }
+    case SimCoreRegister::SYST_LOAD:
+        load = written & SysTick_LOAD_RELOAD_Msk;
+        break;
+    case SimCoreRegister::SYST_VAL:
+        value = 0;
+        count_flag = false;
+        break;
+    case SimCoreRegister::SCB_ICSR:
+        if ((written & SCB_ICSR_PENDSTCLR_Msk) && tick_pending) {
+            tick_pending = false;
+            SimSysTick::pend_clears++;
+        }
+        if (written & SCB_ICSR_PENDSTSET_Msk) {
+            tick_pending = true;
+            tick_pended_at = SimSysTick::cycles;
+        }
+        break;
+    }
+}
+
+void __disable_irq(void) {
+    irq_masked = true;
+    stops_since_mask = 0;
+}
+
+void __enable_irq(void) {
+    irq_masked = false;
+    if (interrupt_at <= SimSysTick::cycles) {
+        interrupt_at = UINT64_MAX;
+    }
+    ServeTick();
+}
+
+void __WFI(void) {
+    // Pending requests end the sleep even while masked
+    assert(interrupt_at != UINT64_MAX || (ctrl & SysTick_CTRL_ENABLE_Msk));
+    while (!tick_pending && SimSysTick::cycles < interrupt_at) {
+        Advance(interrupt_at, true);
+    }
+}
+
+eSleepModeStatus eTaskConfirmSleepModeStatus(void) {
+    return SimSysTick::sleep_status;
+}
+
+void vTaskStepTick(TickType_t ticks) {
+    SimSystem::tick_ms += ticks;
+}
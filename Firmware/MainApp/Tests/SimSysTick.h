@@ -0,0 +1,62 @@
+#ifndef __SIM_SYSTICK_H__
+#define __SIM_SYSTICK_H__
+
+#include <stdint.h>
+#include "FreeRTOS.h"
+#include "at32f403a_407.h"
+
+#define SIM_SYSTICK_DIVIDER         (configCPU_CLOCK_HZ / configSYSTICK_CLOCK_HZ)
+#define SIM_CYCLES_PER_TICK         (configCPU_CLOCK_HZ / configTICK_RATE_HZ)
+
+/**
+ * @brief Host Cortex-M SysTick, interrupt mask and kernel tick
+ * Time is counted in core cycles. The 24-bit counter runs on every core
+ * cycle with CLKSOURCE set, else on every SIM_SYSTICK_DIVIDER-th. As on the
+ * device: an enabled counter at 0 loads LOAD on its next clock, counting
+ * from 1 to 0 sets COUNTFLAG and, with TICKINT, pends the SysTick
+ * exception; reading CTRL or writing VAL clears COUNTFLAG, writing VAL
+ * clears the counter.
+ *
+ * Every SysTick or ICSR access first moves time on by access_cycles, which
+ * stands for the code around it. __WFI() runs until the SysTick exception
+ * or the interrupt set with Interrupt() is pending. The pended exception is
+ * the kernel tick handler: it runs while interrupts are enabled, adds one
+ * to SimSystem::tick_ms and records how far from the tick grid it ran.
+ * vTaskStepTick() adds to tick_ms the same way the kernel does.
+ */
+class SimSysTick {
+public:
+    /**
+     * @brief Counter as the port starts it: one tick period, reference clock, time 0
+     */
+    static void Init(void);
+
+    /**
+     * @brief Run with interrupts enabled for cycles core cycles, serving the ticks
+     */
+    static void Run(uint64_t cycles);
+
+    /**
+     * @brief Interrupt request at core cycle at, ends a __WFI() reaching it
+     */
+    static void Interrupt(uint64_t at);
+
+    /**
+     * @brief Core cycles of kernel time ahead of real time, from the last tick handler
+     * Ticks are due every SIM_CYCLES_PER_TICK from time 0.
+     */
+    static int64_t Drift(void) { return drift; }
+
+    static uint32_t access_cycles;          /// time one register access stands for
+    static eSleepModeStatus sleep_status;   /// eTaskConfirmSleepModeStatus() result
+
+    static uint64_t cycles;                 /// time since Init()
+    static uint64_t stopped_cycles;         /// time the counter was disabled
+    static uint64_t entry_stop;             /// first stopped stretch after the latest __disable_irq()
+    static uint64_t exit_stop;              /// the stopped stretches after it
+    static uint32_t pend_clears;            /// SysTick exceptions cleared through ICSR
+    static uint32_t tick_handlers;          /// tick handler runs
+    static int64_t drift;
+};
+
+#endif // __SIM_SYSTICK_H__
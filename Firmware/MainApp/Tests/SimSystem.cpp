@@ -0,0 +1,27 @@
+#include "SimSystem.h"
+#include "FreeRTOS.h"
+#include "at32f403a_407.h"
+#include "P-Block-struct.h"
+#include <cstring>
+
+uint32_t SimSystem::tick_ms;
+uint32_t SimSystem::rtc_s;
+uint16_t SimSystem::inputs[SIM_UNIVERSAL_INPUTS];
+
+void SimSystem::Init(void) {
+    tick_ms = 0;
+    rtc_s = 0;
+    memset(inputs, 0, sizeof(inputs));
+}
+
+TickType_t xTaskGetTickCount(void) {
+    return SimSystem::tick_ms;
+}
+
+uint32_t rtc_counter_get(void) {
+    return SimSystem::rtc_s;
+}
+
+uint16_t PBlockRegisters_t::GetUniversalInput(uint8_t input_number) {
+    return (input_number >= 1U && input_number <= SIM_UNIVERSAL_INPUTS) ? SimSystem::inputs[input_number - 1U] : 0U;
+}
@@ -0,0 +1,26 @@
+#ifndef __SIM_SYSTEM_H__
+#define __SIM_SYSTEM_H__
+
+#include <stdint.h>
+
+#define SIM_UNIVERSAL_INPUTS        (11U)
+
+/**
+ * @brief Host time and inputs seen by the libraries under test
+ * xTaskGetTickCount() returns tick_ms, rtc_counter_get() returns rtc_s and
+ * PBlockRegisters_t::GetUniversalInput(n) returns inputs[n - 1]. The tests
+ * advance them by hand.
+ */
+class SimSystem {
+public:
+    /**
+     * @brief Zero the clocks and inputs
+     */
+    static void Init(void);
+
+    static uint32_t tick_ms;
+    static uint32_t rtc_s;
+    static uint16_t inputs[SIM_UNIVERSAL_INPUTS];
+};
+
+#endif // __SIM_SYSTEM_H__
@@ -0,0 +1,153 @@
+#include "SimTimer.h"
+
+SimTimer::Isr SimTimer::isr;
+bool SimTimer::levels[SIM_TIMER_CHANNELS];
+tmr_output_control_mode_type SimTimer::modes[SIM_TIMER_CHANNELS];
+std::vector<SimTimerEdge> SimTimer::edges;
+uint32_t SimTimer::late_values;
+
+static uint32_t *ChannelValue(tmr_type *tmr_x, uint8_t index) {
+    uint32_t *const values[SIM_TIMER_CHANNELS] = {&tmr_x->c1dt, &tmr_x->c2dt, &tmr_x->c3dt, &tmr_x->c4dt};
+    return values[index];
+}
+
+static uint8_t ChannelIndex(tmr_channel_select_type tmr_channel) {
+    return static_cast<uint8_t>(tmr_channel / 4);
+}
+
+static void SetLevel(uint8_t index, bool level) {
+    if (SimTimer::levels[index] != level) {
+        SimTimer::levels[index] = level;
+        SimTimer::edges.push_back({static_cast<uint8_t>(index + 1U), TMR5->cval, level});
+    }
+}
+
+void SimTimer::Init(Isr handler, uint32_t start) {
+    sim_tmr5 = tmr_type();
+    sim_tmr5.cval = start;
+    isr = handler;
+    for (uint8_t i = 0; i < SIM_TIMER_CHANNELS; i++) {
+        levels[i] = false;
+        modes[i] = TMR_OUTPUT_CONTROL_OFF;
+    }
+    edges.clear();
+    late_values = 0;
+}
+
+void SimTimer::RunTo(uint32_t at) {
+    while (true) {
+        // Nearest compare value ahead of the counter, CH1 is a capture channel
+        uint8_t next = SIM_TIMER_CHANNELS;
+        uint32_t next_distance = at - TMR5->cval;
+        for (uint8_t i = 1; i < SIM_TIMER_CHANNELS; i++) {
+            const uint32_t distance = *ChannelValue(TMR5, i) - TMR5->cval;
+            if (distance != 0 && distance <= next_distance) {
+                next = i;
+                next_distance = distance;
+            }
+        }
+        if (next == SIM_TIMER_CHANNELS) {
+            TMR5->cval = at;
+            return;
+        }
+
+        TMR5->cval += next_distance;
+        const uint32_t flag = TMR_C1_FLAG << next;
+        TMR5->ists |= flag;
+        if (modes[next] == TMR_OUTPUT_CONTROL_HIGH) {
+            SetLevel(next, true);
+        } else if (modes[next] == TMR_OUTPUT_CONTROL_LOW) {
+            SetLevel(next, false);
+        }
+        if ((TMR5->iden & flag) && isr != nullptr) {
+            isr();
+        }
+    }
+}
+
+void SimTimer::Capture(uint32_t at) {
+    RunTo(at);
+    TMR5->c1dt = at;
+    TMR5->ists |= TMR_C1_FLAG;
+    if ((TMR5->iden & TMR_C1_INT) && isr != nullptr) {
+        isr();
+    }
+}
+
+void tmr_32_bit_function_enable(tmr_type *tmr_x, confirm_state new_state) {
+    (void)tmr_x;
+    (void)new_state;
+}
+
+void tmr_base_init(tmr_type *tmr_x, uint32_t tmr_pr, uint32_t tmr_div) {
+    (void)tmr_x;
+    (void)tmr_pr;
+    (void)tmr_div;
+}
+
+void tmr_cnt_dir_set(tmr_type *tmr_x, tmr_count_mode_type tmr_cnt_dir) {
+    (void)tmr_x;
+    (void)tmr_cnt_dir;
+}
+
+void tmr_counter_enable(tmr_type *tmr_x, confirm_state new_state) {
+    (void)tmr_x;
+    (void)new_state;
+}
+
+uint32_t tmr_counter_value_get(tmr_type *tmr_x) {
+    return tmr_x->cval;
+}
+
+void tmr_input_channel_init(tmr_type *tmr_x, tmr_input_config_type *input_struct, tmr_channel_input_divider_type divider_factor) {
+    (void)tmr_x;
+    (void)input_struct;
+    (void)divider_factor;
+}
+
+void tmr_output_default_para_init(tmr_output_config_type *tmr_output_struct) {
+    *tmr_output_struct = tmr_output_config_type();
+}
+
+void tmr_output_channel_config(tmr_type *tmr_x, tmr_channel_select_type tmr_channel, tmr_output_config_type *tmr_output_struct) {
+    tmr_output_channel_mode_select(tmr_x, tmr_channel, tmr_output_struct->oc_mode);
+}
+
+void tmr_output_channel_mode_select(tmr_type *tmr_x, tmr_channel_select_type tmr_channel, tmr_output_control_mode_type oc_mode) {
+    (void)tmr_x;
+    const uint8_t index = ChannelIndex(tmr_channel);
+    SimTimer::modes[index] = oc_mode;
+    if (oc_mode == TMR_OUTPUT_CONTROL_FORCE_LOW) {
+        SetLevel(index, false);
+    } else if (oc_mode == TMR_OUTPUT_CONTROL_FORCE_HIGH) {
+        SetLevel(index, true);
+    }
+}
+
+void tmr_channel_value_set(tmr_type *tmr_x, tmr_channel_select_type tmr_channel, uint32_t tmr_channel_value) {
+    // At or behind the counter: the match comes only after the wrap
+    if (static_cast<int32_t>(tmr_channel_value - tmr_x->cval) <= 0) {
+        SimTimer::late_values++;
+    }
+    *ChannelValue(tmr_x, ChannelIndex(tmr_channel)) = tmr_channel_value;
+}
+
+uint32_t tmr_channel_value_get(tmr_type *tmr_x, tmr_channel_select_type tmr_channel) {
+    return *ChannelValue(tmr_x, ChannelIndex(tmr_channel));
+}
+
+void tmr_interrupt_enable(tmr_type *tmr_x, uint32_t tmr_interrupt, confirm_state new_state) {
+    if (new_state == TRUE) {
+        tmr_x->iden |= tmr_interrupt;
+    } else {
+        tmr_x->iden &= ~tmr_interrupt;
+    }
+}
+
+flag_status tmr_flag_get(tmr_type *tmr_x, uint32_t tmr_flag) {
+    return (tmr_x->ists & tmr_flag) != 0 ? SET : RESET;
+}
+
+void tmr_flag_clear(tmr_type *tmr_x, uint32_t tmr_flag) {
+    tmr_x->ists &= ~tmr_flag;
+}
@@ -0,0 +1,58 @@
+#ifndef __SIM_TIMER_H__
+#define __SIM_TIMER_H__
+
+#include <stdint.h>
+#include <vector>
+#include "at32f403a_407.h"
+
+#define SIM_TIMER_CHANNELS          (4U)
+
+/**
+ * @brief Level change of a compare output
+ */
+struct SimTimerEdge {
+    uint8_t channel;                    /// 1..4
+    uint32_t at;                        /// counter value of the change
+    bool level;
+};
+
+/**
+ * @brief Host TMR5: a 32-bit up-counter with four capture/compare channels
+ * The test moves the counter with RunTo(); every compare value passed on
+ * the way sets its flag, applies the channel's output mode (HIGH/LOW at the
+ * match, FORCE_* at once) and, with the interrupt enabled, calls the ISR
+ * with the counter at the match, in counter order. Capture() latches CH1
+ * and calls the ISR the same way. A compare value set at or behind the
+ * counter is not matched until the counter wraps, as on the device, and is
+ * counted in late_values.
+ */
+class SimTimer {
+public:
+    typedef void (*Isr)(void);
+
+    /**
+     * @brief Reset TMR5 with the counter at start
+     * @param isr Interrupt body called on enabled flags
+     */
+    static void Init(Isr isr, uint32_t start);
+
+    /**
+     * @brief Advance the counter to at, serving the compare matches on the way
+     */
+    static void RunTo(uint32_t at);
+
+    /**
+     * @brief Rising edge on CH1 at counter value at
+     */
+    static void Capture(uint32_t at);
+
+    static bool Level(uint8_t channel) { return levels[channel - 1U]; }
+
+    static Isr isr;
+    static bool levels[SIM_TIMER_CHANNELS];
+    static tmr_output_control_mode_type modes[SIM_TIMER_CHANNELS];
+    static std::vector<SimTimerEdge> edges;
+    static uint32_t late_values;
+};
+
+#endif // __SIM_TIMER_H__
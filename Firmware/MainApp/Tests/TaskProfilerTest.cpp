@@ -0,0 +1,283 @@
+// TaskProfiler on the host: the kernel hooks and interrupt handlers are
+// called by the test at chosen DWT cycle counts, as the port would. Checked
+// are the window figures of Snapshot (task and ISR shares, switches, load
+// from the idle task), instrumented interrupts taken out of the task they
+// preempt and nested ones out of the handler, task numbers above
+// PROFILER_MAX_TASKS sharing the last slot, the cycle counter wrapping
+// inside a window, a window stepped over by tickless idle, and the latency
+// maximum per window and since start-up.
+
+#include "Check.h"
+#include "SimSystem.h"
+#include "TaskProfiler.h"
+#include <FreeRTOS.h>
+
+#define WINDOW_CYCLES               (1000000U)  /// cycles the test runs per window
+#define IDLE_NUMBER                 (3U)
+
+int failures = 0;
+
+struct SimTask {
+    uint32_t number;
+    const char *name;
+    uint32_t stack_free;
+};
+
+static SimTask tasks[PROFILER_MAX_TASKS + 4U];
+static uint32_t task_count;
+
+UBaseType_t uxTaskGetSystemState(TaskStatus_t *status, UBaseType_t size, uint32_t *total_run_time) {
+    (void)total_run_time;
+    if (size < task_count) {
+        return 0;
+    }
+    for (uint32_t i = 0; i < task_count; i++) {
+        status[i].xHandle = &tasks[i];
+        status[i].pcTaskName = tasks[i].name;
+        status[i].xTaskNumber = tasks[i].number;
+        status[i].usStackHighWaterMark = tasks[i].stack_free;
+    }
+    return task_count;
+}
+
+TaskHandle_t xTaskGetIdleTaskHandle(void) {
+    for (uint32_t i = 0; i < task_count; i++) {
+        if (tasks[i].number == IDLE_NUMBER) {
+            return &tasks[i];
+        }
+    }
+    return NULL;
+}
+
+static void AddTask(uint32_t number, const char *name, uint32_t stack_free) {
+    tasks[task_count++] = {number, name, stack_free};
+}
+
+/**
+ * @brief Switch from the running task to task_number after cycles
+ */
+static void RunThenSwitch(uint32_t cycles, uint32_t task_number) {
+    DWT->CYCCNT += cycles;
+    TaskProfiler_SwitchedOut();
+    TaskProfiler_SwitchedIn(task_number);
+}
+
+/**
+ * @brief An instrumented handler of cycles, with an optional one nested in it
+ */
+static void Interrupt(ProfilerIsr isr, uint32_t cycles, ProfilerIsr nested_isr = PROFILER_ISR_COUNT,
+                      uint32_t nested_cycles = 0) {
+    const ProfilerIsrFrame frame = TaskProfiler_IsrEnter();
+    DWT->CYCCNT += cycles / 2U;
+    if (nested_isr != PROFILER_ISR_COUNT) {
+        const ProfilerIsrFrame inner = TaskProfiler_IsrEnter();
+        DWT->CYCCNT += nested_cycles;
+        TaskProfiler_IsrExit(nested_isr, inner);
+    }
+    DWT->CYCCNT += cycles - cycles / 2U;
+    TaskProfiler_IsrExit(isr, frame);
+}
+
+/**
+ * @brief Run the rest of the window in the running task, then a tick closes it
+ * @param ticks Tick count the window takes, more than PROFILER_WINDOW_MS after a tickless sleep
+ */
+static void CloseWindow(uint32_t window_start, uint32_t ticks = PROFILER_WINDOW_MS) {
+    DWT->CYCCNT = window_start + WINDOW_CYCLES;
+    SimSystem::tick_ms += ticks;
+    TaskProfiler::Tick();
+}
+
+static const TaskProfileTask *Find(const TaskProfileSnapshot &snapshot, uint16_t number) {
+    for (uint32_t i = 0; i < snapshot.task_count; i++) {
+        if (snapshot.tasks[i].number == number) {
+            return &snapshot.tasks[i];
+        }
+    }
+    return NULL;
+}
+
+static void TestBeforeFirstWindow(void) {
+    TaskProfileSnapshot snapshot;
+    TaskProfiler::Snapshot(snapshot);
+    CHECK(snapshot.version == 0 && snapshot.window_cycles == 0);
+    CHECK(sim_dwt.CTRL & DWT_CTRL_CYCCNTENA_Msk);
+
+    // The hook runs every tick, the window closes only after PROFILER_WINDOW_MS
+    SimSystem::tick_ms += PROFILER_WINDOW_MS - 1U;
+    TaskProfiler::Tick();
+    TaskProfiler::Snapshot(snapshot);
+    CHECK(snapshot.version == 0);
+}
+
+static void TestShares(void) {
+    // The first window, from Init, task 1 running
+    TaskProfiler_SwitchedIn(1);
+    CloseWindow(DWT->CYCCNT, 1U);
+
+    // Task 1 250k cycles, task 2 twice 100k, the idle task the rest
+    const uint32_t start = DWT->CYCCNT;
+    RunThenSwitch(250000U, 2);
+    RunThenSwitch(100000U, IDLE_NUMBER);
+    RunThenSwitch(50000U, 2);
+    RunThenSwitch(100000U, IDLE_NUMBER);
+    CloseWindow(start);
+
+    TaskProfileSnapshot snapshot;
+    TaskProfiler::Snapshot(snapshot);
+    CHECK(snapshot.version == PROFILER_LAYOUT && snapshot.window_cycles == WINDOW_CYCLES);
+    CHECK(snapshot.task_count == 3U);
+    const TaskProfileTask *const first = Find(snapshot, 1);
+    const TaskProfileTask *const second = Find(snapshot, 2);
+    const TaskProfileTask *const idle = Find(snapshot, IDLE_NUMBER);
+    CHECK(first != NULL && first->cpu_permille == 250U && first->switches == 0);
+    CHECK(second != NULL && second->cpu_permille == 200U && second->switches == 2U);
+    CHECK(idle != NULL && idle->cpu_permille == 550U && idle->switches == 2U);
+    CHECK(snapshot.cpu_load_permille == 450U);
+
+    // Names and stack watermarks come from the kernel
+    CHECK(first != NULL && strncmp(first->name, "Modbus", PROFILER_NAME_LEN) == 0 && first->stack_free == 120U);
+    CHECK(idle != NULL && memcmp(idle->name, "IDLE", 5) == 0);
+    CHECK(second != NULL && second->stack_free == 0xFFFFU);
+
+    // Tasks in number order
+    CHECK(snapshot.tasks[0].number == 1 && snapshot.tasks[1].number == 2 && snapshot.tasks[2].number == IDLE_NUMBER);
+}
+
+static void TestInterrupts(void) {
+    // 100k of task 1's time is in the UART handler, 20k of that in a nested TMR2 handler
+    const uint32_t start = DWT->CYCCNT;
+    RunThenSwitch(0, 1);
+    DWT->CYCCNT += 200000U;
+    Interrupt(PROFILER_ISR_USART1, 80000U, PROFILER_ISR_TMR2, 20000U);
+    DWT->CYCCNT += 100000U;
+    RunThenSwitch(0, IDLE_NUMBER);
+    Interrupt(PROFILER_ISR_CAN, 5000U);
+    Interrupt(PROFILER_ISR_CAN, 15000U);
+    CloseWindow(start);
+
+    TaskProfileSnapshot snapshot;
+    TaskProfiler::Snapshot(snapshot);
+    const TaskProfileTask *const first = Find(snapshot, 1);
+    const TaskProfileTask *const idle = Find(snapshot, IDLE_NUMBER);
+    CHECK(first != NULL && first->cpu_permille == 300U && first->switches == 1U);
+    CHECK(idle != NULL && idle->cpu_permille == 580U);
+    CHECK(snapshot.isr[PROFILER_ISR_USART1].count == 1U && snapshot.isr[PROFILER_ISR_USART1].cpu_permille == 80U);
+    CHECK(snapshot.isr[PROFILER_ISR_USART1].max_cycles == 80000U);
+    CHECK(snapshot.isr[PROFILER_ISR_TMR2].count == 1U && snapshot.isr[PROFILER_ISR_TMR2].cpu_permille == 20U);
+    CHECK(snapshot.isr[PROFILER_ISR_CAN].count == 2U && snapshot.isr[PROFILER_ISR_CAN].cpu_permille == 20U);
+    CHECK(snapshot.isr[PROFILER_ISR_CAN].max_cycles == 15000U);
+
+    // A quiet window: counts and shares start over, the maximum stays
+    CloseWindow(DWT->CYCCNT);
+    TaskProfiler::Snapshot(snapshot);
+    CHECK(snapshot.isr[PROFILER_ISR_CAN].count == 0 && snapshot.isr[PROFILER_ISR_CAN].cpu_permille == 0);
+    CHECK(snapshot.isr[PROFILER_ISR_CAN].max_cycles == 15000U);
+    CHECK(Find(snapshot, IDLE_NUMBER) != NULL && Find(snapshot, IDLE_NUMBER)->cpu_permille == 1000U);
+}
+
+static void TestCounterWrap(void) {
+    // The DWT counter wraps every 17.9 s at 240 MHz, here in the middle of a task's run
+    DWT->CYCCNT = 0xFFFFFFFFU - 300000U;
+    CloseWindow(DWT->CYCCNT - WINDOW_CYCLES);
+    const uint32_t start = DWT->CYCCNT;
+    RunThenSwitch(100000U, 2);
+    RunThenSwitch(400000U, IDLE_NUMBER);
+    CloseWindow(start);
+
+    TaskProfileSnapshot snapshot;
+    TaskProfiler::Snapshot(snapshot);
+    CHECK(snapshot.window_cycles == WINDOW_CYCLES);
+    CHECK(Find(snapshot, 2) != NULL && Find(snapshot, 2)->cpu_permille == 400U);
+    CHECK(snapshot.cpu_load_permille == 400U);
+}
+
+static void TestSharedSlot(void) {
+    // Task numbers above PROFILER_MAX_TASKS land in the last slot, reported as "other"
+    AddTask(PROFILER_MAX_TASKS, "Storage", 40);
+    AddTask(PROFILER_MAX_TASKS + 2U, "Tmr Svc", 60);
+    const uint32_t start = DWT->CYCCNT;
+    RunThenSwitch(0, PROFILER_MAX_TASKS);
+    RunThenSwitch(100000U, PROFILER_MAX_TASKS + 2U);
+    RunThenSwitch(50000U, IDLE_NUMBER);
+    CloseWindow(start);
+
+    TaskProfileSnapshot snapshot;
+    TaskProfiler::Snapshot(snapshot);
+    CHECK(snapshot.task_count == 4U);
+    const TaskProfileTask &other = snapshot.tasks[snapshot.task_count - 1U];
+    CHECK(other.number == 0 && strncmp(other.name, "other", PROFILER_NAME_LEN) == 0 && other.stack_free == 0);
+    CHECK(other.cpu_permille == 150U && other.switches == 2U);
+    CHECK(snapshot.cpu_load_permille == 150U);
+
+    // Without a slot of its own the idle task gives no load
+    tasks[2].number = PROFILER_MAX_TASKS + 1U;
+    TaskProfiler::Snapshot(snapshot);
+    CHECK(snapshot.cpu_load_permille == PROFILER_NO_LOAD);
+    tasks[2].number = IDLE_NUMBER;
+    task_count -= 2U;
+}
+
+static void TestTicklessWindow(void) {
+    // The hook did not run for the ticks stepped over: the window closes on the
+    // first tick after the sleep, once, and covers the whole time
+    const uint32_t start = DWT->CYCCNT;
+    SimSystem::tick_ms += PROFILER_WINDOW_MS / 2U;
+    TaskProfiler::Tick();
+    CloseWindow(start, PROFILER_WINDOW_MS);
+
+    TaskProfileSnapshot snapshot;
+    TaskProfiler::Snapshot(snapshot);
+    CHECK(snapshot.window_cycles == WINDOW_CYCLES);
+
+    DWT->CYCCNT += 1000U;
+    SimSystem::tick_ms += 1U;
+    TaskProfiler::Tick();
+    TaskProfiler::Snapshot(snapshot);
+    CHECK(snapshot.window_cycles == WINDOW_CYCLES);
+}
+
+static void TestLatency(void) {
+    const uint32_t start = DWT->CYCCNT;
+    TaskProfiler_IsrLatency(40);
+    TaskProfiler_IsrLatency(95);
+    TaskProfiler_IsrLatency(60);
+    CloseWindow(start);
+
+    TaskProfileSnapshot snapshot;
+    TaskProfiler::Snapshot(snapshot);
+    CHECK(snapshot.latency_cycles == 95U && snapshot.latency_peak_cycles == 95U);
+
+    TaskProfiler_IsrLatency(50);
+    CloseWindow(DWT->CYCCNT);
+    TaskProfiler::Snapshot(snapshot);
+    CHECK(snapshot.latency_cycles == 50U && snapshot.latency_peak_cycles == 95U);
+}
+
+static void TestRegisters(void) {
+    // Read by Modbus as words: no padding, 32-bit fields on 16-bit boundaries
+    CHECK(sizeof(TaskProfileSnapshot) == 20U + PROFILER_MAX_TASKS * sizeof(TaskProfileTask) +
+                                             PROFILER_ISR_COUNT * sizeof(TaskProfileIsr));
+    CHECK(sizeof(TaskProfileTask) == 16U && sizeof(TaskProfileIsr) == 8U);
+    CHECK(PROFILER_MB_REGS * sizeof(uint16_t) == sizeof(TaskProfileSnapshot));
+}
+
+int main() {
+    SimSystem::Init();
+    AddTask(1, "Modbus", 120);
+    AddTask(2, "Display", 0x12345);
+    AddTask(IDLE_NUMBER, "IDLE", 30);
+    DWT->CYCCNT = 5000U;
+    TaskProfiler::Init();
+
+    TestBeforeFirstWindow();
+    TestShares();
+    TestInterrupts();
+    TestCounterWrap();
+    TestSharedSlot();
+    TestTicklessWindow();
+    TestLatency();
+    TestRegisters();
+    printf("%s\n", failures ? "FAILED" : "OK");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,228 @@
+// Trace on the host, the UART sink captured: record encoding for every
+// argument type, the ring wrapping many times over, a full ring dropping
+// whole records and Flush reporting the count once, and producers on four
+// threads racing for the write index while a fifth flushes (a harder case
+// than the target, where a producer only preempts another). Last, the cost
+// of a trace point against snprintf of the same format on this host; the
+// cycles on the target are not measured here.
+
+#include "Check.h"
+#include "Trace.h"
+#include "UartDrv.h"
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#define RECORD_WORDS(args)          ((args) + 2U)
+#define THREADS                     (4U)
+#define THREAD_RECORDS              (20000U)
+#define THREAD_BURST                (8U)        /// records a producer emits between yields
+#define BENCH_POINTS                (1000000U)
+
+int failures = 0;
+
+enum class Phase : uint8_t { IDLE = 0, RUN = 3 };
+
+static std::vector<uint32_t> captured;      /// words sent to the sink
+
+void drv_uart_transmit(usart_type *usart, const uint8_t *data, uint16_t length) {
+    if (usart != TRACE_UART || length % sizeof(uint32_t) != 0) {
+        failures++;
+        return;
+    }
+    const size_t at = captured.size();
+    captured.resize(at + length / sizeof(uint32_t));
+    memcpy(&captured[at], data, length);
+}
+
+static uint32_t Header(const char *fmt, uint32_t count) {
+    return TRACE_SYNC | count << 24 | ((reinterpret_cast<uintptr_t>(fmt) - TRACE_FMT_BASE) & 0x00FFFFFFU);
+}
+
+static uint32_t Count(uint32_t header) {
+    return (header >> 24) & 0x0FU;
+}
+
+/**
+ * @brief Flush and take the records sent since the last call
+ */
+static std::vector<uint32_t> Drain(void) {
+    captured.clear();
+    Trace::Flush();
+    return captured;
+}
+
+static void TestEncoding(void) {
+    static const char none[] = "boot";
+    static const char mixed[] = "%d %u %p %f";
+    static const char phase[] = "phase %u";
+    static const float value = -1.5f;
+    uint32_t value_word;
+    memcpy(&value_word, &value, sizeof(value_word));
+
+    DWT->CYCCNT = 1000U;
+    Trace::Emit(none);
+    DWT->CYCCNT = 2000U;
+    Trace::Emit(mixed, -7, 40000U, &captured, value);
+    DWT->CYCCNT = 3000U;
+    Trace::Emit(phase, Phase::RUN);
+    TRACE("macro %u %u", 1, 2);
+
+    const std::vector<uint32_t> out = Drain();
+    const uint32_t expected[] = {
+        Header(none, 0), 1000U,
+        Header(mixed, 4), 2000U, static_cast<uint32_t>(-7), 40000U,
+        static_cast<uint32_t>(reinterpret_cast<uintptr_t>(&captured)), value_word,
+        Header(phase, 1), 3000U, 3U,
+    };
+    const size_t count = sizeof(expected) / sizeof(expected[0]);
+    CHECK(out.size() == count + RECORD_WORDS(2U));
+    if (out.size() == count + RECORD_WORDS(2U)) {
+        CHECK(memcmp(out.data(), expected, sizeof(expected)) == 0);
+        // The macro keeps its format in a static of its own
+        CHECK((out[count] & 0xFF000000U) == (TRACE_SYNC | 2U << 24));
+        CHECK(out[count + 2U] == 1U && out[count + 3U] == 2U);
+    }
+
+    // Nothing left, nothing dropped
+    CHECK(Drain().empty());
+}
+
+static void TestWrap(void) {
+    // Records of every size around the ring several hundred times, flushed now and then
+    static const char fmt[] = "%u %u %u %u";
+    uint32_t sent = 0;
+    uint32_t received = 0;
+    bool in_order = true;
+    for (uint32_t round = 0; round < 20000U; round++) {
+        const uint32_t batch = 1U + round % 7U;
+        for (uint32_t i = 0; i < batch; i++, sent++) {
+            DWT->CYCCNT = sent;
+            switch (sent % 3U) {
+            case 0: Trace::Emit(fmt, sent); break;
+            case 1: Trace::Emit(fmt, sent, ~sent); break;
+            default: Trace::Emit(fmt, sent, ~sent, sent, ~sent); break;
+            }
+        }
+        const std::vector<uint32_t> out = Drain();
+        for (size_t at = 0; at < out.size(); at += RECORD_WORDS(Count(out[at])), received++) {
+            const uint32_t args = received % 3U == 0 ? 1U : received % 3U == 1 ? 2U : 4U;
+            in_order = in_order && out[at] == Header(fmt, args) && out[at + 1U] == received &&
+                       out[at + 2U] == received && (args < 2U || out[at + 3U] == ~received);
+        }
+    }
+    CHECK(in_order && received == sent);
+}
+
+static void TestFull(void) {
+    // A full ring loses the newest records whole; Flush sends the rest, then the count once
+    static const char fmt[] = "%u";
+    const uint32_t fit = TRACE_RING_WORDS / RECORD_WORDS(1U);
+    DWT->CYCCNT = 5000U;
+    for (uint32_t i = 0; i < fit + 25U; i++) {
+        Trace::Emit(fmt, i);
+    }
+    std::vector<uint32_t> out = Drain();
+    CHECK(out.size() == (fit + 1U) * RECORD_WORDS(1U));
+    if (out.size() == (fit + 1U) * RECORD_WORDS(1U)) {
+        CHECK(out[(fit - 1U) * RECORD_WORDS(1U) + 2U] == fit - 1U);
+        const uint32_t *const report = &out[fit * RECORD_WORDS(1U)];
+        CHECK((report[0] & 0xFF000000U) == (TRACE_SYNC | 1U << 24) && report[0] != Header(fmt, 1U));
+        CHECK(report[1] == 5000U && report[2] == 25U);
+    }
+
+    // Reported once; room again afterwards
+    CHECK(Drain().empty());
+    Trace::Emit(fmt, 1U);
+    out = Drain();
+    CHECK(out.size() == RECORD_WORDS(1U) && out[2] == 1U);
+}
+
+static void TestConcurrent(void) {
+    // Every record arrives whole and in order per producer, or is counted as dropped
+    static const char fmt[] = "thread %u record %u";
+    std::atomic<uint32_t> running(THREADS);
+    std::vector<std::thread> producers;
+    for (uint32_t t = 0; t < THREADS; t++) {
+        producers.emplace_back([t, &running] {
+            for (uint32_t i = 0; i < THREAD_RECORDS; i++) {
+                Trace::Emit(fmt, t, i);
+                if (i % THREAD_BURST == 0) {
+                    std::this_thread::yield(); // lets the flush run on a single core too
+                }
+            }
+            running--;
+        });
+    }
+
+    uint32_t next[THREADS] = {};
+    uint32_t received = 0;
+    uint32_t dropped = 0;
+    bool whole = true;
+    bool done = false;
+    while (!done) {
+        done = running == 0;        // a last Flush after the producers finished
+        const std::vector<uint32_t> out = Drain();
+        for (size_t at = 0; at < out.size(); at += RECORD_WORDS(Count(out[at]))) {
+            if (out[at] != Header(fmt, 2U)) {
+                whole = whole && Count(out[at]) == 1U && (out[at] & 0xF0000000U) == TRACE_SYNC;
+                dropped += out[at + 2U];
+                continue;
+            }
+            const uint32_t thread = out[at + 2U];
+            whole = whole && thread < THREADS && out[at + 3U] >= next[thread];
+            if (thread < THREADS) {
+                next[thread] = out[at + 3U] + 1U;
+            }
+            received++;
+        }
+    }
+    for (std::thread &producer : producers) {
+        producer.join();
+    }
+    CHECK(whole);
+    CHECK(received + dropped == THREADS * THREAD_RECORDS);
+    printf("%u producers: %u records received, %u dropped\n", THREADS, received, dropped);
+}
+
+static void TestCost(void) {
+    // Each flushed before the ring fills, the flush is not timed
+    static const char fmt[] = "[DEBUG] Msg#%u | Uptime: %u.%03us\n";
+    const uint32_t batch = TRACE_RING_WORDS / RECORD_WORDS(3U);
+    std::chrono::duration<double, std::nano> trace_ns(0);
+    uint32_t done = 0;
+    for (; done < BENCH_POINTS; done += batch) {
+        const auto start = std::chrono::steady_clock::now();
+        for (uint32_t i = 0; i < batch; i++) {
+            Trace::Emit(fmt, done + i, i, i % 1000U);
+        }
+        trace_ns += std::chrono::steady_clock::now() - start;
+        Drain();
+    }
+
+    char text[64];
+    volatile uint32_t sink = 0;
+    const auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < BENCH_POINTS; i++) {
+        sink = sink + snprintf(text, sizeof(text), fmt, i, i, i % 1000U);
+    }
+    const std::chrono::duration<double, std::nano> snprintf_ns = std::chrono::steady_clock::now() - start;
+
+    const double per_trace = trace_ns.count() / done;
+    const double per_snprintf = snprintf_ns.count() / BENCH_POINTS;
+    printf("trace point with 3 arguments: %.1f ns on the host, snprintf of the same line %.1f ns (%.0fx)\n",
+           per_trace, per_snprintf, per_snprintf / per_trace);
+    CHECK(per_trace < per_snprintf);
+}
+
+int main() {
+    Trace::Init();
+    TestEncoding();
+    TestWrap();
+    TestFull();
+    TestConcurrent();
+    TestCost();
+    printf("%s\n", failures ? "FAILED" : "OK");
+    return failures ? 1 : 0;
+}
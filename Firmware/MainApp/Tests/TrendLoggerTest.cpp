@@ -0,0 +1,173 @@
+// TrendLogger on SimFlash: random-walk inputs sampled through several
+// rotations of the flash ring, with period changes, forced block closes and
+// power cuts at random flash operations during Spill(). Every stored block
+// must pass its CRC and decode to the input values at its sample times, and
+// the blocks must stay in time order. Blocks lost to a power cut are only
+// those still in RAM or cut short in flash.
+
+#include "SimFlash.h"
+#include "SimSystem.h"
+#include "Check.h"
+#include "PBlockConfig.h"
+#include "TrendLogger.h"
+#include "Crc32.h"
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <map>
+#include <random>
+
+// As in TrendLogger.cpp: the CRC covers start_rtc up to the crc field, then the payload
+#define TREND_CRC_OFFSET            (offsetof(TrendBlockHeader, crc))
+
+int failures = 0;
+
+typedef std::array<uint16_t, TREND_CHANNELS> Values;
+
+static std::map<uint32_t, Values> inputs;     /// input values by uptime, ms
+
+/**
+ * @brief Check a stored block against the inputs at its sample times
+ * @return Samples in the block, 0 if it does not match
+ */
+static uint32_t CheckBlock(const uint8_t *data) {
+    TrendBlockHeader header;
+    memcpy(&header, data, sizeof(header));
+    const uint32_t crc = Crc32Final(Crc32Update(Crc32Update(CRC32_INIT, data + 4, TREND_CRC_OFFSET - 4U), data + 20,
+                                                header.payload_size));
+    if (header.crc != crc || header.samples == 0) {
+        return 0;
+    }
+
+    SampleDecoder decoder;
+    decoder.Reset(TREND_CHANNELS);
+    size_t used = 0;
+    for (uint32_t n = 0; n < header.samples; n++) {
+        uint16_t values[TREND_CHANNELS];
+        const size_t size = decoder.Decode(data + TREND_BLOCK_HEADER_SIZE + used, header.payload_size - used, values);
+        const auto sampled = inputs.find(header.start_uptime_ms + n * header.period_ms);
+        if (size == 0 || sampled == inputs.end() || memcmp(values, sampled->second.data(), sizeof(values)) != 0) {
+            return 0;
+        }
+        used += size;
+    }
+    return used == header.payload_size ? header.samples : 0U;
+}
+
+int main() {
+    std::mt19937 rng(7);
+    Values values = {};
+    uint32_t cuts = 0;
+    uint32_t spilled_sequence = 0;  /// blocks before this one were programmed
+
+    SimFlash::Init();
+    SimSystem::Init();
+    PBlockConfig::Init();
+    CHECK(TrendLogger::Init());
+    CHECK(TrendLogger::SetPeriod(TREND_MIN_PERIOD_MS));
+    CHECK(!TrendLogger::SetPeriod(150));
+
+    for (uint32_t step = 1; step <= 300000; step++) {
+        SimSystem::tick_ms += TREND_MIN_PERIOD_MS;
+        SimSystem::rtc_s = SimSystem::tick_ms / 1000U;
+        for (uint32_t ch = 0; ch < TREND_CHANNELS; ch++) {
+            if (rng() % (ch + 2U) == 0) {
+                const int32_t value = values[ch] + static_cast<int32_t>(rng() % 201U) - 100;
+                values[ch] = static_cast<uint16_t>(std::clamp(value, 0, 10000));
+            }
+        }
+        std::copy(values.begin(), values.end(), SimSystem::inputs);
+        inputs[SimSystem::tick_ms] = values;
+        TrendLogger::Sample(SimSystem::tick_ms);
+
+        if (step == 100000) {
+            CHECK(TrendLogger::SetPeriod(200));
+        } else if (step == 200000) {
+            CHECK(TrendLogger::SetPeriod(500));
+        } else if (step % 7001 == 0) {
+            TrendLogger::CloseBlock();
+        }
+
+        if (step % 5 != 0 || !TrendLogger::HasPending()) {
+            continue;
+        }
+        if (rng() % 10 == 0) {
+            SimFlash::power_left = static_cast<int32_t>(rng() % 200);
+        }
+        try {
+            CHECK(TrendLogger::Spill());
+            TrendInfo info;
+            TrendLogger::GetInfo(info);
+            spilled_sequence = info.open_sequence;
+        } catch (const SimPowerCut &) {
+            cuts++;
+            CHECK(TrendLogger::Init());
+
+            // Programmed blocks survive, a block cut short is skipped
+            TrendInfo info;
+            TrendLogger::GetInfo(info);
+            CHECK(info.open_sequence >= spilled_sequence);
+            CHECK(info.open_sequence <= spilled_sequence + TREND_BLOCKS_PER_SECTOR);
+        }
+        SimFlash::power_left = SIM_NO_POWER_CUT;
+        if (failures) {
+            printf("step %u, %u power cuts\n", step, cuts);
+            return 1;
+        }
+    }
+    TrendLogger::CloseBlock();
+    TrendLogger::Sample(SimSystem::tick_ms + 500U);
+    CHECK(TrendLogger::Spill());
+
+    TrendInfo info;
+    TrendLogger::GetInfo(info);
+    CHECK(info.open_sequence > 3U * TREND_BLOCK_SLOTS);
+    CHECK(info.open_sequence - info.first_sequence >= TREND_BLOCK_SLOTS - TREND_BLOCKS_PER_SECTOR);
+    CHECK(info.open_sequence - info.first_sequence <= TREND_BLOCK_SLOTS);
+    CHECK(info.dropped_blocks == 0);
+
+    uint32_t stored = 0;
+    uint32_t samples = 0;
+    uint32_t previous_start = 0;
+    for (uint32_t sequence = info.first_sequence; sequence < info.open_sequence; sequence++) {
+        const uint8_t *block = TrendLogger::StoredBlock(sequence);
+        CHECK(block != nullptr);
+        if (block == nullptr || !TrendLogger::IsStored(sequence)) {
+            continue;
+        }
+        TrendBlockHeader header;
+        memcpy(&header, block, sizeof(header));
+        const uint32_t count = CheckBlock(block);
+        CHECK(count != 0);
+        CHECK(header.start_uptime_ms > previous_start);
+        previous_start = header.start_uptime_ms;
+        samples += count;
+        stored++;
+    }
+    CHECK(info.open_sequence - info.first_sequence - stored <= cuts);
+
+    // FindBlock: first block starting at or after the time
+    uint32_t start_rtc = 0;
+    const uint32_t middle = info.first_sequence + 300U;
+    CHECK(TrendLogger::ReadBlock(middle, offsetof(TrendBlockHeader, start_rtc), &start_rtc, sizeof(start_rtc)));
+    const uint32_t found = TrendLogger::FindBlock(start_rtc);
+    uint32_t found_rtc = 0;
+    CHECK(found <= middle && TrendLogger::ReadBlock(found, 4, &found_rtc, sizeof(found_rtc)));
+    CHECK(found_rtc == start_rtc);
+    CHECK(TrendLogger::FindBlock(0) >= info.first_sequence && TrendLogger::FindBlock(0) <= info.first_sequence + 1U);
+    CHECK(TrendLogger::FindBlock(0xFFFFFFF0U) == info.open_sequence);
+    CHECK(TrendLogger::SlotSequence(static_cast<uint16_t>(middle % TREND_BLOCK_SLOTS)) == middle);
+
+    // The ring is found again after a reset
+    CHECK(TrendLogger::Init());
+    TrendInfo again;
+    TrendLogger::GetInfo(again);
+    CHECK(again.first_sequence == info.first_sequence && again.open_sequence == info.open_sequence);
+    CHECK(again.period_ms == 500);
+    CHECK(SimFlash::program_errors == 0);
+
+    printf("%u blocks stored, %u samples (%.1f bytes/sample), %u power cuts\n", stored, samples,
+           static_cast<double>(stored) * TREND_BLOCK_SIZE / samples, cuts);
+    printf("%s\n", failures ? "FAILED" : "OK");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,133 @@
+// TrendStream over a TrendLogger on SimFlash, sent through a model of an
+// asynchronous bulk endpoint: a piece is read only after the next Next()
+// call, as with a transport whose Send() returns before the data is out.
+// The stream must deliver flash, queued and open blocks byte for byte, clamp
+// its range to the stored blocks, and send a block erased under it as an
+// erased slot.
+
+#include "SimFlash.h"
+#include "SimSystem.h"
+#include "Check.h"
+#include "PBlockConfig.h"
+#include "TrendLogger.h"
+#include "TrendStream.h"
+#include <cstring>
+#include <random>
+#include <vector>
+
+int failures = 0;
+
+typedef std::vector<uint8_t> Bytes;
+
+static std::mt19937 rng(11);
+
+static void SampleInputs(void) {
+    SimSystem::tick_ms += TREND_MIN_PERIOD_MS;
+    SimSystem::rtc_s = SimSystem::tick_ms / 1000U;
+    for (uint16_t &value : SimSystem::inputs) {
+        value = static_cast<uint16_t>(rng() % 10001U);
+    }
+    TrendLogger::Sample(SimSystem::tick_ms);
+}
+
+/**
+ * @brief Sample changing inputs until count more blocks are closed
+ * One more sample starts the next block, so the open block is readable.
+ */
+static void LogBlocks(uint32_t count, bool spill) {
+    TrendInfo info;
+    TrendLogger::GetInfo(info);
+    const uint32_t until = info.open_sequence + count;
+
+    while (info.open_sequence < until) {
+        SampleInputs();
+        if (spill) {
+            CHECK(TrendLogger::Spill());
+        }
+        TrendLogger::GetInfo(info);
+    }
+    SampleInputs();
+}
+
+/**
+ * @brief Run a stream, reading each piece one Next() late
+ */
+static Bytes Stream(const TrendStreamRange &range) {
+    Bytes sent;
+    const uint8_t *data;
+    const uint8_t *pending = nullptr;
+    uint16_t size;
+    uint16_t pending_size = 0;
+    uint32_t pieces = 0;
+
+    while (TrendStream::Next(data, size)) {
+        if (pending != nullptr) {
+            sent.insert(sent.end(), pending, pending + pending_size);
+        }
+        pending = data;
+        pending_size = size;
+        pieces++;
+    }
+    if (pending != nullptr) {
+        sent.insert(sent.end(), pending, pending + pending_size);
+    }
+    CHECK(pieces == range.count);
+    return sent;
+}
+
+static Bytes Expected(uint32_t first, uint16_t count) {
+    Bytes expected(count * TREND_BLOCK_SIZE);
+    for (uint16_t n = 0; n < count; n++) {
+        CHECK(TrendLogger::ReadBlock(first + n, 0, &expected[n * TREND_BLOCK_SIZE], TREND_BLOCK_SIZE));
+    }
+    return expected;
+}
+
+int main() {
+    TrendStreamRange range;
+    TrendInfo info;
+
+    SimFlash::Init();
+    SimSystem::Init();
+    PBlockConfig::Init();
+    CHECK(TrendLogger::Init());
+    CHECK(TrendLogger::SetPeriod(TREND_MIN_PERIOD_MS));
+
+    // A full ring, two blocks queued in RAM and the open one
+    LogBlocks(TREND_BLOCK_SLOTS + 20U, true);
+    LogBlocks(2, false);
+    TrendLogger::GetInfo(info);
+    CHECK(TrendLogger::HasPending());
+    CHECK(info.first_sequence > 0);
+
+    // Range clamping
+    CHECK(TrendStream::Start(0, 10, range));
+    CHECK(range.first_sequence == info.first_sequence && range.count == 10);
+    CHECK(TrendStream::Start(info.open_sequence - 5U, 100, range));
+    CHECK(range.first_sequence == info.open_sequence - 5U && range.count == 6);
+    CHECK(!TrendStream::Start(info.open_sequence + 1U, 5, range));
+    CHECK(range.count == 0);
+    const uint8_t *data;
+    uint16_t size;
+    CHECK(!TrendStream::Next(data, size));
+
+    // Flash blocks, then queued and open blocks through the alternating RAM copies
+    CHECK(TrendStream::Start(info.open_sequence - 40U, 41, range));
+    CHECK(Stream(range) == Expected(range.first_sequence, range.count));
+    CHECK(TrendStream::Start(info.first_sequence, UINT16_MAX, range));
+    CHECK(range.count == info.open_sequence - info.first_sequence + 1U);
+    CHECK(Stream(range) == Expected(range.first_sequence, range.count));
+
+    // The oldest sector is erased while the stream is running
+    CHECK(TrendStream::Start(info.first_sequence, 3, range));
+    CHECK(TrendStream::Next(data, size));
+    CHECK(TrendLogger::Spill());
+    LogBlocks(TREND_BLOCKS_PER_SECTOR, true);
+    const Bytes erased(TREND_BLOCK_SIZE, 0xFF);
+    CHECK(TrendStream::Next(data, size) && Bytes(data, data + size) == erased);
+    TrendStream::Cancel();
+    CHECK(!TrendStream::Next(data, size));
+
+    printf("%s\n", failures ? "FAILED" : "OK");
+    return failures ? 1 : 0;
+}
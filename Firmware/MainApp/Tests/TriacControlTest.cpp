@@ -0,0 +1,289 @@
+// TriacControl on MainsSync and a modelled TMR5 (SimTimer). The firing
+// table is checked against the phase-cut power curve; the gate edges the
+// compare outputs produce are recorded while the mains drifts over
+// 45..65 Hz, jumps between the ends of that range and stops, and every
+// period is checked: two 100 us pulses, the second one half a period
+// after the first, at the delay that delivers the set power, never
+// running into the next zero crossing and never armed in the past.
+
+#include "Check.h"
+#include "SimTimer.h"
+#include "MainsSync.h"
+#include "TriacControl.h"
+#include <cmath>
+#include <vector>
+
+#define GATE_PULSE_TICKS            (TRIAC_GATE_PULSE_US * MAINS_TICKS_PER_US)
+#define MIN_DELAY_TICKS             (TRIAC_MIN_DELAY_US * MAINS_TICKS_PER_US)
+#define END_GUARD_TICKS             (TRIAC_END_GUARD_US * MAINS_TICKS_PER_US)
+
+int failures = 0;
+
+static uint32_t now = 0;                    /// counter value of the last crossing fed
+static uint16_t armed_us[TRIAC_CHANNELS];   /// setpoints taken by the last crossing
+
+/**
+ * @brief Fraction of full power delivered when firing at this fraction of the half-cycle
+ */
+static double PhaseCutPower(double fraction) {
+    const double a = fraction * M_PI;
+    return 1.0 - a / M_PI + sin(2.0 * a) / (2.0 * M_PI);
+}
+
+/**
+ * @brief Feed the next crossing one period after the last one
+ * @return Gate edges of the period that ended with it
+ */
+static std::vector<SimTimerEdge> Cross(uint32_t period_ticks) {
+    SimTimer::edges.clear();
+    SimTimer::RunTo(now + period_ticks);
+    std::vector<SimTimerEdge> edges = SimTimer::edges;
+    now += period_ticks;
+    SimTimer::edges.clear();
+    SimTimer::Capture(now);
+    for (uint8_t channel = 1; channel <= TRIAC_CHANNELS; channel++) {
+        armed_us[channel - 1] = TriacControl::GetOnTime(channel);
+    }
+
+    // Whatever ran in the ended period, both gates are low at the crossing
+    CHECK(!SimTimer::Level(3) && !SimTimer::Level(4));
+    return edges;
+}
+
+static uint32_t PeriodOf(uint32_t millihz) {
+    return static_cast<uint32_t>(10000000000ULL / millihz);
+}
+
+/**
+ * @brief Gate edges one channel must produce in a period
+ * @param on_time_us Setpoint
+ * @param zero_cross Crossing that started the period
+ * @param period_ticks Averaged period MainsSync passed at that crossing
+ */
+static std::vector<SimTimerEdge> Expected(uint8_t channel, uint16_t on_time_us, uint32_t zero_cross,
+                                          uint32_t period_ticks) {
+    const uint32_t half = period_ticks / 2U;
+    const uint32_t on_ticks = on_time_us * MAINS_TICKS_PER_US;
+    std::vector<SimTimerEdge> edges;
+    if (on_ticks == 0) {
+        return edges;
+    }
+    const uint32_t power_q16 = on_ticks < half ? static_cast<uint32_t>((static_cast<uint64_t>(on_ticks) << 16) / half)
+                                               : 0x10000U;
+    uint32_t delay = static_cast<uint32_t>((static_cast<uint64_t>(half) * TriacControl::FiringFraction(power_q16)) >> 16);
+    delay = delay < MIN_DELAY_TICKS ? MIN_DELAY_TICKS : delay;
+    if (delay + GATE_PULSE_TICKS + END_GUARD_TICKS > half) {
+        return edges;
+    }
+    edges.push_back({channel, zero_cross + delay, true});
+    edges.push_back({channel, zero_cross + delay + GATE_PULSE_TICKS, false});
+    edges.push_back({channel, zero_cross + half + delay, true});
+    edges.push_back({channel, zero_cross + half + delay + GATE_PULSE_TICKS, false});
+    return edges;
+}
+
+static std::vector<SimTimerEdge> OfChannel(const std::vector<SimTimerEdge> &edges, uint8_t channel) {
+    std::vector<SimTimerEdge> out;
+    for (const SimTimerEdge &edge : edges) {
+        if (edge.channel == channel) {
+            out.push_back(edge);
+        }
+    }
+    return out;
+}
+
+static bool SameEdges(const std::vector<SimTimerEdge> &a, const std::vector<SimTimerEdge> &b) {
+    if (a.size() != b.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < a.size(); i++) {
+        if (a[i].channel != b[i].channel || a[i].at != b[i].at || a[i].level != b[i].level) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Run periods and compare both gates with the expected sequence of each period
+ * @return Periods whose edges differ
+ */
+static uint32_t RunPeriods(const std::vector<uint32_t> &periods) {
+    uint32_t mismatches = 0;
+    for (uint32_t period : periods) {
+        const uint32_t zero_cross = now;
+        const uint32_t average = MainsSync::GetPeriodTicks();
+        const uint16_t on_time_us[TRIAC_CHANNELS] = {armed_us[0], armed_us[1]};
+        const std::vector<SimTimerEdge> edges = Cross(period);
+        for (uint8_t channel = 1; channel <= TRIAC_CHANNELS; channel++) {
+            const std::vector<SimTimerEdge> expected =
+                average == 0 ? std::vector<SimTimerEdge>()
+                             : Expected(channel + 2U, on_time_us[channel - 1], zero_cross, average);
+            if (!SameEdges(OfChannel(edges, channel + 2U), expected)) {
+                mismatches++;
+            }
+            // The second pulse ends with the guard time left before the crossing
+            if (!expected.empty() && now - expected.back().at < END_GUARD_TICKS) {
+                mismatches++;
+            }
+        }
+    }
+    return mismatches;
+}
+
+static void TestFiringTable(void) {
+    CHECK(TriacControl::FiringFraction(0) == 0x10000U);
+    CHECK(TriacControl::FiringFraction(0x10000U) == 0);
+    CHECK(TriacControl::FiringFraction(0x8000U) == 0x8000U);
+
+    // Monotonic, and the power at the returned angle is the power asked for
+    double worst = 0.0;
+    uint32_t last = 0x10000U;
+    bool monotonic = true;
+    for (uint32_t power = 0; power <= 0x10000U; power += 16) {
+        const uint32_t fraction = TriacControl::FiringFraction(power);
+        monotonic = monotonic && fraction <= last;
+        last = fraction;
+        const double error = fabs(PhaseCutPower(fraction / 65536.0) - power / 65536.0);
+        worst = error > worst ? error : worst;
+    }
+    CHECK(monotonic);
+    CHECK(worst < 0.0016);
+    printf("firing table: worst power error %.4f %%\n", worst * 100.0);
+}
+
+static void TestSteady(void) {
+    // 50 % power at 50 Hz fires at 90 degrees: 5 ms into each half-cycle
+    TriacControl::SetOnTime(1, 5000);
+    TriacControl::SetOnTime(2, 0);
+    std::vector<SimTimerEdge> edges;
+    for (uint32_t i = 0; i < 10; i++) {
+        edges = Cross(PeriodOf(50000));
+    }
+    edges = Cross(PeriodOf(50000));
+    const uint32_t zero_cross = now - PeriodOf(50000);
+    CHECK(edges.size() == 4);
+    CHECK(SameEdges(edges, {{3, zero_cross + 50000U, true},
+                            {3, zero_cross + 50000U + GATE_PULSE_TICKS, false},
+                            {3, zero_cross + 150000U, true},
+                            {3, zero_cross + 150000U + GATE_PULSE_TICKS, false}}));
+
+    // The setpoint takes effect at the next crossing
+    TriacControl::SetOnTime(2, 2500);
+    CHECK(OfChannel(Cross(PeriodOf(50000)), 4).empty());
+    CHECK(RunPeriods(std::vector<uint32_t>(10, PeriodOf(50000))) == 0);
+}
+
+static void TestDrift(void) {
+    // 45 -> 65 -> 45 Hz in 20 mHz steps, both gates at different powers
+    TriacControl::SetOnTime(1, 1500);
+    TriacControl::SetOnTime(2, 8000);
+    std::vector<uint32_t> periods;
+    for (uint32_t millihz = 45000; millihz < 65000; millihz += 20) {
+        periods.push_back(PeriodOf(millihz));
+    }
+    for (uint32_t millihz = 65000; millihz > 45000; millihz -= 20) {
+        periods.push_back(PeriodOf(millihz));
+    }
+    CHECK(RunPeriods(periods) == 0);
+
+    // Delivered power at 60 Hz, once the average has settled: the firing
+    // delay over the half period, as the master reads it
+    TriacControl::SetOnTime(1, 3000);
+    for (uint32_t i = 0; i < 2U * MAINS_AVERAGE_CYCLES; i++) {
+        Cross(PeriodOf(60000));
+    }
+    const uint32_t half = MainsSync::GetPeriodTicks() / 2U;
+    const std::vector<SimTimerEdge> edges = OfChannel(Cross(PeriodOf(60000)), 3);
+    CHECK(edges.size() == 4);
+    if (edges.size() == 4) {
+        const double fraction = static_cast<double>(edges[0].at - (now - PeriodOf(60000))) / half;
+        CHECK(fabs(PhaseCutPower(fraction) - 30000.0 / half) < 0.002);
+    }
+}
+
+static void TestFrequencySteps(void) {
+    // 45 -> 65 Hz at once: the averaged period lags, sequences of the longer
+    // period are cut at the next crossing instead of firing into it
+    TriacControl::SetOnTime(1, 9000);
+    TriacControl::SetOnTime(2, 4000);
+    for (uint32_t i = 0; i < 10; i++) {
+        Cross(PeriodOf(45000));
+    }
+    uint32_t longest = 0;
+    for (uint32_t i = 0; i < 10; i++) {
+        const std::vector<SimTimerEdge> edges = Cross(PeriodOf(65000));
+        for (uint8_t channel = 3; channel <= 4; channel++) {
+            const std::vector<SimTimerEdge> gate = OfChannel(edges, channel);
+            for (size_t k = 0; k + 1 < gate.size(); k++) {
+                if (gate[k].level && !gate[k + 1].level) {
+                    longest = gate[k + 1].at - gate[k].at > longest ? gate[k + 1].at - gate[k].at : longest;
+                }
+            }
+        }
+    }
+    CHECK(longest <= GATE_PULSE_TICKS);
+
+    // Once the average has settled every period is complete again
+    CHECK(RunPeriods(std::vector<uint32_t>(10, PeriodOf(65000))) == 0);
+    for (uint32_t i = 0; i < 10; i++) {
+        Cross(PeriodOf(45000));
+    }
+    CHECK(RunPeriods(std::vector<uint32_t>(10, PeriodOf(45000))) == 0);
+}
+
+static void TestLimits(void) {
+    // Full power fires at the latching delay; 2 us (0.04 %) would fire too
+    // close to the next crossing to fire at all
+    TriacControl::SetOnTime(1, 20000);
+    TriacControl::SetOnTime(2, 2);
+    Cross(PeriodOf(50000));
+    std::vector<SimTimerEdge> edges = Cross(PeriodOf(50000));
+    const std::vector<SimTimerEdge> gate = OfChannel(edges, 3);
+    CHECK(gate.size() == 4 && gate[0].at == now - PeriodOf(50000) + MIN_DELAY_TICKS);
+    CHECK(OfChannel(edges, 4).empty());
+    CHECK(!TriacControl::SetOnTime(0, 100) && !TriacControl::SetOnTime(3, 100));
+    CHECK(TriacControl::GetOnTime(3) == 0);
+
+    // Off: nothing at all
+    TriacControl::SetOnTime(1, 0);
+    TriacControl::SetOnTime(2, 0);
+    Cross(PeriodOf(50000));
+    CHECK(Cross(PeriodOf(50000)).empty());
+}
+
+static void TestMainsLost(void) {
+    TriacControl::SetOnTime(1, 5000);
+    Cross(PeriodOf(50000));
+
+    // The period started by the last crossing completes, then the gates stay low
+    SimTimer::edges.clear();
+    SimTimer::RunTo(now + 10U * PeriodOf(50000));
+    CHECK(OfChannel(SimTimer::edges, 3).size() == 4);
+    CHECK(!SimTimer::Level(3) && !SimTimer::Level(4));
+
+    // After a gap the first crossing fires nothing, the averaging starts over
+    CHECK(Cross(10U * PeriodOf(50000) + 1000U).empty());
+    CHECK(Cross(PeriodOf(50000)).empty());
+    CHECK(OfChannel(Cross(PeriodOf(50000)), 3).size() == 4);
+}
+
+int main() {
+    // The counter wraps 10 s into the drift
+    now = 0xFA000000U;
+    SimTimer::Init(MainsSync::IrqHandler, now);
+    CHECK(MainsSync::Init());
+    CHECK(TriacControl::Init());
+    CHECK(!SimTimer::Level(3) && !SimTimer::Level(4));
+    SimTimer::Capture(now);
+
+    TestFiringTable();
+    TestSteady();
+    TestDrift();
+    TestFrequencySteps();
+    TestLimits();
+    TestMainsLost();
+    CHECK(SimTimer::late_values == 0);
+    printf("%s\n", failures ? "FAILED" : "OK");
+    return failures ? 1 : 0;
+}
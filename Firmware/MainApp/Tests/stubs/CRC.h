@@ -0,0 +1,21 @@
+#ifndef __CRC_H__
+#define __CRC_H__
+
+// Host stand-in for the TafcoMcuCore CRC-8 of the legacy config record. Not
+// the device polynomial: the tests write legacy records with this function too.
+
+#include <stdint.h>
+#include <stddef.h>
+
+inline uint8_t count_CRC(const uint8_t *data, size_t size) {
+    uint8_t crc = 0xFFU;
+    while (size--) {
+        crc ^= *data++;
+        for (uint8_t bit = 0; bit < 8; bit++) {
+            crc = static_cast<uint8_t>((crc & 0x80U) ? (crc << 1) ^ 0x31U : crc << 1);
+        }
+    }
+    return crc;
+}
+
+#endif
@@ -0,0 +1,19 @@
+#ifndef __FLASH_SERVICE_H__
+#define __FLASH_SERVICE_H__
+
+// Host stand-in for the TafcoMcuCore flash service: reads go straight to SimFlash
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+#define SECTOR_ADDRESS(sector)      (0x08000000U + (sector) * 0x800U)
+
+class FlashService {
+public:
+    static void Read(uint32_t address, uint8_t *buffer, size_t size) {
+        memcpy(buffer, reinterpret_cast<const void *>(static_cast<uintptr_t>(address)), size);
+    }
+};
+
+#endif
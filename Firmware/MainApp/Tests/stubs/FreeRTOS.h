@@ -0,0 +1,67 @@
+#ifndef INC_FREERTOS_H
+#define INC_FREERTOS_H
+
+// Host stand-in for FreeRTOS: one thread, no scheduler; the tick comes from SimSystem
+
+#include <stdint.h>
+#include <stddef.h>
+
+typedef uint32_t TickType_t;
+typedef long BaseType_t;
+typedef unsigned long UBaseType_t;
+typedef void *TaskHandle_t;
+typedef void *SemaphoreHandle_t;
+typedef struct {
+    int dummy;
+} StaticSemaphore_t;
+
+#define pdTRUE                      (1)
+#define pdFALSE                     (0)
+#define portMAX_DELAY               (0xFFFFFFFFU)
+#define portTICK_PERIOD_MS          (1U)
+#define pdMS_TO_TICKS(ms)           (static_cast<TickType_t>(ms))
+
+#define taskENTER_CRITICAL()
+#define taskEXIT_CRITICAL()
+#define taskENTER_CRITICAL_FROM_ISR()       (0U)
+#define taskEXIT_CRITICAL_FROM_ISR(mask)    ((void)(mask))
+
+// As in FreeRTOSConfig.h
+#define configCPU_CLOCK_HZ          (240000000UL)
+#define configTICK_RATE_HZ          (1000UL)
+#define configSYSTICK_CLOCK_HZ      (configCPU_CLOCK_HZ / 8)
+#define configUSE_TICKLESS_IDLE     2
+
+// Tickless idle, the kernel side is modelled by SimSysTick
+typedef enum { eAbortSleep = 0, eStandardSleep, eNoTasksWaitingTimeout } eSleepModeStatus;
+eSleepModeStatus eTaskConfirmSleepModeStatus(void);
+void vTaskStepTick(TickType_t ticks);
+inline BaseType_t xPortIsInsideInterrupt(void) { return pdFALSE; }
+inline void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t *woken) { (void)task; (void)woken; }
+#define portYIELD_FROM_ISR(woken)   ((void)(woken))
+
+TickType_t xTaskGetTickCount(void);
+inline TickType_t xTaskGetTickCountFromISR(void) { return xTaskGetTickCount(); }
+
+inline TaskHandle_t xTaskGetCurrentTaskHandle(void) { return NULL; }
+inline void xTaskNotifyGive(TaskHandle_t task) { (void)task; }
+inline uint32_t ulTaskNotifyTake(BaseType_t clear, TickType_t wait) { (void)clear; (void)wait; return 0; }
+inline void vTaskDelay(TickType_t ticks) { (void)ticks; }
+
+// Task state as the profiler reads it, the tests provide the task list
+typedef struct {
+    TaskHandle_t xHandle;
+    const char *pcTaskName;
+    UBaseType_t xTaskNumber;
+    uint32_t usStackHighWaterMark;          // configSTACK_DEPTH_TYPE, StackType_t on the port
+} TaskStatus_t;
+UBaseType_t uxTaskGetSystemState(TaskStatus_t *status, UBaseType_t size, uint32_t *total_run_time);
+TaskHandle_t xTaskGetIdleTaskHandle(void);
+inline void vTaskSuspendAll(void) {}
+inline BaseType_t xTaskResumeAll(void) { return pdFALSE; }
+
+inline SemaphoreHandle_t xSemaphoreCreateMutexStatic(StaticSemaphore_t *buffer) { return buffer; }
+inline BaseType_t xSemaphoreTake(SemaphoreHandle_t mutex, TickType_t wait) { (void)mutex; (void)wait; return pdTRUE; }
+inline BaseType_t xSemaphoreGive(SemaphoreHandle_t mutex) { (void)mutex; return pdTRUE; }
+
+#endif
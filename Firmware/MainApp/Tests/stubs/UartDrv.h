@@ -0,0 +1,9 @@
+// Host stand-in for the UART driver of the core library; the tests provide the functions
+#ifndef __UART_DRV_H__
+#define __UART_DRV_H__
+
+#include "at32f403a_407.h"
+
+void drv_uart_transmit(usart_type *usart, const uint8_t *data, uint16_t length);
+
+#endif // __UART_DRV_H__
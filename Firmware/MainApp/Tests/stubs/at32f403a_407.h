@@ -0,0 +1,417 @@
+#ifndef __AT32F403A_407_H
+#define __AT32F403A_407_H
+
+// Host stand-in for the AT32 device header: flash is a RAM mapping at the device addresses (SimFlash),
+// the RTC counter comes from SimSystem, GPIO and EXINT registers are plain RAM the tests write,
+// TMR5 is modelled by SimTimer, SysTick and the interrupt mask by SimSysTick, SPI2 and DMA1
+// channel 5 with the display controller on them by SimPanel, the DWT cycle counter is plain RAM
+// the tests advance
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+typedef enum { FALSE = 0, TRUE = !FALSE } confirm_state;
+
+typedef enum {
+    FLASH_OPERATE_BUSY = 0,
+    FLASH_PROGRAM_ERROR,
+    FLASH_EPP_ERROR,
+    FLASH_OPERATE_DONE,
+    FLASH_OPERATE_TIMEOUT,
+} flash_status_type;
+
+void flash_unlock(void);
+void flash_lock(void);
+flash_status_type flash_sector_erase(uint32_t sector_address);
+flash_status_type flash_word_program(uint32_t address, uint32_t data);
+
+// Same values as the device header, the config schema tests store them
+typedef enum { USART_DATA_8BITS = 0x00, USART_DATA_9BITS = 0x01 } usart_data_bit_num_type;
+typedef enum { USART_PARITY_NONE = 0x00, USART_PARITY_EVEN = 0x01, USART_PARITY_ODD = 0x02 } usart_parity_selection_type;
+typedef enum {
+    USART_STOP_1_BIT = 0x00,
+    USART_STOP_0_5_BIT = 0x01,
+    USART_STOP_2_BIT = 0x02,
+    USART_STOP_1_5_BIT = 0x03,
+} usart_stop_bit_num_type;
+
+typedef struct {
+    uint16_t year;
+    uint8_t month;
+    uint8_t date;
+    uint8_t hour;
+    uint8_t min;
+    uint8_t sec;
+    uint8_t week;
+} calendar_type;
+
+uint32_t rtc_counter_get(void);
+
+inline void __DMB(void) {}
+inline void __DSB(void) {}
+inline void __ISB(void) {}
+void __WFI(void);
+void __disable_irq(void);
+void __enable_irq(void);
+
+// SysTick and SCB->ICSR: every access goes through SimSysTick, which moves the
+// counter on by the cost of the access first
+#define SysTick_CTRL_ENABLE_Msk     (1UL << 0)
+#define SysTick_CTRL_TICKINT_Msk    (1UL << 1)
+#define SysTick_CTRL_CLKSOURCE_Msk  (1UL << 2)
+#define SysTick_CTRL_COUNTFLAG_Msk  (1UL << 16)
+#define SysTick_LOAD_RELOAD_Msk     (0xFFFFFFUL)
+#define SCB_ICSR_PENDSTCLR_Msk      (1UL << 25)
+#define SCB_ICSR_PENDSTSET_Msk      (1UL << 26)
+
+enum class SimCoreRegister : uint8_t { SYST_CTRL, SYST_LOAD, SYST_VAL, SCB_ICSR };
+
+uint32_t sim_core_read(SimCoreRegister reg);
+void sim_core_write(SimCoreRegister reg, uint32_t value);
+
+template <SimCoreRegister Reg>
+struct SimCoreRegisterAccess {
+    operator uint32_t() const { return sim_core_read(Reg); }
+    SimCoreRegisterAccess &operator=(uint32_t value) {
+        sim_core_write(Reg, value);
+        return *this;
+    }
+};
+
+typedef struct {
+    SimCoreRegisterAccess<SimCoreRegister::SYST_CTRL> CTRL;
+    SimCoreRegisterAccess<SimCoreRegister::SYST_LOAD> LOAD;
+    SimCoreRegisterAccess<SimCoreRegister::SYST_VAL> VAL;
+} SysTick_Type;
+
+typedef struct {
+    SimCoreRegisterAccess<SimCoreRegister::SCB_ICSR> ICSR;
+} SCB_Type;
+
+inline SysTick_Type sim_systick;
+inline SCB_Type sim_scb;
+#define SysTick                     (&sim_systick)
+#define SCB                         (&sim_scb)
+
+// DWT cycle counter: TaskProfiler starts it, the profiler and the trace read it
+#define CoreDebug_DEMCR_TRCENA_Msk  (1UL << 24)
+#define DWT_CTRL_CYCCNTENA_Msk      (1UL << 0)
+
+typedef struct {
+    uint32_t DEMCR;
+} CoreDebug_Type;
+
+typedef struct {
+    uint32_t CTRL;
+    uint32_t CYCCNT;
+} DWT_Type;
+
+inline CoreDebug_Type sim_core_debug;
+inline DWT_Type sim_dwt;
+#define CoreDebug                   (&sim_core_debug)
+#define DWT                         (&sim_dwt)
+
+// USART: only the instance, the transfers go through UartDrv
+typedef struct {
+    uint32_t sts;
+} usart_type;
+
+inline usart_type sim_usart1;
+#define USART1                      (&sim_usart1)
+
+typedef enum { RESET = 0, SET = !RESET } flag_status;
+
+// GPIO: input and output data registers only
+typedef struct {
+    uint32_t idt;
+    uint32_t odt;
+} gpio_type;
+
+inline gpio_type sim_gpio_ports[5];
+#define GPIOA                       (&sim_gpio_ports[0])
+#define GPIOB                       (&sim_gpio_ports[1])
+#define GPIOC                       (&sim_gpio_ports[2])
+#define GPIOD                       (&sim_gpio_ports[3])
+#define GPIOE                       (&sim_gpio_ports[4])
+
+typedef enum { GPIO_PULL_NONE = 0x04, GPIO_PULL_UP = 0x18, GPIO_PULL_DOWN = 0x28 } gpio_pull_type;
+typedef enum { GPIO_MODE_INPUT = 0x00, GPIO_MODE_OUTPUT = 0x10, GPIO_MODE_MUX = 0x08, GPIO_MODE_ANALOG = 0x03 } gpio_mode_type;
+typedef enum { GPIO_OUTPUT_PUSH_PULL = 0x00, GPIO_OUTPUT_OPEN_DRAIN = 0x04 } gpio_output_type;
+typedef enum { GPIO_DRIVE_STRENGTH_STRONGER = 0x01, GPIO_DRIVE_STRENGTH_MODERATE = 0x02 } gpio_drive_type;
+
+#define GPIO_PINS_0                 (0x0001U)
+#define GPIO_PINS_1                 (0x0002U)
+#define GPIO_PINS_2                 (0x0004U)
+#define GPIO_PINS_3                 (0x0008U)
+#define GPIO_PINS_11                (0x0800U)
+#define GPIO_PINS_12                (0x1000U)
+#define GPIO_PINS_13                (0x2000U)
+#define GPIO_PINS_14                (0x4000U)
+#define GPIO_PINS_15                (0x8000U)
+
+typedef struct {
+    uint32_t gpio_pins;
+    gpio_output_type gpio_out_type;
+    gpio_pull_type gpio_pull;
+    gpio_mode_type gpio_mode;
+    gpio_drive_type gpio_drive_strength;
+} gpio_init_type;
+
+typedef enum {
+    GPIO_PORT_SOURCE_GPIOA = 0x00,
+    GPIO_PORT_SOURCE_GPIOB = 0x01,
+    GPIO_PORT_SOURCE_GPIOC = 0x02,
+    GPIO_PORT_SOURCE_GPIOD = 0x03,
+    GPIO_PORT_SOURCE_GPIOE = 0x04,
+} gpio_port_source_type;
+
+typedef uint8_t gpio_pins_source_type;
+inline void gpio_default_para_init(gpio_init_type *gpio_init_struct) { *gpio_init_struct = gpio_init_type(); }
+inline void gpio_init(gpio_type *gpio_x, gpio_init_type *gpio_init_struct) {
+    (void)gpio_x;
+    (void)gpio_init_struct;
+}
+
+inline void gpio_bits_set(gpio_type *gpio_x, uint16_t pins) { gpio_x->odt |= pins; }
+inline void gpio_bits_reset(gpio_type *gpio_x, uint16_t pins) { gpio_x->odt &= ~static_cast<uint32_t>(pins); }
+
+inline void gpio_exint_line_config(gpio_port_source_type port_source, gpio_pins_source_type pin_source) {
+    (void)port_source;
+    (void)pin_source;
+}
+
+// EXINT: the pending flags, written 1 to clear as on the device
+typedef struct {
+    uint32_t inten;
+    uint32_t evten;
+    uint32_t polcfg1;
+    uint32_t polcfg2;
+    uint32_t swtrg;
+    uint32_t intsts;
+} exint_type;
+
+inline exint_type sim_exint;
+#define EXINT                       (&sim_exint)
+
+typedef enum { EXINT_LINE_INTERRUPUT = 0x00, EXINT_LINE_EVENT = 0x01 } exint_line_mode_type;
+typedef enum {
+    EXINT_TRIGGER_RISING_EDGE = 0x00,
+    EXINT_TRIGGER_FALLING_EDGE = 0x01,
+    EXINT_TRIGGER_BOTH_EDGE = 0x02,
+} exint_polarity_config_type;
+
+typedef struct {
+    exint_line_mode_type line_mode;
+    uint32_t line_select;
+    exint_polarity_config_type line_polarity;
+    confirm_state line_enable;
+} exint_init_type;
+
+inline void exint_default_para_init(exint_init_type *exint_struct) { *exint_struct = exint_init_type(); }
+inline void exint_init(exint_init_type *exint_struct) { EXINT->inten |= exint_struct->line_select; }
+inline void exint_flag_clear(uint32_t exint_line) { EXINT->intsts &= ~exint_line; }
+
+// NVIC and clocks: accepted and ignored
+typedef enum {
+    EXINT0_IRQn = 6,
+    EXINT9_5_IRQn = 23,
+    EXINT15_10_IRQn = 40,
+    DMA1_Channel5_IRQn = 15,
+    TMR5_GLOBAL_IRQn = 50,
+} IRQn_Type;
+
+inline void nvic_irq_enable(IRQn_Type irqn, uint32_t preempt_priority, uint32_t sub_priority) {
+    (void)irqn;
+    (void)preempt_priority;
+    (void)sub_priority;
+}
+
+typedef enum {
+    CRM_IOMUX_PERIPH_CLOCK = 0,
+    CRM_GPIOA_PERIPH_CLOCK,
+    CRM_GPIOB_PERIPH_CLOCK,
+    CRM_GPIOC_PERIPH_CLOCK,
+    CRM_TMR5_PERIPH_CLOCK,
+    CRM_SPI2_PERIPH_CLOCK,
+    CRM_DMA1_PERIPH_CLOCK,
+} crm_periph_clock_type;
+inline void crm_periph_clock_enable(crm_periph_clock_type value, confirm_state new_state) {
+    (void)value;
+    (void)new_state;
+}
+
+typedef struct {
+    uint32_t sclk_freq;
+    uint32_t ahb_freq;
+    uint32_t apb2_freq;
+    uint32_t apb1_freq;
+} crm_clocks_freq_type;
+
+// 240 MHz core, APB1 at half of it: the APB1 timers run at 240 MHz
+inline void crm_clocks_freq_get(crm_clocks_freq_type *clocks_struct) {
+    *clocks_struct = {240000000U, 240000000U, 120000000U, 120000000U};
+}
+
+// TMR: the registers the drivers read directly; the functions are in SimTimer.cpp
+typedef struct {
+    uint32_t iden;
+    uint32_t ists;
+    uint32_t cval;
+    uint32_t c1dt;
+    uint32_t c2dt;
+    uint32_t c3dt;
+    uint32_t c4dt;
+} tmr_type;
+
+inline tmr_type sim_tmr5;
+#define TMR5                        (&sim_tmr5)
+
+#define TMR_OVF_FLAG                (0x00000001U)
+#define TMR_C1_FLAG                 (0x00000002U)
+#define TMR_C2_FLAG                 (0x00000004U)
+#define TMR_C3_FLAG                 (0x00000008U)
+#define TMR_C4_FLAG                 (0x00000010U)
+#define TMR_C1_RECAPTURE_FLAG       (0x00000200U)
+#define TMR_OVF_INT                 (0x00000001U)
+#define TMR_C1_INT                  (0x00000002U)
+#define TMR_C2_INT                  (0x00000004U)
+#define TMR_C3_INT                  (0x00000008U)
+#define TMR_C4_INT                  (0x00000010U)
+
+typedef enum {
+    TMR_SELECT_CHANNEL_1 = 0x00,
+    TMR_SELECT_CHANNEL_2 = 0x04,
+    TMR_SELECT_CHANNEL_3 = 0x08,
+    TMR_SELECT_CHANNEL_4 = 0x0C,
+} tmr_channel_select_type;
+
+typedef enum {
+    TMR_OUTPUT_CONTROL_OFF = 0x00,
+    TMR_OUTPUT_CONTROL_HIGH = 0x01,
+    TMR_OUTPUT_CONTROL_LOW = 0x02,
+    TMR_OUTPUT_CONTROL_SWITCH = 0x03,
+    TMR_OUTPUT_CONTROL_FORCE_LOW = 0x04,
+    TMR_OUTPUT_CONTROL_FORCE_HIGH = 0x05,
+    TMR_OUTPUT_CONTROL_PWM_MODE_A = 0x06,
+    TMR_OUTPUT_CONTROL_PWM_MODE_B = 0x07,
+} tmr_output_control_mode_type;
+
+typedef enum { TMR_OUTPUT_ACTIVE_HIGH = 0x00, TMR_OUTPUT_ACTIVE_LOW = 0x01 } tmr_output_polarity_type;
+typedef enum { TMR_COUNT_UP = 0x00, TMR_COUNT_DOWN = 0x10 } tmr_count_mode_type;
+typedef enum { TMR_CC_CHANNEL_MAPPED_DIRECT = 0x01 } tmr_input_direction_mapped_type;
+typedef enum { TMR_INPUT_RISING_EDGE = 0x00, TMR_INPUT_FALLING_EDGE = 0x01 } tmr_input_polarity_type;
+typedef enum { TMR_CHANNEL_INPUT_DIV_1 = 0x00 } tmr_channel_input_divider_type;
+
+typedef struct {
+    tmr_output_control_mode_type oc_mode;
+    confirm_state oc_idle_state;
+    confirm_state occ_idle_state;
+    tmr_output_polarity_type oc_polarity;
+    tmr_output_polarity_type occ_polarity;
+    confirm_state oc_output_state;
+    confirm_state occ_output_state;
+} tmr_output_config_type;
+
+typedef struct {
+    tmr_channel_select_type input_channel_select;
+    tmr_input_polarity_type input_polarity_select;
+    tmr_input_direction_mapped_type input_mapped_select;
+    uint8_t input_filter_value;
+} tmr_input_config_type;
+
+void tmr_32_bit_function_enable(tmr_type *tmr_x, confirm_state new_state);
+void tmr_base_init(tmr_type *tmr_x, uint32_t tmr_pr, uint32_t tmr_div);
+void tmr_cnt_dir_set(tmr_type *tmr_x, tmr_count_mode_type tmr_cnt_dir);
+void tmr_counter_enable(tmr_type *tmr_x, confirm_state new_state);
+uint32_t tmr_counter_value_get(tmr_type *tmr_x);
+void tmr_input_channel_init(tmr_type *tmr_x, tmr_input_config_type *input_struct, tmr_channel_input_divider_type divider_factor);
+void tmr_output_default_para_init(tmr_output_config_type *tmr_output_struct);
+void tmr_output_channel_config(tmr_type *tmr_x, tmr_channel_select_type tmr_channel, tmr_output_config_type *tmr_output_struct);
+void tmr_output_channel_mode_select(tmr_type *tmr_x, tmr_channel_select_type tmr_channel, tmr_output_control_mode_type oc_mode);
+void tmr_channel_value_set(tmr_type *tmr_x, tmr_channel_select_type tmr_channel, uint32_t tmr_channel_value);
+uint32_t tmr_channel_value_get(tmr_type *tmr_x, tmr_channel_select_type tmr_channel);
+void tmr_interrupt_enable(tmr_type *tmr_x, uint32_t tmr_interrupt, confirm_state new_state);
+flag_status tmr_flag_get(tmr_type *tmr_x, uint32_t tmr_flag);
+void tmr_flag_clear(tmr_type *tmr_x, uint32_t tmr_flag);
+
+// SPI: the transmit side as the display driver uses it; the functions are in SimPanel.cpp
+typedef struct {
+    uint32_t dt;
+} spi_type;
+
+inline spi_type sim_spi2;
+#define SPI2                        (&sim_spi2)
+
+typedef enum { SPI_TRANSMIT_FULL_DUPLEX = 0x00, SPI_TRANSMIT_HALF_DUPLEX_TX = 0x03 } spi_transmission_mode_type;
+typedef enum { SPI_MODE_SLAVE = 0x00, SPI_MODE_MASTER = 0x01 } spi_master_slave_mode_type;
+typedef enum { SPI_MCLK_DIV_2 = 0x00, SPI_MCLK_DIV_16 = 0x03 } spi_mclk_freq_div_type;
+typedef enum { SPI_FIRST_BIT_MSB = 0x00, SPI_FIRST_BIT_LSB = 0x01 } spi_first_bit_type;
+typedef enum { SPI_FRAME_8BIT = 0x00, SPI_FRAME_16BIT = 0x01 } spi_frame_bit_num_type;
+typedef enum { SPI_CLOCK_POLARITY_LOW = 0x00, SPI_CLOCK_POLARITY_HIGH = 0x01 } spi_clock_polarity_type;
+typedef enum { SPI_CLOCK_PHASE_1EDGE = 0x00, SPI_CLOCK_PHASE_2EDGE = 0x01 } spi_clock_phase_type;
+typedef enum { SPI_CS_HARDWARE_MODE = 0x00, SPI_CS_SOFTWARE_MODE = 0x01 } spi_cs_mode_type;
+
+typedef struct {
+    spi_transmission_mode_type transmission_mode;
+    spi_master_slave_mode_type master_slave_mode;
+    spi_mclk_freq_div_type mclk_freq_division;
+    spi_first_bit_type first_bit_transmission;
+    spi_frame_bit_num_type frame_bit_num;
+    spi_clock_polarity_type clock_polarity;
+    spi_clock_phase_type clock_phase;
+    spi_cs_mode_type cs_mode_selection;
+} spi_init_type;
+
+#define SPI_I2S_TDBE_FLAG           (0x0002U)
+#define SPI_I2S_BF_FLAG             (0x0080U)
+
+inline void spi_default_para_init(spi_init_type *spi_init_struct) { *spi_init_struct = spi_init_type(); }
+void spi_init(spi_type *spi_x, spi_init_type *spi_init_struct);
+void spi_enable(spi_type *spi_x, confirm_state new_state);
+void spi_i2s_dma_transmitter_enable(spi_type *spi_x, confirm_state new_state);
+flag_status spi_i2s_flag_get(spi_type *spi_x, uint32_t spi_i2s_flag);
+void spi_i2s_data_transmit(spi_type *spi_x, uint16_t tx_data);
+
+// DMA: one channel, memory to peripheral; the functions are in SimPanel.cpp
+typedef struct {
+    uint32_t ctrl;
+    uint32_t dtcnt;
+    uint32_t paddr;
+    uint32_t maddr;
+} dma_channel_type;
+
+inline dma_channel_type sim_dma1_channel5;
+#define DMA1_CHANNEL5               (&sim_dma1_channel5)
+
+#define DMA_FDT_INT                 (0x00000002U)
+#define DMA1_FDT5_FLAG              (0x00020000U)
+
+typedef enum { DMA_DIR_PERIPHERAL_TO_MEMORY = 0x0000, DMA_DIR_MEMORY_TO_PERIPHERAL = 0x0010 } dma_dir_type;
+typedef enum { DMA_PERIPHERAL_DATA_WIDTH_BYTE = 0x0000 } dma_peripheral_data_size_type;
+typedef enum { DMA_MEMORY_DATA_WIDTH_BYTE = 0x0000 } dma_memory_data_size_type;
+typedef enum { DMA_PRIORITY_LOW = 0x0000, DMA_PRIORITY_HIGH = 0x2000 } dma_priority_level_type;
+
+typedef struct {
+    uint32_t peripheral_base_addr;
+    uint32_t memory_base_addr;
+    dma_dir_type direction;
+    uint16_t buffer_size;
+    confirm_state peripheral_inc_enable;
+    confirm_state memory_inc_enable;
+    dma_peripheral_data_size_type peripheral_data_width;
+    dma_memory_data_size_type memory_data_width;
+    confirm_state loop_mode_enable;
+    dma_priority_level_type priority;
+} dma_init_type;
+
+inline void dma_default_para_init(dma_init_type *dma_init_struct) { *dma_init_struct = dma_init_type(); }
+void dma_reset(dma_channel_type *dmax_channely);
+void dma_init(dma_channel_type *dmax_channely, dma_init_type *dma_init_struct);
+void dma_interrupt_enable(dma_channel_type *dmax_channely, uint32_t dma_int, confirm_state new_state);
+void dma_data_number_set(dma_channel_type *dmax_channely, uint16_t data_number);
+void dma_channel_enable(dma_channel_type *dmax_channely, confirm_state new_state);
+flag_status dma_flag_get(uint32_t dmax_flag);
+void dma_flag_clear(uint32_t dmax_flag);
+
+#endif
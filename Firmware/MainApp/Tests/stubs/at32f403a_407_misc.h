@@ -0,0 +1,2 @@
+// Host stand-in, everything is in at32f403a_407.h
+#include "at32f403a_407.h"
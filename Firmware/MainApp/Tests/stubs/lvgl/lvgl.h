@@ -0,0 +1,103 @@
+#ifndef LVGL_H
+#define LVGL_H
+
+// Host stand-in for the LVGL 8.3 display driver API the panel driver uses, with
+// LV_COLOR_DEPTH 8 as ui.c requires. Nothing is drawn: the tests fill the draw
+// buffers themselves and call the registered callbacks the way lv_refr does.
+
+#include <stdint.h>
+
+#define LV_COLOR_DEPTH              8
+
+typedef int16_t lv_coord_t;
+
+typedef struct {
+    lv_coord_t x1;
+    lv_coord_t y1;
+    lv_coord_t x2;
+    lv_coord_t y2;
+} lv_area_t;
+
+inline lv_coord_t lv_area_get_width(const lv_area_t *area) { return static_cast<lv_coord_t>(area->x2 - area->x1 + 1); }
+inline lv_coord_t lv_area_get_height(const lv_area_t *area) { return static_cast<lv_coord_t>(area->y2 - area->y1 + 1); }
+
+// RGB332
+typedef union {
+    struct {
+        uint8_t blue : 2;
+        uint8_t green : 3;
+        uint8_t red : 3;
+    } ch;
+    uint8_t full;
+} lv_color_t;
+
+inline lv_color_t lv_color_make(uint8_t r, uint8_t g, uint8_t b) {
+    lv_color_t color;
+    color.ch.red = static_cast<uint8_t>(r >> 5);
+    color.ch.green = static_cast<uint8_t>(g >> 5);
+    color.ch.blue = static_cast<uint8_t>(b >> 6);
+    return color;
+}
+inline lv_color_t lv_color_black(void) { return lv_color_make(0x00, 0x00, 0x00); }
+inline lv_color_t lv_color_white(void) { return lv_color_make(0xFF, 0xFF, 0xFF); }
+
+// As lv_color_to32() and lv_color_brightness() of LVGL 8.3
+inline uint8_t lv_color_brightness(lv_color_t color) {
+    const uint16_t r = static_cast<uint16_t>(color.ch.red * 36U);
+    const uint16_t g = static_cast<uint16_t>(color.ch.green * 36U);
+    const uint16_t b = static_cast<uint16_t>(color.ch.blue * 85U);
+    return static_cast<uint8_t>((3U * r + b + 4U * g) >> 3);
+}
+
+typedef struct {
+    void *buf1;
+    void *buf2;
+    void *buf_act;
+    uint32_t size;                      // pixels
+    volatile int flushing;
+    volatile int flushing_last;
+} lv_disp_draw_buf_t;
+
+typedef struct _lv_disp_drv_t {
+    lv_coord_t hor_res;
+    lv_coord_t ver_res;
+    lv_disp_draw_buf_t *draw_buf;
+    void (*flush_cb)(struct _lv_disp_drv_t *disp_drv, const lv_area_t *area, lv_color_t *color_p);
+    void (*rounder_cb)(struct _lv_disp_drv_t *disp_drv, lv_area_t *area);
+    void (*wait_cb)(struct _lv_disp_drv_t *disp_drv);
+} lv_disp_drv_t;
+
+typedef struct {
+    lv_disp_drv_t *driver;
+} lv_disp_t;
+
+inline lv_disp_t sim_lv_disp;                   // the registered display
+inline uint32_t sim_lv_flush_ready_count;
+
+inline void lv_init(void) {
+    sim_lv_disp = lv_disp_t();
+    sim_lv_flush_ready_count = 0;
+}
+
+inline void lv_disp_draw_buf_init(lv_disp_draw_buf_t *draw_buf, void *buf1, void *buf2, uint32_t size_in_px_cnt) {
+    *draw_buf = lv_disp_draw_buf_t();
+    draw_buf->buf1 = buf1;
+    draw_buf->buf2 = buf2;
+    draw_buf->buf_act = buf1;
+    draw_buf->size = size_in_px_cnt;
+}
+
+inline void lv_disp_drv_init(lv_disp_drv_t *driver) { *driver = lv_disp_drv_t(); }
+
+inline lv_disp_t *lv_disp_drv_register(lv_disp_drv_t *driver) {
+    sim_lv_disp.driver = driver;
+    return &sim_lv_disp;
+}
+
+inline void lv_disp_flush_ready(lv_disp_drv_t *disp_drv) {
+    disp_drv->draw_buf->flushing = 0;
+    disp_drv->draw_buf->flushing_last = 0;
+    sim_lv_flush_ready_count++;
+}
+
+#endif // LVGL_H
@@ -0,0 +1,12 @@
+#ifndef _MB_PORT_H
+#define _MB_PORT_H
+
+// Host stand-in for the FreeModbus port header, only the types ModbusConfig uses
+
+typedef enum {
+    MB_PAR_NONE,
+    MB_PAR_ODD,
+    MB_PAR_EVEN
+} eMBParity;
+
+#endif
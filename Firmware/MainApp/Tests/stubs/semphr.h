@@ -0,0 +1 @@
+// Host stand-in, everything is in FreeRTOS.h
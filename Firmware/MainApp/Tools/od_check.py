@@ -0,0 +1,106 @@
+#!/usr/bin/env python3
+"""Check that the generated object dictionary matches its EDS.
+
+    od_check.py [PROJECT.eds] [OD.c] [OD.h]
+
+Defaults to the project file named in OD.h (Library/CANopen). OD.c/OD.h are
+generated by CANopenEditor and must never be edited by hand: add or change
+objects in the EDS and regenerate. This check catches the two ways the pair
+drifts apart - an object present on only one side, and OD_ENTRY_H* indices
+that no longer match the position of the object in ODList. For every object
+the index, the object type and the number of sub-entries are compared.
+
+Exit status 0 when consistent, 1 with one line per difference otherwise.
+"""
+
+import os
+import re
+import sys
+
+CANOPEN_DIR = os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "Library", "CANopen")
+OBJECT_TYPES = {0x7: "ODT_VAR", 0x8: "ODT_ARR", 0x9: "ODT_REC"}
+
+
+def read_eds(path):
+    """Return {index: (odt, sub_count)} of the objects listed in the EDS."""
+    sections = {}
+    name = None
+    with open(path, encoding="latin-1") as f:
+        for line in f:
+            line = line.strip()
+            if not line or line.startswith(";"):
+                continue
+            if line.startswith("[") and line.endswith("]"):
+                name = line[1:-1].upper()
+                sections[name] = {}
+            elif name is not None and "=" in line:
+                key, value = line.split("=", 1)
+                sections[name][key.strip().lower()] = value.strip()
+
+    objects = {}
+    for group in ("MANDATORYOBJECTS", "OPTIONALOBJECTS", "MANUFACTUREROBJECTS"):
+        listing = sections.get(group, {})
+        for i in range(1, int(listing.get("supportedobjects", "0"), 0) + 1):
+            index = int(listing[str(i)], 0)
+            obj = sections["%04X" % index]
+            object_type = int(obj.get("objecttype", "0x7"), 0)
+            sub_count = int(obj.get("subnumber", "1"), 0) if object_type != 0x7 else 1
+            objects[index] = (OBJECT_TYPES.get(object_type, hex(object_type)), sub_count)
+    return objects
+
+
+def read_od_c(path):
+    """Return the ODList entries as [(index, odt, sub_count)] in list order."""
+    with open(path, encoding="latin-1") as f:
+        text = f.read()
+    body = re.search(r"OD_entry_t ODList\[\] = \{(.*?)\n\};", text, re.S).group(1)
+    entries = []
+    for m in re.finditer(r"\{0x([0-9A-Fa-f]{4}), 0x([0-9A-Fa-f]{2}), (ODT_\w+),", body):
+        entries.append((int(m.group(1), 16), m.group(3), int(m.group(2), 16)))
+    return entries
+
+
+def read_od_h(path):
+    """Return the project file name and {index: list position} of OD_ENTRY_H* macros."""
+    with open(path, encoding="latin-1") as f:
+        text = f.read()
+    project = re.search(r"Project File:\s*(\S+)", text).group(1)
+    positions = {}
+    for m in re.finditer(r"#define OD_ENTRY_H([0-9A-Fa-f]{4})\w* &OD->list\[(\d+)\]", text):
+        positions.setdefault(int(m.group(1), 16), set()).add(int(m.group(2)))
+    return project, positions
+
+
+def main(argv):
+    od_h = argv[3] if len(argv) > 3 else os.path.join(CANOPEN_DIR, "OD.h")
+    od_c = argv[2] if len(argv) > 2 else os.path.join(CANOPEN_DIR, "OD.c")
+    project, positions = read_od_h(od_h)
+    eds = argv[1] if len(argv) > 1 else os.path.join(os.path.dirname(od_h), project)
+
+    objects = read_eds(eds)
+    entries = read_od_c(od_c)
+    errors = []
+
+    listed = set()
+    for position, (index, odt, sub_count) in enumerate(entries):
+        listed.add(index)
+        if index not in objects:
+            errors.append("0x%04X: in OD.c but not in %s" % (index, os.path.basename(eds)))
+        elif objects[index] != (odt, sub_count):
+            errors.append("0x%04X: OD.c has %s with %d entries, the EDS %s with %d"
+                          % (index, odt, sub_count, objects[index][0], objects[index][1]))
+        if positions.get(index) != {position}:
+            errors.append("0x%04X: OD_ENTRY_H%04X points to %s, ODList position is %d"
+                          % (index, index, sorted(positions.get(index, [])), position))
+    for index in sorted(set(objects) - listed):
+        errors.append("0x%04X: in %s but not in OD.c" % (index, os.path.basename(eds)))
+    if [e[0] for e in entries] != sorted(listed):
+        errors.append("ODList is not sorted by index")
+
+    for line in errors:
+        print(line)
+    return 1 if errors else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv))
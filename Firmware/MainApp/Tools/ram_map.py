@@ -0,0 +1,145 @@
+#!/usr/bin/env python3
+"""Summarise the RAM use of the main application from the linker map file.
+
+    ram_map.py FIRMWARE.map [--top N]
+
+Run as a post-build step (CMakeLists.txt). Prints the RAM output sections,
+the statically allocated task memory (.bss.task_memory, stacks and TCBs
+from main.cpp), the FreeRTOS heap (ucHeap, configTOTAL_HEAP_SIZE) and the
+N largest RAM contributors by object file. Input is the map written by GNU
+ld with -Map; only the allocation lines are read, so the report does not
+depend on the linker script.
+"""
+
+import argparse
+import collections
+import os
+import re
+import sys
+
+HEX = r"0x[0-9a-fA-F]+"
+REGION = re.compile(r"^(\S+)\s+(%s)\s+(%s)\s+\S+" % (HEX, HEX))
+OUTPUT_SECTION = re.compile(r"^(\.\S+)\s+(%s)\s+(%s)" % (HEX, HEX))
+OUTPUT_SECTION_NAME = re.compile(r"^(\.\S+)\s*$")
+INPUT_SECTION = re.compile(r"^ (\.\S+|COMMON)\s+(%s)\s+(%s)\s+(\S.*)$" % (HEX, HEX))
+INPUT_SECTION_NAME = re.compile(r"^ (\.\S+|COMMON)\s*$")
+ADDRESS_SIZE_FILE = re.compile(r"^\s+(%s)\s+(%s)\s+(\S.*)$" % (HEX, HEX))
+
+
+def parse(lines):
+    """Return (regions, output sections, input sections) of a GNU ld map."""
+    regions = []
+    outputs = []
+    inputs = []
+    in_regions = False
+    in_map = False
+    pending_output = None
+    pending_input = None
+    for line in lines:
+        line = line.rstrip("\n")
+        if line.startswith("Memory Configuration"):
+            in_regions = True
+            continue
+        if line.startswith("Linker script and memory map"):
+            in_regions = False
+            in_map = True
+            continue
+        if in_regions:
+            m = REGION.match(line)
+            if m and m.group(1) != "Name":
+                regions.append((m.group(1), int(m.group(2), 16), int(m.group(3), 16)))
+            continue
+        if not in_map:
+            continue
+
+        # Long section names put address and size on the following line
+        if pending_output is not None:
+            m = re.match(r"^\s+(%s)\s+(%s)" % (HEX, HEX), line)
+            if m:
+                outputs.append((pending_output, int(m.group(1), 16), int(m.group(2), 16)))
+            pending_output = None
+            continue
+        if pending_input is not None:
+            m = ADDRESS_SIZE_FILE.match(line)
+            if m:
+                inputs.append((pending_input, int(m.group(1), 16), int(m.group(2), 16), m.group(3)))
+            pending_input = None
+            continue
+
+        m = OUTPUT_SECTION.match(line)
+        if m:
+            outputs.append((m.group(1), int(m.group(2), 16), int(m.group(3), 16)))
+            continue
+        m = OUTPUT_SECTION_NAME.match(line)
+        if m:
+            pending_output = m.group(1)
+            continue
+        m = INPUT_SECTION.match(line)
+        if m:
+            inputs.append((m.group(1), int(m.group(2), 16), int(m.group(3), 16), m.group(4)))
+            continue
+        m = INPUT_SECTION_NAME.match(line)
+        if m:
+            pending_input = m.group(1)
+    return regions, outputs, inputs
+
+
+def ram_regions(regions):
+    """RAM regions of the map; the first region whose name contains RAM otherwise."""
+    ram = [r for r in regions if "RAM" in r[0].upper()]
+    return ram
+
+
+def in_regions(address, regions):
+    return any(origin <= address < origin + length for _, origin, length in regions)
+
+
+def object_name(path):
+    """Short name of an input file: the object, or archive(member)."""
+    m = re.match(r"(.*\.a)\((.*)\)$", path)
+    if m:
+        return "%s(%s)" % (os.path.basename(m.group(1)), m.group(2))
+    name = os.path.basename(path)
+    return re.sub(r"\.(c|cpp|s|S)\.obj$", r".\1", name)
+
+
+def main(argv):
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("map")
+    parser.add_argument("--top", type=int, default=15, help="object files to list")
+    args = parser.parse_args(argv[1:])
+
+    with open(args.map, encoding="latin-1") as f:
+        regions, outputs, inputs = parse(f)
+    ram = ram_regions(regions)
+    if not ram:
+        print("ram_map: no RAM region in %s" % args.map)
+        return 1
+
+    print("RAM map (%s)" % os.path.basename(args.map))
+    for name, origin, length in ram:
+        used = sum(size for _, address, size in outputs if size and origin <= address < origin + length)
+        print("  %-12s 0x%08X %7d of %7d bytes (%.1f %%)" % (name, origin, used, length, 100.0 * used / length))
+
+    print("Output sections")
+    for name, address, size in outputs:
+        if size and in_regions(address, ram):
+            print("  %-24s 0x%08X %7d" % (name, address, size))
+
+    ram_inputs = [i for i in inputs if i[2] and in_regions(i[1], ram)]
+    task_memory = sum(size for name, _, size, _ in ram_inputs if name == ".bss.task_memory")
+    heap = sum(size for name, _, size, _ in ram_inputs if name.endswith(".ucHeap"))
+    print("Static task memory (.bss.task_memory) %7d" % task_memory)
+    print("FreeRTOS heap (ucHeap)                %7d" % heap)
+
+    per_object = collections.Counter()
+    for _, _, size, path in ram_inputs:
+        per_object[object_name(path)] += size
+    print("Largest RAM users")
+    for name, size in per_object.most_common(args.top):
+        print("  %7d %s" % (size, name))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv))
@@ -0,0 +1,145 @@
+#!/usr/bin/env python3
+"""Decode the binary trace of the main application (Library/Trace/Trace.h).
+
+    trace_decode.py FIRMWARE.elf CAPTURE.bin              text, one line per record
+    trace_decode.py FIRMWARE.elf CAPTURE.bin --csv OUT    timeline: time, delta, format address, text
+
+CAPTURE.bin is the raw byte stream of RTT channel 1 ("Trace"), e.g. from
+JLinkRTTLogger -RTTChannel 1, or of TRACE_UART. A record is little-endian
+32-bit words: header (0xA in the top nibble, argument count in bits 24-27,
+format string offset from 0x08000000 in bits 0-23), DWT cycle counter,
+arguments. Format strings and %s arguments are read from the ELF. Bytes
+that do not start a valid record (UART noise, a capture started mid-record)
+are skipped until the next one.
+"""
+
+import argparse
+import csv
+import re
+import struct
+import sys
+
+SYNC = 0xA
+FMT_BASE = 0x08000000
+MAX_ARGS = 4
+CONVERSION = re.compile(r"%([-+ #0]*)(\d*)(?:\.(\d+))?(hh|h|ll|l|z|t|j)?([diuoxXcspfFeEgG%])")
+
+
+class Elf:
+    """Loadable sections of a 32-bit little-endian ELF, enough to read strings by address"""
+
+    def __init__(self, path):
+        with open(path, "rb") as f:
+            self.data = f.read()
+        if self.data[:4] != b"\x7fELF" or self.data[4] != 1 or self.data[5] != 1:
+            sys.exit(f"{path}: not a 32-bit little-endian ELF")
+        shoff, = struct.unpack_from("<I", self.data, 0x20)
+        shentsize, shnum = struct.unpack_from("<HH", self.data, 0x2E)
+        self.sections = []
+        for i in range(shnum):
+            _, sh_type, flags, addr, offset, size = struct.unpack_from("<6I", self.data, shoff + i * shentsize)
+            if sh_type == 1 and flags & 0x2 and size:  # SHT_PROGBITS, SHF_ALLOC
+                self.sections.append((addr, offset, size))
+
+    def string(self, address):
+        for addr, offset, size in self.sections:
+            if addr <= address < addr + size:
+                start = offset + address - addr
+                end = self.data.find(b"\0", start, offset + size)
+                return self.data[start:end if end >= 0 else offset + size].decode("latin-1")
+        return None
+
+
+def format_record(elf, fmt, args):
+    args = list(args)
+    out = []
+    pos = 0
+    for m in CONVERSION.finditer(fmt):
+        out.append(fmt[pos:m.start()])
+        pos = m.end()
+        flags, width, precision, _, conv = m.groups()
+        if conv == "%":
+            out.append("%")
+            continue
+        if not args:
+            out.append("<missing>")
+            continue
+        word = args.pop(0)
+        spec = "%" + flags + width + ("." + precision if precision is not None else "")
+        if conv in "di":
+            out.append((spec + "d") % (word - (1 << 32) if word & 0x80000000 else word))
+        elif conv in "uoxX":
+            out.append((spec + ("d" if conv == "u" else conv)) % word)
+        elif conv == "c":
+            out.append((spec + "c") % chr(word & 0xFF))
+        elif conv == "p":
+            out.append(f"0x{word:08x}")
+        elif conv == "s":
+            text = elf.string(word)
+            out.append((spec + "s") % (text if text is not None else f"<0x{word:08x}>"))
+        else:
+            out.append((spec + conv) % struct.unpack("<f", struct.pack("<I", word))[0])
+    out.append(fmt[pos:])
+    if args:
+        out.append(" <extra:" + " ".join(f"0x{w:08x}" for w in args) + ">")
+    return "".join(out)
+
+
+def records(stream, elf):
+    """Yield (format address, cycles, args), resynchronising on bad headers"""
+    pos = 0
+    skipped = 0
+    while pos + 8 <= len(stream):
+        header, cycles = struct.unpack_from("<II", stream, pos)
+        count = (header >> 24) & 0xF
+        address = FMT_BASE + (header & 0x00FFFFFF)
+        fmt = elf.string(address) if header >> 28 == SYNC and count <= MAX_ARGS else None
+        if fmt is None or pos + 8 + 4 * count > len(stream):
+            pos += 1
+            skipped += 1
+            continue
+        if skipped:
+            print(f"# skipped {skipped} bytes", file=sys.stderr)
+            skipped = 0
+        args = struct.unpack_from(f"<{count}I", stream, pos + 8)
+        pos += 8 + 4 * count
+        yield address, fmt, cycles, args
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("elf")
+    parser.add_argument("capture")
+    parser.add_argument("--clock", type=float, default=240e6, help="DWT clock in Hz (default 240 MHz)")
+    parser.add_argument("--csv", metavar="OUT", help="write the timeline as CSV instead of text")
+    args = parser.parse_args()
+
+    elf = Elf(args.elf)
+    with open(args.capture, "rb") as f:
+        stream = f.read()
+
+    writer = None
+    if args.csv:
+        out = open(args.csv, "w", newline="")
+        writer = csv.writer(out)
+        writer.writerow(["time_s", "delta_us", "format", "text"])
+
+    # The 32-bit cycle counter wraps every 2^32 / clock seconds (17.9 s at 240 MHz);
+    # records are unwrapped against the previous one, small steps back come from preemption
+    time = 0
+    previous = None
+    for address, fmt, cycles, values in records(stream, elf):
+        step = 0 if previous is None else (cycles - previous) & 0xFFFFFFFF
+        if step >= 0x80000000:
+            step -= 1 << 32
+        time += step
+        previous = cycles
+        text = format_record(elf, fmt, values).rstrip("\n")
+        if writer:
+            writer.writerow([f"{time / args.clock:.6f}", f"{step * 1e6 / args.clock:.3f}", f"0x{address:08x}", text])
+        else:
+            print(f"{time / args.clock:12.6f} {step * 1e6 / args.clock:+12.3f} us  {text}")
+
+
+if __name__ == "__main__":
+    main()
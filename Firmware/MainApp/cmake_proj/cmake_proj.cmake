@@ -61,6 +61,18 @@ file(GLOB_RECURSE sources_SRCS
   "Library/GPIO/*.c*"
   "Library/Input/*.c*"
   "Library/Periphery/*.c*"
+  "Library/Mains/*.c*"
+  "Library/Triac/*.c*"
+  "Library/AnalogOutput/*.c*"
+  "Library/Relay/*.c*"
+  "Library/Storage/*.c*"
+  "Library/ErrorLog/*.c*"
+  "Library/Trend/*.c*"
+  "Library/BootProfile/*.c*"
+  "Library/Profiler/*.c*"
+  "Library/Trace/*.c*"
+  "Library/Power/*.c*"
+  "Library/Deadline/*.c*"
   "Library/CANopen/*.c*"
 
   # CANopenNode stack - core CANopen protocol implementation
@@ -152,6 +164,18 @@ set(include_c_DIRS ${include_c_DIRS}
   ${CMAKE_CURRENT_SOURCE_DIR}/Library/GPIO
   ${CMAKE_CURRENT_SOURCE_DIR}/Library/Input
   ${CMAKE_CURRENT_SOURCE_DIR}/Library/Periphery
+  ${CMAKE_CURRENT_SOURCE_DIR}/Library/Mains
+  ${CMAKE_CURRENT_SOURCE_DIR}/Library/Triac
+  ${CMAKE_CURRENT_SOURCE_DIR}/Library/AnalogOutput
+  ${CMAKE_CURRENT_SOURCE_DIR}/Library/Relay
+  ${CMAKE_CURRENT_SOURCE_DIR}/Library/Storage
+  ${CMAKE_CURRENT_SOURCE_DIR}/Library/ErrorLog
+  ${CMAKE_CURRENT_SOURCE_DIR}/Library/Trend
+  ${CMAKE_CURRENT_SOURCE_DIR}/Library/BootProfile
+  ${CMAKE_CURRENT_SOURCE_DIR}/Library/Profiler
+  ${CMAKE_CURRENT_SOURCE_DIR}/Library/Trace
+  ${CMAKE_CURRENT_SOURCE_DIR}/Library/Power
+  ${CMAKE_CURRENT_SOURCE_DIR}/Library/Deadline
   ${CMAKE_CURRENT_SOURCE_DIR}/Library/CANopen
 
   # CANopenNode stack includes
@@ -0,0 +1,45 @@
+#include "BootProfile.h"
+
+uint32_t BootProfile::stamps[static_cast<uint8_t>(BootPhase::COUNT)];
+bool BootProfile::previous_clean;
+bool BootProfile::cold;
+
+static const bpr_data_type stamp_regs[static_cast<uint8_t>(BootPhase::COUNT)] = {
+    BPR_DATA14, BPR_DATA15, BPR_DATA16, BPR_DATA17,
+    BPR_DATA18, BPR_DATA19, BPR_DATA20, BPR_DATA21,
+};
+
+void BootProfile::Begin(void)
+{
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+    cold = crm_flag_get(CRM_POR_RESET_FLAG) == SET || crm_flag_get(CRM_WDT_RESET_FLAG) == SET;
+
+    const uint16_t clean = BOOT_PROFILE_APP_STARTED | BOOT_PROFILE_APP_RUNNING;
+    previous_clean = bpr_data_read(BPR_DATA13) == BOOT_PROFILE_MARKER &&
+                     (bpr_data_read(BPR_DATA22) & clean) == clean;
+    bpr_data_write(BPR_DATA22, 0);
+}
+
+void BootProfile::Mark(BootPhase phase)
+{
+    // 0 means skipped, a phase done within the first cycle still reads 1
+    stamps[static_cast<uint8_t>(phase)] = DWT->CYCCNT | 1U;
+}
+
+void BootProfile::Commit(uint16_t flags)
+{
+    const uint32_t cycles_per_tick = system_core_clock / (1000000U / BOOT_PROFILE_TICK_US);
+
+    bpr_data_write(BPR_DATA13, BOOT_PROFILE_MARKER);
+    for (uint8_t i = 0; i < static_cast<uint8_t>(BootPhase::COUNT); i++)
+    {
+        uint32_t ticks = stamps[i] / cycles_per_tick;
+        if (stamps[i] != 0 && ticks == 0)
+            ticks = 1;
+        bpr_data_write(stamp_regs[i], static_cast<uint16_t>(ticks > 0xFFFFU ? 0xFFFFU : ticks));
+    }
+    bpr_data_write(BPR_DATA22, flags);
+}
@@ -0,0 +1,65 @@
+#ifndef _BOOT_PROFILE_H
+#define _BOOT_PROFILE_H
+
+#include "at32f403a_407.h"
+
+#define BOOT_PROFILE_MARKER (0xB001U)  // BPR_DATA13, layout version 1
+#define BOOT_PROFILE_TICK_US (10U)     // stamp unit, 16 bits cover 655 ms
+
+/// @brief End of each start-up phase, in BPR order
+enum class BootPhase : uint8_t
+{
+    RTC = 0,     // rtc_module_init
+    FLASH,       // FlashService, memory protection, watchdog
+    USB,         // USB detection and init
+    CONFIG,      // BootloadConfig::Init
+    JOURNAL,     // BootloadJournal::Init, CheckWDRTS
+    BOOT_FLAGS,  // HandleBootFlags
+    APP_CHECK,   // AppCheck::IsValid
+    JUMP,        // right before load_app
+    COUNT,
+};
+
+/// @brief Flags word after the stamps
+enum BootProfileFlags : uint16_t
+{
+    BOOT_PROFILE_FAST = 0x0001,         // fast path, skipped phases read 0
+    BOOT_PROFILE_COLD = 0x0002,         // power-on or watchdog reset
+    BOOT_PROFILE_APP_STARTED = 0x0004,  // bootloader jumped to the application
+    BOOT_PROFILE_APP_RUNNING = 0x0008,  // set by the application once it is up
+};
+
+/// @brief Boot-phase profiler
+///
+/// Phases are stamped with the DWT cycle counter, started by Begin. Commit
+/// writes the stamps (time since Begin, BOOT_PROFILE_TICK_US units) and the
+/// flags to BPR_DATA13..BPR_DATA22, where the application reads them:
+///   BPR_DATA13              BOOT_PROFILE_MARKER
+///   BPR_DATA14..BPR_DATA21  BootPhase stamps, 0 = phase skipped
+///   BPR_DATA22              BootProfileFlags
+///
+/// Begin also reads the flags the previous boot left: the previous boot was
+/// clean if the bootloader started the application and the application
+/// reported itself running. The flags are cleared at once, so a boot that
+/// dies before the application is up is not clean for the next one.
+class BootProfile
+{
+public:
+    static void Begin(void);
+    static void Mark(BootPhase phase);
+
+    /// @brief Write the profile to the backup registers
+    static void Commit(uint16_t flags);
+
+    static bool PreviousBootClean(void) { return previous_clean; }
+
+    /// @brief Power-on or watchdog reset
+    static bool IsColdReset(void) { return cold; }
+
+private:
+    static uint32_t stamps[static_cast<uint8_t>(BootPhase::COUNT)];
+    static bool previous_clean;
+    static bool cold;
+};
+
+#endif
@@ -24,6 +24,13 @@ CMD_Map_t cmdMap[] = {
     {REQUEST_COM_PREFIX, 0x45, 3, CheckAppExistence_cmd, MAP_FLGS(0x0, 0x0)},
     {REQUEST_COM_PREFIX, 0x46, 3, IsMemoryProtect_cmd, MAP_FLGS(0x0, 0x0)},
     {REQUEST_COM_PREFIX, 0x47, 4, SetMemoryProtection_cmd, MAP_FLGS(0x0, 0x0)},
+    {REQUEST_COM_PREFIX, 0x48, 135, QueueData_cmd, MAP_FLGS(0x0, 0x0)},
+    {REQUEST_COM_PREFIX, 0x49, 3, GetQueueState_cmd, MAP_FLGS(0x0, 0x0)},
+    {REQUEST_COM_PREFIX, 0x4A, 27, StartPatch_cmd, MAP_FLGS(0x0, 0x0)},
+    {REQUEST_COM_PREFIX, 0x4B, 135, PatchData_cmd, MAP_FLGS(0x0, 0x0)},
+    {REQUEST_COM_PREFIX, 0x4C, 35, FinishPatch_cmd, MAP_FLGS(0x0, 0x0)},
+    {REQUEST_COM_PREFIX, 0x4D, 3, GetPatchState_cmd, MAP_FLGS(0x0, 0x0)},
+    {REQUEST_COM_PREFIX, 0x4E, 3, CheckAppTrailer_cmd, MAP_FLGS(0x0, 0x0)},
 
     // jump to main
     {REQUEST_COM_PREFIX, 0x50, 3, GoToMainApp_cmd, MAP_FLGS(0x0, 0x0)},
@@ -75,14 +82,19 @@ bool ResetRestBootloaderCnt_cmd(uint8_t *buff)
 
 bool StartUpdating_cmd(uint8_t *buff)
 {
+    AppCheck::Invalidate();
     FW_Loader::StartUpdate();
+    UpdateWindow::Reset();
     CmdHandler.SetResponce(SUCCESS_CS);
     return true;
 }
 
 bool EraseMainApp_cmd(uint8_t *buff)
 {
+    AppCheck::Invalidate();
     bool result = FW_Loader::EraseMainApp();
+    if (result)
+        UpdateWindow::MarkErased();
     CmdHandler.SetResponce(result ? SUCCESS_CS : ERROR_CS);
     return true;
 }
@@ -100,8 +112,87 @@ bool ProgrammData_cmd(uint8_t *buff)
     return true;
 }
 
+bool QueueData_cmd(uint8_t *buff)
+{
+    uint32_t blockNum = *reinterpret_cast<uint32_t *>(buff + COMMAND_PACK_POS);
+    bool result = UpdateWindow::Queue(blockNum, buff + COMMAND_PACK_POS + sizeof(blockNum));
+    UpdateWindowState state;
+    UpdateWindow::GetState(state);
+    // Program after the response, the host sends the next blocks meanwhile
+    CmdHandler.SetPostCmd(UpdateWindow::Process);
+    CmdHandler.SetResponce(result ? SUCCESS_CS : ERROR_CS, &state, sizeof(state));
+    return true;
+}
+
+bool GetQueueState_cmd(uint8_t *buff)
+{
+    UpdateWindowState state;
+    UpdateWindow::GetState(state);
+    CmdHandler.SetResponce(SUCCESS_CS, &state, sizeof(state));
+    return true;
+}
+
+static void patch_response(bool result)
+{
+    DeltaPatchState state;
+    DeltaPatch::GetState(state);
+    CmdHandler.SetResponce(result ? SUCCESS_CS : ERROR_CS, &state, sizeof(state));
+}
+
+/// Copy the patched image from the reserve area, same as on boot
+static void apply_reserve(void)
+{
+    AppCheck::Invalidate();
+    BootloadConfig::HandleBootFlags();
+}
+
+bool StartPatch_cmd(uint8_t *buff)
+{
+    DeltaPatchHeader header;
+    memcpy(&header, buff + COMMAND_PACK_POS, sizeof(header));
+    patch_response(DeltaPatch::Start(header));
+    return true;
+}
+
+bool PatchData_cmd(uint8_t *buff)
+{
+    uint32_t offset = *reinterpret_cast<uint32_t *>(buff + COMMAND_PACK_POS);
+    patch_response(DeltaPatch::Data(offset, buff + COMMAND_PACK_POS + sizeof(offset)));
+    return true;
+}
+
+bool FinishPatch_cmd(uint8_t *buff)
+{
+    bool result = DeltaPatch::Finish(buff + COMMAND_PACK_POS);
+    if (result)
+        CmdHandler.SetPostCmd(apply_reserve);
+    patch_response(result);
+    return true;
+}
+
+bool GetPatchState_cmd(uint8_t *buff)
+{
+    patch_response(true);
+    return true;
+}
+
+bool CheckAppTrailer_cmd(uint8_t *buff)
+{
+    AppCheckState state;
+    AppCheck::Check(state);
+    CmdHandler.SetResponce(state.valid ? SUCCESS_CS : ERROR_CS, &state, sizeof(state));
+    return true;
+}
+
 bool StopUpdating_cmd(uint8_t *buff)
 {
+    if (!UpdateWindow::Drain())
+    {
+        UpdateWindowState state;
+        UpdateWindow::GetState(state);
+        CmdHandler.SetResponce(ERROR_CS, &state, sizeof(state));
+        return true;
+    }
     FW_Loader::StopUpdate();
     bootloader_flags_t flags = BootloadConfig::GetBootloaderFlags();
     flags.is_main_app_ok = true;
@@ -118,6 +209,7 @@ bool CheckAppCRC_cmd(uint8_t *buff)
 {
     uint8_t crc = *reinterpret_cast<uint8_t *>(buff + COMMAND_PACK_POS);
     uint32_t length = *reinterpret_cast<uint32_t *>(buff + COMMAND_PACK_POS + sizeof(crc));
+    UpdateWindow::Drain();
     UpdateStatus result = FW_Loader::CheckCRC(crc, length);
     CmdHandler.SetResponce(result == SuccessUS ? SUCCESS_CS : ERROR_CS, &result, sizeof(result));
     return true;
@@ -17,6 +17,9 @@
 #include "rtc_module.h"
 #include "TafcoCrypt.h"
 #include "Enums.h"
+#include "UpdateWindow.h"
+#include "DeltaPatch.h"
+#include "AppCheck.h"
 
 bool ResetRestBootloaderCnt_cmd(uint8_t *buff);
 
@@ -42,6 +45,13 @@ bool CheckAppCRC_cmd(uint8_t *buff);
 bool CheckAppExistence_cmd(uint8_t *buff);
 bool IsMemoryProtect_cmd(uint8_t *buff);
 bool SetMemoryProtection_cmd(uint8_t *buff);
+bool QueueData_cmd(uint8_t *buff);
+bool GetQueueState_cmd(uint8_t *buff);
+bool StartPatch_cmd(uint8_t *buff);
+bool PatchData_cmd(uint8_t *buff);
+bool FinishPatch_cmd(uint8_t *buff);
+bool GetPatchState_cmd(uint8_t *buff);
+bool CheckAppTrailer_cmd(uint8_t *buff);
 
 bool GetBootloadJournalSize_cmd(uint8_t *buff);
 bool GetBootloadJournalItemByNum_cmd(uint8_t *buff);
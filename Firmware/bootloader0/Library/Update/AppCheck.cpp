@@ -0,0 +1,111 @@
+#include "AppCheck.h"
+#include "ImageCrc.h"
+
+#ifdef APP_CHECK_ALLOW_LEGACY
+static constexpr bool allow_legacy = true;
+#else
+static constexpr bool allow_legacy = false;
+#endif
+
+AppCheck::Stage AppCheck::stage = AppCheck::Stage::IDLE;
+uint32_t AppCheck::length;
+
+static inline const AppTrailer *trailer_at(uint32_t length)
+{
+    return reinterpret_cast<const AppTrailer *>(APPLICATION_ADDRESS + length);
+}
+
+/// @brief Image length from the vector table
+/// @return 0 if the image has no valid trailer
+uint32_t AppCheck::TrailerLength(void)
+{
+    const uint32_t value = *reinterpret_cast<const uint32_t *>(APPLICATION_ADDRESS + APP_LENGTH_OFFSET);
+
+    if (value <= APP_LENGTH_OFFSET || value > APPLICATION_SIZE - sizeof(AppTrailer) || value % sizeof(uint32_t) != 0)
+        return 0;
+    if (trailer_at(value)->magic != APP_TRAILER_MAGIC)
+        return 0;
+    return value;
+}
+
+bool AppCheck::CacheMatches(uint32_t image_length, uint32_t crc)
+{
+    uint16_t record[6];
+    const bpr_data_type regs[6] = {BPR_DATA7, BPR_DATA8, BPR_DATA9, BPR_DATA10, BPR_DATA11, BPR_DATA12};
+
+    for (uint8_t i = 0; i < 6; i++)
+        record[i] = bpr_data_read(regs[i]);
+    return record[0] == APP_CACHE_MARKER &&
+           record[1] == static_cast<uint16_t>(image_length) && record[2] == static_cast<uint16_t>(image_length >> 16) &&
+           record[3] == static_cast<uint16_t>(crc) && record[4] == static_cast<uint16_t>(crc >> 16) &&
+           record[5] == static_cast<uint16_t>(~(record[0] ^ record[1] ^ record[2] ^ record[3] ^ record[4]));
+}
+
+void AppCheck::CacheStore(uint32_t image_length, uint32_t crc)
+{
+    const uint16_t record[5] = {
+        APP_CACHE_MARKER,
+        static_cast<uint16_t>(image_length), static_cast<uint16_t>(image_length >> 16),
+        static_cast<uint16_t>(crc), static_cast<uint16_t>(crc >> 16),
+    };
+
+    bpr_data_write(BPR_DATA7, record[0]);
+    bpr_data_write(BPR_DATA8, record[1]);
+    bpr_data_write(BPR_DATA9, record[2]);
+    bpr_data_write(BPR_DATA10, record[3]);
+    bpr_data_write(BPR_DATA11, record[4]);
+    bpr_data_write(BPR_DATA12, static_cast<uint16_t>(~(record[0] ^ record[1] ^ record[2] ^ record[3] ^ record[4])));
+}
+
+void AppCheck::Begin(void)
+{
+    length = TrailerLength();
+    if (length == 0)
+    {
+        stage = Stage::NONE;
+        return;
+    }
+
+    // Flash may have been corrupted while the power was off or the application hung
+    const bool cold = crm_flag_get(CRM_POR_RESET_FLAG) == SET || crm_flag_get(CRM_WDT_RESET_FLAG) == SET;
+    if (!cold && CacheMatches(length, trailer_at(length)->crc))
+    {
+        stage = Stage::CACHED;
+        return;
+    }
+    ImageCrc::Start(APPLICATION_ADDRESS, length);
+    stage = Stage::RUNNING;
+}
+
+bool AppCheck::IsValid(void)
+{
+    if (stage == Stage::IDLE)
+        Begin();
+    if (stage == Stage::RUNNING)
+    {
+        const uint32_t crc = ImageCrc::Wait();
+        stage = crc == trailer_at(length)->crc ? Stage::VALID : Stage::INVALID;
+        if (stage == Stage::VALID)
+            CacheStore(length, crc);
+        else // a restart must not trust the record of this image
+            bpr_data_write(BPR_DATA7, 0);
+    }
+    return stage == Stage::VALID || stage == Stage::CACHED || (stage == Stage::NONE && allow_legacy);
+}
+
+void AppCheck::Invalidate(void)
+{
+    if (stage == Stage::RUNNING)
+        ImageCrc::Cancel();
+    stage = Stage::IDLE;
+    bpr_data_write(BPR_DATA7, 0);
+}
+
+void AppCheck::Check(AppCheckState &state)
+{
+    state.length = TrailerLength();
+    state.crc = state.length != 0 ? ImageCrc::Calculate(APPLICATION_ADDRESS, state.length) : 0;
+    state.valid = state.length != 0 && state.crc == trailer_at(state.length)->crc;
+    if (state.valid)
+        CacheStore(state.length, state.crc);
+}
@@ -0,0 +1,80 @@
+#ifndef _APP_CHECK_H
+#define _APP_CHECK_H
+
+#include "at32f403a_407.h"
+#include "flash_map.h"
+
+#define APP_TRAILER_MAGIC (0x43524354U)   // "TCRC"
+#define APP_LENGTH_OFFSET (0x1CU)         // reserved vector 7, written by Tools/image_crc.py
+#define APP_CACHE_MARKER (0xA5C3U)
+
+/// @brief Application trailer, right after the image
+#pragma pack(push, 1)
+struct AppTrailer
+{
+    uint32_t magic; // APP_TRAILER_MAGIC
+    uint32_t crc;   // CRC-32 of the image, length bytes from APPLICATION_ADDRESS
+};
+#pragma pack(pop)
+
+/// @brief Result of CheckAppTrailer
+#pragma pack(push, 1)
+struct AppCheckState
+{
+    uint8_t valid;   // image has a trailer and matches it
+    uint32_t length; // image length, 0 without a trailer
+    uint32_t crc;    // CRC-32 read back from flash
+};
+#pragma pack(pop)
+
+/// @brief CRC-32 check of the main application before it is started
+///
+/// Tools/image_crc.py writes the image length into the reserved vector table
+/// word at APP_LENGTH_OFFSET and appends an AppTrailer. An image without
+/// one (length word 0 or erased) is not started: an erased or half-written
+/// application area has no trailer either. Builds with APP_CHECK_ALLOW_LEGACY
+/// (the debug builds, whose application is flashed as a hex without the
+/// trailer) start such an image on the boot flags alone.
+///
+/// Begin starts the CRC on DMA right after reset so it runs during the rest
+/// of the bootloader start-up; IsValid collects it. A verified image is
+/// recorded in BPR_DATA7..BPR_DATA12. After a software or reset-pin restart
+/// that record is trusted and the image is not read again. A power-on or
+/// watchdog reset always checks the whole image. Every path that writes the
+/// application area calls Invalidate first.
+class AppCheck
+{
+public:
+    /// @brief Start checking the application in the background
+    static void Begin(void);
+
+    /// @brief Result of the check started by Begin
+    /// @return false if the image has no trailer or does not match it
+    static bool IsValid(void);
+
+    /// @brief Forget the verified image, the application area is about to change
+    static void Invalidate(void);
+
+    /// @brief Check the image now, for CheckAppTrailer
+    static void Check(AppCheckState &state);
+
+private:
+    enum class Stage : uint8_t
+    {
+        IDLE,     // Begin not called, or invalidated
+        NONE,     // no trailer, valid only with APP_CHECK_ALLOW_LEGACY
+        CACHED,   // matches the BPR record
+        RUNNING,  // background CRC in progress
+        VALID,
+        INVALID,
+    };
+
+    static uint32_t TrailerLength(void);
+    static bool CacheMatches(uint32_t length, uint32_t crc);
+    static void CacheStore(uint32_t length, uint32_t crc);
+
+    static Stage stage;
+    static uint32_t length;
+};
+
+#endif
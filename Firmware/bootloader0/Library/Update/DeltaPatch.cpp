@@ -0,0 +1,257 @@
+#include "DeltaPatch.h"
+#include "ImageCrc.h"
+#include "BootloadConfig.h"
+#include "SimpleWD.h"
+
+#define DELTA_OP_COPY (0U)
+#define DELTA_OP_ADD (1U)
+#define DELTA_OP_INSERT (2U)
+#define DELTA_VARINT_MAX_SHIFT (28U)
+
+#ifdef DELTA_PATCH_KEY
+static const uint8_t patch_key[DELTA_PATCH_KEY_SIZE] = {DELTA_PATCH_KEY};
+#endif
+
+DeltaPatchHeader DeltaPatch::header;
+DeltaPatchResult DeltaPatch::result = DeltaPatchResult::NOT_STARTED;
+DeltaPatch::Stage DeltaPatch::stage;
+uint32_t DeltaPatch::received;
+uint32_t DeltaPatch::varint;
+uint8_t DeltaPatch::shift;
+uint32_t DeltaPatch::length;
+uint32_t DeltaPatch::source_pos;
+uint32_t DeltaPatch::target_pos;
+uint32_t DeltaPatch::word;
+bool DeltaPatch::done;
+
+static inline const uint8_t *source_byte(uint32_t pos)
+{
+    return reinterpret_cast<const uint8_t *>(APPLICATION_ADDRESS + pos);
+}
+
+bool DeltaPatch::Start(const DeltaPatchHeader &new_header)
+{
+    header = new_header;
+    stage = Stage::OP;
+    received = 0;
+    varint = 0;
+    shift = 0;
+    length = 0;
+    source_pos = 0;
+    target_pos = 0;
+    word = 0xFFFFFFFFU;
+    done = false;
+    result = DeltaPatchResult::OK;
+
+#ifndef DELTA_PATCH_KEY
+    return Fail(DeltaPatchResult::NO_KEY);
+#endif
+    if (header.magic != DELTA_PATCH_MAGIC || header.patch_size == 0 ||
+        header.source_size == 0 || header.source_size > APPLICATION_SIZE ||
+        header.target_size == 0 || header.target_size > APPLICATION_SIZE ||
+        header.target_size > RESERVE_APPLICATION_SIZE)
+        return Fail(DeltaPatchResult::BAD_HEADER);
+
+    if (ImageCrc::Calculate(APPLICATION_ADDRESS, header.source_size) != header.source_crc)
+        return Fail(DeltaPatchResult::SOURCE_MISMATCH);
+
+    // The reserve area is about to be overwritten, it must not be copied on the next boot
+    bootloader_flags_t flags = BootloadConfig::GetBootloaderFlags();
+    if (flags.need_reprogramm_from_reserv)
+    {
+        flags.need_reprogramm_from_reserv = false;
+        BootloadConfig::SetBootloaderFlags(flags);
+    }
+    return true;
+}
+
+bool DeltaPatch::Data(uint32_t offset, const uint8_t *data)
+{
+    // A repeated chunk (lost response) is refused without failing the patch
+    if (result != DeltaPatchResult::OK || offset != received || received == header.patch_size)
+        return false;
+
+    uint32_t count = header.patch_size - received;
+    if (count > DELTA_PATCH_CHUNK_SIZE)
+        count = DELTA_PATCH_CHUNK_SIZE;
+
+    flash_unlock();
+    for (uint32_t i = 0; i < count && result == DeltaPatchResult::OK; i++)
+        Consume(data[i]);
+    flash_lock();
+
+    if (result != DeltaPatchResult::OK)
+        return false;
+    received += count;
+    return true;
+}
+
+bool DeltaPatch::Finish(const uint8_t *tag)
+{
+    if (result != DeltaPatchResult::OK)
+        return false;
+    if (done)
+        return true;
+    if (received != header.patch_size || stage != Stage::OP || shift != 0 || target_pos != header.target_size)
+        return Fail(DeltaPatchResult::BAD_DATA);
+
+    if (target_pos % sizeof(word) != 0)
+    {
+        flash_unlock();
+        bool ok = FlushWord();
+        flash_lock();
+        if (!ok)
+            return false;
+    }
+
+    if (ImageCrc::Calculate(RESERVE_APPLICATION_ADDRESS, header.target_size) != header.target_crc)
+        return Fail(DeltaPatchResult::TARGET_MISMATCH);
+    // The CRC only catches transfer errors, the tag shows the image comes from the key holder
+    if (!Authentic(tag))
+        return Fail(DeltaPatchResult::AUTH_FAILED);
+
+    bootloader_flags_t flags = BootloadConfig::GetBootloaderFlags();
+    flags.need_reprogramm_from_reserv = true;
+    BootloadConfig::SetBootloaderFlags(flags);
+    done = true;
+    return true;
+}
+
+void DeltaPatch::GetState(DeltaPatchState &state)
+{
+    state.result = static_cast<uint8_t>(result);
+    state.received = received;
+    state.written = target_pos;
+}
+
+bool DeltaPatch::Fail(DeltaPatchResult reason)
+{
+    result = reason;
+    return false;
+}
+
+/// @brief Feed one patch byte to the decoder
+bool DeltaPatch::Consume(uint8_t byte)
+{
+    switch (stage)
+    {
+    case Stage::OP:
+    case Stage::SEEK:
+        if (shift > DELTA_VARINT_MAX_SHIFT)
+            return Fail(DeltaPatchResult::BAD_DATA);
+        varint |= static_cast<uint32_t>(byte & 0x7FU) << shift;
+        if (byte & 0x80U)
+        {
+            shift += 7;
+            return true;
+        }
+        shift = 0;
+        if (stage == Stage::SEEK)
+        {
+            // zigzag, seek may go backwards
+            const int32_t seek = static_cast<int32_t>(varint >> 1) ^ -static_cast<int32_t>(varint & 1U);
+            const int64_t pos = static_cast<int64_t>(source_pos) + seek;
+            varint = 0;
+            if (pos < 0 || pos > static_cast<int64_t>(header.source_size - length))
+                return Fail(DeltaPatchResult::BAD_DATA);
+            source_pos = static_cast<uint32_t>(pos);
+            stage = Stage::OP;
+            return Copy(length);
+        }
+
+        length = varint >> 2;
+        if (length == 0 || length > header.target_size - target_pos)
+            return Fail(DeltaPatchResult::BAD_DATA);
+        switch (varint & 0x03U)
+        {
+        case DELTA_OP_COPY:
+            if (length > header.source_size)
+                return Fail(DeltaPatchResult::BAD_DATA);
+            stage = Stage::SEEK;
+            break;
+        case DELTA_OP_ADD:
+            if (length > header.source_size - source_pos)
+                return Fail(DeltaPatchResult::BAD_DATA);
+            stage = Stage::ADD;
+            break;
+        case DELTA_OP_INSERT:
+            stage = Stage::INSERT;
+            break;
+        default:
+            return Fail(DeltaPatchResult::BAD_DATA);
+        }
+        varint = 0;
+        return true;
+
+    case Stage::ADD:
+        byte += *source_byte(source_pos++);
+        // fall through
+    case Stage::INSERT:
+        if (--length == 0)
+            stage = Stage::OP;
+        return Put(byte);
+    }
+    return Fail(DeltaPatchResult::BAD_DATA);
+}
+
+bool DeltaPatch::Copy(uint32_t count)
+{
+    while (count-- != 0)
+    {
+        if (!Put(*source_byte(source_pos++)))
+            return false;
+    }
+    return true;
+}
+
+bool DeltaPatch::Put(uint8_t byte)
+{
+    const uint32_t byte_shift = (target_pos % sizeof(word)) * 8U;
+    word = (word & ~(0xFFU << byte_shift)) | (static_cast<uint32_t>(byte) << byte_shift);
+    target_pos++;
+    if (target_pos % sizeof(word) == 0)
+        return FlushWord();
+    return true;
+}
+
+/// @brief Program the word holding the last image byte, erase sectors on entry
+bool DeltaPatch::FlushWord(void)
+{
+    const uint32_t address = RESERVE_APPLICATION_ADDRESS + ((target_pos - 1U) & ~(sizeof(word) - 1U));
+    bool ok = true;
+
+    if ((address - RESERVE_APPLICATION_ADDRESS) % FLASH_SECTOR_SIZE == 0)
+    {
+        ok = flash_sector_erase(address) == FLASH_OPERATE_DONE;
+        simple_wdt_reload();
+    }
+    // An erased word already reads 0xFFFFFFFF
+    if (ok && word != 0xFFFFFFFFU)
+        ok = flash_word_program(address, word) == FLASH_OPERATE_DONE;
+    word = 0xFFFFFFFFU;
+    return ok ? true : Fail(DeltaPatchResult::FLASH_FAILED);
+}
+
+/// @brief Check the HMAC-SHA256 of the header and the rebuilt image
+bool DeltaPatch::Authentic(const uint8_t *tag)
+{
+#ifdef DELTA_PATCH_KEY
+    HmacSha256 mac;
+    uint8_t expected[DELTA_PATCH_TAG_SIZE];
+
+    mac.Start(patch_key, sizeof(patch_key));
+    mac.Update(&header, sizeof(header));
+    for (uint32_t done = 0; done < header.target_size; done += FLASH_SECTOR_SIZE)
+    {
+        const uint32_t left = header.target_size - done;
+        mac.Update(reinterpret_cast<const void *>(RESERVE_APPLICATION_ADDRESS + done),
+                   left < FLASH_SECTOR_SIZE ? left : FLASH_SECTOR_SIZE);
+        simple_wdt_reload();
+    }
+    mac.Finish(expected);
+    return HmacSha256::Equal(expected, tag);
+#else
+    (void)tag;
+    return false;
+#endif
+}
@@ -0,0 +1,124 @@
+#ifndef _DELTA_PATCH_H
+#define _DELTA_PATCH_H
+
+#include "at32f403a_407.h"
+#include "flash_map.h"
+#include "Sha256.h"
+
+#define DELTA_PATCH_MAGIC (0x31504454U) // "TDP1"
+#define DELTA_PATCH_CHUNK_SIZE (128U)   // patch bytes per PatchData command
+#define DELTA_PATCH_TAG_SIZE SHA256_SIZE // HMAC-SHA256 sent with FinishPatch
+#define DELTA_PATCH_KEY_SIZE (32U)
+
+/// @brief Header sent with StartPatch
+#pragma pack(push, 1)
+struct DeltaPatchHeader
+{
+    uint32_t magic;       // DELTA_PATCH_MAGIC
+    uint32_t source_size; // installed image the patch was made against
+    uint32_t source_crc;  // CRC-32 of the installed image
+    uint32_t target_size; // image after patching
+    uint32_t target_crc;  // CRC-32 of the image after patching
+    uint32_t patch_size;  // bytes of operations following the header
+};
+#pragma pack(pop)
+
+/// @brief Patch result, sticky until the next StartPatch
+enum class DeltaPatchResult : uint8_t
+{
+    OK = 0,
+    BAD_HEADER = 1,      // magic or sizes
+    SOURCE_MISMATCH = 2, // installed image is not the one the patch was made against
+    BAD_DATA = 3,        // malformed operation or patch size
+    FLASH_FAILED = 4,
+    TARGET_MISMATCH = 5, // CRC-32 of the rebuilt image
+    NOT_STARTED = 6,
+    AUTH_FAILED = 7,     // tag over the header and the rebuilt image
+    NO_KEY = 8,          // bootloader built without DELTA_PATCH_KEY_FILE
+};
+
+/// @brief State returned by the patch commands
+#pragma pack(push, 1)
+struct DeltaPatchState
+{
+    uint8_t result;    // DeltaPatchResult
+    uint32_t received; // patch bytes accepted, the next PatchData offset
+    uint32_t written;  // image bytes rebuilt in the reserve area
+};
+#pragma pack(pop)
+
+/// @brief Delta update of the main application
+///
+/// The patch is a bsdiff-like operation stream against the installed image.
+/// It is applied while it arrives, and the new image is rebuilt in the
+/// reserve area (RESERVE_APPLICATION_ADDRESS). Every operation starts with a
+/// varint (length << 2 | op):
+///   COPY   0  zigzag varint seek, then length bytes of the source
+///   ADD    1  length bytes, each added to the next source byte
+///   INSERT 2  length literal bytes
+/// COPY moves the source position by seek before copying; COPY and ADD
+/// advance it by length, INSERT leaves it. ADD carries code that moved with
+/// its pointers (mostly zero bytes with a few small differences).
+///
+/// bsdiff streaming variants bound the source window to bound RAM. Here the
+/// source is the installed image, which is read straight from flash, so any
+/// seek inside source_size is allowed and the applier keeps only its decoder
+/// state and one flash word in RAM.
+///
+/// The patch stream is not encrypted; it is authenticated instead. Finish
+/// checks the CRC-32 of the rebuilt image, then the HMAC-SHA256 tag over the
+/// header and the rebuilt image with the key built into the bootloader
+/// (DELTA_PATCH_KEY_FILE, the same file delta_patch.py signs with). Only
+/// then it sets need_reprogramm_from_reserv; the reserve image replaces the
+/// application on the next boot (BootloadConfig::HandleBootFlags). A
+/// bootloader built without a key refuses every patch.
+class DeltaPatch
+{
+public:
+    /// @brief Check the header and the installed image, start a patch
+    /// @return false if the header is invalid or the installed image differs
+    static bool Start(const DeltaPatchHeader &header);
+
+    /// @brief Apply the next patch chunk
+    /// @param offset Patch offset of the chunk, must equal received
+    /// @param data DELTA_PATCH_CHUNK_SIZE bytes, the bytes past patch_size are ignored
+    /// @return false if the chunk is out of order or the patch failed
+    static bool Data(uint32_t offset, const uint8_t *data);
+
+    /// @brief Verify the rebuilt image and request the swap
+    /// @param tag DELTA_PATCH_TAG_SIZE bytes, HMAC-SHA256 of the header and the image
+    /// @return true if the image is complete, its CRC-32 matches and the tag is valid
+    static bool Finish(const uint8_t *tag);
+
+    static void GetState(DeltaPatchState &state);
+
+private:
+    enum class Stage : uint8_t
+    {
+        OP,   // reading the operation varint
+        SEEK, // reading the COPY seek varint
+        ADD,
+        INSERT,
+    };
+
+    static bool Fail(DeltaPatchResult reason);
+    static bool Consume(uint8_t byte);
+    static bool Copy(uint32_t count);
+    static bool Put(uint8_t byte);
+    static bool FlushWord(void);
+    static bool Authentic(const uint8_t *tag);
+
+    static DeltaPatchHeader header;
+    static DeltaPatchResult result;
+    static Stage stage;
+    static uint32_t received;
+    static uint32_t varint;     // varint being read
+    static uint8_t shift;       // its next bit position
+    static uint32_t length;     // bytes left in the current operation
+    static uint32_t source_pos; // next source byte for COPY and ADD
+    static uint32_t target_pos; // next image byte
+    static uint32_t word;       // image bytes not yet programmed
+    static bool done;           // Finish succeeded
+};
+
+#endif
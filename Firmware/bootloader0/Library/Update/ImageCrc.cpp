@@ -0,0 +1,133 @@
+#include "ImageCrc.h"
+#include "SimpleWD.h"
+
+#define IMAGE_CRC_HW_STEP (0x4000U) // words per CRC unit run, the watchdog is reloaded between runs
+
+/// Nibble table, 64 bytes of flash instead of 1 KB for a byte table
+static const uint32_t crc_nibble[16] = {
+    0x00000000U, 0x1DB71064U, 0x3B6E20C8U, 0x26D930ACU,
+    0x76DC4190U, 0x6B6B51F4U, 0x4DB26158U, 0x5005713CU,
+    0xEDB88320U, 0xF00F9344U, 0xD6D6A3E8U, 0xCB61B38CU,
+    0x9B64C2B0U, 0x86D3D2D4U, 0xA00AE278U, 0xBDBDF21CU,
+};
+
+bool ImageCrc::running;
+uint32_t ImageCrc::address;
+uint32_t ImageCrc::size;
+uint32_t ImageCrc::dma_words;
+uint32_t ImageCrc::result;
+
+uint32_t ImageCrc::SoftUpdate(uint32_t crc, const uint8_t *data, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        crc ^= data[i];
+        crc = (crc >> 4) ^ crc_nibble[crc & 0x0FU];
+        crc = (crc >> 4) ^ crc_nibble[crc & 0x0FU];
+    }
+    return crc;
+}
+
+/// @brief Load a running (reflected) CRC into the CRC unit
+void ImageCrc::HwStart(uint32_t crc)
+{
+    crm_periph_clock_enable(CRM_CRC_PERIPH_CLOCK, TRUE);
+    crc_reverse_input_data_set(CRC_REVERSE_INPUT_BY_WORD);
+    crc_reverse_output_data_set(CRC_REVERSE_OUTPUT_DATA);
+    // The unit works MSB first, its register holds the running CRC bit reversed
+    crc_init_data_set(__RBIT(crc));
+    crc_data_reset();
+}
+
+uint32_t ImageCrc::Update(uint32_t crc, const void *data, size_t count)
+{
+    const uint8_t *ptr = static_cast<const uint8_t *>(data);
+
+    Complete();
+
+    const size_t head = (0U - reinterpret_cast<uintptr_t>(ptr)) % sizeof(uint32_t);
+    if (head >= count)
+        return SoftUpdate(crc, ptr, count);
+    crc = SoftUpdate(crc, ptr, head);
+    ptr += head;
+    count -= head;
+
+    size_t words = count / sizeof(uint32_t);
+    while (words != 0)
+    {
+        const uint32_t step = words > IMAGE_CRC_HW_STEP ? IMAGE_CRC_HW_STEP : words;
+        HwStart(crc);
+        crc = crc_block_calculate(reinterpret_cast<uint32_t *>(const_cast<uint8_t *>(ptr)), step);
+        ptr += step * sizeof(uint32_t);
+        words -= step;
+        simple_wdt_reload();
+    }
+    return SoftUpdate(crc, ptr, count % sizeof(uint32_t));
+}
+
+void ImageCrc::Start(uint32_t start, uint32_t length)
+{
+    dma_init_type dma_init_struct;
+
+    Complete();
+    address = start;
+    size = length;
+    dma_words = length / sizeof(uint32_t);
+    if (dma_words > IMAGE_CRC_DMA_MAX_WORDS)
+        dma_words = IMAGE_CRC_DMA_MAX_WORDS;
+
+    HwStart(IMAGE_CRC_INIT);
+    crm_periph_clock_enable(CRM_DMA2_PERIPH_CLOCK, TRUE);
+    dma_reset(IMAGE_CRC_DMA_CHANNEL);
+    dma_default_para_init(&dma_init_struct);
+    // Memory to memory: the "peripheral" side is the source
+    dma_init_struct.direction = DMA_DIR_MEMORY_TO_MEMORY;
+    dma_init_struct.peripheral_base_addr = start;
+    dma_init_struct.peripheral_inc_enable = TRUE;
+    dma_init_struct.peripheral_data_width = DMA_PERIPHERAL_DATA_WIDTH_WORD;
+    dma_init_struct.memory_base_addr = reinterpret_cast<uint32_t>(&CRC->dt);
+    dma_init_struct.memory_inc_enable = FALSE;
+    dma_init_struct.memory_data_width = DMA_MEMORY_DATA_WIDTH_WORD;
+    dma_init_struct.buffer_size = static_cast<uint16_t>(dma_words);
+    dma_init_struct.priority = DMA_PRIORITY_LOW;
+    dma_init_struct.loop_mode_enable = FALSE;
+    dma_init(IMAGE_CRC_DMA_CHANNEL, &dma_init_struct);
+    dma_flag_clear(IMAGE_CRC_DMA_DONE_FLAG);
+    running = dma_words != 0;
+    if (running)
+        dma_channel_enable(IMAGE_CRC_DMA_CHANNEL, TRUE);
+    else
+        result = Calculate(start, length);
+}
+
+void ImageCrc::Cancel(void)
+{
+    if (running)
+    {
+        dma_channel_enable(IMAGE_CRC_DMA_CHANNEL, FALSE);
+        dma_flag_clear(IMAGE_CRC_DMA_DONE_FLAG);
+        running = false;
+    }
+}
+
+uint32_t ImageCrc::Wait(void)
+{
+    Complete();
+    return result;
+}
+
+/// @brief Finish a background run: wait for the DMA, add what it did not cover
+void ImageCrc::Complete(void)
+{
+    if (!running)
+        return;
+    while (dma_flag_get(IMAGE_CRC_DMA_DONE_FLAG) == RESET)
+        ;
+    dma_channel_enable(IMAGE_CRC_DMA_CHANNEL, FALSE);
+    dma_flag_clear(IMAGE_CRC_DMA_DONE_FLAG);
+    running = false;
+
+    const uint32_t done = dma_words * sizeof(uint32_t);
+    const uint32_t crc = crc_data_get();
+    result = Final(Update(crc, reinterpret_cast<const void *>(address + done), size - done));
+}
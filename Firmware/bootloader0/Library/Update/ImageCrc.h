@@ -0,0 +1,65 @@
+#ifndef _IMAGE_CRC_H
+#define _IMAGE_CRC_H
+
+#include "at32f403a_407.h"
+#include <stddef.h>
+
+#define IMAGE_CRC_INIT (0xFFFFFFFFU)
+#define IMAGE_CRC_DMA_CHANNEL DMA2_CHANNEL1  // not used by the bootloader drivers
+#define IMAGE_CRC_DMA_DONE_FLAG DMA2_FDT1_FLAG
+#define IMAGE_CRC_DMA_MAX_WORDS (0xFFFFU)    // 16-bit transfer counter
+
+/// @brief CRC-32 of firmware images (IEEE 802.3, reflected, poly 0xEDB88320)
+///
+/// Same parameters as zlib / Python binascii.crc32, so host tools compute
+/// the value without a custom implementation. Whole words go through the
+/// CRC unit with word input and output reversal, which turns its MSB-first
+/// 0x04C11DB7 into the reflected CRC-32; unaligned head and tail bytes use a
+/// nibble table.
+///
+/// A background run feeds the CRC unit from flash by memory-to-memory DMA
+/// while the CPU does other work (bootloader start-up). Any other use of
+/// the unit first completes the background run.
+class ImageCrc
+{
+public:
+    /// @brief Continue a running CRC
+    /// @param crc Value of the previous call, IMAGE_CRC_INIT for the first one
+    /// @param data Data to add
+    /// @param size Data size in bytes
+    /// @return Running CRC, pass to Final when done
+    static uint32_t Update(uint32_t crc, const void *data, size_t size);
+
+    static uint32_t Final(uint32_t crc) { return crc ^ 0xFFFFFFFFU; }
+
+    /// @brief CRC-32 of a flash range
+    static uint32_t Calculate(uint32_t address, uint32_t size)
+    {
+        return Final(Update(IMAGE_CRC_INIT, reinterpret_cast<const void *>(address), size));
+    }
+
+    /// @brief Start the CRC-32 of a flash range in the background
+    /// @param address Word aligned start
+    /// @param size Range size in bytes
+    static void Start(uint32_t address, uint32_t size);
+
+    /// @brief Stop a background run, its result is not needed any more
+    static void Cancel(void);
+
+    /// @brief Wait for the background run
+    /// @return CRC-32 of the range given to Start
+    static uint32_t Wait(void);
+
+private:
+    static uint32_t SoftUpdate(uint32_t crc, const uint8_t *data, size_t size);
+    static void HwStart(uint32_t crc);
+    static void Complete(void);
+
+    static bool running;        // DMA is feeding the CRC unit
+    static uint32_t address;    // background range
+    static uint32_t size;
+    static uint32_t dma_words;  // words given to the DMA
+    static uint32_t result;     // background CRC-32 once complete
+};
+
+#endif
@@ -0,0 +1,151 @@
+#include "Sha256.h"
+#include "string.h"
+
+static const uint32_t round_constants[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+};
+
+static inline uint32_t rotr(uint32_t x, uint32_t n)
+{
+    return (x >> n) | (x << (32U - n));
+}
+
+void Sha256::Start(void)
+{
+    static const uint32_t initial[8] = {
+        0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19,
+    };
+    memcpy(state, initial, sizeof(state));
+    total = 0;
+}
+
+void Sha256::Compress(const uint8_t *block)
+{
+    uint32_t w[64];
+    for (uint32_t i = 0; i < 16; i++)
+    {
+        w[i] = static_cast<uint32_t>(block[4 * i]) << 24 | static_cast<uint32_t>(block[4 * i + 1]) << 16 |
+               static_cast<uint32_t>(block[4 * i + 2]) << 8 | block[4 * i + 3];
+    }
+    for (uint32_t i = 16; i < 64; i++)
+    {
+        const uint32_t s0 = rotr(w[i - 15], 7) ^ rotr(w[i - 15], 18) ^ (w[i - 15] >> 3);
+        const uint32_t s1 = rotr(w[i - 2], 17) ^ rotr(w[i - 2], 19) ^ (w[i - 2] >> 10);
+        w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+    }
+
+    uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
+    uint32_t e = state[4], f = state[5], g = state[6], h = state[7];
+    for (uint32_t i = 0; i < 64; i++)
+    {
+        const uint32_t t1 = h + (rotr(e, 6) ^ rotr(e, 11) ^ rotr(e, 25)) + ((e & f) ^ (~e & g)) + round_constants[i] + w[i];
+        const uint32_t t2 = (rotr(a, 2) ^ rotr(a, 13) ^ rotr(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+        h = g;
+        g = f;
+        f = e;
+        e = d + t1;
+        d = c;
+        c = b;
+        b = a;
+        a = t1 + t2;
+    }
+    state[0] += a;
+    state[1] += b;
+    state[2] += c;
+    state[3] += d;
+    state[4] += e;
+    state[5] += f;
+    state[6] += g;
+    state[7] += h;
+}
+
+void Sha256::Update(const void *data, size_t size)
+{
+    const uint8_t *ptr = static_cast<const uint8_t *>(data);
+    size_t used = total % SHA256_BLOCK_SIZE;
+    total += size;
+
+    if (used != 0)
+    {
+        const size_t count = size < SHA256_BLOCK_SIZE - used ? size : SHA256_BLOCK_SIZE - used;
+        memcpy(buffer + used, ptr, count);
+        ptr += count;
+        size -= count;
+        if (used + count < SHA256_BLOCK_SIZE)
+            return;
+        Compress(buffer);
+    }
+    // Whole blocks straight from the source (flash for image checks)
+    for (; size >= SHA256_BLOCK_SIZE; ptr += SHA256_BLOCK_SIZE, size -= SHA256_BLOCK_SIZE)
+        Compress(ptr);
+    memcpy(buffer, ptr, size);
+}
+
+void Sha256::Finish(uint8_t digest[SHA256_SIZE])
+{
+    const uint64_t bits = total * 8U;
+    size_t used = total % SHA256_BLOCK_SIZE;
+
+    buffer[used++] = 0x80;
+    if (used > SHA256_BLOCK_SIZE - sizeof(bits))
+    {
+        memset(buffer + used, 0, SHA256_BLOCK_SIZE - used);
+        Compress(buffer);
+        used = 0;
+    }
+    memset(buffer + used, 0, SHA256_BLOCK_SIZE - sizeof(bits) - used);
+    for (uint32_t i = 0; i < sizeof(bits); i++)
+        buffer[SHA256_BLOCK_SIZE - 1U - i] = static_cast<uint8_t>(bits >> (8U * i));
+    Compress(buffer);
+
+    for (uint32_t i = 0; i < 8; i++)
+    {
+        digest[4 * i] = static_cast<uint8_t>(state[i] >> 24);
+        digest[4 * i + 1] = static_cast<uint8_t>(state[i] >> 16);
+        digest[4 * i + 2] = static_cast<uint8_t>(state[i] >> 8);
+        digest[4 * i + 3] = static_cast<uint8_t>(state[i]);
+    }
+}
+
+void HmacSha256::Start(const uint8_t *key, size_t key_size)
+{
+    uint8_t inner_key[SHA256_BLOCK_SIZE];
+
+    memset(inner_key, 0x36, sizeof(inner_key));
+    memset(outer_key, 0x5c, sizeof(outer_key));
+    for (size_t i = 0; i < key_size && i < SHA256_BLOCK_SIZE; i++)
+    {
+        inner_key[i] ^= key[i];
+        outer_key[i] ^= key[i];
+    }
+    inner.Start();
+    inner.Update(inner_key, sizeof(inner_key));
+    memset(inner_key, 0, sizeof(inner_key));
+}
+
+void HmacSha256::Finish(uint8_t tag[SHA256_SIZE])
+{
+    uint8_t inner_digest[SHA256_SIZE];
+    Sha256 outer;
+
+    inner.Finish(inner_digest);
+    outer.Update(outer_key, sizeof(outer_key));
+    outer.Update(inner_digest, sizeof(inner_digest));
+    outer.Finish(tag);
+    memset(outer_key, 0, sizeof(outer_key));
+}
+
+bool HmacSha256::Equal(const uint8_t *a, const uint8_t *b)
+{
+    uint8_t diff = 0;
+    for (uint32_t i = 0; i < SHA256_SIZE; i++)
+        diff |= static_cast<uint8_t>(a[i] ^ b[i]);
+    return diff == 0;
+}
@@ -0,0 +1,45 @@
+#ifndef _SHA256_H
+#define _SHA256_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define SHA256_SIZE (32U)
+#define SHA256_BLOCK_SIZE (64U)
+
+/// @brief SHA-256 (FIPS 180-4), for authenticating update images
+class Sha256
+{
+public:
+    Sha256(void) { Start(); }
+
+    void Start(void);
+    void Update(const void *data, size_t size);
+    void Finish(uint8_t digest[SHA256_SIZE]);
+
+private:
+    void Compress(const uint8_t *block);
+
+    uint32_t state[8];
+    uint64_t total;                     // bytes hashed
+    uint8_t buffer[SHA256_BLOCK_SIZE];  // partial block
+};
+
+/// @brief HMAC-SHA256 (RFC 2104)
+class HmacSha256
+{
+public:
+    /// @param key Key of at most SHA256_BLOCK_SIZE bytes
+    void Start(const uint8_t *key, size_t key_size);
+    void Update(const void *data, size_t size) { inner.Update(data, size); }
+    void Finish(uint8_t tag[SHA256_SIZE]);
+
+    /// @brief Compare two tags in constant time
+    static bool Equal(const uint8_t *a, const uint8_t *b);
+
+private:
+    Sha256 inner;
+    uint8_t outer_key[SHA256_BLOCK_SIZE];
+};
+
+#endif
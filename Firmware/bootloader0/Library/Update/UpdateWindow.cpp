@@ -0,0 +1,112 @@
+#include "UpdateWindow.h"
+#include "SimpleWD.h"
+#include "string.h"
+
+#define APPLICATION_END (APPLICATION_ADDRESS + APPLICATION_SIZE)
+
+uint8_t UpdateWindow::blocks[UPDATE_WINDOW_SLOTS][UPDATE_BLOCK_SIZE];
+uint32_t UpdateWindow::head;
+uint32_t UpdateWindow::tail;
+uint32_t UpdateWindow::erased_end = APPLICATION_ADDRESS;
+UpdateWindowResult UpdateWindow::result = UpdateWindowResult::OK;
+UpdateStatus UpdateWindow::program_status = SuccessUS;
+
+void UpdateWindow::Reset(void)
+{
+    head = 0;
+    tail = 0;
+    erased_end = APPLICATION_ADDRESS;
+    result = UpdateWindowResult::OK;
+    program_status = SuccessUS;
+}
+
+void UpdateWindow::MarkErased(void)
+{
+    erased_end = APPLICATION_END;
+}
+
+bool UpdateWindow::Queue(uint32_t block_num, const uint8_t *data)
+{
+    if (result != UpdateWindowResult::OK || block_num != head || head - tail == UPDATE_WINDOW_SLOTS)
+    {
+        return false;
+    }
+    memcpy(blocks[head % UPDATE_WINDOW_SLOTS], data, UPDATE_BLOCK_SIZE);
+    head++;
+    return true;
+}
+
+/// @brief Erase whole sectors until address is covered
+/// @param address End of the range that must be erased
+/// @return false if an erase failed
+bool UpdateWindow::EraseUpTo(uint32_t address)
+{
+    bool ok = true;
+
+    if (address > APPLICATION_END)
+    {
+        address = APPLICATION_END;
+    }
+    if (erased_end >= address)
+    {
+        return true;
+    }
+
+    flash_unlock();
+    while (ok && erased_end < address)
+    {
+        ok = flash_sector_erase(erased_end) == FLASH_OPERATE_DONE;
+        erased_end += FLASH_SECTOR_SIZE;
+        simple_wdt_reload();
+    }
+    flash_lock();
+    return ok;
+}
+
+void UpdateWindow::Process(void)
+{
+    while (result == UpdateWindowResult::OK && tail != head)
+    {
+        uint32_t next_block = 0;
+
+        if (!EraseUpTo(APPLICATION_ADDRESS + (tail + 1U) * UPDATE_BLOCK_SIZE))
+        {
+            result = UpdateWindowResult::ERASE_FAILED;
+            break;
+        }
+        FW_Loader::SetBlockAndDecrypt(blocks[tail % UPDATE_WINDOW_SLOTS]);
+        program_status = FW_Loader::Programm(tail, next_block);
+        if (program_status != SuccessUS)
+        {
+            result = UpdateWindowResult::PROGRAM_FAILED;
+            break;
+        }
+        tail++;
+        simple_wdt_reload();
+    }
+
+    // Queue empty: prepare the next sectors while the host sends more blocks
+    if (result == UpdateWindowResult::OK && tail == head)
+    {
+        const uint32_t current = APPLICATION_ADDRESS + tail * UPDATE_BLOCK_SIZE;
+        const uint32_t sector = current - (current - APPLICATION_ADDRESS) % FLASH_SECTOR_SIZE;
+        if (!EraseUpTo(sector + (UPDATE_ERASE_AHEAD_SECTORS + 1U) * FLASH_SECTOR_SIZE))
+        {
+            result = UpdateWindowResult::ERASE_FAILED;
+        }
+    }
+}
+
+bool UpdateWindow::Drain(void)
+{
+    Process();
+    return result == UpdateWindowResult::OK && tail == head;
+}
+
+void UpdateWindow::GetState(UpdateWindowState &state)
+{
+    state.result = static_cast<uint8_t>(result);
+    state.program_status = static_cast<uint8_t>(program_status);
+    state.next_block = tail;
+    state.free_slots = static_cast<uint8_t>(result == UpdateWindowResult::OK ? UPDATE_WINDOW_SLOTS - (head - tail) : 0U);
+}
@@ -0,0 +1,87 @@
+#ifndef _UPDATE_WINDOW_H
+#define _UPDATE_WINDOW_H
+
+#include "at32f403a_407.h"
+#include "flash_map.h"
+#include "FW_Loader.h"
+
+#define UPDATE_BLOCK_SIZE (128U)          // encrypted block of ProgrammData/QueueData
+#define UPDATE_WINDOW_SLOTS (8U)          // blocks the host may send ahead of programming
+#define UPDATE_ERASE_AHEAD_SECTORS (4U)   // sectors erased in advance while the queue is empty
+
+/// @brief Window result, sticky until StartUpdating
+enum class UpdateWindowResult : uint8_t
+{
+    OK = 0,
+    ERASE_FAILED = 1,
+    PROGRAM_FAILED = 2, // see program_status
+};
+
+/// @brief State returned by every windowed update command
+#pragma pack(push, 1)
+struct UpdateWindowState
+{
+    uint8_t result;         // UpdateWindowResult
+    uint8_t program_status; // UpdateStatus of the last FW_Loader::Programm call
+    uint32_t next_block;    // first block not yet programmed, the host resends from here after a failure
+    uint8_t free_slots;     // blocks the host may still send
+};
+#pragma pack(pop)
+
+/// @brief Windowed firmware transfer
+///
+/// QueueData only stores the encrypted block and answers at once; the block
+/// is decrypted and programmed after the response has gone out (CmdHandler
+/// post command). The host keeps up to UPDATE_WINDOW_SLOTS blocks in flight,
+/// so the USB round trip no longer adds to the programming time of every
+/// block, and the next blocks arrive while the current one is programmed.
+///
+/// Application sectors are erased on demand instead of all at once by
+/// EraseMainApp: the sector under a block is erased before the block is
+/// programmed, and up to UPDATE_ERASE_AHEAD_SECTORS further sectors are
+/// erased while the queue is empty. Block n is programmed at
+/// APPLICATION_ADDRESS + n * UPDATE_BLOCK_SIZE.
+///
+/// Blocks must arrive in order. Once programming fails the window stops
+/// accepting blocks; StartUpdating starts over.
+///
+/// Blocks stay UPDATE_BLOCK_SIZE bytes and a block is decrypted and then
+/// programmed, one after the other: the command packet size and the single
+/// decrypt buffer belong to FW_Loader (TafcoMcuCore). Tests/UpdateWindowBench
+/// compares the update time with ProgrammData on simulated flash.
+class UpdateWindow
+{
+public:
+    /// @brief Empty the window, called by StartUpdating
+    static void Reset(void);
+
+    /// @brief Note that EraseMainApp erased the whole application area
+    static void MarkErased(void);
+
+    /// @brief Store a block for programming
+    /// @param block_num Block number, must be the next one expected
+    /// @param data UPDATE_BLOCK_SIZE encrypted bytes
+    /// @return false if the window is full, out of order or stopped by an error
+    static bool Queue(uint32_t block_num, const uint8_t *data);
+
+    /// @brief Program queued blocks and erase ahead, run after the response is sent
+    static void Process(void);
+
+    /// @brief Program everything still queued, before StopUpdating/CheckAppCRC
+    /// @return true if all blocks were programmed
+    static bool Drain(void);
+
+    static void GetState(UpdateWindowState &state);
+
+private:
+    static bool EraseUpTo(uint32_t address);
+
+    static uint8_t blocks[UPDATE_WINDOW_SLOTS][UPDATE_BLOCK_SIZE];
+    static uint32_t head;        // next block number expected from the host
+    static uint32_t tail;        // next block number to program
+    static uint32_t erased_end;  // application flash below this address is erased
+    static UpdateWindowResult result;
+    static UpdateStatus program_status;
+};
+
+#endif
@@ -12,6 +12,8 @@
 #include "CommandHandler.h"
 #include "PacketWrapper.h"
 #include "Command.h"
+#include "AppCheck.h"
+#include "BootProfile.h"
 #include "ArteryCore/BprDriver/BprDriver.h"
 #include "usb_process.h"
 #include "BootloadJournal.h"
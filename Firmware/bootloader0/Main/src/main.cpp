@@ -7,6 +7,44 @@
 
 #include "main.h"
 
+/**
+ * @brief Start the application right away after a clean warm restart
+ * Skips RTC, USB and journal work. Returns if the application cannot be
+ * started this way; main then runs the full start-up.
+ */
+static void fast_boot(void)
+{
+    if (BootProfile::IsColdReset() || !BootProfile::PreviousBootClean() || usbService.IsConnect() ||
+        state_machine.stop_usb)
+        return;
+#ifdef LITE_GATEWAY
+    if (state_machine.work_with_uart)
+        return;
+#endif
+
+    FlashService::Init();
+#ifndef DEBUG
+    FlashService::SetMemoryProtect(true);
+#endif
+    simple_wdt_init();
+    BootProfile::Mark(BootPhase::FLASH);
+    BootloadConfig::Init();
+    BootProfile::Mark(BootPhase::CONFIG);
+
+    bootloader_flags_t flags = BootloadConfig::GetBootloaderFlags();
+    if (flags.need_reprogramm_from_reserv || flags.need_reprogramm_from_fuota || !BootloadConfig::CanRunMainApp())
+        return;
+    bool valid = AppCheck::IsValid();
+    BootProfile::Mark(BootPhase::APP_CHECK);
+    if (!valid)
+        return;
+
+    BootProfile::Mark(BootPhase::JUMP);
+    BootProfile::Commit(BOOT_PROFILE_FAST | BOOT_PROFILE_APP_STARTED);
+    simple_wdt_reload();
+    load_app();
+}
+
 /**
  * @brief main function.
  */
@@ -33,6 +71,10 @@ int main(void)
     init_bpr_logick();
     // increment failed booting cnt
     set_failed_booting();
+    BootProfile::Begin();
+    // CRC of the application runs on DMA during the rest of the start-up
+    AppCheck::Begin();
+    fast_boot();
 
     if (usbService.IsConnect())
         init_UpTime_Tmr();
@@ -46,12 +88,14 @@ int main(void)
     }
 
     rtc_module_init();
+    BootProfile::Mark(BootPhase::RTC);
     FlashService::Init();
 #ifndef DEBUG
     FlashService::SetMemoryProtect(true);
 #endif
 
     simple_wdt_init();
+    BootProfile::Mark(BootPhase::FLASH);
 
 #ifdef LITE_GATEWAY
     CmdHandler.SetCommands(cmdMap, command_amount);
@@ -80,11 +124,14 @@ int main(void)
         }
     }
     simple_wdt_reload();
+    BootProfile::Mark(BootPhase::USB);
     BootloadConfig::Init();
+    BootProfile::Mark(BootPhase::CONFIG);
     simple_wdt_reload();
     BootloadJournal::Init();
     simple_wdt_reload();
     BootloadJournal::CheckWDRTS();
+    BootProfile::Mark(BootPhase::JOURNAL);
     simple_wdt_reload();
 
     first_load_blink();
@@ -97,15 +144,25 @@ int main(void)
         uartFun(NULL);
 #endif
     simple_wdt_reload();
+    bootloader_flags_t flags = BootloadConfig::GetBootloaderFlags();
+    if (flags.need_reprogramm_from_reserv || flags.need_reprogramm_from_fuota)
+        AppCheck::Invalidate();
     BootloadConfig::HandleBootFlags();
+    BootProfile::Mark(BootPhase::BOOT_FLAGS);
     simple_wdt_reload();
-    if (BootloadConfig::CanRunMainApp())
+    const uint16_t cold = BootProfile::IsColdReset() ? BOOT_PROFILE_COLD : 0;
+    bool valid = BootloadConfig::CanRunMainApp() && AppCheck::IsValid();
+    BootProfile::Mark(BootPhase::APP_CHECK);
+    if (valid)
     {
+        BootProfile::Mark(BootPhase::JUMP);
+        BootProfile::Commit(cold | BOOT_PROFILE_APP_STARTED);
         simple_wdt_reload();
         load_app();
     }
     else
     {
+        BootProfile::Commit(cold);
         app_wasnt_found_blink();
 #ifdef END_DEVICE_TEMPERATURE_SENSOR
         pwc_standby_mode_enter();
@@ -0,0 +1,165 @@
+// AppCheck over the boot sequence: an application with and without the
+// CRC-32 trailer in SimFlash, power-on and software resets with the backup
+// registers kept across them, a corrupted image and an invalidated record.
+// Begin() stands for the reset, IsValid() for the jump decision.
+//
+// The boot time from Begin() to the jump is estimated with assumed costs:
+// the start-up work the background CRC overlaps, and the DMA feed of the
+// CRC unit. Built twice, with and without APP_CHECK_ALLOW_LEGACY.
+
+#include "SimFlash.h"
+#include "SimImageCrc.h"
+#include "AppCheck.h"
+#include "ImageCrc.h"
+#include <cstdio>
+#include <vector>
+
+// Assumed costs, not measured on the board; change them to rerun the estimate
+#define SIM_STARTUP_US (20000U)    // RTC, flash service, USB detection, config and journal
+#define SIM_CRC_NS_PER_WORD (500U) // DMA to the CRC unit at the reset clock
+#define SIM_IMAGE_SIZE (200U * 1024U)
+
+static int failures = 0;
+
+#define CHECK(condition)                                              \
+    do                                                                \
+    {                                                                 \
+        if (!(condition))                                             \
+        {                                                             \
+            printf("%s:%d: %s failed\n", __FILE__, __LINE__, #condition); \
+            failures++;                                               \
+        }                                                             \
+    } while (0)
+
+static uint16_t bpr[BPR_DATA12 + 1];
+static bool power_on_reset;
+
+uint16_t bpr_data_read(bpr_data_type bpr_data)
+{
+    return bpr[bpr_data];
+}
+
+void bpr_data_write(bpr_data_type bpr_data, uint16_t data_value)
+{
+    bpr[bpr_data] = data_value;
+}
+
+flag_status crm_flag_get(uint32_t flag)
+{
+    return flag == CRM_POR_RESET_FLAG && power_on_reset ? SET : RESET;
+}
+
+/// @brief Program an image, with the length word and the trailer as Tools/image_crc.py writes them
+static void install(uint32_t size, bool trailer)
+{
+    SimFlash::Init();
+    std::vector<uint8_t> image(size);
+    for (uint32_t i = 0; i < size; i++)
+        image[i] = static_cast<uint8_t>(i * 7U + (i >> 9));
+    const uint32_t length = trailer ? size : 0;
+    memcpy(image.data() + APP_LENGTH_OFFSET, &length, sizeof(length));
+    memcpy(SimFlash::At(APPLICATION_ADDRESS), image.data(), size);
+    if (trailer)
+    {
+        const AppTrailer tail = {APP_TRAILER_MAGIC, ImageCrc::Calculate(APPLICATION_ADDRESS, size)};
+        memcpy(SimFlash::At(APPLICATION_ADDRESS + size), &tail, sizeof(tail));
+    }
+}
+
+/// @brief Reset, start-up and jump decision
+/// @param cold Power-on reset, else a software restart
+/// @param us Estimated time from the reset to the jump
+static bool boot(bool cold, uint32_t &us)
+{
+    power_on_reset = cold;
+    const uint32_t runs = SimImageCrc::background_runs;
+    AppCheck::Begin();
+    const bool valid = AppCheck::IsValid();
+
+    const uint32_t crc_us = SimImageCrc::background_runs != runs
+                                ? SimImageCrc::background_bytes / 4U * SIM_CRC_NS_PER_WORD / 1000U
+                                : 0;
+    us = crc_us > SIM_STARTUP_US ? crc_us : SIM_STARTUP_US;
+    return valid;
+}
+
+static bool boot(bool cold)
+{
+    uint32_t us;
+    return boot(cold, us);
+}
+
+int main()
+{
+    uint32_t cold_us, warm_us;
+    AppCheckState state;
+
+    // Same CRC-32 as zlib, which Tools/image_crc.py uses
+    CHECK(ImageCrc::Final(ImageCrc::Update(IMAGE_CRC_INIT, "123456789", 9)) == 0xCBF43926U);
+
+    // A power-on reset checks the whole image and records it, a restart trusts the record
+    install(SIM_IMAGE_SIZE, true);
+    memset(bpr, 0, sizeof(bpr));
+    uint32_t runs = SimImageCrc::background_runs;
+    CHECK(boot(true, cold_us));
+    CHECK(SimImageCrc::background_runs == runs + 1);
+    CHECK(bpr[BPR_DATA7] == APP_CACHE_MARKER);
+    runs = SimImageCrc::background_runs;
+    CHECK(boot(false, warm_us));
+    CHECK(SimImageCrc::background_runs == runs);
+
+    const uint32_t crc_us = SIM_IMAGE_SIZE / 4U * SIM_CRC_NS_PER_WORD / 1000U;
+    printf("%u KB image: cold boot %u us, restart %u us; CRC before the start-up would take %u us\n",
+           SIM_IMAGE_SIZE / 1024U, cold_us, warm_us, SIM_STARTUP_US + crc_us);
+    CHECK(warm_us <= cold_us);
+
+    // A flipped bit passes a restart on the record but not a power-on reset,
+    // which drops the record so the restarts after it fail as well
+    SimFlash::At(APPLICATION_ADDRESS + SIM_IMAGE_SIZE / 2)[0] ^= 0x10;
+    CHECK(boot(false));
+    CHECK(!boot(true));
+    CHECK(bpr[BPR_DATA7] != APP_CACHE_MARKER);
+    CHECK(!boot(false));
+
+    // Invalidate drops the record, the next restart reads the image again
+    install(SIM_IMAGE_SIZE, true);
+    CHECK(boot(true));
+    AppCheck::Invalidate();
+    CHECK(bpr[BPR_DATA7] == 0);
+    runs = SimImageCrc::background_runs;
+    CHECK(boot(false));
+    CHECK(SimImageCrc::background_runs == runs + 1);
+
+    // A record of another image does not match
+    install(SIM_IMAGE_SIZE - 1024U, true);
+    runs = SimImageCrc::background_runs;
+    CHECK(boot(false));
+    CHECK(SimImageCrc::background_runs == runs + 1);
+
+    // No trailer: an erased area, a length word of 0, a length pointing at no trailer
+#ifdef APP_CHECK_ALLOW_LEGACY
+    const bool legacy = true;
+#else
+    const bool legacy = false;
+#endif
+    SimFlash::Init();
+    CHECK(boot(true) == legacy);
+    CHECK(boot(false) == legacy);
+    install(SIM_IMAGE_SIZE, false);
+    CHECK(boot(true) == legacy);
+    CHECK(boot(false) == legacy);
+    install(SIM_IMAGE_SIZE, true);
+    memset(SimFlash::At(APPLICATION_ADDRESS + SIM_IMAGE_SIZE), 0xFF, sizeof(AppTrailer));
+    CHECK(boot(true) == legacy);
+
+    // The CheckAppTrailer command reads the image directly
+    install(SIM_IMAGE_SIZE, true);
+    AppCheck::Check(state);
+    CHECK(state.valid && state.length == SIM_IMAGE_SIZE);
+    install(SIM_IMAGE_SIZE, false);
+    AppCheck::Check(state);
+    CHECK(!state.valid && state.length == 0);
+
+    printf("%s\n", failures ? "FAILED" : "passed");
+    return failures ? 1 : 0;
+}
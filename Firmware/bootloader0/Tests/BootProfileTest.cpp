@@ -0,0 +1,154 @@
+// BootProfile over a series of boots, the backup registers kept across
+// them: the clean-boot handshake that lets a warm restart take the fast
+// path (the bootloader starts the application, the application reports
+// itself running), boots that die before that, cold resets, and the stamps
+// written for the application in BOOT_PROFILE_TICK_US units at the
+// bootloader clocks. The application side is the bit MainApp's
+// BootProfile::MarkRunning sets; that class has the same name and is not
+// linked here. Stamps are taken at DWT counts the test sets: the boot times
+// themselves need the board.
+
+#include "BootProfile.h"
+#include <cstdio>
+
+static int failures = 0;
+
+#define CHECK(condition)                                              \
+    do                                                                \
+    {                                                                 \
+        if (!(condition))                                             \
+        {                                                             \
+            printf("%s:%d: %s failed\n", __FILE__, __LINE__, #condition); \
+            failures++;                                               \
+        }                                                             \
+    } while (0)
+
+unsigned int system_core_clock = 240000000U;
+
+static uint16_t bpr[BPR_DATA22 + 1];
+static uint32_t reset_flags;
+
+uint16_t bpr_data_read(bpr_data_type bpr_data)
+{
+    return bpr[bpr_data];
+}
+
+void bpr_data_write(bpr_data_type bpr_data, uint16_t data_value)
+{
+    bpr[bpr_data] = data_value;
+}
+
+flag_status crm_flag_get(uint32_t flag)
+{
+    return (reset_flags & flag) != 0 ? SET : RESET;
+}
+
+/// @brief Reset handling up to BootProfile::Begin, the DWT counter stops with the reset
+static void reset(uint32_t flags)
+{
+    reset_flags = flags;
+    sim_dwt.CTRL = 0;
+    sim_dwt.CYCCNT = 0xDEADBEEFU;
+    BootProfile::Begin();
+}
+
+/// @brief Full start-up that jumps to the application, each phase us long
+static void full_boot(uint32_t flags, uint32_t us)
+{
+    reset(flags);
+    const uint32_t cycles = static_cast<uint32_t>(static_cast<uint64_t>(us) * system_core_clock / 1000000U);
+    for (uint8_t i = 0; i < static_cast<uint8_t>(BootPhase::COUNT); i++)
+    {
+        DWT->CYCCNT += cycles;
+        BootProfile::Mark(static_cast<BootPhase>(i));
+    }
+    BootProfile::Commit((BootProfile::IsColdReset() ? BOOT_PROFILE_COLD : 0) | BOOT_PROFILE_APP_STARTED);
+}
+
+/// @brief The application has run BOOT_PROFILE_RUNNING_MS, as MainApp's MarkRunning
+static void app_running(void)
+{
+    if (bpr[BPR_DATA13] == BOOT_PROFILE_MARKER)
+        bpr[BPR_DATA22] |= BOOT_PROFILE_APP_RUNNING;
+}
+
+static void test_first_boot(void)
+{
+    // Nothing in the backup registers: never clean
+    reset(CRM_POR_RESET_FLAG);
+    CHECK(sim_dwt.CYCCNT == 0 && (sim_dwt.CTRL & DWT_CTRL_CYCCNTENA_Msk) != 0);
+    CHECK((sim_core_debug.DEMCR & CoreDebug_DEMCR_TRCENA_Msk) != 0);
+    CHECK(BootProfile::IsColdReset() && !BootProfile::PreviousBootClean());
+
+    // A phase under one unit still reads 1, a skipped one 0, past 655 ms saturates
+    DWT->CYCCNT = 100;
+    BootProfile::Mark(BootPhase::RTC);
+    DWT->CYCCNT = 700000U * 240U;
+    BootProfile::Mark(BootPhase::JUMP);
+    BootProfile::Commit(0);
+    CHECK(bpr[BPR_DATA14] == 1U && bpr[BPR_DATA21] == 0xFFFFU);
+    for (uint8_t i = 1; i < static_cast<uint8_t>(BootPhase::COUNT) - 1U; i++)
+        CHECK(bpr[BPR_DATA14 + i] == 0);
+
+    full_boot(CRM_POR_RESET_FLAG, 1000);
+    CHECK(bpr[BPR_DATA13] == BOOT_PROFILE_MARKER);
+    CHECK(bpr[BPR_DATA22] == (BOOT_PROFILE_COLD | BOOT_PROFILE_APP_STARTED));
+}
+
+static void test_clean_handshake(void)
+{
+    // Started and running: the next warm restart may take the fast path
+    app_running();
+    reset(0);
+    CHECK(!BootProfile::IsColdReset() && BootProfile::PreviousBootClean());
+
+    // The flags are cleared at once, a boot that dies now is not clean for the next one
+    CHECK(bpr[BPR_DATA22] == 0);
+    reset(0);
+    CHECK(!BootProfile::PreviousBootClean());
+}
+
+static void test_unclean_boots(void)
+{
+    // The application was started but reset before it was up
+    full_boot(0, 1000);
+    reset(0);
+    CHECK(!BootProfile::PreviousBootClean());
+
+    // A watchdog reset is cold even after a clean boot
+    full_boot(0, 1000);
+    app_running();
+    reset(CRM_WDT_RESET_FLAG);
+    CHECK(BootProfile::IsColdReset() && BootProfile::PreviousBootClean());
+
+    // Running without a profile of this layout: an older bootloader wrote the registers
+    full_boot(0, 1000);
+    app_running();
+    bpr[BPR_DATA13] = 0xB000U;
+    reset(0);
+    CHECK(!BootProfile::PreviousBootClean());
+}
+
+static void test_stamps(void)
+{
+    // 240 MHz: 2400 cycles per 10 us
+    full_boot(0, 1230);
+    for (uint8_t i = 0; i < static_cast<uint8_t>(BootPhase::COUNT); i++)
+        CHECK(bpr[BPR_DATA14 + i] == 123U * (i + 1U));
+
+    // END_DEVICE_TEMPERATURE_SENSOR runs the bootloader at 4.8 MHz
+    system_core_clock = 4800000U;
+    full_boot(0, 5000);
+    CHECK(bpr[BPR_DATA14] == 500U && bpr[BPR_DATA21] == 4000U);
+    system_core_clock = 240000000U;
+}
+
+int main()
+{
+    test_first_boot();
+    test_clean_handshake();
+    test_unclean_boots();
+    test_stamps();
+    printf("%s\n", failures ? "FAILED" : "OK");
+    return failures ? 1 : 0;
+}
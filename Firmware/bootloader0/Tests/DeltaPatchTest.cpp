@@ -0,0 +1,173 @@
+// DeltaPatch on SimFlash with patches made by Tools/delta_patch.py between
+// two PatchImage builds:
+//   delta_patch_test OLD.bin NEW.bin PATCH FORGED_PATCH
+// PATCH is signed with the key this test is built with (DELTA_PATCH_KEY),
+// FORGED_PATCH with another one.
+
+#include "SimFlash.h"
+#include "DeltaPatch.h"
+#include "BootloadConfig.h"
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <vector>
+
+typedef std::vector<uint8_t> Bytes;
+
+static int failures = 0;
+
+#define CHECK(condition)                                              \
+    do                                                                \
+    {                                                                 \
+        if (!(condition))                                             \
+        {                                                             \
+            printf("%s:%d: %s failed\n", __FILE__, __LINE__, #condition); \
+            failures++;                                               \
+        }                                                             \
+    } while (0)
+
+static Bytes read_file(const char *path)
+{
+    std::ifstream file(path, std::ios::binary);
+    return Bytes(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+static std::string hex(const uint8_t *data, size_t size)
+{
+    std::string out;
+    char text[3];
+    for (size_t i = 0; i < size; i++)
+    {
+        snprintf(text, sizeof(text), "%02x", data[i]);
+        out += text;
+    }
+    return out;
+}
+
+static void check_sha256(void)
+{
+    uint8_t digest[SHA256_SIZE];
+    Sha256 sha;
+    sha.Update("abc", 3);
+    sha.Finish(digest);
+    CHECK(hex(digest, sizeof(digest)) == "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad");
+
+    // Two blocks, split at odd offsets
+    const char *text = "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq";
+    sha.Start();
+    sha.Update(text, 5);
+    sha.Update(text + 5, 50);
+    sha.Update(text + 55, 1);
+    sha.Finish(digest);
+    CHECK(hex(digest, sizeof(digest)) == "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1");
+
+    // RFC 4231 test case 2
+    HmacSha256 mac;
+    mac.Start(reinterpret_cast<const uint8_t *>("Jefe"), 4);
+    mac.Update("what do ya want for nothing?", 28);
+    mac.Finish(digest);
+    CHECK(hex(digest, sizeof(digest)) == "5bdcc146bf60754e6a042426089575c75a003f089d2739839dec58b964ec3843");
+}
+
+static void install(const Bytes &image)
+{
+    SimFlash::Init();
+    memcpy(SimFlash::At(APPLICATION_ADDRESS), image.data(), image.size());
+    BootloadConfig::flags = {};
+}
+
+/// @brief Send a patch file the way the update tool does
+/// @param resend Repeat every chunk once, as after lost responses
+static bool send_patch(const Bytes &patch, bool resend)
+{
+    DeltaPatchHeader header;
+    memcpy(&header, patch.data(), sizeof(header));
+    if (patch.size() != sizeof(header) + header.patch_size + DELTA_PATCH_TAG_SIZE || !DeltaPatch::Start(header))
+        return false;
+
+    const uint8_t *ops = patch.data() + sizeof(header);
+    for (uint32_t offset = 0; offset < header.patch_size; offset += DELTA_PATCH_CHUNK_SIZE)
+    {
+        uint8_t chunk[DELTA_PATCH_CHUNK_SIZE] = {};
+        const uint32_t left = header.patch_size - offset;
+        memcpy(chunk, ops + offset, left < DELTA_PATCH_CHUNK_SIZE ? left : DELTA_PATCH_CHUNK_SIZE);
+        if (!DeltaPatch::Data(offset, chunk))
+            return false;
+        if (resend && DeltaPatch::Data(offset, chunk))
+            return false;
+    }
+    return DeltaPatch::Finish(patch.data() + patch.size() - DELTA_PATCH_TAG_SIZE);
+}
+
+static DeltaPatchResult patch_result(void)
+{
+    DeltaPatchState state;
+    DeltaPatch::GetState(state);
+    return static_cast<DeltaPatchResult>(state.result);
+}
+
+int main(int argc, char **argv)
+{
+    if (argc != 5)
+    {
+        printf("usage: delta_patch_test OLD.bin NEW.bin PATCH FORGED_PATCH\n");
+        return 2;
+    }
+    const Bytes old_image = read_file(argv[1]);
+    const Bytes new_image = read_file(argv[2]);
+    const Bytes patch = read_file(argv[3]);
+    const Bytes forged = read_file(argv[4]);
+    if (old_image.empty() || new_image.empty() || patch.empty() || forged.empty())
+    {
+        printf("cannot read the images and patches\n");
+        return 2;
+    }
+    printf("images %zu -> %zu bytes, patch %zu bytes (%.1f %%)\n", old_image.size(), new_image.size(), patch.size(),
+           100.0 * patch.size() / new_image.size());
+
+    check_sha256();
+
+    // The signed patch rebuilds the new image in the reserve area and requests the swap
+    install(old_image);
+    CHECK(send_patch(patch, false));
+    CHECK(memcmp(SimFlash::At(RESERVE_APPLICATION_ADDRESS), new_image.data(), new_image.size()) == 0);
+    CHECK(BootloadConfig::flags.need_reprogramm_from_reserv);
+    CHECK(SimFlash::program_errors == 0);
+
+    // Resent chunks are refused without failing the patch
+    install(old_image);
+    CHECK(send_patch(patch, true));
+    CHECK(BootloadConfig::flags.need_reprogramm_from_reserv);
+
+    // Same image and CRC-32, tag made with another key
+    install(old_image);
+    CHECK(!send_patch(forged, false));
+    CHECK(patch_result() == DeltaPatchResult::AUTH_FAILED);
+    CHECK(!BootloadConfig::flags.need_reprogramm_from_reserv);
+
+    // One flipped tag bit
+    Bytes bad_tag = patch;
+    bad_tag.back() ^= 0x01;
+    install(old_image);
+    CHECK(!send_patch(bad_tag, false));
+    CHECK(patch_result() == DeltaPatchResult::AUTH_FAILED);
+    CHECK(!BootloadConfig::flags.need_reprogramm_from_reserv);
+
+    // A changed operation byte with the CRC-32 fixed up would still fail the tag;
+    // unchanged, it already fails the CRC-32 or the operation stream
+    Bytes bad_ops = patch;
+    bad_ops[sizeof(DeltaPatchHeader) + bad_ops.size() / 2] ^= 0x40;
+    install(old_image);
+    CHECK(!send_patch(bad_ops, false));
+    CHECK(!BootloadConfig::flags.need_reprogramm_from_reserv);
+
+    // Made against another installed image
+    Bytes other = old_image;
+    other[0] ^= 0xFF;
+    install(other);
+    CHECK(!send_patch(patch, false));
+    CHECK(patch_result() == DeltaPatchResult::SOURCE_MISMATCH);
+
+    printf("%s\n", failures ? "FAILED" : "passed");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,31 @@
+// A firmware stand-in for DeltaPatchTest: the bootloader update code built
+// twice for the host. The second build links one more function first and
+// changes a constant, so most of its code moves and the calls, jumps and
+// data references in it change as they do between two firmware releases.
+
+#include "SimFlash.h"
+#include "UpdateWindow.h"
+#include "Sha256.h"
+#include <cstdio>
+
+#ifdef PATCH_IMAGE_V2
+#define PATCH_IMAGE_BLOCKS (64U)
+#else
+#define PATCH_IMAGE_BLOCKS (32U)
+#endif
+
+int main()
+{
+    static uint8_t block[UPDATE_BLOCK_SIZE];
+    uint8_t digest[SHA256_SIZE];
+    Sha256 sha;
+
+    SimFlash::Init();
+    UpdateWindow::Reset();
+    for (uint32_t i = 0; i < PATCH_IMAGE_BLOCKS && UpdateWindow::Queue(i, block); i++)
+        UpdateWindow::Process();
+    sha.Update(SimFlash::At(APPLICATION_ADDRESS), PATCH_IMAGE_BLOCKS * UPDATE_BLOCK_SIZE);
+    sha.Finish(digest);
+    printf("%02x %llu us\n", digest[0], static_cast<unsigned long long>(SimFlash::now_us));
+    return 0;
+}
@@ -0,0 +1,10 @@
+// Linked first into the second PatchImage build, see PatchImage.cpp
+
+#include <stdint.h>
+
+extern "C" uint32_t patch_image_extra(uint32_t x)
+{
+    for (uint32_t i = 0; i < 8; i++)
+        x = x * 1664525U + 1013904223U;
+    return x;
+}
@@ -0,0 +1,59 @@
+#include "SimFlash.h"
+#include "at32f403a_407.h"
+#include <sys/mman.h>
+#include <cstdio>
+#include <cstdlib>
+
+uint64_t SimFlash::now_us;
+uint32_t SimFlash::sector_erases;
+uint32_t SimFlash::word_programs;
+uint32_t SimFlash::program_errors;
+
+void SimFlash::Init(void)
+{
+    static bool mapped = false;
+    if (!mapped)
+    {
+        void *base = mmap(At(SIM_FLASH_BASE), SIM_FLASH_SIZE, PROT_READ | PROT_WRITE,
+                          MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE, -1, 0);
+        if (base != At(SIM_FLASH_BASE))
+        {
+            printf("SimFlash: cannot map 0x%08X\n", SIM_FLASH_BASE);
+            exit(2);
+        }
+        mapped = true;
+    }
+    memset(At(SIM_FLASH_BASE), 0xFF, SIM_FLASH_SIZE);
+    now_us = 0;
+    sector_erases = 0;
+    word_programs = 0;
+    program_errors = 0;
+}
+
+void flash_unlock(void) {}
+
+void flash_lock(void) {}
+
+flash_status_type flash_sector_erase(uint32_t sector_address)
+{
+    sector_address -= (sector_address - SIM_FLASH_BASE) % SIM_SECTOR_SIZE;
+    memset(SimFlash::At(sector_address), 0xFF, SIM_SECTOR_SIZE);
+    SimFlash::now_us += SIM_SECTOR_ERASE_US;
+    SimFlash::sector_erases++;
+    return FLASH_OPERATE_DONE;
+}
+
+flash_status_type flash_word_program(uint32_t address, uint32_t data)
+{
+    uint32_t old;
+    memcpy(&old, SimFlash::At(address), sizeof(old));
+    SimFlash::now_us += SIM_WORD_PROGRAM_US;
+    SimFlash::word_programs++;
+    if (old != 0xFFFFFFFFU)
+    {
+        SimFlash::program_errors++;
+        return FLASH_PROGRAM_ERROR;
+    }
+    memcpy(SimFlash::At(address), &data, sizeof(data));
+    return FLASH_OPERATE_DONE;
+}
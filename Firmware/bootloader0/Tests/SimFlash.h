@@ -0,0 +1,34 @@
+#ifndef _SIM_FLASH_H
+#define _SIM_FLASH_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Assumed costs, not measured on the board; change them to rerun the comparison
+#define SIM_SECTOR_ERASE_US (30000U) // 2 KB sector erase
+#define SIM_WORD_PROGRAM_US (42U)    // one 32-bit word
+#define SIM_DECRYPT_US (20U)         // one 128-byte block
+#define SIM_FLASH_BASE (0x08000000U)
+#define SIM_FLASH_SIZE (0x100000U)
+#define SIM_SECTOR_SIZE (0x800U)
+
+/// @brief Host flash: RAM mapped at the device flash addresses, with a cost clock
+///
+/// Erase fills a sector with 0xFF, program only clears bits of an erased
+/// word (a second write of a programmed word fails, as on the device). Every
+/// operation advances now_us by its assumed cost.
+class SimFlash
+{
+public:
+    /// @brief Map the flash and erase all of it
+    static void Init(void);
+
+    static uint8_t *At(uint32_t address) { return reinterpret_cast<uint8_t *>(static_cast<uintptr_t>(address)); }
+
+    static uint64_t now_us;
+    static uint32_t sector_erases;
+    static uint32_t word_programs;
+    static uint32_t program_errors;
+};
+
+#endif
@@ -0,0 +1,38 @@
+#include "ImageCrc.h"
+#include "SimImageCrc.h"
+
+// Software CRC-32 in place of the CRC unit and its DMA feed
+
+uint32_t ImageCrc::SoftUpdate(uint32_t crc, const uint8_t *data, size_t size)
+{
+    for (size_t i = 0; i < size; i++)
+    {
+        crc ^= data[i];
+        for (uint32_t bit = 0; bit < 8; bit++)
+            crc = (crc >> 1) ^ (0xEDB88320U & -(crc & 1U));
+    }
+    return crc;
+}
+
+uint32_t ImageCrc::Update(uint32_t crc, const void *data, size_t size)
+{
+    return SoftUpdate(crc, static_cast<const uint8_t *>(data), size);
+}
+
+uint32_t ImageCrc::result;
+uint32_t SimImageCrc::background_bytes;
+uint32_t SimImageCrc::background_runs;
+
+void ImageCrc::Start(uint32_t address, uint32_t size)
+{
+    SimImageCrc::background_bytes = size;
+    SimImageCrc::background_runs++;
+    result = Calculate(address, size);
+}
+
+void ImageCrc::Cancel(void) {}
+
+uint32_t ImageCrc::Wait(void)
+{
+    return result;
+}
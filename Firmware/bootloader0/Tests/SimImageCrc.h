@@ -0,0 +1,14 @@
+#ifndef _SIM_IMAGE_CRC_H
+#define _SIM_IMAGE_CRC_H
+
+#include <stdint.h>
+
+/// @brief What the software ImageCrc was asked to do, for the boot-time estimate
+class SimImageCrc
+{
+public:
+    static uint32_t background_bytes; // range of the last Start
+    static uint32_t background_runs;  // Start calls
+};
+
+#endif
@@ -0,0 +1,47 @@
+#include "FW_Loader.h"
+#include "SimFlash.h"
+#include "UpdateWindow.h"
+
+// Same role as the TafcoMcuCore loader: decrypt into one buffer, program it at block_num
+static uint8_t plain[UPDATE_BLOCK_SIZE];
+
+void FW_Loader::SetBlockAndDecrypt(const uint8_t *block)
+{
+    for (uint32_t i = 0; i < UPDATE_BLOCK_SIZE; i++)
+    {
+        plain[i] = static_cast<uint8_t>(block[i] ^ 0x5A);
+    }
+    SimFlash::now_us += SIM_DECRYPT_US;
+}
+
+UpdateStatus FW_Loader::Programm(uint32_t block_num, uint32_t &next_block_num)
+{
+    const uint32_t address = APPLICATION_ADDRESS + block_num * UPDATE_BLOCK_SIZE;
+    if (block_num >= APPLICATION_SIZE / UPDATE_BLOCK_SIZE)
+    {
+        return ErrorUS;
+    }
+    for (uint32_t i = 0; i < UPDATE_BLOCK_SIZE; i += sizeof(uint32_t))
+    {
+        uint32_t word;
+        memcpy(&word, plain + i, sizeof(word));
+        if (flash_word_program(address + i, word) != FLASH_OPERATE_DONE)
+        {
+            return ErrorUS;
+        }
+    }
+    next_block_num = block_num + 1U;
+    return SuccessUS;
+}
+
+bool FW_Loader::EraseMainApp(void)
+{
+    for (uint32_t address = APPLICATION_ADDRESS; address < APPLICATION_ADDRESS + APPLICATION_SIZE; address += SIM_SECTOR_SIZE)
+    {
+        if (flash_sector_erase(address) != FLASH_OPERATE_DONE)
+        {
+            return false;
+        }
+    }
+    return true;
+}
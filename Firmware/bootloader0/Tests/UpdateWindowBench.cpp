@@ -0,0 +1,126 @@
+// Update time of a full image over ProgrammData (one block per round trip, EraseMainApp first)
+// and over QueueData (UpdateWindow), on SimFlash with the real UpdateWindow code.
+//
+// The host side is a model: a command reaches the device LINK_US after it is
+// sent, and so does the response. The device runs one command at a time and
+// the QueueData post command (UpdateWindow::Process) before the next one;
+// commands that arrive meanwhile wait in the receive buffer.
+
+#include "SimFlash.h"
+#include "UpdateWindow.h"
+#include <cstdio>
+#include <deque>
+#include <random>
+#include <vector>
+
+#define LINK_US (500U) // one way, USB full speed: a request and its response each wait for a frame
+
+static std::vector<uint8_t> plain_image;
+static std::vector<uint8_t> cipher_image;
+
+static void make_image(uint32_t size)
+{
+    std::mt19937 rng(37);
+    plain_image.resize(size);
+    cipher_image.resize(size);
+    for (uint32_t i = 0; i < size; i++)
+    {
+        plain_image[i] = static_cast<uint8_t>(rng());
+        cipher_image[i] = static_cast<uint8_t>(plain_image[i] ^ 0x5A);
+    }
+}
+
+static bool image_programmed(void)
+{
+    return memcmp(SimFlash::At(APPLICATION_ADDRESS), plain_image.data(), plain_image.size()) == 0 &&
+           SimFlash::program_errors == 0;
+}
+
+/// @brief EraseMainApp, then ProgrammData block by block, each waiting for its response
+static uint64_t stop_and_wait(uint32_t blocks)
+{
+    SimFlash::Init();
+    SimFlash::now_us += LINK_US;
+    FW_Loader::EraseMainApp();
+    SimFlash::now_us += LINK_US;
+    for (uint32_t block = 0; block < blocks; block++)
+    {
+        uint32_t next_block = 0;
+        SimFlash::now_us += LINK_US;
+        FW_Loader::SetBlockAndDecrypt(&cipher_image[block * UPDATE_BLOCK_SIZE]);
+        if (FW_Loader::Programm(block, next_block) != SuccessUS)
+        {
+            return 0;
+        }
+        SimFlash::now_us += LINK_US;
+    }
+    return SimFlash::now_us;
+}
+
+/// @brief QueueData with UPDATE_WINDOW_SLOTS blocks in flight, then StopUpdating
+static uint64_t windowed(uint32_t blocks)
+{
+    std::deque<uint64_t> arrivals; // QueueData of block (sent - arrivals.size()) arrives at arrivals.front()
+    uint32_t sent = 0;
+    uint32_t handled = 0;
+
+    SimFlash::Init();
+    UpdateWindow::Reset();
+    for (; sent < blocks && sent < UPDATE_WINDOW_SLOTS; sent++)
+    {
+        arrivals.push_back(LINK_US);
+    }
+    while (handled < blocks)
+    {
+        if (SimFlash::now_us < arrivals.front())
+        {
+            SimFlash::now_us = arrivals.front(); // idle, waiting for the host
+        }
+        arrivals.pop_front();
+        if (!UpdateWindow::Queue(handled, &cipher_image[handled * UPDATE_BLOCK_SIZE]))
+        {
+            return 0;
+        }
+        handled++;
+        // The response reaches the host LINK_US later, the host sends the next block at once
+        if (sent < blocks)
+        {
+            arrivals.push_back(SimFlash::now_us + 2U * LINK_US);
+            sent++;
+        }
+        UpdateWindow::Process();
+    }
+    SimFlash::now_us += LINK_US;
+    if (!UpdateWindow::Drain())
+    {
+        return 0;
+    }
+    return SimFlash::now_us + LINK_US;
+}
+
+int main()
+{
+    static const uint32_t sizes[] = {APPLICATION_SIZE, 100U * 1024U};
+    bool ok = true;
+
+    printf("Costs: erase %u us/sector, program %u us/word, decrypt %u us/block, link %u us one way\n",
+           SIM_SECTOR_ERASE_US, SIM_WORD_PROGRAM_US, SIM_DECRYPT_US, LINK_US);
+    printf("%8s %7s %15s %15s %8s %7s\n", "image", "blocks", "ProgrammData ms", "QueueData ms", "speedup", "erases");
+    for (uint32_t size : sizes)
+    {
+        const uint32_t blocks = size / UPDATE_BLOCK_SIZE;
+        make_image(size);
+
+        const uint64_t serial_us = stop_and_wait(blocks);
+        ok = ok && serial_us != 0 && image_programmed();
+
+        const uint64_t window_us = windowed(blocks);
+        const bool window_ok = window_us != 0 && image_programmed();
+        ok = ok && window_ok && window_us < serial_us;
+
+        printf("%7uK %7u %15.1f %15.1f %7.2fx %7u%s\n", size / 1024U, blocks, serial_us / 1000.0, window_us / 1000.0,
+               window_us ? static_cast<double>(serial_us) / window_us : 0.0, SimFlash::sector_erases,
+               window_ok ? "" : "  FAILED");
+    }
+    return ok ? 0 : 1;
+}
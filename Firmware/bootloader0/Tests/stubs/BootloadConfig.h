@@ -0,0 +1,24 @@
+#ifndef _BOOTLOAD_CONFIG_H
+#define _BOOTLOAD_CONFIG_H
+
+// Host stand-in for the TafcoMcuCore boot flags, kept in RAM
+
+typedef struct
+{
+    bool is_main_app_ok;
+    bool is_reserv_using;
+    bool is_fuota_using;
+    bool need_reprogramm_from_reserv;
+    bool need_reprogramm_from_fuota;
+} bootloader_flags_t;
+
+class BootloadConfig
+{
+public:
+    static bootloader_flags_t GetBootloaderFlags(void) { return flags; }
+    static void SetBootloaderFlags(bootloader_flags_t new_flags) { flags = new_flags; }
+
+    static inline bootloader_flags_t flags = {};
+};
+
+#endif
@@ -0,0 +1,22 @@
+#ifndef _FW_LOADER_H
+#define _FW_LOADER_H
+
+// Host stand-in for the TafcoMcuCore loader: the block cipher is a byte XOR, the timing is SimFlash's
+
+#include <stdint.h>
+
+enum UpdateStatus : uint8_t
+{
+    SuccessUS = 0,
+    ErrorUS = 1,
+};
+
+class FW_Loader
+{
+public:
+    static void SetBlockAndDecrypt(const uint8_t *block);
+    static UpdateStatus Programm(uint32_t block_num, uint32_t &next_block_num);
+    static bool EraseMainApp(void);
+};
+
+#endif
@@ -0,0 +1,79 @@
+#ifndef __AT32F403A_407_H
+#define __AT32F403A_407_H
+
+// Host stand-in for the AT32 device header: flash is a RAM mapping at the device addresses (SimFlash),
+// the DWT cycle counter is plain RAM the tests set
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+typedef enum { FALSE = 0, TRUE = !FALSE } confirm_state;
+
+typedef enum
+{
+    FLASH_OPERATE_BUSY = 0,
+    FLASH_PROGRAM_ERROR,
+    FLASH_EPP_ERROR,
+    FLASH_OPERATE_DONE,
+    FLASH_OPERATE_TIMEOUT,
+} flash_status_type;
+
+void flash_unlock(void);
+void flash_lock(void);
+flash_status_type flash_sector_erase(uint32_t sector_address);
+flash_status_type flash_word_program(uint32_t address, uint32_t data);
+
+typedef enum { RESET = 0, SET = !RESET } flag_status;
+
+// Backup registers and reset flags, defined by the test that uses them (AppCheckBootSim.cpp, BootProfileTest.cpp)
+typedef enum
+{
+    BPR_DATA7 = 7,
+    BPR_DATA8,
+    BPR_DATA9,
+    BPR_DATA10,
+    BPR_DATA11,
+    BPR_DATA12,
+    BPR_DATA13,
+    BPR_DATA14,
+    BPR_DATA15,
+    BPR_DATA16,
+    BPR_DATA17,
+    BPR_DATA18,
+    BPR_DATA19,
+    BPR_DATA20,
+    BPR_DATA21,
+    BPR_DATA22,
+} bpr_data_type;
+
+#define CRM_POR_RESET_FLAG (0x1U)
+#define CRM_WDT_RESET_FLAG (0x2U)
+
+uint16_t bpr_data_read(bpr_data_type bpr_data);
+void bpr_data_write(bpr_data_type bpr_data, uint16_t data_value);
+flag_status crm_flag_get(uint32_t flag);
+
+extern unsigned int system_core_clock;
+
+// DWT cycle counter, started by BootProfile::Begin
+#define CoreDebug_DEMCR_TRCENA_Msk (1UL << 24)
+#define DWT_CTRL_CYCCNTENA_Msk (1UL << 0)
+
+typedef struct
+{
+    uint32_t DEMCR;
+} CoreDebug_Type;
+
+typedef struct
+{
+    uint32_t CTRL;
+    uint32_t CYCCNT;
+} DWT_Type;
+
+inline CoreDebug_Type sim_core_debug;
+inline DWT_Type sim_dwt;
+#define CoreDebug (&sim_core_debug)
+#define DWT (&sim_dwt)
+
+#endif
@@ -0,0 +1,295 @@
+#!/usr/bin/env python3
+"""Delta patches for bootloader0 (StartPatch/PatchData/FinishPatch).
+
+    delta_patch.py make --key KEY OLD.bin NEW.bin PATCH    build and sign a patch, then check it by applying it
+    delta_patch.py apply [--key KEY] OLD.bin PATCH NEW.bin rebuild NEW.bin the way the bootloader does
+    delta_patch.py info PATCH                              print the header and the operation mix
+
+OLD.bin must be exactly the image installed on the device: its size and
+CRC-32 go into the header and the bootloader refuses the patch otherwise.
+KEY is the 32-byte file the bootloader was built with (DELTA_PATCH_KEY_FILE),
+e.g. made once with "head -c 32 /dev/urandom"; keep it out of the repository.
+
+Format (see Library/Update/DeltaPatch.h), little endian:
+    header   magic "TDP1", source_size, source_crc, target_size, target_crc, patch_size (u32 each)
+    ops      varint (length << 2 | op), then
+             COPY   0  zigzag varint seek, copy length source bytes
+             ADD    1  length bytes added (mod 256) to the next source bytes
+             INSERT 2  length literal bytes
+    tag      HMAC-SHA256 with KEY over the header and the new image, sent with FinishPatch
+"""
+
+import argparse
+import hashlib
+import hmac
+import struct
+import sys
+import zlib
+
+MAGIC = 0x31504454
+HEADER = struct.Struct("<6I")
+TAG_SIZE = 32
+KEY_SIZE = 32
+OP_COPY, OP_ADD, OP_INSERT = 0, 1, 2
+
+KEY = 8            # bytes hashed to find match candidates
+CANDIDATES = 16    # source positions kept per key
+MIN_SEEK_MATCH = 16  # exact bytes needed to jump to an unrelated source position
+MIN_COPY = 4       # shorter equal runs inside an aligned region stay in ADD
+
+
+def varint(value):
+    out = bytearray()
+    while value >= 0x80:
+        out.append((value & 0x7F) | 0x80)
+        value >>= 7
+    out.append(value)
+    return bytes(out)
+
+
+def read_varint(data, pos):
+    value = shift = 0
+    while True:
+        if pos >= len(data) or shift > 28:
+            raise ValueError("truncated varint")
+        byte = data[pos]
+        pos += 1
+        value |= (byte & 0x7F) << shift
+        if not byte & 0x80:
+            return value, pos
+        shift += 7
+
+
+def zigzag(value):
+    return (value << 1) ^ (value >> 63) if value < 0 else value << 1
+
+
+def unzigzag(value):
+    return (value >> 1) ^ -(value & 1)
+
+
+def match_length(old, o, new, n):
+    """Length of the exact match of new[n:] against old[o:]."""
+    length = 0
+    limit = min(len(old) - o, len(new) - n)
+    while length + 32 <= limit and old[o + length:o + length + 32] == new[n + length:n + length + 32]:
+        length += 32
+    while length < limit and old[o + length] == new[n + length]:
+        length += 1
+    return length
+
+
+def aligned_end(old, o, new, n):
+    """End (in new) of the region that still follows old[o:] with some mismatches.
+
+    Same idea as bsdiff: keep extending while matches outweigh mismatches, and
+    stop at the best score so a trailing run of differences goes to INSERT.
+    """
+    limit = min(len(old) - o, len(new) - n)
+    score = best = 0
+    best_end = 0
+    i = 0
+    while i < limit:
+        score += 1 if old[o + i] == new[n + i] else -1
+        i += 1
+        if score > best:
+            best, best_end = score, i
+        elif score < best - 16:
+            break
+    return n + best_end
+
+
+class Encoder:
+    def __init__(self, old):
+        self.old = old
+        self.index = {}
+        for pos in range(len(old) - KEY + 1):
+            positions = self.index.setdefault(old[pos:pos + KEY], [])
+            if len(positions) < CANDIDATES:
+                positions.append(pos)
+        self.ops = bytearray()
+        self.source_pos = 0
+        self.stats = {"copy": 0, "add": 0, "insert": 0, "ops": 0}
+
+    def emit_copy(self, o, length):
+        self.ops += varint(length << 2 | OP_COPY) + varint(zigzag(o - self.source_pos))
+        self.source_pos = o + length
+        self.stats["copy"] += length
+        self.stats["ops"] += 1
+
+    def emit_add(self, o, new, n, length):
+        assert o == self.source_pos
+        self.ops += varint(length << 2 | OP_ADD)
+        self.ops += bytes((new[n + i] - self.old[o + i]) & 0xFF for i in range(length))
+        self.source_pos = o + length
+        self.stats["add"] += length
+        self.stats["ops"] += 1
+
+    def emit_insert(self, data):
+        if data:
+            self.ops += varint(len(data) << 2 | OP_INSERT) + data
+            self.stats["insert"] += len(data)
+            self.stats["ops"] += 1
+
+    def emit_aligned(self, o, new, n, end):
+        """Cover new[n:end] from old[o:]: long equal runs as COPY, the rest as ADD."""
+        old = self.old
+        add_start = None
+        i = n
+        while i < end:
+            run = 0
+            while i + run < end and old[o + i - n + run] == new[i + run]:
+                run += 1
+            # The first run is always a COPY, only COPY can seek
+            if run >= MIN_COPY or (run and add_start is None and (i == n or i + run == end)):
+                if add_start is not None:
+                    self.emit_add(o + add_start - n, new, add_start, i - add_start)
+                    add_start = None
+                self.emit_copy(o + i - n, run)
+                i += run
+            else:
+                if add_start is None:
+                    add_start = i
+                i += max(run, 1)
+        if add_start is not None:
+            self.emit_add(o + add_start - n, new, add_start, end - add_start)
+
+    def best_match(self, new, n):
+        old = self.old
+        best_o, best_len, bonus = -1, 0, 0
+        # Prefer following the current source position (unchanged code after an edit)
+        if self.source_pos < len(old):
+            length = match_length(old, self.source_pos, new, n)
+            if length >= KEY:
+                best_o, best_len, bonus = self.source_pos, length + MIN_SEEK_MATCH, MIN_SEEK_MATCH
+        for o in self.index.get(bytes(new[n:n + KEY]), ()):
+            length = match_length(old, o, new, n)
+            if length > best_len:
+                best_o, best_len, bonus = o, length, 0
+        return best_o, best_len - bonus
+
+    def encode(self, new):
+        n = 0
+        literal_start = 0
+        while n < len(new):
+            o, length = self.best_match(new, n) if n + KEY <= len(new) else (-1, 0)
+            if o < 0 or (length < MIN_SEEK_MATCH and o != self.source_pos):
+                n += 1
+                continue
+            # Grow the match backwards over bytes not yet covered
+            while n > literal_start and o > 0 and self.old[o - 1] == new[n - 1]:
+                n -= 1
+                o -= 1
+            self.emit_insert(bytes(new[literal_start:n]))
+            end = aligned_end(self.old, o, new, n)
+            self.emit_aligned(o, new, n, end)
+            n = literal_start = end
+        self.emit_insert(bytes(new[literal_start:]))
+        return bytes(self.ops)
+
+
+def tag(key, header, new):
+    return hmac.new(key, header + new, hashlib.sha256).digest()
+
+
+def make_patch(old, new, key):
+    encoder = Encoder(old)
+    ops = encoder.encode(new)
+    header = HEADER.pack(MAGIC, len(old), zlib.crc32(old), len(new), zlib.crc32(new), len(ops))
+    return header + ops + tag(key, header, new), encoder.stats
+
+
+def apply_patch(old, patch, key=None):
+    magic, source_size, source_crc, target_size, target_crc, patch_size = HEADER.unpack_from(patch)
+    if magic != MAGIC or len(patch) != HEADER.size + patch_size + TAG_SIZE:
+        raise ValueError("not a patch")
+    if len(old) != source_size or zlib.crc32(old) != source_crc:
+        raise ValueError("patch was made against another image")
+    ops = patch[HEADER.size:HEADER.size + patch_size]
+    out = bytearray()
+    pos = source_pos = 0
+    while pos < len(ops):
+        value, pos = read_varint(ops, pos)
+        op, length = value & 3, value >> 2
+        if length == 0 or len(out) + length > target_size:
+            raise ValueError("bad operation length")
+        if op == OP_COPY:
+            seek, pos = read_varint(ops, pos)
+            source_pos += unzigzag(seek)
+            if source_pos < 0 or source_pos + length > source_size:
+                raise ValueError("copy outside the source")
+            out += old[source_pos:source_pos + length]
+            source_pos += length
+        elif op == OP_ADD:
+            if source_pos + length > source_size or pos + length > len(ops):
+                raise ValueError("add outside the source")
+            out += bytes((old[source_pos + i] + ops[pos + i]) & 0xFF for i in range(length))
+            source_pos += length
+            pos += length
+        elif op == OP_INSERT:
+            if pos + length > len(ops):
+                raise ValueError("truncated insert")
+            out += ops[pos:pos + length]
+            pos += length
+        else:
+            raise ValueError("unknown operation")
+    if len(out) != target_size or zlib.crc32(out) != target_crc:
+        raise ValueError("rebuilt image does not match")
+    if key is not None and not hmac.compare_digest(tag(key, patch[:HEADER.size], bytes(out)), patch[-TAG_SIZE:]):
+        raise ValueError("tag does not match, wrong key")
+    return bytes(out)
+
+
+def read(path):
+    with open(path, "rb") as f:
+        return f.read()
+
+
+def read_key(path):
+    key = read(path)
+    if len(key) != KEY_SIZE:
+        sys.exit(f"{path}: a key is {KEY_SIZE} bytes, not {len(key)}")
+    return key
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    sub = parser.add_subparsers(dest="command", required=True)
+    p = sub.add_parser("make")
+    p.add_argument("--key", required=True)
+    p.add_argument("old")
+    p.add_argument("new")
+    p.add_argument("patch")
+    p = sub.add_parser("apply")
+    p.add_argument("--key")
+    p.add_argument("old")
+    p.add_argument("patch")
+    p.add_argument("new")
+    p = sub.add_parser("info")
+    p.add_argument("patch")
+    args = parser.parse_args()
+
+    if args.command == "make":
+        old, new, key = read(args.old), read(args.new), read_key(args.key)
+        patch, stats = make_patch(old, new, key)
+        if apply_patch(old, patch, key) != new:
+            sys.exit("internal error: patch does not rebuild the new image")
+        with open(args.patch, "wb") as f:
+            f.write(patch)
+        print(f"{len(old)} -> {len(new)} bytes, patch {len(patch)} bytes "
+              f"({100.0 * len(patch) / len(new):.1f}% of the image)")
+        print(f"copy {stats['copy']}, add {stats['add']}, insert {stats['insert']} bytes in {stats['ops']} operations")
+    elif args.command == "apply":
+        new = apply_patch(read(args.old), read(args.patch), read_key(args.key) if args.key else None)
+        with open(args.new, "wb") as f:
+            f.write(new)
+    else:
+        patch = read(args.patch)
+        magic, source_size, source_crc, target_size, target_crc, patch_size = HEADER.unpack_from(patch)
+        print(f"magic {magic:08X}, source {source_size} bytes crc {source_crc:08X}, "
+              f"target {target_size} bytes crc {target_crc:08X}, {patch_size} bytes of operations, "
+              f"tag {patch[-TAG_SIZE:].hex()}")
+
+
+if __name__ == "__main__":
+    main()
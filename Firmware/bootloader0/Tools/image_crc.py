@@ -0,0 +1,69 @@
+#!/usr/bin/env python3
+"""Add the CRC-32 trailer checked by bootloader0 (Library/Update/AppCheck.h).
+
+    image_crc.py add APP.bin OUT.bin    pad to a word, write the length, append the trailer
+    image_crc.py check APP.bin          verify an image that already has a trailer
+
+The image length goes into the reserved vector table word at 0x1C, which
+must still be 0 (or erased) in the input. The trailer {magic "TCRC",
+CRC-32} follows the image; the CRC covers the image including the length
+word. The CRC is zlib's CRC-32, as computed by the bootloader.
+"""
+
+import argparse
+import struct
+import sys
+import zlib
+
+MAGIC = 0x43524354
+LENGTH_OFFSET = 0x1C
+APPLICATION_SIZE = 0x40000
+TRAILER = struct.Struct("<2I")
+
+
+def add(image):
+    image = bytearray(image)
+    image += b"\xff" * (-len(image) % 4)
+    old, = struct.unpack_from("<I", image, LENGTH_OFFSET)
+    if old not in (0, 0xFFFFFFFF):
+        sys.exit(f"word at 0x{LENGTH_OFFSET:X} is 0x{old:08X}, not a free vector (already has a trailer?)")
+    if len(image) + TRAILER.size > APPLICATION_SIZE:
+        sys.exit(f"image of {len(image)} bytes and trailer do not fit {APPLICATION_SIZE} bytes")
+    struct.pack_into("<I", image, LENGTH_OFFSET, len(image))
+    return bytes(image) + TRAILER.pack(MAGIC, zlib.crc32(image))
+
+
+def check(image):
+    length, = struct.unpack_from("<I", image, LENGTH_OFFSET)
+    if length % 4 or length + TRAILER.size > len(image):
+        return False, length, 0
+    magic, crc = TRAILER.unpack_from(image, length)
+    return magic == MAGIC and crc == zlib.crc32(image[:length]), length, crc
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    sub = parser.add_subparsers(dest="command", required=True)
+    p = sub.add_parser("add")
+    p.add_argument("image")
+    p.add_argument("out")
+    p = sub.add_parser("check")
+    p.add_argument("image")
+    args = parser.parse_args()
+
+    with open(args.image, "rb") as f:
+        image = f.read()
+    if args.command == "add":
+        out = add(image)
+        with open(args.out, "wb") as f:
+            f.write(out)
+        ok, length, crc = check(out)
+        print(f"{length} bytes, CRC-32 {crc:08X}")
+    else:
+        ok, length, crc = check(image)
+        print(f"{length} bytes, CRC-32 {crc:08X}: {'OK' if ok else 'MISMATCH'}")
+        sys.exit(0 if ok else 1)
+
+
+if __name__ == "__main__":
+    main()
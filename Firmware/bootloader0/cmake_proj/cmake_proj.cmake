@@ -38,6 +38,8 @@ endif()
 file(GLOB_RECURSE sources_SRCS
   "Main/src/*.c*"
   "Library/Command/*.c*"
+  "Library/Update/*.c*"
+  "Library/BootProfile/*.c*"
 
   "${SHARED_LIB_PATH}/AT32F403A/cmsis/cm4/device_support/*.c"
   "${SHARED_LIB_PATH}/AT32F403A/drivers/src/*.c"
@@ -78,6 +80,8 @@ file(GLOB_RECURSE sources_SRCS
 set(include_c_DIRS ${include_c_DIRS}
   ${CMAKE_CURRENT_SOURCE_DIR}/Main/inc
   ${CMAKE_CURRENT_SOURCE_DIR}/Library/Command
+  ${CMAKE_CURRENT_SOURCE_DIR}/Library/Update
+  ${CMAKE_CURRENT_SOURCE_DIR}/Library/BootProfile
 
 
   ${SHARED_LIB_PATH}/AT32F403A/cmsis/cm4/core_support